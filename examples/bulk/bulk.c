@@ -0,0 +1,114 @@
+/**
+ * @brief Spawns a large number of independent EDTs, either one at a
+ * time with ocrEdtCreate or all at once with ocrEdtCreateBulk.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+// Number of EDTs a spawner creates in a loop. Spawners split larger
+// ranges in two so that workpiles never hold too many EDTs at once.
+#define SPAWN_GRAIN 64
+
+static ocrGuid_t workTemplate;
+static ocrGuid_t spawnTemplate;
+static u64 sum;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* paramv: i */
+ocrGuid_t workEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    __sync_fetch_and_add(&sum, paramv[0]);
+    return NULL_GUID;
+}
+
+/* paramv: first, last (excluded) - creates one EDT per index with ocrEdtCreate */
+ocrGuid_t spawnEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 first = paramv[0];
+    u64 last = paramv[1];
+    ocrGuid_t guid;
+    if ((last - first) > SPAWN_GRAIN) {
+        u64 mid = first + (last - first)/2;
+        u64 lowParamv[2] = {first, mid};
+        u64 highParamv[2] = {mid, last};
+        ocrEdtCreate(&guid, spawnTemplate, EDT_PARAM_DEF, lowParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        ocrEdtCreate(&guid, spawnTemplate, EDT_PARAM_DEF, highParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        return NULL_GUID;
+    }
+    u64 i;
+    for (i = first; i < last; i++) {
+        ocrEdtCreate(&guid, workTemplate, EDT_PARAM_DEF, &i, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+    return NULL_GUID;
+}
+
+/* paramv: count - creates all the EDTs with ocrEdtCreateBulk */
+ocrGuid_t bulkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 first = 0;
+    u64 stride = 1;
+    ocrEdtCreateBulk(NULL, workTemplate, (u32) paramv[0], EDT_PARAM_DEF, &first, &stride,
+                     EDT_PROP_NONE, NULL_GUID);
+    return NULL_GUID;
+}
+
+/* paramv: count, bulk */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    u64 n = paramv[0];
+    printf("%llu EDTs %s in %f s (%s)\n", (unsigned long long) n,
+           paramv[1] ? "created in bulk" : "created one by one", elapsed,
+           (sum == n*(n-1)/2) ? "OK" : "FAILED");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 doneParamv[2] = {1000000, 1};
+    if (getArgc(programArg) == 3) {
+        doneParamv[0] = atoi(getArgv(programArg, 1));
+        doneParamv[1] = atoi(getArgv(programArg, 2));
+    } else {
+        printf("Usage: bulk <count> <bulk 0|1>, defaulting to %llu 1\n",
+               (unsigned long long) doneParamv[0]);
+    }
+    ocrEdtTemplateCreate(&workTemplate, workEdt, 1, 0);
+    ocrEdtTemplateCreate(&spawnTemplate, spawnEdt, 2, 0);
+    ocrGuid_t bulkTemplate, doneTemplate;
+    ocrEdtTemplateCreate(&bulkTemplate, bulkEdt, 1, 0);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 2, 1);
+
+    // The root is a finish EDT: its output event is satisfied
+    // once all the EDTs it transitively created have run
+    start = now();
+    ocrGuid_t rootGuid, rootDone;
+    if (doneParamv[1]) {
+        ocrEdtCreate(&rootGuid, bulkTemplate, EDT_PARAM_DEF, doneParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_FINISH, NULL_GUID, &rootDone);
+    } else {
+        u64 rootParamv[2] = {0, doneParamv[0]};
+        ocrEdtCreate(&rootGuid, spawnTemplate, EDT_PARAM_DEF, rootParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_FINISH, NULL_GUID, &rootDone);
+    }
+    ocrGuid_t doneGuid;
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, doneParamv, EDT_PARAM_DEF, &rootDone,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
@@ -0,0 +1,131 @@
+/**
+ * @brief Stresses the data-block allocator from all the workers at once.
+ * Each of a set of chains of EDTs creates small data-blocks of random
+ * sizes and frees the ones the previous EDT of its chain created, which
+ * likely ran on another worker. Run it with the single TLSF allocator
+ * and with one TLSF arena per worker to compare.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 chains;
+static u64 steps;
+static u64 blocks;      // Data-blocks created per EDT
+static u64 maxSize;     // In bytes
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* paramv: step. depv: data-blocks created by the previous step of the chain, previous step done */
+ocrGuid_t stepEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t * created = (ocrGuid_t *) depv[0].ptr;
+    u64 seed = paramv[0]*2654435761ULL + (u64) created;
+    u64 i;
+    for (i = 0; i < blocks; i++) {
+        if (paramv[0] != 0) {
+            ocrDbDestroy(created[i]);
+        }
+        seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+        u64 size = 16 + (seed >> 33) % maxSize;
+        u64 * ptr;
+        if (ocrDbCreate(&created[i], (void **) &ptr, size, 0, NULL_GUID, NO_ALLOC) != 0) {
+            printf("Not enough memory for the data-blocks\n");
+            exit(1);
+        }
+        ptr[0] = size;
+        ocrDbRelease(created[i]);
+    }
+    return NULL_GUID;
+}
+
+/* depv: lists of data-blocks of the chains, last steps done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    u64 i, j;
+    for (i = 0; i < chains; i++) {
+        ocrGuid_t * created = (ocrGuid_t *) depv[i].ptr;
+        for (j = 0; j < blocks; j++) {
+            ocrDbDestroy(created[j]);
+        }
+        ocrDbDestroy(depv[i].guid);
+    }
+    double count = (double) chains*steps*blocks;
+    printf("%d chains of %d steps creating %d data-blocks of up to %d bytes: %f s, "
+           "%f M create/destroy per s\n", (u32) chains, (u32) steps, (u32) blocks,
+           (u32) maxSize, elapsed, count/elapsed*1e-6);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    chains = 64;
+    steps = 100;
+    blocks = 64;
+    maxSize = 1024;
+    if (getArgc(programArg) == 5) {
+        chains = atoll(getArgv(programArg, 1));
+        steps = atoll(getArgv(programArg, 2));
+        blocks = atoll(getArgv(programArg, 3));
+        maxSize = atoll(getArgv(programArg, 4));
+    } else {
+        printf("Usage: dballoc <chains> <steps> <data-blocks per step> <max size>, "
+               "defaulting to %d %d %d %d\n", (u32) chains, (u32) steps, (u32) blocks,
+               (u32) maxSize);
+    }
+    if ((chains == 0) || (chains > 128) || (steps == 0) || (blocks == 0) || (maxSize == 0)) {
+        printf("Between 1 and 128 chains of at least one step are needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    ocrGuid_t * lists = (ocrGuid_t *) malloc(chains*sizeof(ocrGuid_t));
+    ocrGuid_t * previous = (ocrGuid_t *) malloc(chains*sizeof(ocrGuid_t));
+    u64 i, t;
+    for (i = 0; i < chains; i++) {
+        void * list;
+        ocrDbCreate(&lists[i], &list, blocks*sizeof(ocrGuid_t), 0, NULL_GUID, NO_ALLOC);
+        ocrDbRelease(lists[i]);
+    }
+
+    ocrGuid_t firstTemplate, stepTemplate, doneTemplate, edt;
+    ocrEdtTemplateCreate(&firstTemplate, stepEdt, 1, 1);
+    ocrEdtTemplateCreate(&stepTemplate, stepEdt, 1, 2);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 2*chains);
+    start = now();
+    for (t = 0; t < steps; t++) {
+        for (i = 0; i < chains; i++) {
+            ocrGuid_t done;
+            ocrEdtCreate(&edt, (t == 0) ? firstTemplate : stepTemplate, EDT_PARAM_DEF, &t,
+                         EDT_PARAM_DEF, NULL, EDT_PROP_NONE, NULL_GUID, &done);
+            if (t != 0) {
+                ocrAddDependence(previous[i], edt, 1, DB_MODE_RO);
+            }
+            ocrAddDependence(lists[i], edt, 0, DB_MODE_ITW);
+            previous[i] = done;
+        }
+    }
+    ocrEdtCreate(&edt, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    for (i = 0; i < chains; i++) {
+        ocrAddDependence(previous[i], edt, chains + i, DB_MODE_RO);
+        ocrAddDependence(lists[i], edt, i, DB_MODE_RO);
+    }
+    free(lists);
+    free(previous);
+    return NULL_GUID;
+}
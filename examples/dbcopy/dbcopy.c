@@ -0,0 +1,100 @@
+/**
+ * @brief Measures the bandwidth of copies between two data-blocks, either
+ * with a single memcpy inside an EDT or with ocrDbCopy.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 size;
+static u64 reps;
+static u64 useDbCopy;
+static ocrGuid_t source;
+static ocrGuid_t destination;
+static ocrGuid_t repTemplate;
+static ocrGuid_t memcpyTemplate;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* depv: source, destination - output event satisfied with the destination */
+ocrGuid_t memcpyEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    memcpy(depv[1].ptr, depv[0].ptr, size);
+    return depv[1].guid;
+}
+
+/* paramv: rep - depv: previous copy */
+ocrGuid_t repEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 rep = paramv[0];
+    if (rep == 0) {
+        start = now();
+    }
+    if (rep == reps) {
+        double elapsed = now() - start;
+        char * dst = (char *) depv[0].ptr;
+        printf("%llu copies of %llu bytes with %s: %f GB/s (%s)\n", (unsigned long long) reps,
+               (unsigned long long) size, useDbCopy ? "ocrDbCopy" : "memcpy in an EDT",
+               (reps*size)/elapsed*1e-9, (dst[size - 1] == (char) (size - 1)) ? "OK" : "FAILED");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    ocrGuid_t done, guid;
+    if (useDbCopy) {
+        ocrDbCopy(destination, 0, source, 0, size, 0, &done);
+    } else {
+        ocrGuid_t copyDepv[2] = {source, destination};
+        ocrEdtCreate(&guid, memcpyTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, copyDepv,
+                     EDT_PROP_NONE, NULL_GUID, &done);
+    }
+    u64 nextRep = rep + 1;
+    ocrEdtCreate(&guid, repTemplate, EDT_PARAM_DEF, &nextRep, EDT_PARAM_DEF, &done,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    size = 12582912;
+    reps = 20;
+    useDbCopy = 1;
+    if (getArgc(programArg) == 4) {
+        size = atoll(getArgv(programArg, 1));
+        reps = atoll(getArgv(programArg, 2));
+        useDbCopy = atoi(getArgv(programArg, 3));
+    } else {
+        printf("Usage: dbcopy <size> <reps> <dbcopy 0|1>, defaulting to %llu %llu 1\n",
+               (unsigned long long) size, (unsigned long long) reps);
+    }
+    char * ptr;
+    ocrDbCreate(&source, (void **) &ptr, size, 0, NULL_GUID, NO_ALLOC);
+    u64 i;
+    for (i = 0; i < size; i++) {
+        ptr[i] = (char) i;
+    }
+    ocrDbRelease(source);
+    ocrDbCreate(&destination, (void **) &ptr, size, 0, NULL_GUID, NO_ALLOC);
+    memset(ptr, 0, size);
+    ocrDbRelease(destination);
+
+    ocrEdtTemplateCreate(&repTemplate, repEdt, 1, 1);
+    ocrEdtTemplateCreate(&memcpyTemplate, memcpyEdt, 0, 2);
+    ocrGuid_t guid;
+    u64 firstRep = 0;
+    ocrEdtCreate(&guid, repTemplate, EDT_PARAM_DEF, &firstRep, EDT_PARAM_DEF, &destination,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
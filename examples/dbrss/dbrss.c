@@ -0,0 +1,110 @@
+/**
+ * @brief Reports the resident memory of a program whose memory use
+ * rises and falls. Each step of a chain of EDTs creates a data-block
+ * and writes all of it while the memory rises, then destroys the
+ * last one while it falls, a number of times. Run it with memory the
+ * allocator keeps and with memory it gives back to compare.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ocr.h"
+
+#define MB (1024*1024)
+
+static u64 cycles;
+static u64 steps;       // Data-blocks at the top of a cycle
+static u64 size;        // Of each data-block, in bytes
+static ocrGuid_t * guids;
+static ocrGuid_t stepTemplate;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+// Resident set size of the process in MB
+static u32 rss() {
+    unsigned long total, resident = 0;
+    FILE * statm = fopen("/proc/self/statm", "r");
+    if (statm != NULL) {
+        if (fscanf(statm, "%lu %lu", &total, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return (u32) (resident*sysconf(_SC_PAGESIZE)/MB);
+}
+
+/* paramv: step, counting up then down through each cycle */
+ocrGuid_t stepEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 step = paramv[0];
+    u64 inCycle = step % (2*steps);
+    if (inCycle < steps) {
+        void * ptr;
+        if (ocrDbCreate(&guids[inCycle], &ptr, size, 0, NULL_GUID, NO_ALLOC) != 0) {
+            printf("Not enough memory for the data-blocks\n");
+            exit(1);
+        }
+        memset(ptr, (int) step, size);
+        // Only the step destroying it uses it next
+        ocrDbRelease(guids[inCycle]);
+    } else {
+        ocrDbDestroy(guids[2*steps - 1 - inCycle]);
+    }
+    u64 live = (inCycle < steps) ? inCycle + 1 : 2*steps - 1 - inCycle;
+    printf("%8.3f s: %4d MB in data-blocks, %4d MB resident\n", now() - start,
+           (u32) (live*size/MB), rss());
+    if (step + 1 == cycles*2*steps) {
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    ocrGuid_t next;
+    u64 nextStep = step + 1;
+    ocrEdtCreate(&next, stepTemplate, EDT_PARAM_DEF, &nextStep, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    cycles = 2;
+    steps = 16;
+    size = 8;
+    if (getArgc(programArg) == 4) {
+        cycles = atoll(getArgv(programArg, 1));
+        steps = atoll(getArgv(programArg, 2));
+        size = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: dbrss <cycles> <steps per cycle> <MB per step>, defaulting to %d %d %d\n",
+               (u32) cycles, (u32) steps, (u32) size);
+    }
+    if ((cycles == 0) || (steps == 0) || (size == 0)) {
+        printf("At least one cycle of one step is needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    size *= MB;
+    guids = (ocrGuid_t *) malloc(steps*sizeof(ocrGuid_t));
+    start = now();
+    printf("%8.3f s: %4d MB in data-blocks, %4d MB resident\n", 0.0, 0, rss());
+
+    ocrGuid_t first;
+    u64 firstStep = 0;
+    ocrEdtTemplateCreate(&stepTemplate, stepEdt, 1, 0);
+    ocrEdtCreate(&first, stepTemplate, EDT_PARAM_DEF, &firstStep, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
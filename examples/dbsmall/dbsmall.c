@@ -0,0 +1,103 @@
+/**
+ * @brief Measures the rate at which workers create and destroy small
+ * data-blocks, such as counters and partial sums. A set of EDTs running
+ * at once each repeatedly create a batch of data-blocks of 8 to 256
+ * bytes and destroy them. Run it with the different allocators to
+ * compare.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 edts;
+static u64 rounds;
+static u64 batch;       // Data-blocks alive at once in each EDT
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* depv: start */
+ocrGuid_t workEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t * guids = (ocrGuid_t *) malloc(batch*sizeof(ocrGuid_t));
+    u64 r, i;
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < batch; i++) {
+            // Sizes cycle through 8, 16, ..., 256 bytes
+            u64 size = 8 << ((r + i) % 6);
+            u64 * ptr;
+            if (ocrDbCreate(&guids[i], (void **) &ptr, size, 0, NULL_GUID, NO_ALLOC) != 0) {
+                printf("Not enough memory for the data-blocks\n");
+                exit(1);
+            }
+            ptr[0] = i;
+        }
+        for (i = batch; i > 0; i--) {
+            ocrDbDestroy(guids[i - 1]);
+        }
+    }
+    free(guids);
+    return NULL_GUID;
+}
+
+/* depv: EDTs done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    double count = (double) edts*rounds*batch;
+    printf("%d EDTs of %d rounds of %d data-blocks of 8 to 256 bytes: %f s, "
+           "%f M create/destroy per s\n", (u32) edts, (u32) rounds, (u32) batch,
+           elapsed, count/elapsed*1e-6);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    edts = 16;
+    rounds = 200;
+    batch = 256;
+    if (getArgc(programArg) == 4) {
+        edts = atoll(getArgv(programArg, 1));
+        rounds = atoll(getArgv(programArg, 2));
+        batch = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: dbsmall <EDTs> <rounds> <data-blocks per round>, defaulting to %d %d %d\n",
+               (u32) edts, (u32) rounds, (u32) batch);
+    }
+    if ((edts == 0) || (edts > 128) || (rounds == 0) || (batch == 0)) {
+        printf("Between 1 and 128 EDTs of at least one round are needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    // The EDTs wait for all of them to be set up to start at once
+    ocrGuid_t workTemplate, doneTemplate, done, edt, go;
+    ocrEventCreate(&go, OCR_EVENT_STICKY_T, false);
+    ocrEdtTemplateCreate(&workTemplate, workEdt, 0, 1);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, edts);
+    ocrEdtCreate(&done, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    u64 i;
+    for (i = 0; i < edts; i++) {
+        ocrGuid_t output;
+        ocrEdtCreate(&edt, workTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, &output);
+        ocrAddDependence(output, done, i, DB_MODE_RO);
+        ocrAddDependence(go, edt, 0, DB_MODE_RO);
+    }
+    start = now();
+    ocrEventSatisfy(go, NULL_GUID);
+    return NULL_GUID;
+}
@@ -0,0 +1,123 @@
+/**
+ * @brief Keeps the last versions of a grid of which each step only writes
+ * a small part, as a checkpointing or undo history would. Versions are
+ * either copy-on-write snapshots (ocrDbSnapshot()) or full copies.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+// Versions kept alive
+#define WINDOW 4
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+// Memory available to the system in MB. Pages of snapshots live in
+// in-memory files and are not all counted in the process' resident set
+static u32 availableMB() {
+    char line[128];
+    u32 available = 0;
+    FILE * meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo != NULL) {
+        while (fgets(line, sizeof(line), meminfo) != NULL) {
+            if (sscanf(line, "MemAvailable: %u kB", &available) == 1) {
+                break;
+            }
+        }
+        fclose(meminfo);
+    }
+    return available >> 10;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 sizeMB = 64, versions = 32, percent = 1;
+    bool copy = false;
+    u32 argc = getArgc(programArg);
+    if (argc >= 4) {
+        sizeMB = atoll(getArgv(programArg, 1));
+        versions = atoll(getArgv(programArg, 2));
+        percent = atoll(getArgv(programArg, 3));
+        copy = (argc == 5) && (strcmp(getArgv(programArg, 4), "copy") == 0);
+    } else {
+        printf("Usage: dbsnapshot <size in MB> <versions> <%% written per step> [copy], "
+               "defaulting to %d %d %d\n", (u32) sizeMB, (u32) versions, (u32) percent);
+    }
+    u64 words = (sizeMB << 20)/sizeof(u64);
+    u64 stepWords = words*percent/100;
+    if ((stepWords == 0) || (percent > 100)) {
+        printf("The grid must be written at each step\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    u32 availableBefore = availableMB();
+    ocrGuid_t gridGuid;
+    u64 * grid;
+    if (ocrDbCreate(&gridGuid, (void **) &grid, words*sizeof(u64), DB_PROP_SNAPSHOT,
+                    NULL_GUID, NO_ALLOC) != 0) {
+        printf("Not enough memory for the grid\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    memset(grid, 0, words*sizeof(u64));
+
+    ocrGuid_t history[WINDOW];
+    u64 * historyPtr[WINDOW];
+    double versioning = 0.0;
+    u64 v, i;
+    for (v = 0; v < versions; v++) {
+        // Step v writes v + 1 to its part of the grid
+        u64 first = (v*stepWords) % (words - stepWords + 1);
+        for (i = first; i < first + stepWords; i++) {
+            grid[i] = v + 1;
+        }
+        if (v >= WINDOW) {
+            ocrDbDestroy(history[v % WINDOW]);
+        }
+        double start = now();
+        if (copy) {
+            ocrDbCreate(&history[v % WINDOW], (void **) &historyPtr[v % WINDOW], words*sizeof(u64),
+                        DB_PROP_SNAPSHOT, NULL_GUID, NO_ALLOC);
+            memcpy(historyPtr[v % WINDOW], grid, words*sizeof(u64));
+        } else {
+            ocrDbSnapshot(&history[v % WINDOW], (void **) &historyPtr[v % WINDOW], gridGuid);
+        }
+        versioning += now() - start;
+    }
+
+    // Each version kept has the part its step wrote but not the next one
+    bool ok = true;
+    for (v = (versions > WINDOW) ? versions - WINDOW : 0; v < versions; v++) {
+        u64 * version = historyPtr[v % WINDOW];
+        u64 first = (v*stepWords) % (words - stepWords + 1);
+        u64 next = ((v + 1)*stepWords) % (words - stepWords + 1);
+        ok = ok && (version[first] == v + 1) && (version[first + stepWords - 1] == v + 1);
+        ok = ok && ((v + 1 == versions) || (version[next + stepWords - 1] != v + 2));
+    }
+    printf("%d versions of %d MB (%d%% written per step), %s: %f ms per version, "
+           "%d MB used (%s)\n", (u32) versions, (u32) sizeMB, (u32) percent,
+           copy ? "full copies" : "snapshots", versioning/versions*1e3,
+           (s32) (availableBefore - availableMB()), ok ? "OK" : "FAILED");
+
+    for (v = (versions > WINDOW) ? versions - WINDOW : 0; v < versions; v++) {
+        ocrDbDestroy(history[v % WINDOW]);
+    }
+    ocrDbDestroy(gridGuid);
+    ocrShutdown();
+    return NULL_GUID;
+}
@@ -0,0 +1,154 @@
+/**
+ * @brief Sweeps a working set of data-blocks larger than the memory of the
+ * allocators. Each pass runs one EDT per data-block that increments all of
+ * its words, then the data-blocks are checked. Without eviction they cannot
+ * all be created.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 count;
+static u64 size;
+static u64 passes;
+static ocrGuid_t * dbs;
+static ocrGuid_t incrementTemplate;
+static ocrGuid_t passTemplate;
+static ocrGuid_t checkTemplate;
+static volatile u64 errors;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* depv: data-block */
+ocrGuid_t incrementEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * words = (u64 *) depv[0].ptr;
+    u64 i;
+    for (i = 0; i < size/sizeof(u64); i++) {
+        words[i]++;
+    }
+    return NULL_GUID;
+}
+
+/* paramv: data-block index - depv: data-block */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 d = paramv[0];
+    u64 * words = (u64 *) depv[0].ptr;
+    u64 i;
+    // Word i of data-block d started at d + i
+    for (i = 0; i < size/sizeof(u64); i++) {
+        if (words[i] != d + i + passes) {
+            __sync_fetch_and_add(&errors, 1);
+            break;
+        }
+    }
+    ocrDbDestroy(depv[0].guid);
+    return NULL_GUID;
+}
+
+/* depv: checks done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    printf("%d passes over %d data-blocks of %d bytes: %f s, %f MB/s (%s)\n",
+           (u32) passes, (u32) count, (u32) size, elapsed,
+           passes*count*size/elapsed*1e-6, (errors == 0) ? "OK" : "FAILED");
+    free(dbs);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+/* paramv: passes done - depv: increments of the pass done */
+ocrGuid_t passEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 done = paramv[0];
+    u64 d;
+    // Only the EDTs of the next pass hold data-blocks: the
+    // working set does not have to fit in memory at once
+    ocrGuid_t nextTemplate, nextGuid;
+    u64 next = done + 1;
+    if (done == passes) {
+        ocrEdtTemplateCreate(&nextTemplate, doneEdt, 0, count);
+        ocrEdtCreate(&nextGuid, nextTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    } else {
+        ocrEdtCreate(&nextGuid, passTemplate, EDT_PARAM_DEF, &next, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+    for (d = 0; d < count; d++) {
+        ocrGuid_t edtGuid, edtDone;
+        if (done == passes) {
+            ocrEdtCreate(&edtGuid, checkTemplate, EDT_PARAM_DEF, &d, EDT_PARAM_DEF, NULL,
+                         EDT_PROP_NONE, NULL_GUID, &edtDone);
+        } else {
+            ocrEdtCreate(&edtGuid, incrementTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                         EDT_PROP_NONE, NULL_GUID, &edtDone);
+        }
+        ocrAddDependence(edtDone, nextGuid, d, DB_MODE_RO);
+        ocrAddDependence(dbs[d], edtGuid, 0, (done == passes) ? DB_MODE_RO : DB_MODE_ITW);
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    count = 32;
+    size = 2*1024*1024;
+    passes = 4;
+    if (getArgc(programArg) == 4) {
+        count = atoll(getArgv(programArg, 1));
+        size = atoll(getArgv(programArg, 2)) & ~(sizeof(u64) - 1);
+        passes = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: dbspill <data-blocks> <size> <passes>, defaulting to %d %d %d\n",
+               (u32) count, (u32) size, (u32) passes);
+    }
+
+    // Data-blocks are released as soon as they are initialized
+    // so that the runtime can evict them to make room
+    dbs = (ocrGuid_t *) malloc(count*sizeof(ocrGuid_t));
+    start = now();
+    u64 d, i;
+    for (d = 0; d < count; d++) {
+        u64 * words;
+        if (ocrDbCreate(&dbs[d], (void **) &words, size, 0, NULL_GUID, NO_ALLOC) != 0) {
+            printf("Out of memory after %d data-blocks of %d bytes\n", (u32) d, (u32) size);
+            while (d > 0) {
+                ocrDbDestroy(dbs[--d]);
+            }
+            free(dbs);
+            ocrShutdown();
+            return NULL_GUID;
+        }
+        for (i = 0; i < size/sizeof(u64); i++) {
+            words[i] = d + i;
+        }
+        ocrDbRelease(dbs[d]);
+    }
+    printf("Created %d data-blocks in %f s\n", (u32) count, now() - start);
+
+    ocrEdtTemplateCreate(&incrementTemplate, incrementEdt, 0, 1);
+    ocrEdtTemplateCreate(&passTemplate, passEdt, 1, count);
+    ocrEdtTemplateCreate(&checkTemplate, checkEdt, 1, 1);
+    ocrGuid_t firstGuid;
+    u64 first = 0;
+    ocrGuid_t firstDepv[count];
+    for (d = 0; d < count; d++) {
+        firstDepv[d] = NULL_GUID;
+    }
+    start = now();
+    ocrEdtCreate(&firstGuid, passTemplate, EDT_PARAM_DEF, &first, EDT_PARAM_DEF, firstDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
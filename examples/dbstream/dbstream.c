@@ -0,0 +1,117 @@
+/**
+ * @brief Measures the memory bandwidth of EDTs working on their own
+ * data-blocks, like the STREAM triad. Each of a set of EDTs running at
+ * once creates three data-blocks, the last two with the first as
+ * affinity, and repeatedly computes a = b + s*c over them. Run it with
+ * one allocator per NUMA node, so that the data-blocks come from the
+ * node of the worker creating them, and with memory interleaved over
+ * the nodes to compare.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 edts;
+static u64 iterations;
+static u64 length;      // Doubles in each data-block
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* depv: start */
+ocrGuid_t triadEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t aGuid, bGuid, cGuid;
+    double * a, * b, * c;
+    u64 size = length*sizeof(double);
+    if ((ocrDbCreate(&aGuid, (void **) &a, size, 0, NULL_GUID, NO_ALLOC) != 0) ||
+        (ocrDbCreate(&bGuid, (void **) &b, size, 0, aGuid, NO_ALLOC) != 0) ||
+        (ocrDbCreate(&cGuid, (void **) &c, size, 0, aGuid, NO_ALLOC) != 0)) {
+        printf("Not enough memory for the data-blocks\n");
+        exit(1);
+    }
+    // First touch from the worker, as the computation
+    u64 i, k;
+    for (i = 0; i < length; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    const double s = 3.0;
+    for (k = 0; k < iterations; k++) {
+        for (i = 0; i < length; i++) {
+            a[i] = b[i] + s*c[i];
+        }
+    }
+    if (a[length - 1] != 7.0) {
+        printf("Wrong result %f\n", a[length - 1]);
+        exit(1);
+    }
+    ocrDbDestroy(aGuid);
+    ocrDbDestroy(bGuid);
+    ocrDbDestroy(cGuid);
+    return NULL_GUID;
+}
+
+/* depv: EDTs done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    // Two loads and a store per element, plus the initialization
+    double bytes = (double) edts*length*sizeof(double)*(3*iterations + 3);
+    printf("%d EDTs of %d triads over 3 data-blocks of %d MB: %f s, %f GB/s\n",
+           (u32) edts, (u32) iterations, (u32) (length*sizeof(double) >> 20),
+           elapsed, bytes/elapsed*1e-9);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    edts = 4;
+    iterations = 20;
+    length = 2*1024*1024;
+    if (getArgc(programArg) == 4) {
+        edts = atoll(getArgv(programArg, 1));
+        iterations = atoll(getArgv(programArg, 2));
+        length = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: dbstream <EDTs> <iterations> <doubles per data-block>, defaulting to %d %d %d\n",
+               (u32) edts, (u32) iterations, (u32) length);
+    }
+    if ((edts == 0) || (edts > 128) || (iterations == 0) || (length == 0)) {
+        printf("Between 1 and 128 EDTs of at least one iteration are needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    // The EDTs wait for all of them to be set up to start at once
+    ocrGuid_t triadTemplate, doneTemplate, done, edt, go;
+    ocrEventCreate(&go, OCR_EVENT_STICKY_T, false);
+    ocrEdtTemplateCreate(&triadTemplate, triadEdt, 0, 1);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, edts);
+    ocrEdtCreate(&done, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    u64 i;
+    for (i = 0; i < edts; i++) {
+        ocrGuid_t output;
+        ocrEdtCreate(&edt, triadTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, &output);
+        ocrAddDependence(output, done, i, DB_MODE_RO);
+        ocrAddDependence(go, edt, 0, DB_MODE_RO);
+    }
+    start = now();
+    ocrEventSatisfy(go, NULL_GUID);
+    return NULL_GUID;
+}
@@ -0,0 +1,107 @@
+/**
+ * @brief Recursive Fibonacci where each EDT does very little work,
+ * measuring the benefit of executing EDTs inline.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static ocrGuid_t fibTemplate;
+static ocrGuid_t sumTemplate;
+static ocrGuid_t doneTemplate;
+static u16 properties;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* paramv: event - depv: fib(n-1), fib(n-2)
+ * satisfies the event with a data-block holding fib(n) */
+ocrGuid_t sumEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * result;
+    ocrGuid_t resultGuid;
+    ocrDbCreate(&resultGuid, (void **) &result, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    *result = *((u64 *) depv[0].ptr) + *((u64 *) depv[1].ptr);
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    ocrEventSatisfy((ocrGuid_t) paramv[0], resultGuid);
+    return NULL_GUID;
+}
+
+/* paramv: n, event - satisfies the event with a data-block holding fib(n) */
+ocrGuid_t fibEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 n = paramv[0];
+    if (n < 2) {
+        u64 * result;
+        ocrGuid_t resultGuid;
+        ocrDbCreate(&resultGuid, (void **) &result, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+        *result = n;
+        ocrEventSatisfy((ocrGuid_t) paramv[1], resultGuid);
+        return NULL_GUID;
+    }
+    ocrGuid_t childDone[2];
+    ocrEventCreate(&childDone[0], OCR_EVENT_ONCE_T, true);
+    ocrEventCreate(&childDone[1], OCR_EVENT_ONCE_T, true);
+    u64 sumParamv[1] = {paramv[1]};
+    ocrGuid_t sumGuid;
+    ocrEdtCreate(&sumGuid, sumTemplate, EDT_PARAM_DEF, sumParamv, EDT_PARAM_DEF, childDone,
+                 properties, NULL_GUID, NULL);
+    u64 i;
+    for (i = 0; i < 2; i++) {
+        u64 childParamv[2] = {n - 1 - i, (u64) childDone[i]};
+        ocrGuid_t childGuid;
+        ocrEdtCreate(&childGuid, fibTemplate, EDT_PARAM_DEF, childParamv, EDT_PARAM_DEF, NULL,
+                     properties, NULL_GUID, NULL);
+    }
+    return NULL_GUID;
+}
+
+/* paramv: n - depv: fib(n) */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    printf("fib(%llu) = %llu in %f s with%s inlining\n", (unsigned long long) paramv[0],
+           (unsigned long long) *((u64 *) depv[0].ptr), elapsed,
+           (properties & EDT_PROP_INLINE) ? "" : "out");
+    ocrDbDestroy(depv[0].guid);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 n = 22;
+    properties = EDT_PROP_INLINE;
+    if (getArgc(programArg) == 3) {
+        n = atoi(getArgv(programArg, 1));
+        properties = atoi(getArgv(programArg, 2)) ? EDT_PROP_INLINE : EDT_PROP_NONE;
+    } else {
+        printf("Usage: fib <n> <inline 0|1>, defaulting to %llu 1\n", (unsigned long long) n);
+    }
+    ocrEdtTemplateCreate(&fibTemplate, fibEdt, 2, 0);
+    ocrEdtTemplateCreate(&sumTemplate, sumEdt, 1, 2);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 1, 1);
+
+    ocrGuid_t done;
+    ocrEventCreate(&done, OCR_EVENT_ONCE_T, true);
+    ocrGuid_t doneGuid;
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, &n, EDT_PARAM_DEF, &done,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    start = now();
+    u64 fibParamv[2] = {n, (u64) done};
+    ocrGuid_t fibGuid;
+    ocrEdtCreate(&fibGuid, fibTemplate, EDT_PARAM_DEF, fibParamv, EDT_PARAM_DEF, NULL,
+                 properties, NULL_GUID, NULL);
+    return NULL_GUID;
+}
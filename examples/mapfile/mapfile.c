@@ -0,0 +1,116 @@
+/**
+ * @brief Loads an input file in a data-block, either by reading it into
+ * a data-block created with ocrDbCreate or by mapping it with
+ * ocrDbCreateFromFile, and reports the time until the first EDT using it
+ * starts and the memory resident once it has been scanned.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "ocr.h"
+
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+// Prints the anonymous and file-backed resident memory of the process
+static void printRss() {
+    char line[256];
+    FILE * status = fopen("/proc/self/status", "r");
+    if (status == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if ((strncmp(line, "RssAnon:", 8) == 0) || (strncmp(line, "RssFile:", 8) == 0)) {
+            printf("  %s", line);
+        }
+    }
+    fclose(status);
+}
+
+/* paramv: map - depv: input */
+ocrGuid_t scanEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double firstEdt = now() - start;
+    u64 * input = (u64 *) depv[0].ptr;
+    u64 n = paramv[1]/sizeof(u64);
+    u64 sum = 0;
+    u64 i;
+    for (i = 0; i < n; i++) {
+        sum += input[i];
+    }
+    double scanned = now() - start;
+    printf("%s %llu bytes: first EDT after %f s, scanned after %f s (%s)\n",
+           paramv[0] ? "Mapped" : "Read", (unsigned long long) paramv[1], firstEdt, scanned,
+           (sum == n*(n-1)/2) ? "OK" : "FAILED");
+    printRss();
+    ocrDbDestroy(depv[0].guid);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 scanParamv[2] = {1, 16*1024*1024};
+    if (getArgc(programArg) == 3) {
+        scanParamv[1] = atoll(getArgv(programArg, 1));
+        scanParamv[0] = atoi(getArgv(programArg, 2));
+    } else {
+        printf("Usage: mapfile <size> <map 0|1>, defaulting to %llu 1\n",
+               (unsigned long long) scanParamv[1]);
+    }
+    u64 size = scanParamv[1] & ~(sizeof(u64) - 1);
+    scanParamv[1] = size;
+
+    // Input file of consecutive u64s
+    char path[] = "/tmp/ocrMapFileXXXXXX";
+    int fd = mkstemp(path);
+    FILE * file = fdopen(fd, "w");
+    u64 i;
+    for (i = 0; i < size/sizeof(u64); i++) {
+        fwrite(&i, sizeof(u64), 1, file);
+    }
+    fclose(file);
+
+    start = now();
+    ocrGuid_t inputGuid;
+    void * input;
+    if (scanParamv[0]) {
+        ocrDbCreateFromFile(&inputGuid, &input, path, 0, 0, DB_PROP_MAP_SEQUENTIAL, NULL_GUID);
+    } else {
+        ocrDbCreate(&inputGuid, &input, size, 0, NULL_GUID, NO_ALLOC);
+        fd = open(path, O_RDONLY);
+        u64 done = 0;
+        while (done < size) {
+            ssize_t got = read(fd, (char *) input + done, size - done);
+            if (got <= 0) {
+                break;
+            }
+            done += got;
+        }
+        close(fd);
+    }
+    unlink(path);
+
+    ocrGuid_t scanTemplate, scanGuid;
+    ocrEdtTemplateCreate(&scanTemplate, scanEdt, 2, 1);
+    ocrEdtCreate(&scanGuid, scanTemplate, EDT_PARAM_DEF, scanParamv, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrDbRelease(inputGuid);
+    ocrAddDependence(inputGuid, scanGuid, 0, DB_MODE_RO);
+    return NULL_GUID;
+}
@@ -0,0 +1,162 @@
+/**
+ * @brief Sums an array either with a hand-written tree of EDTs joined
+ * by events, as in the treesum examples, or with ocrParallelReduce.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+// Number of leaves of the hand-written tree
+#define TREE_LEAVES 256
+
+static u64 * data;
+static u64 n;
+static u64 reps;
+static u64 useReduce;
+static u64 treeGrain;
+static ocrGuid_t treeTemplate;
+static ocrGuid_t joinTemplate;
+static ocrGuid_t repTemplate;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+static ocrGuid_t newResult(u64 value) {
+    u64 * result;
+    ocrGuid_t resultGuid;
+    ocrDbCreate(&resultGuid, (void **) &result, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    *result = value;
+    return resultGuid;
+}
+
+void initBody(u64 first, u64 last, void *arg) {
+    u64 i;
+    for (i = first; i < last; i++) {
+        data[i] = i;
+    }
+}
+
+void sumBody(u64 first, u64 last, void *arg, void *result) {
+    u64 sum = 0;
+    u64 i;
+    for (i = first; i < last; i++) {
+        sum += data[i];
+    }
+    *((u64 *) result) += sum;
+}
+
+void sumCombine(void *left, const void *right, void *arg) {
+    *((u64 *) left) += *((const u64 *) right);
+}
+
+/* paramv: event - depv: partial sums */
+ocrGuid_t joinEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 sum = *((u64 *) depv[0].ptr) + *((u64 *) depv[1].ptr);
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    ocrEventSatisfy((ocrGuid_t) paramv[0], newResult(sum));
+    return NULL_GUID;
+}
+
+/* paramv: first, last, event - satisfies the event with the sum of the range */
+ocrGuid_t treeEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 first = paramv[0];
+    u64 last = paramv[1];
+    if ((last - first) <= treeGrain) {
+        u64 sum = 0;
+        sumBody(first, last, NULL, &sum);
+        ocrEventSatisfy((ocrGuid_t) paramv[2], newResult(sum));
+        return NULL_GUID;
+    }
+    ocrGuid_t childDone[2];
+    ocrEventCreate(&childDone[0], OCR_EVENT_ONCE_T, true);
+    ocrEventCreate(&childDone[1], OCR_EVENT_ONCE_T, true);
+    ocrGuid_t guid;
+    ocrEdtCreate(&guid, joinTemplate, EDT_PARAM_DEF, &paramv[2], EDT_PARAM_DEF, childDone,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    u64 mid = first + (last - first)/2;
+    u64 lowParamv[3] = {first, mid, (u64) childDone[0]};
+    u64 highParamv[3] = {mid, last, (u64) childDone[1]};
+    ocrEdtCreate(&guid, treeTemplate, EDT_PARAM_DEF, lowParamv, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrEdtCreate(&guid, treeTemplate, EDT_PARAM_DEF, highParamv, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
+
+/* paramv: rep - depv: sum of the previous repetition */
+ocrGuid_t repEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 rep = paramv[0];
+    u64 sum = 0;
+    if (depv[0].guid != NULL_GUID) {
+        sum = *((u64 *) depv[0].ptr);
+        ocrDbDestroy(depv[0].guid);
+    } else {
+        start = now();
+    }
+    if (rep == reps) {
+        double elapsed = now() - start;
+        printf("%llu sums of %llu elements with %s in %f s (%s)\n", (unsigned long long) reps,
+               (unsigned long long) n, useReduce ? "ocrParallelReduce" : "an EDT tree", elapsed,
+               (sum == n*(n-1)/2) ? "OK" : "FAILED");
+        free(data);
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    ocrGuid_t done, guid;
+    ocrEventCreate(&done, OCR_EVENT_ONCE_T, true);
+    u64 nextRep = rep + 1;
+    ocrEdtCreate(&guid, repTemplate, EDT_PARAM_DEF, &nextRep, EDT_PARAM_DEF, &done,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    if (useReduce) {
+        u64 zero = 0;
+        ocrParallelReduce(0, n, 0, sumBody, sumCombine, &zero, sizeof(u64), NULL, done);
+    } else {
+        u64 treeParamv[3] = {0, n, (u64) done};
+        ocrEdtCreate(&guid, treeTemplate, EDT_PARAM_DEF, treeParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    n = 4194304;
+    reps = 10;
+    useReduce = 1;
+    if (getArgc(programArg) == 4) {
+        n = atoll(getArgv(programArg, 1));
+        reps = atoll(getArgv(programArg, 2));
+        useReduce = atoi(getArgv(programArg, 3));
+    } else {
+        printf("Usage: parallel_sum <n> <reps> <reduce 0|1>, defaulting to %llu %llu 1\n",
+               (unsigned long long) n, (unsigned long long) reps);
+    }
+    treeGrain = (n < TREE_LEAVES) ? 1 : n/TREE_LEAVES;
+    data = (u64 *) malloc(sizeof(u64)*n);
+    ocrEdtTemplateCreate(&treeTemplate, treeEdt, 3, 0);
+    ocrEdtTemplateCreate(&joinTemplate, joinEdt, 1, 2);
+    ocrEdtTemplateCreate(&repTemplate, repEdt, 1, 1);
+
+    // Initialize the array in parallel, then run the repetitions
+    ocrGuid_t initDone, guid;
+    ocrEventCreate(&initDone, OCR_EVENT_ONCE_T, false);
+    u64 firstRep = 0;
+    ocrEdtCreate(&guid, repTemplate, EDT_PARAM_DEF, &firstRep, EDT_PARAM_DEF, &initDone,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrParallelFor(0, n, 0, initBody, NULL, initDone);
+    return NULL_GUID;
+}
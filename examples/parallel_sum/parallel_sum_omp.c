@@ -0,0 +1,49 @@
+/**
+ * @brief OpenMP baseline for parallel_sum.c
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+int main(int argc, char ** argv) {
+    unsigned long long n = 4194304;
+    unsigned long long reps = 10;
+    if (argc == 3) {
+        n = atoll(argv[1]);
+        reps = atoll(argv[2]);
+    }
+    unsigned long long * data = malloc(sizeof(unsigned long long)*n);
+    long long i;
+#pragma omp parallel for
+    for (i = 0; i < (long long) n; i++) {
+        data[i] = i;
+    }
+    double start = now();
+    unsigned long long sum = 0;
+    unsigned long long r;
+    for (r = 0; r < reps; r++) {
+        sum = 0;
+#pragma omp parallel for reduction(+:sum)
+        for (i = 0; i < (long long) n; i++) {
+            sum += data[i];
+        }
+    }
+    double elapsed = now() - start;
+    printf("%llu sums of %llu elements with OpenMP in %f s (%s)\n", reps, n, elapsed,
+           (sum == n*(n-1)/2) ? "OK" : "FAILED");
+    free(data);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * @brief Compares the ways an EDT can get temporary memory. Independent
+ * EDTs each allocate buffers of random sizes, write to them and give them
+ * back before returning: with ocrScratchMalloc, freed when the EDT
+ * returns, with malloc/free or with ocrDbCreate/ocrDbDestroy.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+#define MAX_ALLOCS 1024
+
+#define SCRATCH 0
+#define MALLOC 1
+#define DATABLOCK 2
+
+static const char * methods[] = { "scratch", "malloc", "datablock" };
+
+static u64 edts;
+static u64 allocs;      // Allocations per EDT
+static u64 maxSize;     // In bytes
+static u64 method;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* paramv: EDT number */
+ocrGuid_t workEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * buffers[MAX_ALLOCS];
+    ocrGuid_t guids[MAX_ALLOCS];
+    u64 seed = paramv[0]*2654435761ULL;
+    u64 i;
+    for (i = 0; i < allocs; i++) {
+        seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+        u64 size = 16 + (seed >> 33) % maxSize;
+        u8 status = 0;
+        switch (method) {
+        case SCRATCH:
+            status = ocrScratchMalloc(size, &buffers[i]);
+            break;
+        case MALLOC:
+            buffers[i] = malloc(size);
+            break;
+        case DATABLOCK:
+            status = ocrDbCreate(&guids[i], &buffers[i], size, 0, NULL_GUID, NO_ALLOC);
+            break;
+        }
+        if ((status != 0) || (buffers[i] == NULL)) {
+            printf("Not enough memory for the buffers\n");
+            exit(1);
+        }
+        *(u64 *) buffers[i] = size;
+    }
+    for (i = 0; i < allocs; i++) {
+        if (method == MALLOC) {
+            free(buffers[i]);
+        } else if (method == DATABLOCK) {
+            ocrDbDestroy(guids[i]);
+        }
+    }
+    return NULL_GUID;
+}
+
+/* depv: work EDTs done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    double count = (double) edts*allocs;
+    printf("%s: %d EDTs allocating %d buffers of up to %d bytes: %f s, "
+           "%f ns per allocation\n", methods[method], (u32) edts, (u32) allocs,
+           (u32) maxSize, elapsed, elapsed/count*1e9);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+// Spawn EDTs creating fewer work EDTs than this create them directly
+#define LEAF 32
+
+/* paramv: first EDT number, number of EDTs. Splits the range in two
+   until it is small enough, so that few EDTs are ready at once */
+ocrGuid_t spawnEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t edt;
+    u64 first = paramv[0];
+    u64 count = paramv[1];
+    if (count > LEAF) {
+        ocrGuid_t spawnTemplate;
+        ocrEdtTemplateCreate(&spawnTemplate, spawnEdt, 2, 0);
+        u64 halves[2][2] = { {first, count/2}, {first + count/2, count - count/2} };
+        ocrEdtCreate(&edt, spawnTemplate, EDT_PARAM_DEF, halves[0], EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        ocrEdtCreate(&edt, spawnTemplate, EDT_PARAM_DEF, halves[1], EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        return NULL_GUID;
+    }
+    ocrGuid_t workTemplate;
+    ocrEdtTemplateCreate(&workTemplate, workEdt, 1, 0);
+    u64 i;
+    for (i = first; i < first + count; i++) {
+        ocrEdtCreate(&edt, workTemplate, EDT_PARAM_DEF, &i, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    edts = 1000;
+    allocs = 1024;
+    maxSize = 256;
+    method = SCRATCH;
+    if (getArgc(programArg) == 5) {
+        for (method = 0; method < 3; method++) {
+            if (strcmp(getArgv(programArg, 1), methods[method]) == 0) {
+                break;
+            }
+        }
+        edts = atoll(getArgv(programArg, 2));
+        allocs = atoll(getArgv(programArg, 3));
+        maxSize = atoll(getArgv(programArg, 4));
+    } else {
+        printf("Usage: scratch <scratch|malloc|datablock> <EDTs> <allocations per EDT> "
+               "<max size>, defaulting to %s %d %d %d\n", methods[method], (u32) edts,
+               (u32) allocs, (u32) maxSize);
+    }
+    if ((method == 3) || (edts == 0) || (allocs == 0) || (allocs > MAX_ALLOCS) || (maxSize == 0)) {
+        printf("A known method and between 1 and %d allocations per EDT are needed\n", MAX_ALLOCS);
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    ocrGuid_t spawnTemplate, doneTemplate, spawn, done, edt;
+    ocrEdtTemplateCreate(&spawnTemplate, spawnEdt, 2, 0);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 1);
+    u64 range[2] = {0, edts};
+    start = now();
+    // The finish scope of the root spawn EDT includes all the work EDTs
+    ocrEdtCreate(&spawn, spawnTemplate, EDT_PARAM_DEF, range, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_FINISH, NULL_GUID, &done);
+    ocrEdtCreate(&edt, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &done,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
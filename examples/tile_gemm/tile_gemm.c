@@ -0,0 +1,134 @@
+/**
+ * @brief Multiplies two square matrices held in single data-blocks with
+ * one EDT per tile of the result. Tiles of the inputs are read in place,
+ * striding over the whole matrices, which stresses the TLB. Run it with
+ * the malloc and hugepage memory platforms to compare them.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 n;
+static u64 tile;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* paramv: first row, first column - depv: A, B, C */
+ocrGuid_t tileEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    const double * a = (const double *) depv[0].ptr;
+    const double * b = (const double *) depv[1].ptr;
+    double * c = (double *) depv[2].ptr;
+    u64 i0 = paramv[0];
+    u64 j0 = paramv[1];
+    u64 i, j, k, k0;
+    for (k0 = 0; k0 < n; k0 += tile) {
+        for (i = i0; i < i0 + tile; i++) {
+            for (k = k0; k < k0 + tile; k++) {
+                double aik = a[i*n + k];
+                for (j = j0; j < j0 + tile; j++) {
+                    c[i*n + j] += aik*b[k*n + j];
+                }
+            }
+        }
+    }
+    return NULL_GUID;
+}
+
+/* depv: A, B, C, tiles done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    const double * c = (const double *) depv[2].ptr;
+    // A is all ones and B(k, j) = j, so C(i, j) = n*j
+    u64 i, j;
+    bool ok = true;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            ok = ok && (c[i*n + j] == (double) (n*j));
+        }
+    }
+    printf("%llux%llu product in %llux%llu tiles: %f s, %f GFlop/s (%s)\n",
+           (unsigned long long) n, (unsigned long long) n, (unsigned long long) tile,
+           (unsigned long long) tile, elapsed, 2.0*n*n*n/elapsed*1e-9, ok ? "OK" : "FAILED");
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    ocrDbDestroy(depv[2].guid);
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    n = 1024;
+    tile = 128;
+    if (getArgc(programArg) == 3) {
+        n = atoll(getArgv(programArg, 1));
+        tile = atoll(getArgv(programArg, 2));
+    } else {
+        printf("Usage: tile_gemm <n> <tile>, defaulting to %llu %llu\n",
+               (unsigned long long) n, (unsigned long long) tile);
+    }
+    if ((tile == 0) || (n % tile) != 0) {
+        printf("The tile size must divide n\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    ocrGuid_t matrices[3];
+    double * a, * b, * c;
+    ocrDbCreate(&matrices[0], (void **) &a, n*n*sizeof(double), 0, NULL_GUID, NO_ALLOC);
+    ocrDbCreate(&matrices[1], (void **) &b, n*n*sizeof(double), 0, NULL_GUID, NO_ALLOC);
+    ocrDbCreate(&matrices[2], (void **) &c, n*n*sizeof(double), 0, NULL_GUID, NO_ALLOC);
+    if ((a == NULL) || (b == NULL) || (c == NULL)) {
+        printf("Not enough memory for the matrices\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    u64 i, j;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            a[i*n + j] = 1.0;
+            b[i*n + j] = (double) j;
+            c[i*n + j] = 0.0;
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        ocrDbRelease(matrices[i]);
+    }
+
+    u64 tiles = (n/tile)*(n/tile);
+    ocrGuid_t tileTemplate, doneTemplate, tileGuid, doneGuid;
+    ocrEdtTemplateCreate(&tileTemplate, tileEdt, 2, 3);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 3 + tiles);
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    start = now();
+    u64 t;
+    for (t = 0; t < tiles; t++) {
+        u64 position[2] = {(t/(n/tile))*tile, (t%(n/tile))*tile};
+        ocrGuid_t tileDone;
+        ocrEdtCreate(&tileGuid, tileTemplate, EDT_PARAM_DEF, position, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, &tileDone);
+        ocrAddDependence(tileDone, doneGuid, 3 + t, DB_MODE_RO);
+        ocrAddDependence(matrices[0], tileGuid, 0, DB_MODE_RO);
+        ocrAddDependence(matrices[1], tileGuid, 1, DB_MODE_RO);
+        ocrAddDependence(matrices[2], tileGuid, 2, DB_MODE_ITW);
+    }
+    for (i = 0; i < 3; i++) {
+        ocrAddDependence(matrices[i], doneGuid, i, DB_MODE_RO);
+    }
+    return NULL_GUID;
+}
@@ -0,0 +1,156 @@
+/**
+ * @brief Iterates a 3-point averaging stencil over a periodic 1D domain
+ * split in tiles, each held in its own data-blocks. The EDT updating a
+ * tile reads it and its two neighbors and writes the tile's other buffer,
+ * so each step streams the whole domain through memory. Run it with and
+ * without prefetching of the data-blocks of queued EDTs to compare.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+static u64 tiles;
+static u64 tileSize; // In doubles
+static u64 iterations;
+static double initialSum;
+static double start;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* depv: left, tile, right, output, previous steps of left, tile and right */
+ocrGuid_t stepEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    const double * left = (const double *) depv[0].ptr;
+    const double * in = (const double *) depv[1].ptr;
+    const double * right = (const double *) depv[2].ptr;
+    double * out = (double *) depv[3].ptr;
+    u64 k;
+    out[0] = (left[tileSize - 1] + in[0] + in[1])/3.0;
+    for (k = 1; k < tileSize - 1; k++) {
+        out[k] = (in[k - 1] + in[k] + in[k + 1])/3.0;
+    }
+    out[tileSize - 1] = (in[tileSize - 2] + in[tileSize - 1] + right[0])/3.0;
+    return NULL_GUID;
+}
+
+/* depv: tiles of the last step, last steps done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    double elapsed = now() - start;
+    // Averaging over a periodic domain preserves the sum
+    double sum = 0.0;
+    u64 i, k;
+    for (i = 0; i < tiles; i++) {
+        const double * tile = (const double *) depv[i].ptr;
+        for (k = 0; k < tileSize; k++) {
+            sum += tile[k];
+        }
+    }
+    bool ok = fabs(sum - initialSum) <= 1e-9*initialSum;
+    double bytes = 2.0*tiles*tileSize*sizeof(double)*iterations;
+    printf("%d steps over %d tiles of %d KB: %f s, %f GB/s (%s)\n", (u32) iterations,
+           (u32) tiles, (u32) (tileSize*sizeof(double)/1024), elapsed, bytes/elapsed*1e-9,
+           ok ? "OK" : "FAILED");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    tiles = 48;
+    u64 tileKB = 256;
+    iterations = 50;
+    if (getArgc(programArg) == 4) {
+        tiles = atoll(getArgv(programArg, 1));
+        tileKB = atoll(getArgv(programArg, 2));
+        iterations = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: tile_stencil <tiles> <tile size in KB> <steps>, defaulting to %d %d %d\n",
+               (u32) tiles, (u32) tileKB, (u32) iterations);
+    }
+    tileSize = tileKB*1024/sizeof(double);
+    if ((tiles < 3) || (tileSize < 2) || (iterations == 0)) {
+        printf("At least 3 tiles of 1 KB and one step are needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    // Two buffers per tile, step t reads buffer t%2 and writes the other
+    ocrGuid_t * buffers[2];
+    buffers[0] = (ocrGuid_t *) malloc(tiles*sizeof(ocrGuid_t));
+    buffers[1] = (ocrGuid_t *) malloc(tiles*sizeof(ocrGuid_t));
+    u64 i, k, t;
+    initialSum = 0.0;
+    for (i = 0; i < tiles; i++) {
+        double * in, * out;
+        if ((ocrDbCreate(&buffers[0][i], (void **) &in, tileSize*sizeof(double), 0,
+                         NULL_GUID, NO_ALLOC) != 0) ||
+            (ocrDbCreate(&buffers[1][i], (void **) &out, tileSize*sizeof(double), 0,
+                         NULL_GUID, NO_ALLOC) != 0)) {
+            printf("Not enough memory for the tiles\n");
+            ocrShutdown();
+            return NULL_GUID;
+        }
+        for (k = 0; k < tileSize; k++) {
+            in[k] = (double) ((i*tileSize + k) % 7);
+            out[k] = 0.0;
+            initialSum += in[k];
+        }
+        ocrDbRelease(buffers[0][i]);
+        ocrDbRelease(buffers[1][i]);
+    }
+
+    ocrGuid_t firstTemplate, stepTemplate, doneTemplate, edt;
+    ocrEdtTemplateCreate(&firstTemplate, stepEdt, 0, 4);
+    ocrEdtTemplateCreate(&stepTemplate, stepEdt, 0, 7);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 2*tiles);
+    ocrGuid_t * previous = (ocrGuid_t *) malloc(tiles*sizeof(ocrGuid_t));
+    ocrGuid_t * current = (ocrGuid_t *) malloc(tiles*sizeof(ocrGuid_t));
+    // The first steps run as they are created
+    start = now();
+    for (t = 0; t < iterations; t++) {
+        ocrGuid_t * in = buffers[t % 2];
+        for (i = 0; i < tiles; i++) {
+            u64 left = (i + tiles - 1) % tiles;
+            u64 right = (i + 1) % tiles;
+            // The neighbors must be done reading the output buffer at the previous step
+            ocrEdtCreate(&edt, (t == 0) ? firstTemplate : stepTemplate, EDT_PARAM_DEF, NULL,
+                         EDT_PARAM_DEF, NULL, EDT_PROP_NONE, NULL_GUID, &current[i]);
+            if (t != 0) {
+                ocrAddDependence(previous[left], edt, 4, DB_MODE_RO);
+                ocrAddDependence(previous[i], edt, 5, DB_MODE_RO);
+                ocrAddDependence(previous[right], edt, 6, DB_MODE_RO);
+            }
+            ocrAddDependence(in[left], edt, 0, DB_MODE_RO);
+            ocrAddDependence(in[i], edt, 1, DB_MODE_RO);
+            ocrAddDependence(in[right], edt, 2, DB_MODE_RO);
+            ocrAddDependence(buffers[(t + 1) % 2][i], edt, 3, DB_MODE_ITW);
+        }
+        ocrGuid_t * swap = previous;
+        previous = current;
+        current = swap;
+    }
+    ocrEdtCreate(&edt, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    for (i = 0; i < tiles; i++) {
+        ocrAddDependence(previous[i], edt, tiles + i, DB_MODE_RO);
+        ocrAddDependence(buffers[iterations % 2][i], edt, i, DB_MODE_RO);
+    }
+    free(previous);
+    free(current);
+    free(buffers[0]);
+    free(buffers[1]);
+    return NULL_GUID;
+}
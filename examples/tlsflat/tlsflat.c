@@ -0,0 +1,127 @@
+/**
+ * @brief Measures the latency of the TLSF allocator. A data-block holding
+ * a heap is allocated into with ocrDbMalloc() and freed with ocrDbFree()
+ * for sizes drawn from several distributions, keeping a ring of
+ * allocations alive so that the free-lists are not all empty or all full.
+ * The heap is used from a single EDT: only the allocator is timed. Each
+ * distribution is run twice and the second run is reported, once the
+ * pages of the heap are mapped.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+#define MB (1024*1024)
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+typedef enum {
+    SMALL_FIXED,        // 64 bytes
+    SMALL_UNIFORM,      // 16 bytes to 4KB
+    LOG_UNIFORM,        // 16 bytes to 1MB, as many of each power of two
+    LARGE_UNIFORM,      // 64KB to 4MB
+    DISTRIBUTION_COUNT
+} distribution_t;
+
+static const char * names[DISTRIBUTION_COUNT] = {
+    "64 B", "16 B - 4 KB uniform", "16 B - 1 MB log-uniform", "64 KB - 4 MB uniform"
+};
+
+static u64 drawSize(distribution_t distribution, u64 * seed) {
+    *seed = *seed*6364136223846793005ULL + 1442695040888963407ULL;
+    u64 r = *seed >> 24;
+    switch (distribution) {
+    case SMALL_FIXED:
+        return 64;
+    case SMALL_UNIFORM:
+        return 16 + r % (4096 - 16);
+    case LOG_UNIFORM:
+        // 2^4 to 2^20, then anywhere in that power of two
+        return (1ULL << (4 + r % 16)) + (r >> 8) % (1ULL << (4 + r % 16));
+    default:
+        return 64*1024 + r % (4*MB - 64*1024);
+    }
+}
+
+// Returns the average cost of an allocation and a free in ns
+static double measure(ocrGuid_t heap, distribution_t distribution, u64 count, u64 live,
+                      void ** ring) {
+    u64 seed = 42;
+    u64 i, failed = 0;
+    for (i = 0; i < live; i++) {
+        ring[i] = NULL;
+    }
+    double start = now();
+    for (i = 0; i < count; i++) {
+        u64 slot = i % live;
+        if (ring[slot] != NULL) {
+            ocrDbFree(heap, ring[slot]);
+        }
+        if (ocrDbMalloc(heap, drawSize(distribution, &seed), &ring[slot]) != 0) {
+            ring[slot] = NULL;
+            failed++;
+        }
+    }
+    double elapsed = now() - start;
+    for (i = 0; i < live; i++) {
+        if (ring[i] != NULL) {
+            ocrDbFree(heap, ring[i]);
+        }
+    }
+    if (failed != 0) {
+        printf("%d allocations did not fit in the heap, ", (u32) failed);
+    }
+    return elapsed/count*1e9;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 count = 1000000;
+    u64 live = 128;
+    u64 heapSize = 512;     // In MB
+    if (getArgc(programArg) == 4) {
+        count = atoll(getArgv(programArg, 1));
+        live = atoll(getArgv(programArg, 2));
+        heapSize = atoll(getArgv(programArg, 3));
+    } else {
+        printf("Usage: tlsflat <allocations> <alive at once> <heap MB>, defaulting to %d %d %d\n",
+               (u32) count, (u32) live, (u32) heapSize);
+    }
+    if ((count == 0) || (live == 0) || (heapSize == 0)) {
+        printf("At least one allocation in a heap of at least 1 MB is needed\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+
+    ocrGuid_t heap;
+    void * ptr;
+    if (ocrDbCreate(&heap, &ptr, heapSize*MB, 0, NULL_GUID, TLSF_ALLOC) != 0) {
+        printf("Not enough memory for the heap\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    void ** ring = (void **) malloc(live*sizeof(void *));
+    u32 d;
+    for (d = 0; d < DISTRIBUTION_COUNT; d++) {
+        measure(heap, (distribution_t) d, count, live, ring);
+        double latency = measure(heap, (distribution_t) d, count, live, ring);
+        printf("%-24s %8.1f ns per malloc/free\n", names[d], latency);
+    }
+    free(ring);
+    ocrDbDestroy(heap);
+    ocrShutdown();
+    return NULL_GUID;
+}
@@ -0,0 +1,168 @@
+/**
+ * @brief Iterated tree sum comparing rebuilding the DAG at each
+ * iteration against replaying a recorded task graph.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "ocr.h"
+
+#define MODE_REBUILD 0
+#define MODE_REPLAY  1
+
+typedef struct {
+    u64 depth;
+    u64 iterations;
+    ocrGuid_t valuesGuid;
+    ocrGuid_t nodeTemplate;
+    ocrGuid_t leafTemplate;
+    ocrGuid_t driverTemplate;
+    ocrGuid_t graph;
+    double start;
+} state_t;
+
+static double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec*1e-6;
+}
+
+/* values[k] = values[2k] + values[2k+1]
+ * paramv: factor, k, done event - depv: values, left, right */
+ocrGuid_t nodeEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 k = paramv[1];
+    u64 * values = (u64 *) depv[0].ptr;
+    values[k] = values[2*k] + values[2*k+1];
+    ocrEventSatisfy((ocrGuid_t) paramv[2], NULL_GUID);
+    return NULL_GUID;
+}
+
+/* values[k] = factor * (k - leaves)
+ * paramv: factor, k, done event, leaves - depv: values */
+ocrGuid_t leafEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 k = paramv[1];
+    u64 * values = (u64 *) depv[0].ptr;
+    values[k] = paramv[0] * (k - paramv[3]);
+    ocrEventSatisfy((ocrGuid_t) paramv[2], NULL_GUID);
+    return NULL_GUID;
+}
+
+/* Creates the EDTs and events of the tree, returns the root's event */
+static ocrGuid_t buildTree(state_t * state, u64 factor) {
+    u64 leaves = 1UL << state->depth;
+    ocrGuid_t * done = (ocrGuid_t *) malloc(sizeof(ocrGuid_t)*2*leaves);
+    u64 k;
+    for (k = 1; k < 2*leaves; k++) {
+        ocrEventCreate(&done[k], OCR_EVENT_ONCE_T, false);
+    }
+    for (k = 2*leaves-1; k >= 1; k--) {
+        ocrGuid_t edt;
+        if (k >= leaves) {
+            u64 paramv[4] = {factor, k, (u64) done[k], leaves};
+            ocrGuid_t depv[1] = {state->valuesGuid};
+            ocrEdtCreate(&edt, state->leafTemplate, EDT_PARAM_DEF, paramv, EDT_PARAM_DEF, depv,
+                         EDT_PROP_NONE, NULL_GUID, NULL);
+        } else {
+            u64 paramv[3] = {factor, k, (u64) done[k]};
+            ocrGuid_t depv[3] = {state->valuesGuid, done[2*k], done[2*k+1]};
+            ocrEdtCreate(&edt, state->nodeTemplate, EDT_PARAM_DEF, paramv, EDT_PARAM_DEF, depv,
+                         EDT_PROP_NONE, NULL_GUID, NULL);
+        }
+    }
+    ocrGuid_t root = done[1];
+    free(done);
+    return root;
+}
+
+/* Checks the previous iteration, runs the next one and creates its driver
+ * paramv: mode, iteration - depv: state, values, previous iteration done */
+ocrGuid_t driverEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 mode = paramv[0];
+    u64 iteration = paramv[1];
+    state_t * state = (state_t *) depv[0].ptr;
+    u64 * values = (u64 *) depv[1].ptr;
+    u64 leaves = 1UL << state->depth;
+
+    if ((iteration != 0) && (values[1] != iteration*leaves*(leaves-1)/2)) {
+        printf("error: iteration %llu computed %llu\n", (unsigned long long) iteration,
+               (unsigned long long) values[1]);
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    if (iteration == state->iterations) {
+        double elapsed = now() - state->start;
+        printf("%s: %llu iterations of %llu EDTs in %f s (%f us per EDT)\n",
+               (mode == MODE_REBUILD) ? "rebuild" : "replay ",
+               (unsigned long long) state->iterations, (unsigned long long) (2*leaves-1),
+               elapsed, elapsed*1e6/(state->iterations*(2*leaves-1)));
+        if (mode == MODE_REPLAY) {
+            ocrGraphDestroy(state->graph);
+            ocrShutdown();
+            return NULL_GUID;
+        }
+        // Record the tree once for the replay runs
+        ocrGraphBegin(&(state->graph), 1);
+        buildTree(state, 0);
+        ocrGraphEnd(state->graph);
+        mode = MODE_REPLAY;
+        iteration = 0;
+        state->start = now();
+    }
+
+    ocrGuid_t done;
+    u64 factor = iteration + 1;
+    if (mode == MODE_REPLAY) {
+        ocrEventCreate(&done, OCR_EVENT_ONCE_T, false);
+    } else {
+        done = buildTree(state, factor);
+    }
+    u64 nparamv[2] = {mode, iteration+1};
+    ocrGuid_t ndepv[3] = {depv[0].guid, depv[1].guid, done};
+    ocrGuid_t driver;
+    ocrEdtCreate(&driver, state->driverTemplate, EDT_PARAM_DEF, nparamv, EDT_PARAM_DEF, ndepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    if (mode == MODE_REPLAY) {
+        ocrGraphReplay(state->graph, 1, &factor, 0, NULL, done);
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * programArg = depv[0].ptr;
+    u64 depth = 6, iterations = 1000;
+    if (getArgc(programArg) == 3) {
+        depth = atoi(getArgv(programArg, 1));
+        iterations = atoi(getArgv(programArg, 2));
+    } else {
+        printf("Usage: treesum_graph <depth> <iterations>, defaulting to %llu %llu\n",
+               (unsigned long long) depth, (unsigned long long) iterations);
+    }
+
+    ocrGuid_t stateGuid;
+    state_t * state;
+    ocrDbCreate(&stateGuid, (void **) &state, sizeof(state_t), 0, NULL_GUID, NO_ALLOC);
+    u64 * values;
+    state->depth = depth;
+    state->iterations = iterations;
+    ocrDbCreate(&(state->valuesGuid), (void **) &values, sizeof(u64)*(2UL << depth), 0, NULL_GUID, NO_ALLOC);
+    ocrEdtTemplateCreate(&(state->nodeTemplate), nodeEdt, 3, 3);
+    ocrEdtTemplateCreate(&(state->leafTemplate), leafEdt, 4, 1);
+    ocrEdtTemplateCreate(&(state->driverTemplate), driverEdt, 2, 3);
+    state->graph = NULL_GUID;
+    state->start = now();
+
+    u64 driverParamv[2] = {MODE_REBUILD, 0};
+    ocrGuid_t driverDepv[3] = {stateGuid, state->valuesGuid, NULL_GUID};
+    ocrGuid_t driver;
+    ocrEdtCreate(&driver, state->driverTemplate, EDT_PARAM_DEF, driverParamv, EDT_PARAM_DEF, driverDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
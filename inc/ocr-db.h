@@ -45,6 +45,20 @@ extern "C" {
                                        *   is just being created but does not need to be acquired
                                        *   at the same time (creation for another EDT)
                                        */
+#define DB_PROP_MAP_PRIVATE    ((u16)0x2) /**< ocrDbCreateFromFile(): the data-block is a private
+                                           *   copy-on-write view of the file instead of a
+                                           *   read-only one. Writes never reach the file
+                                           */
+#define DB_PROP_MAP_SEQUENTIAL ((u16)0x4) /**< ocrDbCreateFromFile(): EDTs mostly read the
+                                           *   data-block sequentially (aggressive read-ahead)
+                                           */
+#define DB_PROP_MAP_RANDOM     ((u16)0x8) /**< ocrDbCreateFromFile(): EDTs mostly access the
+                                           *   data-block randomly (no read-ahead)
+                                           */
+#define DB_PROP_SNAPSHOT      ((u16)0x10) /**< ocrDbCreate(): snapshots of the data-block taken
+                                           *   with ocrDbSnapshot() share its memory
+                                           *   until either side writes to it
+                                           */
 
 /**
  * @brief Request the creation of a data-block
@@ -72,12 +86,149 @@ extern "C" {
  *
  * @note The default allocator (NO_ALLOC) will disallow calls to ocrDbMalloc and ocrDbFree.
  * If an allocator is used, part of the data-block's space will be taken up by the
- * allocator's management overhead
+ * allocator's management overhead. With TLSF_ALLOC, this overhead (about 2KB)
+ * sits at the start of the data-block and the memory should only be used
+ * through ocrDbMalloc and ocrDbMallocOffset. ENOMEM is returned if the
+ * data-block is too small to hold the overhead
+ *
+ * @note With DB_PROP_SNAPSHOT, the data-block is mapped outside of the
+ * allocators of the policy domain, in whole pages, and is never evicted
+ *
+ * @note When the policy domain is configured with a 'spilldir', data-blocks
+ * nobody holds are evicted to a file in that directory instead of failing
+ * with ENOMEM. They are read back, possibly at another address, when an
+ * EDT using them runs or when they are acquired again
  *
  **/
 u8 ocrDbCreate(ocrGuid_t *db, void** addr, u64 len, u16 flags,
                ocrGuid_t affinity, ocrInDbAllocator_t allocator);
 
+/**
+ * @brief Request the creation of a data-block mapping a range of a file
+ *
+ * The data-block is backed by the file itself: no memory is allocated or
+ * filled up front and pages are read from the file as EDTs touch them.
+ * When an EDT acquiring the data-block through one of its dependences
+ * becomes ready, the runtime asks the OS to start reading the data-block
+ * in so that the I/O overlaps with other EDTs.
+ *
+ * By default the data-block is read-only and must only be acquired in
+ * DB_MODE_RO. With DB_PROP_MAP_PRIVATE, it can be written but the
+ * modifications are private to the data-block and are never written
+ * back to the file. The file can be closed or removed once this call
+ * returns.
+ *
+ * The data-block is acquired for the calling EDT as with ocrDbCreate().
+ * It cannot be allocated into with ocrDbMalloc().
+ *
+ * @param db        On successful creation, contains the GUID for the DB
+ * @param addr      On successful creation, contains the address of the DB
+ * @param path      File to map
+ * @param offset    Offset of the range in the file
+ * @param len       Size of the range in bytes, 0 for the rest of the file
+ * @param flags     DB_PROP_MAP_PRIVATE, DB_PROP_MAP_SEQUENTIAL or
+ *                  DB_PROP_MAP_RANDOM
+ * @param affinity  GUID to indicate the affinity container of this DB.
+ *
+ * @return a status code on failure and 0 on success. On failure will return one of:
+ *      - EINVAL: the range is empty or does not fit in the file
+ *      - ENOMEM: the file could not be mapped
+ *      - the error of open() if the file cannot be opened (ENOENT, EACCES...)
+ **/
+u8 ocrDbCreateFromFile(ocrGuid_t *db, void** addr, const char* path, u64 offset, u64 len,
+                       u16 flags, ocrGuid_t affinity);
+
+/**
+ * @brief Request the creation of a data-block aliasing a range of another one
+ *
+ * The view is a data-block of its own, with its own GUID, that can be a
+ * dependence of EDTs and be destroyed like any other data-block. Its
+ * memory is the range [offset, offset+len) of the parent: nothing is
+ * copied and writes through the view are visible through the parent.
+ * Views can be created from views.
+ *
+ * The view holds the parent: a parent destroyed with ocrDbDestroy() is
+ * only freed once all its views have been destroyed as well.
+ *
+ * Access modes are accounted for per data-block. EDTs acquiring a view
+ * and its parent or two overlapping views do not exclude each other even
+ * in DB_MODE_EW: use disjoint views to give EDTs separate parts of the
+ * parent.
+ *
+ * The view is acquired for the calling EDT as with ocrDbCreate().
+ *
+ * @param view      On successful creation, contains the GUID for the view
+ * @param addr      On successful creation, contains the address of the view
+ * @param parent    Data-block to alias
+ * @param offset    Offset of the range in the parent
+ * @param len       Size of the range in bytes
+ * @param flags     Same as for ocrDbCreate()
+ *
+ * @return a status code on failure and 0 on success. On failure will return one of:
+ *      - EINVAL: 'parent' is not a data-block or the range is empty or
+ *        does not fit in it
+ *      - EPERM: 'parent' is being destroyed
+ **/
+u8 ocrDbCreateView(ocrGuid_t *view, void** addr, ocrGuid_t parent, u64 offset, u64 len,
+                   u16 flags);
+
+/**
+ * @brief Request the creation of a data-block aliasing a strided 2D region
+ * of another one, such as a tile of a matrix
+ *
+ * The region is made of 'rows' rows of 'rowSize' bytes, the first one
+ * starting at 'offset' in the parent and each following one 'stride'
+ * bytes after the previous one. Row i is at addr + i*stride.
+ *
+ * The view spans from the start of its first row to the end of its last
+ * row, so the bytes between rows, which belong to the rest of the parent,
+ * must not be accessed through it. Otherwise this behaves as
+ * ocrDbCreateView().
+ *
+ * @param view      On successful creation, contains the GUID for the view
+ * @param addr      On successful creation, contains the address of the view
+ * @param parent    Data-block to alias
+ * @param offset    Offset of the first row in the parent
+ * @param rowSize   Size of a row in bytes
+ * @param rows      Number of rows
+ * @param stride    Distance in bytes between the starts of two rows
+ * @param flags     Same as for ocrDbCreate()
+ *
+ * @return a status code on failure and 0 on success. On failure will return one of:
+ *      - EINVAL: 'parent' is not a data-block, the region is empty or
+ *        does not fit in it or 'stride' is less than 'rowSize'
+ *      - EPERM: 'parent' is being destroyed
+ **/
+u8 ocrDbCreateView2D(ocrGuid_t *view, void** addr, ocrGuid_t parent, u64 offset,
+                     u64 rowSize, u64 rows, u64 stride, u16 flags);
+
+/**
+ * @brief Request the creation of a data-block holding a copy of the
+ * current content of another one
+ *
+ * If 'source' was created with DB_PROP_SNAPSHOT (or is itself a snapshot),
+ * nothing is copied up front: the snapshot and the source share their
+ * pages and a page is only copied, by the OS, when one side writes to it.
+ * Taking a snapshot costs a copy of the pages the source wrote since its
+ * previous snapshot at most. Other data-blocks are copied in full.
+ *
+ * The snapshot is independent of the source: either one can be written
+ * or destroyed without affecting the other. It can be snapshotted in turn.
+ * It is acquired for the calling EDT as with ocrDbCreate().
+ *
+ * The calling EDT must have acquired 'source' and nothing must write to
+ * it until the call returns.
+ *
+ * @param snapshot  On successful creation, contains the GUID for the snapshot
+ * @param addr      On successful creation, contains the address of the snapshot
+ * @param source    Data-block to copy
+ *
+ * @return a status code on failure and 0 on success. On failure will return one of:
+ *      - EINVAL: 'source' is not a data-block
+ *      - ENOMEM: the snapshot could not be mapped or allocated
+ **/
+u8 ocrDbSnapshot(ocrGuid_t *snapshot, void** addr, ocrGuid_t source);
+
 /**
  * @brief Request for the destruction of a data-block
  *
@@ -126,6 +277,34 @@ u8 ocrDbDestroy(ocrGuid_t db);
  */
 u8 ocrDbRelease(ocrGuid_t db);
 
+/**
+ * @brief Changes the size of a data-block, like realloc
+ *
+ * The data-block keeps its GUID and its content up to the smaller of
+ * the two sizes. It grows in place when the memory right after it is
+ * free and is moved (and copied) otherwise. The EDT must hold the
+ * data-block and be its only holder: the previous address is invalid
+ * once the call succeeds and EDTs acquiring the data-block afterwards
+ * get the new address and size.
+ *
+ * Data-blocks that are views, file mappings or snapshots cannot be
+ * resized. Data-blocks created with TLSF_ALLOC can only grow; the space
+ * added is given to their heap, whose chunks keep their offsets.
+ *
+ * @param db                DB to resize
+ * @param size              New size in bytes
+ * @param addr              New address of the DB on success, unchanged
+ *                          otherwise
+ *
+ * @return The status of the operation:
+ *      - 0: successful
+ *      - ENOMEM: not enough memory. The DB is unchanged
+ *      - EBUSY: other EDTs hold the DB or the EDT does not hold it
+ *      - EPERM: the DB cannot be resized or is being destroyed
+ *      - EINVAL: db does not refer to a valid data-block or size is invalid
+ */
+u8 ocrDbResize(ocrGuid_t db, u64 size, void** addr);
+
 /**
  * @brief Allocates memory *inside* a data-block in a way similar to malloc
  *
@@ -144,8 +323,6 @@ u8 ocrDbRelease(ocrGuid_t db);
  * @warning The address returned is valid *only* between the innermost
  * ocrAcquire/ocrRelease pair. Use ocrDbMallocOffset to get a more
  * stable 'pointer'
- *
- * @todo Not supported at this point
  */
 u8 ocrDbMalloc(ocrGuid_t guid, u64 size, void** addr);
 
@@ -154,7 +331,9 @@ u8 ocrDbMalloc(ocrGuid_t guid, u64 size, void** addr);
  *
  * This call is very similar to ocrDbMalloc except that it returns
  * the location of the memory allocated as an *offset* from the start
- * of the data-block. This is the preferred method.
+ * of the data-block. This is the preferred method: offsets stay valid
+ * across EDTs and if the data-block is moved or copied, so they can be
+ * used to link objects packed in the same data-block.
  *
  * @param guid              DB to malloc from
  * @param size              Size of the chunk to allocate
@@ -165,7 +344,8 @@ u8 ocrDbMalloc(ocrGuid_t guid, u64 size, void** addr);
  *      - ENOMEM: Not enough space to allocate
  *      - EINVAL: DB does not support allocation
  *
- * @todo Not supported at this point
+ * @note The EDT must have acquired the data-block. Allocations from
+ * several EDTs holding the data-block at the same time are safe.
  */
 u8 ocrDbMallocOffset(ocrGuid_t guid, u64 size, u64* offset);
 
@@ -180,7 +360,10 @@ u8 ocrDbMallocOffset(ocrGuid_t guid, u64 size, u64* offset);
  * ocrDbFreeOffset if allocating and freeing across EDTs for
  * example
  *
- * @todo Not supported at this point
+ * @return The status of the operation:
+ *      - 0: successful
+ *      - EINVAL: DB does not support allocation or 'addr' is
+ *        not in the data-block
  */
 u8 ocrDbFree(ocrGuid_t guid, void* addr);
 
@@ -190,10 +373,29 @@ u8 ocrDbFree(ocrGuid_t guid, void* addr);
  * @param guid              DB to free from
  * @param offset            Offset to free
  *
- * @todo Not supported at this point
+ * @return The status of the operation:
+ *      - 0: successful
+ *      - EINVAL: DB does not support allocation or 'offset' is
+ *        not in the data-block
  */
 u8 ocrDbFreeOffset(ocrGuid_t guid, u64 offset);
 
+/**
+ * @brief Reports the state of the memory data-blocks are allocated from
+ *
+ * The allocators of the policy domain are summed up. Only their free
+ * blocks are visited, which is cheap enough to sample the memory
+ * periodically. A walk also visits the allocated chunks to count them
+ * and checks the consistency of the allocators; it takes time
+ * proportional to the number of data-blocks.
+ *
+ * @param stats             Filled with the state of the memory
+ * @param walk              Also count the allocated chunks
+ *
+ * @return 0 on success
+ */
+u8 ocrDbMemoryStats(ocrMemoryStats_t *stats, bool walk);
+
 /**
  * @brief Copies data between two data-blocks in an asynchronous manner
  *
@@ -209,6 +411,11 @@ u8 ocrDbFreeOffset(ocrGuid_t guid, u64 offset);
  *      used as the source data-block
  *    - if it is a data-block GUID, the EDT is immediately available to run.
  *
+ * The source is acquired in DB_MODE_RO and the destination in DB_MODE_ITW.
+ * Large copies are split in chunks run by the idle workers and copies
+ * larger than the caches use non-temporal stores. Neither data-block may
+ * be destroyed before the completion event is satisfied.
+ *
  * @param destination           Data-block to copy to (must already be created
  *                              and large enough to contain copy)
  * @param destinationOffset     Where to start the copy in the destination (in bytes)
@@ -217,14 +424,12 @@ u8 ocrDbFreeOffset(ocrGuid_t guid, u64 offset);
  * @param size                  How many bytes to copy
  * @param copyType              Reserved
  * @param completionEvt         (Returned) Event that will be satisfied when the
- *                              copy is successful
+ *                              copy is successful (may be NULL)
  *
  * @return 0 on success or the following error codes:
  *    - EINVAL: Invalid values for one of the arguments
- *    - EPERM: Overlapping data-blocks
+ *    - EPERM: Overlapping data-blocks or a read-only file-mapped destination
  *    - ENOMEM: Destination too small to copy into or source too small to copy from
- *
- * @todo Not supported at this point
  */
 u8 ocrDbCopy(ocrGuid_t destination, u64 destinationOffset, ocrGuid_t source,
              u64 sourceOffset, u64 size, u64 copyType, ocrGuid_t * completionEvt);
@@ -150,6 +150,9 @@ typedef struct {
 
 #define EDT_PROP_NONE   ((u16) 0x0) /**< Property bits indicating a regular EDT */
 #define EDT_PROP_FINISH ((u16) 0x1) /**< Property bits indicating a FINISH EDT */
+#define EDT_PROP_INLINE ((u16) 0x2) /**< Property bits indicating a short EDT that the
+                                     * runtime may execute inline on the worker that
+                                     * makes it ready instead of scheduling it */
 
 /**
  * @brief Constant indicating that the number of parameters to an EDT template
@@ -222,7 +225,8 @@ u8 ocrEdtTemplateDestroy(ocrGuid_t guid);
  * @param depv              Values for the GUIDs of the dependences (if known)
  *                          Use ocrAddDependence to add unknown ones or ones with
  *                          a mode other than the default DB_MODE_ITW
- * @param properties        Used to indicate if this is a finish EDT (EDT_PROP_FINISH).
+ * @param properties        Used to indicate if this is a finish EDT (EDT_PROP_FINISH)
+ *                          and/or a short EDT that can be executed inline (EDT_PROP_INLINE).
  *                          Other uses reserved.
  * @param affinity          Affinity container for this EDT. Can be NULL_GUID
  * @param outputEvent       Returned value: If not NULL, will return the GUID
@@ -237,6 +241,43 @@ u8 ocrEdtCreate(ocrGuid_t * guid, ocrGuid_t templateGuid,
                 u32 paramc, u64* paramv, u32 depc, ocrGuid_t *depv,
                 u16 properties, ocrGuid_t affinity, ocrGuid_t *outputEvent);
 
+/**
+ * @brief Creates 'count' independent EDT instances from the same template
+ *
+ * This is the equivalent of calling ocrEdtCreate 'count' times with no
+ * dependences and no output event, but the runtime allocates and
+ * schedules the EDTs as a whole. The EDTs are scheduled as soon as they
+ * are created and are spread over the workers as they become idle.
+ *
+ * The parameters of the i-th EDT (starting at 0) are computed as
+ * paramv[k] + i*paramStride[k], which makes it easy to pass loop indices.
+ *
+ * The EDTs belong to the finish scope of the calling EDT like any other
+ * EDT it creates.
+ *
+ * @param guids             Returned value: If not NULL, array of 'count' GUIDs
+ *                          of the newly created EDTs. These GUIDs cannot be
+ *                          destroyed with ocrEdtDestroy nor used as the
+ *                          destination of a dependence
+ * @param templateGuid      GUID of the template to use for the EDTs. Its 'depc'
+ *                          must be 0 or 'EDT_PARAM_UNK'
+ * @param count             Number of EDTs to create
+ * @param paramc            Number of non-DB 64 bit values, as for ocrEdtCreate
+ * @param paramv            Values of the parameters of the first EDT (copied in)
+ * @param paramStride       Increment of each parameter from one EDT to the
+ *                          next (copied in). If NULL, all the EDTs get paramv
+ * @param properties        Reserved (set to 0). Bulk EDTs cannot be finish EDTs
+ * @param affinity          Affinity container for these EDTs. Can be NULL_GUID
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: 'count' is 0, the template expects dependences,
+ *               'properties' contains EDT_PROP_FINISH or the calling EDT
+ *               is recording a task graph
+ *     - ENOMEM: The EDTs or their GUIDs could not be allocated
+ **/
+u8 ocrEdtCreateBulk(ocrGuid_t * guids, ocrGuid_t templateGuid, u32 count,
+                    u32 paramc, u64* paramv, u64* paramStride,
+                    u16 properties, ocrGuid_t affinity);
+
 /**
  * @brief Destroy an EDT
  *
@@ -308,7 +349,9 @@ typedef enum {
  *
  * @return Status:
  *      - 0: Success
- *      - EINVAL: The slot number is invalid
+ *      - EINVAL: The slot number is invalid or, outside of the recording
+ *                of a task graph, the source or destination is an event
+ *                of a task graph
  *      - ENOPERM: The source and destination GUIDs cannot be linked with
  *                 a dependence
  */
@@ -0,0 +1,119 @@
+/**
+ * @brief Task graph capture and replay API
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __OCR_GRAPH_H__
+#define __OCR_GRAPH_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "ocr-types.h"
+
+/**
+ * @defgroup OCRGraph Task graph capture and replay
+ * @brief APIs to record a DAG of EDTs once and replay it many times
+ *
+ * Iterative applications often build the exact same DAG of EDTs, events
+ * and dependences at each iteration. A task graph records that DAG once,
+ * resolves all its dependences up-front and can then be replayed with
+ * new parameters and data-blocks without creating any runtime object.
+ *
+ * Between ocrGraphBegin() and ocrGraphEnd(), the EDTs and events created
+ * by the calling EDT, and the dependences it adds between them, are
+ * recorded in the graph instead of being run:
+ *     - Events of any kind but OCR_EVENT_LATCH_T can be created. In a graph,
+ *       events behave as sticky events that are reset at each replay.
+ *     - EDTs can be created with or without an output event but cannot be
+ *       finish EDTs.
+ *     - Dependences can only target objects of the graph. Their source must
+ *       be an object of the graph, a data-block or NULL_GUID. The access
+ *       mode of a dependence to an EDT is used at each replay.
+ *     - Events of the graph can be satisfied while recording. The
+ *       satisfaction is then performed at the beginning of each replay.
+ *
+ * Data-blocks used as a dependence source or to satisfy an event are the
+ * graph's inputs, numbered in the order they first appear. They can be
+ * substituted at each replay.
+ *
+ * When replayed, the graph's EDTs run with the dependences that were
+ * recorded. They can use the GUIDs of the graph's events (for instance to
+ * satisfy them) but cannot add dependences to or from them: ocrAddDependence()
+ * returns EINVAL and ocrWait() does not wait for them.
+ *
+ * @{
+ **/
+
+/**
+ * @brief Starts recording a task graph
+ *
+ * Must be called from an EDT. Until ocrGraphEnd() is called, the EDTs, events
+ * and dependences the calling EDT creates are recorded in the graph.
+ *
+ * @param graph            Returned value: GUID of the new graph
+ * @param paramc           Number of leading parameters of each EDT of the graph
+ *                         that are replaced by the parameters given at replay
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: Not called from an EDT or the EDT is already recording a graph
+ **/
+u8 ocrGraphBegin(ocrGuid_t *graph, u32 paramc);
+
+/**
+ * @brief Stops recording a task graph
+ *
+ * The graph's dependence counts are computed and it becomes ready to be
+ * replayed. All the dependence slots of the recorded EDTs must have been
+ * added.
+ *
+ * @param graph            GUID of the graph being recorded by the calling EDT
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: The calling EDT is not recording this graph or an EDT of the
+ *               graph has unconnected dependence slots. In the latter case,
+ *               the recording goes on
+ **/
+u8 ocrGraphEnd(ocrGuid_t graph);
+
+/**
+ * @brief Runs a recorded task graph
+ *
+ * A graph can only be replayed once the previous replay has completed.
+ *
+ * @param graph            GUID of the graph to run
+ * @param paramc           Number of parameters. Must be 0 or the number of
+ *                         parameters given to ocrGraphBegin()
+ * @param paramv           Values replacing the leading parameters of each EDT
+ * @param depc             Number of data-blocks. Must be 0 or the number of
+ *                         inputs of the graph
+ * @param depv             Data-blocks replacing the graph's inputs, in order.
+ *                         When depc is 0, the recorded data-blocks are used
+ * @param completionEvent  Event satisfied with NULL_GUID once all the EDTs of
+ *                         the graph have run (or NULL_GUID)
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: Invalid graph or argument counts
+ *     - EPERM: The graph is being recorded or replayed
+ **/
+u8 ocrGraphReplay(ocrGuid_t graph, u32 paramc, u64 *paramv, u32 depc,
+                  ocrGuid_t *depv, ocrGuid_t completionEvent);
+
+/**
+ * @brief Destroys a task graph and all the EDTs and events it contains
+ *
+ * @param graph            GUID of the graph to destroy
+ * @return 0 on success and an error code on failure:
+ *     - EPERM: The graph is being replayed
+ **/
+u8 ocrGraphDestroy(ocrGuid_t graph);
+
+/**
+ * @}
+ **/
+#ifdef __cplusplus
+}
+#endif
+#endif /* __OCR_GRAPH_H__ */
@@ -63,12 +63,18 @@ void ocrFinalize();
 /**
  * @brief OCR library mode - Waits for an output event to be satisfied
  *
+ * The caller is suspended while the worker it runs on keeps executing
+ * other EDTs. Single events as well as latch events can be waited on.
+ *
  * @warning This call is meant to be called from sequential C code
  * and is *NOT* supported on all implementations of OCR. This call runs
  * contrary to the 'non-blocking EDT' philosophy so use with care
  *
  * @param outputEvent       Event to wait on
  * @return A GUID to the data-block that was used to satisfy the event
+ * (NULL_GUID for latch events), ERROR_GUID if the runtime is shut down
+ * before the event is satisfied or if the event belongs to a task graph
+ * and is not satisfied in its current replay
  */
 ocrGuid_t ocrWait(ocrGuid_t outputEvent);
 
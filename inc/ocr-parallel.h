@@ -0,0 +1,128 @@
+/**
+ * @brief Parallel loop and reduction helpers built on EDTs
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __OCR_PARALLEL_H__
+#define __OCR_PARALLEL_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "ocr-types.h"
+
+/**
+ * @defgroup OCRParallel Parallel loops and reductions
+ * @brief APIs to run a loop or a reduction over an iteration space
+ *
+ * These helpers spare applications from writing the recursive splitting
+ * EDTs and the joins of parallel loops and reductions themselves.
+ *
+ * The iteration space is split lazily: each EDT runs its range 'grain'
+ * iterations at a time and only gives away the upper half of what remains
+ * when some workers are idle. A loop therefore creates few EDTs when all
+ * the workers are busy and spreads out as soon as some are looking for
+ * work.
+ *
+ * Partial results of a reduction are combined pairwise along the
+ * splitting tree, in iteration order, by the EDT that completes a
+ * subtree last. There is no global accumulator or latch.
+ *
+ * The calls are asynchronous: they return once the first EDT has been
+ * created. The EDTs of a loop belong to the finish scope of the calling
+ * EDT. The body and combine functions run inside these EDTs and must
+ * only access memory reachable from 'arg'.
+ *
+ * @{
+ **/
+
+/**
+ * @brief Body of a parallel loop
+ *
+ * @param first            First iteration to run
+ * @param last             Iteration following the last one to run
+ * @param arg              Argument given to ocrParallelFor()
+ **/
+typedef void (*ocrParallelForBody_t)(u64 first, u64 last, void *arg);
+
+/**
+ * @brief Body of a parallel reduction
+ *
+ * @param first            First iteration to reduce
+ * @param last             Iteration following the last one to reduce
+ * @param arg              Argument given to ocrParallelReduce()
+ * @param result           Accumulator to reduce the iterations into. It
+ *                         initially holds the identity value
+ **/
+typedef void (*ocrParallelReduceBody_t)(u64 first, u64 last, void *arg, void *result);
+
+/**
+ * @brief Combines two partial results of a reduction
+ *
+ * @param left             Result of the lower iterations, updated with
+ *                         the combined result
+ * @param right            Result of the following iterations
+ * @param arg              Argument given to ocrParallelReduce()
+ **/
+typedef void (*ocrParallelCombine_t)(void *left, const void *right, void *arg);
+
+/**
+ * @brief Runs 'body' over the iterations [first, last) in parallel
+ *
+ * @param first            First iteration
+ * @param last             Iteration following the last one
+ * @param grain            Number of iterations an EDT runs before checking
+ *                         whether it should split its range. 0 lets the
+ *                         runtime choose
+ * @param body             Function running a range of iterations
+ * @param arg              Argument passed to 'body'
+ * @param completionEvent  Event satisfied with NULL_GUID once all the
+ *                         iterations have run (or NULL_GUID)
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: 'body' is NULL or 'last' is lower than 'first'
+ *     - ENOMEM: The runtime could not allocate the loop or its first EDT
+ **/
+u8 ocrParallelFor(u64 first, u64 last, u64 grain, ocrParallelForBody_t body,
+                  void *arg, ocrGuid_t completionEvent);
+
+/**
+ * @brief Reduces the iterations [first, last) in parallel
+ *
+ * The result is delivered in a data-block of 'size' bytes satisfying
+ * 'completionEvent'. The consumer of that data-block is responsible for
+ * destroying it. If the data-block cannot be created, 'completionEvent'
+ * is satisfied with NULL_GUID instead.
+ *
+ * @param first            First iteration
+ * @param last             Iteration following the last one
+ * @param grain            Number of iterations an EDT reduces before
+ *                         checking whether it should split its range. 0
+ *                         lets the runtime choose
+ * @param body             Function reducing a range of iterations
+ * @param combine          Function combining two partial results. It must
+ *                         be associative but does not need to be commutative
+ * @param identity         Identity value of 'combine' (copied in)
+ * @param size             Size in bytes of a result
+ * @param arg              Argument passed to 'body' and 'combine'
+ * @param completionEvent  Event satisfied with the result data-block
+ * @return 0 on success and an error code on failure:
+ *     - EINVAL: A function, 'identity' or 'completionEvent' is missing,
+ *               'size' is 0 or 'last' is lower than 'first'
+ *     - ENOMEM: The runtime could not allocate the loop or its first EDT
+ **/
+u8 ocrParallelReduce(u64 first, u64 last, u64 grain, ocrParallelReduceBody_t body,
+                     ocrParallelCombine_t combine, const void *identity, u64 size,
+                     void *arg, ocrGuid_t completionEvent);
+
+/**
+ * @}
+ **/
+#ifdef __cplusplus
+}
+#endif
+#endif /* __OCR_PARALLEL_H__ */
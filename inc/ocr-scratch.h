@@ -0,0 +1,58 @@
+/**
+ * @brief Scratch memory for the temporary buffers of EDTs
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __OCR_SCRATCH_H__
+#define __OCR_SCRATCH_H__
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "ocr-types.h"
+
+/**
+ * @defgroup OCRScratch Scratch memory
+ * @brief Temporary memory that lives until the EDT returns
+ *
+ * Each worker hands out scratch memory by bumping a pointer in an arena
+ * of its own: there is no lock, no GUID and no free. Everything an EDT
+ * allocated is freed at once when it returns. This suits the short-lived
+ * buffers EDT bodies need better than malloc, which is shared by all the
+ * workers, or than a data-block.
+ *
+ * On a single worker, an allocation costs about a third of a malloc/free
+ * pair and a thirtieth of a data-block create/destroy: see
+ * examples/scratch.
+ *
+ * @{
+ **/
+
+/**
+ * @brief Allocates scratch memory for the calling EDT
+ *
+ * The memory is not initialized and is aligned on 16 bytes. It is
+ * freed when the EDT returns and must not be given to other EDTs:
+ * use a data-block for data that outlives the EDT.
+ *
+ * @param size              Size of the memory in bytes
+ * @param addr              Address of the memory or NULL on failure
+ *
+ * @return The status of the operation:
+ *      - 0: successful
+ *      - ENOMEM: not enough memory
+ **/
+u8 ocrScratchMalloc(u64 size, void** addr);
+
+/**
+ * @}
+ **/
+#ifdef __cplusplus
+}
+#endif
+#endif /* __OCR_SCRATCH_H__ */
@@ -53,10 +53,39 @@ typedef intptr_t ocrGuid_t; /**< GUID type */
  * within a data-block
  */
 typedef enum {
-    NO_ALLOC = 0 /**< No allocation inside data-blocks */
+    NO_ALLOC = 0,   /**< No allocation inside data-blocks */
+    TLSF_ALLOC = 1  /**< TLSF heap over the data-block's memory */
     /* Add others */
 } ocrInDbAllocator_t;
 
+/**
+ * @brief Number of size classes in the histograms of ocrMemoryStats_t.
+ * Class i counts the blocks of 2^i to 2^(i+1)-1 bytes; the last one
+ * also counts all the larger blocks
+ */
+#define OCR_MEMORY_STATS_CLASSES 40
+
+/**
+ * @brief State of the memory data-blocks are allocated from
+ *
+ * The fragmentation is the part of the free memory that a single
+ * allocation cannot get: an allocation can fail with ENOMEM while
+ * freeSize is large if the fragmentation is high as well.
+ */
+typedef struct {
+    u64 totalSize;      /**< Bytes managed by the allocators */
+    u64 growableSize;   /**< Bytes the allocators can still add to totalSize, (u64)-1 for no bound */
+    u64 usedSize;       /**< Bytes not free, meta-data of the allocators included */
+    u64 freeSize;       /**< Bytes in free blocks */
+    u64 largestFree;    /**< Largest free block: the most one allocation can get */
+    u64 fragmentation;  /**< Part of freeSize not in the largest free block, in 1/1000 */
+    u64 freeCount;      /**< Free blocks */
+    u64 freeHistogram[OCR_MEMORY_STATS_CLASSES];
+    u64 usedCount;      /**< Allocated chunks, only counted by a walk */
+    u64 usedHistogram[OCR_MEMORY_STATS_CLASSES]; /**< Only filled by a walk */
+    u64 errors;         /**< Inconsistencies found by a walk */
+} ocrMemoryStats_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,9 @@ extern "C" {
 #include "ocr-types.h"
 #include "ocr-db.h"
 #include "ocr-edt.h"
+#include "ocr-graph.h"
+#include "ocr-parallel.h"
+#include "ocr-scratch.h"
 #include "compat.h"
 
 /**
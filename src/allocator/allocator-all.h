@@ -18,23 +18,37 @@
 
 typedef enum _allocatorType_t {
     allocatorTlsf_id,
+    allocatorArena_id,
+    allocatorSlab_id,
     allocatorMax_id
 } allocatorType_t;
 
 const char * allocator_types[] = {
     "tlsf",
+    "arena",
+    "slab",
     NULL
 };
 
 // TLSF allocator
 #include "allocator/tlsf/tlsf-allocator.h"
 
+// TLSF arena per worker
+#include "allocator/arena/arena-allocator.h"
+
+// Size-class slabs in front of TLSF
+#include "allocator/slab/slab-allocator.h"
+
 // Add other allocators using the same pattern as above
 
 inline ocrAllocatorFactory_t *newAllocatorFactory(allocatorType_t type, ocrParamList_t *typeArg) {
     switch(type) {
     case allocatorTlsf_id:
         return newAllocatorFactoryTlsf(typeArg);
+    case allocatorArena_id:
+        return newAllocatorFactoryArena(typeArg);
+    case allocatorSlab_id:
+        return newAllocatorFactorySlab(typeArg);
     case allocatorMax_id:
     default:
         ASSERT(0);
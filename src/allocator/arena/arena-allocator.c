@@ -0,0 +1,238 @@
+/**
+ * @brief Allocator splitting its memory in one TLSF arena per worker
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/arena/arena-allocator.h"
+#include "allocator/tlsf/tlsf-allocator.h"
+#include "debug.h"
+#include "ocr-macros.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#define DEBUG_TYPE ALLOCATOR
+
+#define ARENA_CACHE_LINE 64
+
+// The arenas take 1/ARENA_SPLIT_RATIO of the memory, the shared pool the rest
+#define ARENA_SPLIT_RATIO 4
+
+// Requests larger than 1/ARENA_LARGE_RATIO of an arena go to the shared pool
+#define ARENA_LARGE_RATIO 4
+
+/******************************************************/
+/* ARENAS                                             */
+/******************************************************/
+
+static void arenaLock(ocrAllocatorArenaPool_t *arena) {
+    while(!__sync_bool_compare_and_swap(&(arena->lock), 0, 1)) ;
+}
+
+static void arenaUnlock(ocrAllocatorArenaPool_t *arena) {
+    __sync_lock_release(&(arena->lock));
+}
+
+// Arena of the calling worker. Threads that are not workers of the
+// policy domain share the arenas of the workers
+static u64 arenaOfCaller(ocrAllocatorArena_t *rself) {
+    return getCurrentWorkerContext()->sourceId % rself->arenaCount;
+}
+
+// Index of the arena of 'address', arenaCount for the shared pool
+static u64 arenaOfAddress(ocrAllocatorArena_t *rself, u64 address) {
+    ASSERT(address >= rself->addr && address < rself->addr + rself->totalSize);
+    u64 idx = (address - rself->addr)/rself->arenaSize;
+    return (idx < rself->arenaCount) ? idx : rself->arenaCount;
+}
+
+// Returns to the pool the chunks other workers freed. The arena must be locked
+static void arenaDrain(ocrAllocatorArenaPool_t *arena) {
+    if(arena->remoteFrees == 0) {
+        return;
+    }
+    u64 chunk = __sync_lock_test_and_set(&(arena->remoteFrees), 0);
+    while(chunk != 0) {
+        u64 next = *(u64*)chunk;
+        tlsfPoolFree(arena->pool, chunk);
+        chunk = next;
+    }
+}
+
+static u64 arenaMalloc(ocrAllocatorArenaPool_t *arena, u64 size) {
+    arenaLock(arena);
+    arenaDrain(arena);
+    u64 result = tlsfPoolMalloc(arena->pool, size);
+    arenaUnlock(arena);
+    return result;
+}
+
+/******************************************************/
+/* OCR ALLOCATOR ARENA                                */
+/******************************************************/
+
+static void arenaDestruct(ocrAllocator_t *self) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    if(self->memoryCount)
+        self->memories[0]->fctPtrs->free(self->memories[0], (void*)rself->addr);
+    free(rself->arenas);
+    free(self->memories);
+
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t *orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->type = PD_MSG_GUID_REL;
+    pd->inform(pd, self->guid, ctx);
+    ctx->destruct(ctx);
+    free(rself);
+}
+
+static void arenaStart(ocrAllocator_t *self, ocrPolicyDomain_t * PD) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    ASSERT(self->memoryCount == 1);
+    rself->addr = (u64)(self->memories[0]->fctPtrs->allocate(self->memories[0], rself->totalSize));
+    ASSERT(rself->addr);
+
+    rself->arenaCount = (PD->workerCount > 0) ? PD->workerCount : 1;
+    rself->arenaSize = (rself->totalSize/ARENA_SPLIT_RATIO/rself->arenaCount) & ~((u64)ARENA_CACHE_LINE - 1);
+    RESULT_ASSERT(posix_memalign((void**)&(rself->arenas), ARENA_CACHE_LINE,
+                                 (rself->arenaCount + 1)*sizeof(ocrAllocatorArenaPool_t)), ==, 0);
+    u64 i;
+    for(i = 0; i <= rself->arenaCount; ++i) {
+        ocrAllocatorArenaPool_t *arena = &(rself->arenas[i]);
+        arena->lock = 0;
+        arena->pool = rself->addr + i*rself->arenaSize;
+        arena->remoteFrees = 0;
+        RESULT_ASSERT(tlsfPoolInit(arena->pool, (i < rself->arenaCount) ? rself->arenaSize :
+                                   rself->totalSize - i*rself->arenaSize), ==, 0);
+    }
+    DPRINTF(DEBUG_LVL_INFO, "Split 0x%"PRIx64" bytes @ 0x%"PRIx64" in %"PRIu64" arenas of 0x%"PRIx64" bytes\n",
+            rself->totalSize, rself->addr, rself->arenaCount, rself->arenaSize);
+}
+
+static void arenaStop(ocrAllocator_t *self) { }
+
+static void* arenaAllocate(ocrAllocator_t *self, u64 size) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    // A freed chunk must be able to hold the link of the remote-free stack
+    if(size < sizeof(u64)) {
+        size = sizeof(u64);
+    }
+    u64 mine = arenaOfCaller(rself);
+    u64 result = 0;
+    if(size <= rself->arenaSize/ARENA_LARGE_RATIO) {
+        result = arenaMalloc(&(rself->arenas[mine]), size);
+    }
+    if(result == 0) {
+        result = arenaMalloc(&(rself->arenas[rself->arenaCount]), size);
+    }
+    u64 i;
+    for(i = 1; (result == 0) && (i < rself->arenaCount); ++i) {
+        // Borrow from the next arenas
+        result = arenaMalloc(&(rself->arenas[(mine + i) % rself->arenaCount]), size);
+    }
+    return (void*)result;
+}
+
+static void arenaDeallocate(ocrAllocator_t *self, void* address) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    u64 owner = arenaOfAddress(rself, (u64)address);
+    ocrAllocatorArenaPool_t *arena = &(rself->arenas[owner]);
+    if((owner == arenaOfCaller(rself)) || (owner == rself->arenaCount)) {
+        arenaLock(arena);
+        tlsfPoolFree(arena->pool, (u64)address);
+        arenaUnlock(arena);
+    } else {
+        u64 head;
+        do {
+            head = arena->remoteFrees;
+            *(u64*)address = head;
+        } while(!__sync_bool_compare_and_swap(&(arena->remoteFrees), head, (u64)address));
+    }
+}
+
+// Resizes within the arena of the chunk, whoever calls
+static void* arenaReallocate(ocrAllocator_t *self, void* address, u64 size) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    if(address == NULL) {
+        return arenaAllocate(self, size);
+    }
+    if((size > 0) && (size < sizeof(u64))) {
+        size = sizeof(u64);
+    }
+    ocrAllocatorArenaPool_t *arena = &(rself->arenas[arenaOfAddress(rself, (u64)address)]);
+    arenaLock(arena);
+    arenaDrain(arena);
+    void* toReturn = (void*)tlsfPoolRealloc(arena->pool, (u64)address, size);
+    arenaUnlock(arena);
+    return toReturn;
+}
+
+static u8 arenaGetStats(ocrAllocator_t *self, ocrMemoryStats_t *stats, bool walk) {
+    ocrAllocatorArena_t *rself = (ocrAllocatorArena_t*)self;
+    u64 i;
+    for(i = 0; i <= rself->arenaCount; ++i) {
+        ocrAllocatorArenaPool_t *arena = &(rself->arenas[i]);
+        arenaLock(arena);
+        arenaDrain(arena);
+        tlsfPoolStats(arena->pool, (i < rself->arenaCount) ? rself->arenaSize :
+                      rself->totalSize - i*rself->arenaSize, stats, walk);
+        arenaUnlock(arena);
+    }
+    return 0;
+}
+
+// Method to create the arena allocator
+static ocrAllocator_t * newAllocatorArena(ocrAllocatorFactory_t * factory, ocrParamList_t *perInstance) {
+
+    ocrAllocatorArena_t *result = (ocrAllocatorArena_t*)
+        checkedMalloc(result, sizeof(ocrAllocatorArena_t));
+    result->base.guid = UNINITIALIZED_GUID;
+    guidify(getCurrentPD(), (u64) result, &(result->base.guid), OCR_GUID_ALLOCATOR);
+    result->base.fctPtrs = &(factory->allocFcts);
+    result->base.memories = NULL;
+    result->base.memoryCount = 0;
+
+    paramListAllocatorInst_t *perInstanceReal = (paramListAllocatorInst_t*)perInstance;
+
+    result->addr = 0ULL;
+    result->totalSize = perInstanceReal->size;
+    // The arenas are laid out when the workers are known
+    result->arenaSize = 0;
+    result->arenaCount = 0;
+    result->arenas = NULL;
+
+    result->base.module.mapFct = NULL;
+
+    return (ocrAllocator_t*)result;
+}
+
+/******************************************************/
+/* OCR ALLOCATOR ARENA FACTORY                        */
+/******************************************************/
+
+static void destructAllocatorFactoryArena(ocrAllocatorFactory_t * factory) {
+    free(factory);
+}
+
+ocrAllocatorFactory_t * newAllocatorFactoryArena(ocrParamList_t *perType) {
+    ocrAllocatorFactory_t* base = (ocrAllocatorFactory_t*)
+        checkedMalloc(base, sizeof(ocrAllocatorFactoryArena_t));
+    base->instantiate = newAllocatorArena;
+    base->destruct =  &destructAllocatorFactoryArena;
+    base->allocFcts.destruct = &arenaDestruct;
+    base->allocFcts.start = &arenaStart;
+    base->allocFcts.stop = &arenaStop;
+    base->allocFcts.allocate = &arenaAllocate;
+    base->allocFcts.free = &arenaDeallocate;
+    base->allocFcts.reallocate = &arenaReallocate;
+    base->allocFcts.getStats = &arenaGetStats;
+    return base;
+}
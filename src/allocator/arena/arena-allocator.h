@@ -0,0 +1,55 @@
+/**
+ * @brief Allocator splitting its memory in one TLSF arena per worker
+ *
+ * Each worker allocates from and frees to its own arena, so workers do
+ * not serialize on a single allocator lock. A chunk freed by a worker
+ * other than the owner of its arena is pushed on the arena's remote-free
+ * stack, which is drained by the next worker working in that arena.
+ *
+ * Most of the memory is kept in a pool shared by all the workers for
+ * the chunks too large for an arena. A worker whose arena is exhausted
+ * allocates from the shared pool, then borrows from the other arenas.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __ALLOCATOR_ARENA_H__
+#define __ALLOCATOR_ARENA_H__
+
+#include "ocr-allocator.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+typedef struct {
+    ocrAllocatorFactory_t base;
+} ocrAllocatorFactoryArena_t;
+
+/**
+ * @brief One arena, alone on its cache line
+ *
+ * The lock is only contended when another worker borrows from the arena
+ */
+typedef struct {
+    volatile u32 lock;
+    u32 _padding;
+    u64 pool;                   /**< Start of the arena's TLSF pool */
+    volatile u64 remoteFrees;   /**< Chunks freed by other workers, linked
+                                 * through their first word. 0 ends the stack */
+    u64 _padding2[5];
+} ocrAllocatorArenaPool_t;
+
+typedef struct {
+    ocrAllocator_t base;
+    u64 addr, totalSize;
+    u64 arenaSize;              /**< Bytes of memory of each arena */
+    u64 arenaCount;             /**< One arena per worker of the policy domain */
+    ocrAllocatorArenaPool_t *arenas; /**< The arenas followed by the shared pool */
+} ocrAllocatorArena_t;
+
+extern ocrAllocatorFactory_t* newAllocatorFactoryArena(ocrParamList_t *perType);
+
+#endif /* __ALLOCATOR_ARENA_H__ */
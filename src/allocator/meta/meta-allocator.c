@@ -0,0 +1,276 @@
+/**
+ * @brief Allocator of the runtime's own objects
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/meta/meta-allocator.h"
+#include "debug.h"
+#include "ocr-macros.h"
+#include "ocr-mem-target.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-utils.h"
+#include "ocr-worker.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG_TYPE ALLOCATOR
+
+#define META_CACHE_LINE 64
+
+#define META_CHUNK_SIZE (64*1024)
+
+// Bytes of blocks a worker hands to or takes from the shared free-list at once
+#define META_BATCH_SIZE (4*1024)
+
+// Header of the blocks that come from calloc
+#define META_LARGE ((u64)-1)
+
+/******************************************************/
+/* SIZE CLASSES                                       */
+/******************************************************/
+
+// Each block starts with a header holding its size class
+static u32 metaClassOfSize(u64 size) {
+    size += sizeof(u64);
+    if(size <= (1ULL << META_MIN_BLOCK_LOG2)) {
+        return 0;
+    }
+    return fls64(size - 1) + 1 - META_MIN_BLOCK_LOG2;
+}
+
+static u64 metaBlockSize(u32 sizeClass) {
+    return 1ULL << (sizeClass + META_MIN_BLOCK_LOG2);
+}
+
+static u32 metaBatch(u32 sizeClass) {
+    return META_BATCH_SIZE/metaBlockSize(sizeClass);
+}
+
+static ocrPolicyCtx_t * metaContextOfCaller() {
+    return (getCurrentWorkerContext != NULL) ? getCurrentWorkerContext() : NULL;
+}
+
+// The context of a worker knows its policy domain, which saves a lookup
+static ocrPolicyDomain_t * metaPDOfCaller(ocrPolicyCtx_t *ctx) {
+    if((ctx != NULL) && (ctx->PD != NULL)) {
+        return ctx->PD;
+    }
+    return (getCurrentPD != NULL) ? getCurrentPD() : NULL;
+}
+
+// Free-lists of the calling worker, NULL if the caller is not one of the
+// workers of the policy domain (the thread bringing the runtime up)
+static ocrMetaAllocCache_t * metaCacheOfCaller(ocrMetaAlloc_t *self, ocrPolicyCtx_t *ctx) {
+    if((ctx == NULL) || (ctx->PD != self->pd) || (ctx->sourceId >= self->cacheCount) ||
+       (self->pd->workers[ctx->sourceId]->guid != ctx->sourceObj)) {
+        return NULL;
+    }
+    return &(self->caches[ctx->sourceId]);
+}
+
+static void metaLock(volatile u32 *lock) {
+    while(!__sync_bool_compare_and_swap(lock, 0, 1)) ;
+}
+
+static void metaUnlock(volatile u32 *lock) {
+    __sync_lock_release(lock);
+}
+
+/******************************************************/
+/* CHUNKS                                             */
+/******************************************************/
+
+// Carves up to 'count' blocks of 'sizeClass' from the chunks and links
+// them. Returns the first one, 0 if the memory target is full
+static u64 metaCarve(ocrMetaAlloc_t *self, u32 sizeClass, u32 *count) {
+    u64 blockSize = metaBlockSize(sizeClass);
+    metaLock(&(self->chunkLock));
+    if(self->bump + blockSize > self->bumpEnd) {
+        u64 chunk = (u64)self->memory->fctPtrs->allocate(self->memory, META_CHUNK_SIZE);
+        if(chunk == 0) {
+            metaUnlock(&(self->chunkLock));
+            return 0;
+        }
+        *(u64*)chunk = self->chunks;
+        self->chunks = chunk;
+        // The link to the next chunk takes the first 16 bytes
+        self->bump = chunk + 2*sizeof(u64);
+        self->bumpEnd = chunk + META_CHUNK_SIZE;
+        DPRINTF(DEBUG_LVL_VERB, "Metadata chunk @ 0x%"PRIx64"\n", chunk);
+    }
+    u64 available = (self->bumpEnd - self->bump)/blockSize;
+    if(*count > available) {
+        *count = available;
+    }
+    u64 head = self->bump;
+    self->bump += (*count)*blockSize;
+    metaUnlock(&(self->chunkLock));
+
+    u64 block;
+    for(block = head; block < head + (*count - 1)*blockSize; block += blockSize) {
+        *(u64*)block = block + blockSize;
+    }
+    *(u64*)block = 0;
+    return head;
+}
+
+/******************************************************/
+/* FREE-LISTS                                         */
+/******************************************************/
+
+// Takes up to 'count' blocks from the shared free-list of 'sizeClass'
+// or, failing that, from the chunks
+static u64 metaTake(ocrMetaAlloc_t *self, u32 sizeClass, u32 *count) {
+    ocrMetaAllocClass_t *shared = &(self->classes[sizeClass]);
+    if(shared->count > 0) {
+        metaLock(&(shared->lock));
+        u64 head = shared->free;
+        u64 tail = head;
+        u32 taken = 0;
+        if(head != 0) {
+            taken = 1;
+            while((taken < *count) && (*(u64*)tail != 0)) {
+                tail = *(u64*)tail;
+                ++taken;
+            }
+            shared->free = *(u64*)tail;
+            shared->count -= taken;
+            *(u64*)tail = 0;
+        }
+        metaUnlock(&(shared->lock));
+        if(head != 0) {
+            *count = taken;
+            return head;
+        }
+    }
+    return metaCarve(self, sizeClass, count);
+}
+
+// Puts the 'count' blocks linked from 'head' to 'tail' on the shared free-list
+static void metaGive(ocrMetaAlloc_t *self, u32 sizeClass, u64 head, u64 tail, u32 count) {
+    ocrMetaAllocClass_t *shared = &(self->classes[sizeClass]);
+    metaLock(&(shared->lock));
+    *(u64*)tail = shared->free;
+    shared->free = head;
+    shared->count += count;
+    metaUnlock(&(shared->lock));
+}
+
+static u64 metaAllocBlock(ocrMetaAlloc_t *self, ocrPolicyCtx_t *ctx, u32 sizeClass) {
+    ocrMetaAllocCache_t *cache = metaCacheOfCaller(self, ctx);
+    u32 count;
+    if(cache == NULL) {
+        count = 1;
+        return metaTake(self, sizeClass, &count);
+    }
+    if(cache->free[sizeClass] == 0) {
+        count = metaBatch(sizeClass);
+        cache->free[sizeClass] = metaTake(self, sizeClass, &count);
+        if(cache->free[sizeClass] == 0) {
+            return 0;
+        }
+        cache->count[sizeClass] = count;
+    }
+    u64 block = cache->free[sizeClass];
+    cache->free[sizeClass] = *(u64*)block;
+    --cache->count[sizeClass];
+    return block;
+}
+
+static void metaFreeBlock(ocrMetaAlloc_t *self, ocrPolicyCtx_t *ctx, u32 sizeClass, u64 block) {
+    ocrMetaAllocCache_t *cache = metaCacheOfCaller(self, ctx);
+    if(cache == NULL) {
+        metaGive(self, sizeClass, block, block, 1);
+        return;
+    }
+    *(u64*)block = cache->free[sizeClass];
+    cache->free[sizeClass] = block;
+    ++cache->count[sizeClass];
+    // Keep a batch for the next allocations, hand the rest over
+    u32 batch = metaBatch(sizeClass);
+    if(cache->count[sizeClass] >= 2*batch) {
+        u64 head = cache->free[sizeClass];
+        u64 tail = head;
+        u32 i;
+        for(i = 1; i < batch; ++i) {
+            tail = *(u64*)tail;
+        }
+        cache->free[sizeClass] = *(u64*)tail;
+        cache->count[sizeClass] -= batch;
+        metaGive(self, sizeClass, head, tail, batch);
+    }
+}
+
+/******************************************************/
+/* OCR METADATA ALLOCATOR                             */
+/******************************************************/
+
+ocrMetaAlloc_t * newMetaAlloc(ocrPolicyDomain_t *pd) {
+    if(pd->memoryCount == 0) {
+        return NULL;
+    }
+    ocrMetaAlloc_t *self = (ocrMetaAlloc_t*) checkedMalloc(self, sizeof(ocrMetaAlloc_t));
+    self->pd = pd;
+    self->memory = pd->memories[0];
+    self->chunkLock = 0;
+    self->chunks = 0;
+    self->bump = self->bumpEnd = 0;
+    self->cacheCount = pd->workerCount;
+    RESULT_ASSERT(posix_memalign((void**)&(self->caches), META_CACHE_LINE,
+                                 self->cacheCount*sizeof(ocrMetaAllocCache_t)), ==, 0);
+    memset(self->caches, 0, self->cacheCount*sizeof(ocrMetaAllocCache_t));
+    DPRINTF(DEBUG_LVL_INFO, "Metadata allocator for %"PRIu64" workers\n", self->cacheCount);
+    return self;
+}
+
+void destructMetaAlloc(ocrMetaAlloc_t *self) {
+    u64 chunk = self->chunks;
+    while(chunk != 0) {
+        u64 next = *(u64*)chunk;
+        self->memory->fctPtrs->free(self->memory, (void*)chunk);
+        chunk = next;
+    }
+    free(self->caches);
+    free(self);
+}
+
+void * metaMalloc(u64 size) {
+    ocrPolicyCtx_t *ctx = metaContextOfCaller();
+    ocrPolicyDomain_t *pd = metaPDOfCaller(ctx);
+    u64 *block = NULL;
+    if((pd != NULL) && (pd->metaAlloc != NULL) && (size + sizeof(u64) <= META_MAX_BLOCK)) {
+        u32 sizeClass = metaClassOfSize(size);
+        block = (u64*) metaAllocBlock(pd->metaAlloc, ctx, sizeClass);
+        if(block != NULL) {
+            block[0] = sizeClass;
+            memset(block + 1, 0, size);
+            return block + 1;
+        }
+    }
+    checkedMalloc(block, size + sizeof(u64));
+    block[0] = META_LARGE;
+    return block + 1;
+}
+
+void metaFree(void *ptr) {
+    if(ptr == NULL) {
+        return;
+    }
+    u64 *block = ((u64*)ptr) - 1;
+    if(block[0] == META_LARGE) {
+        free(block);
+        return;
+    }
+    ocrPolicyCtx_t *ctx = metaContextOfCaller();
+    ocrPolicyDomain_t *pd = metaPDOfCaller(ctx);
+    ASSERT(block[0] < META_CLASS_COUNT);
+    ASSERT(pd->metaAlloc != NULL);
+    metaFreeBlock(pd->metaAlloc, ctx, (u32)block[0], (u64)block);
+}
@@ -0,0 +1,98 @@
+/**
+ * @brief Allocator of the runtime's own objects
+ *
+ * Tasks, events, data-block descriptors, GUID entries, locks and the
+ * other small objects the runtime creates and destroys for every EDT
+ * are allocated here rather than with malloc. Each object type has a
+ * fixed size, so the pools are kept per size class: requests are
+ * rounded up to a power of two between META_MIN_BLOCK and
+ * META_MAX_BLOCK bytes, header included. Each worker keeps its own
+ * free-lists and only exchanges batches of blocks with the free-lists
+ * shared by all the workers. Blocks are carved from chunks allocated in
+ * the first memory target of the policy domain.
+ *
+ * Larger requests, and the ones made while no policy domain has its
+ * metadata allocator running (when the runtime is brought up and torn
+ * down), fall back to calloc. metaFree() tells them apart from the
+ * header of the block.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __ALLOCATOR_META_H__
+#define __ALLOCATOR_META_H__
+
+#include "ocr-policy-domain.h"
+#include "ocr-types.h"
+
+#define META_MIN_BLOCK_LOG2 4
+#define META_MAX_BLOCK_LOG2 10
+#define META_MAX_BLOCK (1ULL << META_MAX_BLOCK_LOG2)
+#define META_CLASS_COUNT (META_MAX_BLOCK_LOG2 - META_MIN_BLOCK_LOG2 + 1)
+
+/**
+ * @brief Free-lists of a worker, alone on its cache lines
+ *
+ * Free blocks are linked through their first word. 0 ends a list
+ */
+typedef struct {
+    u64 free[META_CLASS_COUNT];
+    u32 count[META_CLASS_COUNT];
+    u8 _padding[128 - META_CLASS_COUNT*(sizeof(u64) + sizeof(u32))];
+} ocrMetaAllocCache_t;
+
+/**
+ * @brief Free-list of a size class shared by all the workers
+ */
+typedef struct {
+    volatile u32 lock;
+    u32 count;
+    u64 free;
+} ocrMetaAllocClass_t;
+
+typedef struct _ocrMetaAlloc_t {
+    ocrPolicyDomain_t *pd;
+    ocrMemTarget_t *memory;     /**< Memory target the chunks come from */
+    volatile u32 chunkLock;     /**< Protects the fields of the chunks below */
+    u64 chunks;                 /**< Chunks allocated, linked through their first word */
+    u64 bump, bumpEnd;          /**< Part of the last chunk not carved yet */
+    u64 cacheCount;             /**< One set of free-lists per worker */
+    ocrMetaAllocCache_t *caches;
+    ocrMetaAllocClass_t classes[META_CLASS_COUNT];
+} ocrMetaAlloc_t;
+
+/**
+ * @brief Creates the metadata allocator of a policy domain whose
+ * workers and memory targets are set up
+ *
+ * @return NULL if the policy domain has no memory target
+ */
+ocrMetaAlloc_t * newMetaAlloc(ocrPolicyDomain_t *pd);
+
+/**
+ * @brief Gives the chunks back to the memory target
+ *
+ * Blocks still allocated become invalid: the policy domain must clear
+ * its 'metaAlloc' first and only destroy it once the objects allocated
+ * while it was running are freed.
+ */
+void destructMetaAlloc(ocrMetaAlloc_t *self);
+
+/**
+ * @brief Allocates a zero-filled runtime object of 'size' bytes
+ *
+ * Uses the metadata allocator of the current policy domain when it has
+ * one running. The result is aligned on 8 bytes
+ */
+void * metaMalloc(u64 size);
+
+/**
+ * @brief Frees an object allocated with metaMalloc(). NULL is ignored
+ */
+void metaFree(void *ptr);
+
+#endif /* __ALLOCATOR_META_H__ */
@@ -0,0 +1,86 @@
+/**
+ * @brief Bump-pointer allocator of the scratch memory of EDTs
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/scratch/scratch-allocator.h"
+#include "debug.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#define DEBUG_TYPE ALLOCATOR
+
+// Chunks larger than this are given back rather than kept aside
+#define SCRATCH_SPARE_MAX_SIZE (4*1024*1024)
+
+static u64 scratchAlign(u64 value) {
+    return (value + SCRATCH_ALIGN - 1) & ~((u64)SCRATCH_ALIGN - 1);
+}
+
+// Starts a new chunk that can hold 'size' bytes
+static bool scratchGrow(ocrScratch_t *self, u64 size) {
+    ocrScratchChunk_t *chunk = self->spare;
+    if((chunk != NULL) && (chunk->size >= size)) {
+        self->spare = NULL;
+    } else {
+        u64 chunkSize = SCRATCH_CHUNK_SIZE - sizeof(ocrScratchChunk_t);
+        if(size > chunkSize) {
+            if(size > ((u64)-1)/2) {
+                return false;
+            }
+            chunkSize = scratchAlign(size);
+        }
+        if(posix_memalign((void**)&chunk, SCRATCH_ALIGN, sizeof(ocrScratchChunk_t) + chunkSize) != 0) {
+            return false;
+        }
+        chunk->size = chunkSize;
+        DPRINTF(DEBUG_LVL_VERB, "Scratch chunk of %"PRIu64" bytes @ 0x%"PRIx64"\n", chunkSize, (u64)chunk);
+    }
+    chunk->prev = self->chunk;
+    self->chunk = chunk;
+    self->bump = (u64)(chunk + 1);
+    self->end = self->bump + chunk->size;
+    return true;
+}
+
+void * scratchMalloc(ocrScratch_t *self, u64 size) {
+    u64 start = scratchAlign(self->bump);
+    if((self->chunk == NULL) || (size > self->end - start)) {
+        if(!scratchGrow(self, size)) {
+            return NULL;
+        }
+        start = self->bump;
+    }
+    self->bump = start + size;
+    return (void*)start;
+}
+
+void scratchRollBack(ocrScratch_t *self, ocrScratchMark_t mark) {
+    while(self->chunk != mark.chunk) {
+        ocrScratchChunk_t *chunk = self->chunk;
+        self->chunk = chunk->prev;
+        // Keep the largest chunk for the next EDTs
+        if((chunk->size <= SCRATCH_SPARE_MAX_SIZE) &&
+           ((self->spare == NULL) || (self->spare->size < chunk->size))) {
+            free(self->spare);
+            self->spare = chunk;
+        } else {
+            free(chunk);
+        }
+    }
+    self->bump = mark.bump;
+    self->end = (self->chunk == NULL) ? 0 : ((u64)(self->chunk + 1) + self->chunk->size);
+}
+
+void scratchDestruct(ocrScratch_t *self) {
+    ocrScratchMark_t empty = { NULL, 0 };
+    scratchRollBack(self, empty);
+    free(self->spare);
+    self->spare = NULL;
+}
@@ -0,0 +1,79 @@
+/**
+ * @brief Bump-pointer allocator of the scratch memory of EDTs
+ *
+ * Each worker execution stack has its own scratch arena: EDTs allocate
+ * from it without any lock and never free. The worker takes a mark
+ * before running an EDT and rolls the arena back to it once the EDT
+ * returns. EDTs running on one stack are strictly nested (an EDT that
+ * waits suspends its whole stack), so rolling back never releases the
+ * memory of an EDT still running.
+ *
+ * The memory comes in chunks allocated with malloc. Rolling back keeps
+ * one chunk aside, so that an EDT allocating past the first chunk does
+ * not go back to malloc every time it runs.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __ALLOCATOR_SCRATCH_H__
+#define __ALLOCATOR_SCRATCH_H__
+
+#include "ocr-types.h"
+
+#define SCRATCH_CHUNK_SIZE (64*1024)
+
+// Alignment of the scratch allocations
+#define SCRATCH_ALIGN 16
+
+/**
+ * @brief Chunk of scratch memory, followed by its usable bytes
+ */
+typedef struct _ocrScratchChunk_t {
+    struct _ocrScratchChunk_t *prev;    /**< Chunk allocated before this one */
+    u64 size;                           /**< Usable bytes after the header */
+} ocrScratchChunk_t;
+
+/**
+ * @brief Scratch arena. All zeros is a valid empty arena
+ */
+typedef struct _ocrScratch_t {
+    ocrScratchChunk_t *chunk;   /**< Chunk allocations are carved from, NULL if none */
+    u64 bump, end;              /**< Part of 'chunk' not allocated yet */
+    ocrScratchChunk_t *spare;   /**< Chunk kept by the last roll back, NULL if none */
+} ocrScratch_t;
+
+/**
+ * @brief State of an arena to roll back to
+ */
+typedef struct {
+    ocrScratchChunk_t *chunk;
+    u64 bump;
+} ocrScratchMark_t;
+
+/**
+ * @brief Gives all the chunks of 'self' back
+ */
+void scratchDestruct(ocrScratch_t *self);
+
+/**
+ * @brief Allocates 'size' bytes aligned on SCRATCH_ALIGN
+ *
+ * @return NULL if no memory is left
+ */
+void * scratchMalloc(ocrScratch_t *self, u64 size);
+
+static inline ocrScratchMark_t scratchMark(ocrScratch_t *self) {
+    ocrScratchMark_t mark = { self->chunk, self->bump };
+    return mark;
+}
+
+/**
+ * @brief Frees everything allocated since 'mark' was taken
+ */
+void scratchRollBack(ocrScratch_t *self, ocrScratchMark_t mark);
+
+#endif /* __ALLOCATOR_SCRATCH_H__ */
@@ -0,0 +1,349 @@
+/**
+ * @brief Allocator serving small chunks from size-class slabs in front
+ * of a TLSF pool
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/slab/slab-allocator.h"
+#include "allocator/tlsf/tlsf-allocator.h"
+#include "debug.h"
+#include "ocr-macros.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG_TYPE ALLOCATOR
+
+#define SLAB_CACHE_LINE 64
+
+#define SLAB_SIZE (16*1024)
+
+// The slabs take 1/SLAB_SPLIT_RATIO of the memory, the TLSF pool the rest
+#define SLAB_SPLIT_RATIO 4
+
+/******************************************************/
+/* SIZE CLASSES                                       */
+/******************************************************/
+
+static u32 slabClassOfSize(u64 size) {
+    if(size <= (1ULL << SLAB_MIN_CHUNK_LOG2)) {
+        return 0;
+    }
+    return fls64(size - 1) + 1 - SLAB_MIN_CHUNK_LOG2;
+}
+
+static u64 slabChunkSize(u32 sizeClass) {
+    return 1ULL << (sizeClass + SLAB_MIN_CHUNK_LOG2);
+}
+
+// Chunks of a class a worker hands to or takes from the shared free-list at once
+static u32 slabBatch(u32 sizeClass) {
+    return SLAB_SIZE/slabChunkSize(sizeClass);
+}
+
+static bool slabOwns(ocrAllocatorSlab_t *rself, u64 address) {
+    return (address >= rself->slabAddr) && (address < rself->slabAddr + rself->slabCount*SLAB_SIZE);
+}
+
+static ocrAllocatorSlabCache_t * slabCacheOfCaller(ocrAllocatorSlab_t *rself) {
+    return &(rself->caches[getCurrentWorkerContext()->sourceId % rself->cacheCount]);
+}
+
+static void slabLock(ocrAllocatorSlabClass_t *sizeClass) {
+    while(!__sync_bool_compare_and_swap(&(sizeClass->lock), 0, 1)) ;
+}
+
+static void slabUnlock(ocrAllocatorSlabClass_t *sizeClass) {
+    __sync_lock_release(&(sizeClass->lock));
+}
+
+/******************************************************/
+/* FREE-LISTS                                         */
+/******************************************************/
+
+// Fills the empty free-list of 'sizeClass' of 'cache' from the shared
+// free-list or, failing that, from a new slab
+static bool slabRefill(ocrAllocatorSlab_t *rself, ocrAllocatorSlabCache_t *cache, u32 sizeClass) {
+    ocrAllocatorSlabClass_t *shared = &(rself->classes[sizeClass]);
+    u32 batch = slabBatch(sizeClass);
+    if(shared->count > 0) {
+        slabLock(shared);
+        u64 head = shared->free;
+        u64 tail = head;
+        u32 taken = 0;
+        if(head != 0) {
+            taken = 1;
+            while((taken < batch) && (*(u64*)tail != 0)) {
+                tail = *(u64*)tail;
+                ++taken;
+            }
+            shared->free = *(u64*)tail;
+            shared->count -= taken;
+            *(u64*)tail = 0;
+        }
+        slabUnlock(shared);
+        if(head != 0) {
+            cache->free[sizeClass] = head;
+            cache->count[sizeClass] = taken;
+            return true;
+        }
+    }
+
+    u64 slab = __sync_fetch_and_add(&(rself->slabsUsed), 1);
+    if(slab >= rself->slabCount) {
+        return false;
+    }
+    rself->slabClass[slab] = sizeClass;
+    u64 chunkSize = slabChunkSize(sizeClass);
+    u64 start = rself->slabAddr + slab*SLAB_SIZE;
+    u64 chunk;
+    for(chunk = start; chunk < start + SLAB_SIZE - chunkSize; chunk += chunkSize) {
+        *(u64*)chunk = chunk + chunkSize;
+    }
+    *(u64*)chunk = 0;
+    cache->free[sizeClass] = start;
+    cache->count[sizeClass] = batch;
+    DPRINTF(DEBUG_LVL_VERB, "Slab %"PRIu64" @ 0x%"PRIx64" carved in chunks of %"PRIu64" bytes\n",
+            slab, start, chunkSize);
+    return true;
+}
+
+// Hands a batch of the chunks of 'sizeClass' of 'cache' to the shared free-list
+static void slabFlush(ocrAllocatorSlab_t *rself, ocrAllocatorSlabCache_t *cache, u32 sizeClass) {
+    ocrAllocatorSlabClass_t *shared = &(rself->classes[sizeClass]);
+    u32 batch = slabBatch(sizeClass);
+    u64 head = cache->free[sizeClass];
+    u64 tail = head;
+    u32 i;
+    for(i = 1; i < batch; ++i) {
+        tail = *(u64*)tail;
+    }
+    cache->free[sizeClass] = *(u64*)tail;
+    cache->count[sizeClass] -= batch;
+    slabLock(shared);
+    *(u64*)tail = shared->free;
+    shared->free = head;
+    shared->count += batch;
+    slabUnlock(shared);
+}
+
+/******************************************************/
+/* OCR ALLOCATOR SLAB                                 */
+/******************************************************/
+
+static void slabDestruct(ocrAllocator_t *self) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    if(self->memoryCount)
+        self->memories[0]->fctPtrs->free(self->memories[0], (void*)rself->addr);
+    rself->lock->fctPtrs->destruct(rself->lock);
+    free(rself->slabClass);
+    free(rself->caches);
+    free(self->memories);
+
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t *orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->type = PD_MSG_GUID_REL;
+    pd->inform(pd, self->guid, ctx);
+    ctx->destruct(ctx);
+    free(rself);
+}
+
+static void slabStart(ocrAllocator_t *self, ocrPolicyDomain_t * PD) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    ASSERT(self->memoryCount == 1);
+    rself->addr = (u64)(self->memories[0]->fctPtrs->allocate(self->memories[0], rself->totalSize));
+    ASSERT(rself->addr);
+    RESULT_ASSERT(tlsfPoolInit(rself->addr, rself->totalSize), ==, 0);
+
+    rself->slabCount = rself->totalSize/SLAB_SPLIT_RATIO/SLAB_SIZE;
+    rself->slabAddr = tlsfPoolMalloc(rself->addr, rself->slabCount*SLAB_SIZE);
+    if(rself->slabAddr == 0) {
+        rself->slabCount = 0;
+    }
+    rself->slabsUsed = 0;
+    rself->slabClass = (u8*) checkedMalloc(rself->slabClass, rself->slabCount + 1);
+
+    rself->cacheCount = (PD->workerCount > 0) ? PD->workerCount : 1;
+    RESULT_ASSERT(posix_memalign((void**)&(rself->caches), SLAB_CACHE_LINE,
+                                 rself->cacheCount*sizeof(ocrAllocatorSlabCache_t)), ==, 0);
+    memset(rself->caches, 0, rself->cacheCount*sizeof(ocrAllocatorSlabCache_t));
+    memset(rself->classes, 0, sizeof(rself->classes));
+    DPRINTF(DEBUG_LVL_INFO, "%"PRIu64" slabs of %d bytes @ 0x%"PRIx64" for %"PRIu64" workers\n",
+            rself->slabCount, SLAB_SIZE, rself->slabAddr, rself->cacheCount);
+}
+
+static void slabStop(ocrAllocator_t *self) { }
+
+static void* slabAllocate(ocrAllocator_t *self, u64 size) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    if(size <= SLAB_MAX_CHUNK) {
+        u32 sizeClass = slabClassOfSize(size);
+        ocrAllocatorSlabCache_t *cache = slabCacheOfCaller(rself);
+        if((cache->free[sizeClass] != 0) || slabRefill(rself, cache, sizeClass)) {
+            u64 chunk = cache->free[sizeClass];
+            cache->free[sizeClass] = *(u64*)chunk;
+            --cache->count[sizeClass];
+            return (void*)chunk;
+        }
+    }
+    rself->lock->fctPtrs->lock(rself->lock);
+    void* toReturn = (void*)tlsfPoolMalloc(rself->addr, size);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    return toReturn;
+}
+
+static void slabDeallocate(ocrAllocator_t *self, void* address) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    if(slabOwns(rself, (u64)address)) {
+        u32 sizeClass = rself->slabClass[((u64)address - rself->slabAddr)/SLAB_SIZE];
+        ocrAllocatorSlabCache_t *cache = slabCacheOfCaller(rself);
+        *(u64*)address = cache->free[sizeClass];
+        cache->free[sizeClass] = (u64)address;
+        if(++cache->count[sizeClass] >= 2*slabBatch(sizeClass)) {
+            slabFlush(rself, cache, sizeClass);
+        }
+        return;
+    }
+    rself->lock->fctPtrs->lock(rself->lock);
+    tlsfPoolFree(rself->addr, (u64)address);
+    rself->lock->fctPtrs->unlock(rself->lock);
+}
+
+static void* slabReallocate(ocrAllocator_t *self, void* address, u64 size) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    if(address == NULL) {
+        return slabAllocate(self, size);
+    }
+    if(size == 0) {
+        slabDeallocate(self, address);
+        return NULL;
+    }
+    if(slabOwns(rself, (u64)address)) {
+        u64 chunkSize = slabChunkSize(rself->slabClass[((u64)address - rself->slabAddr)/SLAB_SIZE]);
+        if(size <= chunkSize) {
+            return address;
+        }
+        void* toReturn = slabAllocate(self, size);
+        if(toReturn != NULL) {
+            memcpy(toReturn, address, chunkSize);
+            slabDeallocate(self, address);
+        }
+        return toReturn;
+    }
+    rself->lock->fctPtrs->lock(rself->lock);
+    void* toReturn = (void*)tlsfPoolRealloc(rself->addr, (u64)address, size);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    return toReturn;
+}
+
+// The chunks on the free-lists and the slabs not carved yet are free
+// memory, although the TLSF pool sees them as one allocated chunk. The
+// free-lists of the workers are read while they use them: the result is
+// only approximate while EDTs run
+static u8 slabGetStats(ocrAllocator_t *self, ocrMemoryStats_t *stats, bool walk) {
+    ocrAllocatorSlab_t *rself = (ocrAllocatorSlab_t*)self;
+    rself->lock->fctPtrs->lock(rself->lock);
+    tlsfPoolStats(rself->addr, rself->totalSize, stats, walk);
+    rself->lock->fctPtrs->unlock(rself->lock);
+
+    u64 slabsUsed = (rself->slabsUsed < rself->slabCount) ? rself->slabsUsed : rself->slabCount;
+    u64 carved[SLAB_CLASS_COUNT] = { 0 };
+    u64 freeSize = 0;
+    u64 sizeClass, i;
+    for(i = 0; walk && (i < slabsUsed); ++i) {
+        carved[rself->slabClass[i]] += slabBatch(rself->slabClass[i]);
+    }
+    if(slabsUsed < rself->slabCount) {
+        freeSize = (rself->slabCount - slabsUsed)*SLAB_SIZE;
+        stats->freeCount += 1;
+        stats->freeHistogram[ocrMemoryStatsClass(freeSize)] += 1;
+        if(freeSize > stats->largestFree) {
+            stats->largestFree = freeSize;
+        }
+    }
+    for(sizeClass = 0; sizeClass < SLAB_CLASS_COUNT; ++sizeClass) {
+        u64 count = rself->classes[sizeClass].count;
+        for(i = 0; i < rself->cacheCount; ++i) {
+            count += rself->caches[i].count[sizeClass];
+        }
+        freeSize += count*slabChunkSize(sizeClass);
+        stats->freeCount += count;
+        stats->freeHistogram[ocrMemoryStatsClass(slabChunkSize(sizeClass))] += count;
+        if(carved[sizeClass] > count) {
+            // The TLSF walk only counted the region of the slabs
+            stats->usedCount += carved[sizeClass] - count;
+            stats->usedHistogram[ocrMemoryStatsClass(slabChunkSize(sizeClass))] += carved[sizeClass] - count;
+        }
+    }
+    if(freeSize > stats->usedSize) {
+        freeSize = stats->usedSize;
+    }
+    stats->freeSize += freeSize;
+    stats->usedSize -= freeSize;
+    ocrMemoryStatsUpdate(stats);
+    return 0;
+}
+
+// Method to create the slab allocator
+static ocrAllocator_t * newAllocatorSlab(ocrAllocatorFactory_t * factory, ocrParamList_t *perInstance) {
+
+    ocrAllocatorSlab_t *result = (ocrAllocatorSlab_t*)
+        checkedMalloc(result, sizeof(ocrAllocatorSlab_t));
+    result->base.guid = UNINITIALIZED_GUID;
+    guidify(getCurrentPD(), (u64) result, &(result->base.guid), OCR_GUID_ALLOCATOR);
+    result->base.fctPtrs = &(factory->allocFcts);
+    result->base.memories = NULL;
+    result->base.memoryCount = 0;
+
+    paramListAllocatorInst_t *perInstanceReal = (paramListAllocatorInst_t*)perInstance;
+
+    result->addr = 0ULL;
+    result->totalSize = perInstanceReal->size;
+    // The slabs and free-lists are set up when the workers are known
+    result->slabAddr = 0ULL;
+    result->slabCount = result->slabsUsed = 0;
+    result->slabClass = NULL;
+    result->cacheCount = 0;
+    result->caches = NULL;
+
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t *ctx = getCurrentWorkerContext();
+
+    result->lock = pd->getLock(pd, ctx);
+
+    result->base.module.mapFct = NULL;
+
+    return (ocrAllocator_t*)result;
+}
+
+/******************************************************/
+/* OCR ALLOCATOR SLAB FACTORY                         */
+/******************************************************/
+
+static void destructAllocatorFactorySlab(ocrAllocatorFactory_t * factory) {
+    free(factory);
+}
+
+ocrAllocatorFactory_t * newAllocatorFactorySlab(ocrParamList_t *perType) {
+    ocrAllocatorFactory_t* base = (ocrAllocatorFactory_t*)
+        checkedMalloc(base, sizeof(ocrAllocatorFactorySlab_t));
+    base->instantiate = newAllocatorSlab;
+    base->destruct =  &destructAllocatorFactorySlab;
+    base->allocFcts.destruct = &slabDestruct;
+    base->allocFcts.start = &slabStart;
+    base->allocFcts.stop = &slabStop;
+    base->allocFcts.allocate = &slabAllocate;
+    base->allocFcts.free = &slabDeallocate;
+    base->allocFcts.reallocate = &slabReallocate;
+    base->allocFcts.getStats = &slabGetStats;
+    return base;
+}
@@ -0,0 +1,71 @@
+/**
+ * @brief Allocator serving small chunks from size-class slabs in front
+ * of a TLSF pool
+ *
+ * Requests of up to SLAB_MAX_CHUNK bytes are rounded up to a power of
+ * two and served from free-lists of chunks of that size. Each worker
+ * keeps its own free-lists and only exchanges batches of chunks with
+ * the free-lists shared by all the workers. The chunks are carved from
+ * slabs of a region allocated in the TLSF pool. Larger requests, and
+ * small ones once the region is used up, go to the TLSF pool.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __ALLOCATOR_SLAB_H__
+#define __ALLOCATOR_SLAB_H__
+
+#include "ocr-allocator.h"
+#include "ocr-sync.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+#define SLAB_MIN_CHUNK_LOG2 4
+#define SLAB_MAX_CHUNK_LOG2 8
+#define SLAB_MAX_CHUNK (1ULL << SLAB_MAX_CHUNK_LOG2)
+#define SLAB_CLASS_COUNT (SLAB_MAX_CHUNK_LOG2 - SLAB_MIN_CHUNK_LOG2 + 1)
+
+typedef struct {
+    ocrAllocatorFactory_t base;
+} ocrAllocatorFactorySlab_t;
+
+/**
+ * @brief Free-lists of a worker, alone on its cache line
+ *
+ * Free chunks are linked through their first word. 0 ends a list
+ */
+typedef struct {
+    u64 free[SLAB_CLASS_COUNT];
+    u32 count[SLAB_CLASS_COUNT];
+    u8 _padding[64 - SLAB_CLASS_COUNT*(sizeof(u64) + sizeof(u32))];
+} ocrAllocatorSlabCache_t;
+
+/**
+ * @brief Free-list of a size class shared by all the workers
+ */
+typedef struct {
+    volatile u32 lock;
+    u32 count;
+    u64 free;
+} ocrAllocatorSlabClass_t;
+
+typedef struct {
+    ocrAllocator_t base;
+    u64 addr, totalSize;
+    ocrLock_t* lock;            /**< Serializes the calls on the TLSF pool */
+    u64 slabAddr;               /**< Region of the slabs in the TLSF pool */
+    u64 slabCount;
+    volatile u64 slabsUsed;     /**< Slabs of the region carved so far */
+    u8 *slabClass;              /**< Size class of each slab carved */
+    u64 cacheCount;             /**< One set of free-lists per worker */
+    ocrAllocatorSlabCache_t *caches;
+    ocrAllocatorSlabClass_t classes[SLAB_CLASS_COUNT];
+} ocrAllocatorSlab_t;
+
+extern ocrAllocatorFactory_t* newAllocatorFactorySlab(ocrParamList_t *perType);
+
+#endif /* __ALLOCATOR_SLAB_H__ */
@@ -18,9 +18,12 @@
 #include "ocr-utils.h"
 #include "tlsf-allocator.h"
 
+#include <errno.h>
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #define DEBUG_TYPE ALLOCATOR
 
@@ -42,9 +45,9 @@
  *  - make sure the fls routine in tlsfMalloc.c exists for the size
  *  - change FL_MAX_LOG2 if required
  */
-typedef u32 tlsfSize_t;
-#define SIZE_TLSF_SIZE 32
-#define SIZE_TLSF_SIZE_LOG2 5
+typedef u64 tlsfSize_t;
+#define SIZE_TLSF_SIZE 64
+#define SIZE_TLSF_SIZE_LOG2 6
 
 /*
  * Configuration constants
@@ -66,14 +69,14 @@ typedef u32 tlsfSize_t;
 
 /*
  * Number of bytes the "size" of a block
- * is a multiple of. A size of 1 means 1 word (4 bytes, 32 bits)
+ * is a multiple of. A size of 1 means 1 word (8 bytes, 64 bits)
  * This is used to "extend" the range possible by trading some
  * granularity in allocation. The maximum size allocatable/addressable
  * will be ELEMENT_SIZE_BYTES*2^{sizeof(tlsfSize_t)*8} bytes
  * NOTE: Must be at least 2 bytes
  */
-#define ELEMENT_SIZE_LOG2 2
-#define ELEMENT_SIZE_BYTES 4
+#define ELEMENT_SIZE_LOG2 3
+#define ELEMENT_SIZE_BYTES 8
 
 /*
  * Alignment of returned block
@@ -88,8 +91,8 @@ typedef u32 tlsfSize_t;
  * of tlsfSize_t will "pad" the full block to start
  * on an ALIGN_BYTES alignment
  */
-#define ALIGN_BLOCK_LOG2 2 // 4 byte
-#define ALIGN_BLOCK_BYTES 4
+#define ALIGN_BLOCK_LOG2 3 // 8 byte
+#define ALIGN_BLOCK_BYTES 8
 
 /*
  * Number of subdivisions in the second-level list
@@ -101,19 +104,17 @@ typedef u32 tlsfSize_t;
  * Support allocations/memory of size up to (1 << FL_MAX_LOG2) * ELEMENT_SIZE_BYTES
  * Note that bitmaps are of type tlsfSize_t so FL_MAX_LOG2 must be
  * less than or equal to SIZE_TLSF_SIZE.
- * For 64K memory: 14 (if ELEMENT_SIZE_LOG2 == 2)
- * For 1024K memory: 18 (if ELEMENT_SIZE_LOG2 == 2)
- * For 4096K memory: 20 (if ELEMENT_SIZE_LOG2 == 2)
- * For 16384K memory: 22 (if ELEMENT_SIZE_LOG2 == 2)
- * For 32768K memory: 23 (if ELEMENT_SIZE_LOG2 == 2)
- * For 65536K memory: 24 (if ELEMENT_SIZE_LOG2 == 2)
- * For 128MB memory: 25 (if ELEMENT_SIZE_LOG2 == 2)
- * For 256MB memory: 26 (if ELEMENT_SIZE_LOG2 == 2)
- * For 512MB memory: 27 (if ELEMENT_SIZE_LOG2 == 2)
- * For 2GB memory: 29
- * For 4GB memory: 30
+ * For 64K memory: 13 (if ELEMENT_SIZE_LOG2 == 3)
+ * For 1024K memory: 17 (if ELEMENT_SIZE_LOG2 == 3)
+ * For 128MB memory: 24 (if ELEMENT_SIZE_LOG2 == 3)
+ * For 2GB memory: 28 (if ELEMENT_SIZE_LOG2 == 3)
+ * For 32GB memory: 32 (if ELEMENT_SIZE_LOG2 == 3)
+ * For 512GB memory: 36 (if ELEMENT_SIZE_LOG2 == 3)
+ * Each increment adds SL_COUNT + 1 words to the meta-data of a pool, which
+ * also sits at the start of the heaps made in data-blocks. Larger memories
+ * are split in several pools by the allocator
  */
-#define FL_MAX_LOG2 29
+#define FL_MAX_LOG2 32
 
 
 /* Size specific functions:
@@ -124,12 +125,19 @@ typedef u32 tlsfSize_t;
 // ST_SIZE/LD_SIZE will be used to st/ld values of type tlsfSize_t
 #if SIZE_TLSF_SIZE == 16
 #define FLS fls16
+#define FFS ffs16
 #define ST_SIZE(addr, value) (*((u16*)(addr)) = (u16)(value))
 #define LD_SIZE(var, addr)   ((var) = *((u16*)(addr)))
 #elif SIZE_TLSF_SIZE == 32
 #define FLS fls32
+#define FFS ffs32
 #define ST_SIZE(addr, value) (*((u32*)(addr)) = (u32)(value))
 #define LD_SIZE(var, addr)   ((var) = *((u32*)(addr)))
+#elif SIZE_TLSF_SIZE == 64
+#define FLS fls64
+#define FFS ffs64
+#define ST_SIZE(addr, value) (*((u64*)(addr)) = (u64)(value))
+#define LD_SIZE(var, addr)   ((var) = *((u64*)(addr)))
 #else
 #error "Unknown size for tlsfSize_t"
 #endif
@@ -192,6 +200,10 @@ myStaticAssert(ELEMENT_SIZE_BYTES >= 2);
 myStaticAssert(SL_COUNT_LOG2 < SIZE_TLSF_SIZE_LOG2);
 myStaticAssert(FL_MAX_LOG2 <= SIZE_TLSF_SIZE);
 
+// Single bits and masks of the bitmaps
+#define BIT(idx)            (((tlsfSize_t)1) << (idx))
+#define BITS_FROM(idx)      ((~((tlsfSize_t)0)) << (idx))
+
 /*
  * Some computed values:
  *  - SL_COUNT: Number of buckets in each SL list
@@ -294,11 +306,7 @@ static const tlsfSize_t GusedBlockOverhead  = (offsetof(header_t, nextFreeBlock)
 // This computation just rounds it up to the closest multiple of ELEMENT_SIZE_BYTES
 static const tlsfSize_t GminBlockRealSize   = (sizeof(header_t) + sizeof(tlsfSize_t) + ELEMENT_SIZE_BYTES - 1)
     >> ELEMENT_SIZE_LOG2;
-static const tlsfSize_t GmaxBlockRealSize   = (tlsfSize_t)((1<<FL_MAX_LOG2) - 1);
-
-static int myffs(tlsfSize_t val) {
-    return FLS(val & (~val + 1));
-}
+static const tlsfSize_t GmaxBlockRealSize   = (tlsfSize_t)(BIT(FL_MAX_LOG2) - 1);
 
 /* Utility functions for blocks. All these functions that
  * a "me" block pointer as their first argument
@@ -493,12 +501,20 @@ static void mappingInsert(tlsfSize_t realSize, int* flIndex, int* slIndex) {
  * pick it in constant time.
  */
 static void mappingSearch(tlsfSize_t realSize, int* flIndex, int* slIndex) {
-    if(realSize >= ZERO_LIST_SIZE) {
-        // If not, we don't need to do anything since the mappingInsert
-        // will return the correct thing
-        realSize += (1 << (FLS(realSize) - SL_COUNT_LOG2)) - 1;
+    int tf;
+
+    if(realSize < ZERO_LIST_SIZE) {
+        // No rounding needed, mappingInsert returns the correct thing
+        mappingInsert(realSize, flIndex, slIndex);
+        return;
     }
-    mappingInsert(realSize, flIndex, slIndex);
+    tf = FLS(realSize);
+    realSize += BIT(tf - SL_COUNT_LOG2) - 1;
+    // Rounding up carries at most into the next power of two: adjust
+    // the first level without scanning the bits again
+    tf += (int)(realSize >> (tf + 1));
+    *flIndex = tf - (FL_COUNT_SHIFT - 1);
+    *slIndex = (realSize >> (tf - SL_COUNT_LOG2)) - (SL_COUNT);
 }
 
 /* Search for a suitable free block:
@@ -527,19 +543,19 @@ static headerAddr_t findFreeBlockForRealSize(u64 pgStart, tlsfSize_t realSize,
 
     LD_SIZE(slBitMap, ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, tf));
     FENCE_LOAD;
-    slBitMap &= (~0 << ts); // This takes all SL bins bigger or requal to ts
+    slBitMap &= BITS_FROM(ts); // This takes all SL bins bigger or requal to ts
     if(slBitMap == 0) {
         // We don't have any non-zero block here so we look at the flAvailOrNot map
         LD_SIZE(flBitMap, ADDR_OF(pool_t, pgStart, flAvailOrNot));
         FENCE_LOAD;
-        flBitMap &= (~0 << (tf + 1));
+        flBitMap &= BITS_FROM(tf + 1);
         if(flBitMap == 0) {
             SET_NULL(res);
             return res;
         }
 
         // Look for the first bit that is a one
-        tf = myffs(flBitMap);
+        tf = FFS(flBitMap);
         ASSERT(tf > *flIndex);
         *flIndex = tf;
 
@@ -550,7 +566,7 @@ static headerAddr_t findFreeBlockForRealSize(u64 pgStart, tlsfSize_t realSize,
 
     ASSERT(slBitMap != 0);
 
-    ts = myffs(slBitMap);
+    ts = FFS(slBitMap);
     *slIndex = ts;
 
     LD_SIZE(res.value, ADDR_OF_2(pool_t, pgStart, tlsfSize_t, blocks, tf, SL_COUNT, ts));
@@ -592,7 +608,7 @@ static void removeFreeBlock(u64 pgStart, headerAddr_t freeBlock) {
         if(GET_ADDRESS(nextFreeBlock) == ADDR_OF(pool_t, pgStart, nullBlock)) {
             LD_SIZE(tempSz, ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, flIndex));
             FENCE_LOAD;
-            tempSz &= ~(1 << slIndex); // Clear me bit
+            tempSz &= ~BIT(slIndex); // Clear me bit
             ST_SIZE(ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, flIndex), tempSz);
 
             // Check if slAvailOrNot is now 0
@@ -600,7 +616,7 @@ static void removeFreeBlock(u64 pgStart, headerAddr_t freeBlock) {
                 LD_SIZE(tempSz, ADDR_OF(pool_t, pgStart, flAvailOrNot));
                 FENCE_LOAD;
 
-                tempSz &= ~(1 << flIndex);
+                tempSz &= ~BIT(flIndex);
                 ST_SIZE(ADDR_OF(pool_t, pgStart, flAvailOrNot), tempSz);
             }
         }
@@ -648,16 +664,16 @@ void addFreeBlock(u64 pgStart, headerAddr_t freeBlock) {
 
     LD_SIZE(tempSz, ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, flIndex));
     FENCE_LOAD;
-    if(!(tempSz & (1 << slIndex))) {
+    if(!(tempSz & BIT(slIndex))) {
         // Here it wasn't stored so we definitely have to update
 
-        tempSz |= (1 << slIndex);
+        tempSz |= BIT(slIndex);
         ST_SIZE(ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, flIndex), tempSz);
 
         LD_SIZE(tempSz, ADDR_OF(pool_t, pgStart, flAvailOrNot));
         FENCE_LOAD;
-        if(!(tempSz & (1 << flIndex))) {
-            tempSz |= (1 << flIndex);
+        if(!(tempSz & BIT(flIndex))) {
+            tempSz |= BIT(flIndex);
             ST_SIZE(ADDR_OF(pool_t, pgStart, flAvailOrNot), tempSz);
         }
     }
@@ -815,7 +831,8 @@ static void initializePool(u64 pgStart, tlsfSize_t poolRealSize) {
     addFreeBlock(pgStart, mainBlockAddr);
 }
 
-static u32 tlsfInit(u64 pgStart, u64 size) {
+// Number of elements managed by a pool laid out over 'size' bytes
+static tlsfSize_t tlsfPoolRealSize(u64 size) {
     tlsfSize_t realSizeForPool = size >> ELEMENT_SIZE_LOG2;
     /* The memory will be layed out as follows:
      *  - at location: the pool structure is used
@@ -828,29 +845,27 @@ static u32 tlsfInit(u64 pgStart, u64 size) {
     // Now we have a poolHeaderSize that is big enough to contain the pool
     // and right after it, we can start the big block.
 
-    tlsfSize_t poolRealSize = realSizeForPool -
-        ((poolHeaderSize + ELEMENT_SIZE_BYTES - 1) >> ELEMENT_SIZE_LOG2);
+    return realSizeForPool - ((poolHeaderSize + ELEMENT_SIZE_BYTES - 1) >> ELEMENT_SIZE_LOG2);
+}
+
+static u32 tlsfInit(u64 pgStart, u64 size) {
+    tlsfSize_t poolRealSize = tlsfPoolRealSize(size);
 
     if(poolRealSize < GminBlockRealSize || poolRealSize > GmaxBlockRealSize) {
-        DPRINTF(DEBUG_LVL_WARN, "Space mismatch allocating TLSF pool at 0x%"PRIx64" of sz %d (user sz: %d)\n",
-                pgStart, (u32)poolRealSize, (u32)(poolRealSize << ELEMENT_SIZE_LOG2));
-        DPRINTF(DEBUG_LVL_WARN, "Sz must be at least %d and at most %d\n", GminBlockRealSize, GmaxBlockRealSize);
+        DPRINTF(DEBUG_LVL_WARN, "Space mismatch allocating TLSF pool at 0x%"PRIx64" of sz %"PRIu64" (user sz: %"PRIu64")\n",
+                pgStart, poolRealSize, poolRealSize << ELEMENT_SIZE_LOG2);
+        DPRINTF(DEBUG_LVL_WARN, "Sz must be at least %"PRIu64" and at most %"PRIu64"\n", GminBlockRealSize, GmaxBlockRealSize);
         return -1; // Can't allocate pool
     }
 
-    DPRINTF(DEBUG_LVL_INFO,"Allocating a TLSF pool at 0x%"PRIx64" of sz %d (user sz: %d)\n",
-            pgStart, (u32)poolRealSize, (u32)(poolRealSize << ELEMENT_SIZE_LOG2));
+    DPRINTF(DEBUG_LVL_INFO,"Allocating a TLSF pool at 0x%"PRIx64" of sz %"PRIu64" (user sz: %"PRIu64")\n",
+            pgStart, poolRealSize, poolRealSize << ELEMENT_SIZE_LOG2);
 
     initializePool(pgStart, poolRealSize);
 
     return 0;
 }
 
-//static u32 tlsfResize(u64 pgStart, u64 newsize) {
-//    return -1;
-//    // TODO: Not implemented yet
-//}
-
 static u64 tlsfMalloc(u64 pgStart, u64 size) {
     u64 result = 0ULL;
     tlsfSize_t allocSize, returnedSize;
@@ -899,7 +914,8 @@ static u64 tlsfMalloc(u64 pgStart, u64 size) {
     return result;
 }
 
-static void tlsfFree(u64 pgStart, u64 ptr) {
+// Returns the free block the chunk ends up in once merged with its neighbors
+static u64 tlsfFree(u64 pgStart, u64 ptr) {
     headerAddr_t bl;
 
     DPRINTF(DEBUG_LVL_VERB, "tlsfFree @ 0x%"PRIx64" going to free 0x%"PRIx64"\n",
@@ -910,6 +926,7 @@ static void tlsfFree(u64 pgStart, u64 ptr) {
     bl = mergePrevious(pgStart, bl);
     bl = mergeNext(pgStart, bl);
     addFreeBlock(pgStart, bl);
+    return GET_ADDRESS(bl);
 }
 
 static u64 tlsfRealloc(u64 pgStart, u64 ptr, u64 size) {
@@ -943,7 +960,7 @@ static u64 tlsfRealloc(u64 pgStart, u64 ptr, u64 size) {
     // + nextBlockAddr->sizeBlock + GusedBlockOverhead
     realReqSize = getRealSizeOfRequest(size);
 
-    if(realReqSize > tempSz || (!isBlockFree(nextBlockAddr) || realReqSize > realAvailSize)) {
+    if((realReqSize > tempSz) && (!isBlockFree(nextBlockAddr) || (realReqSize > realAvailSize))) {
         // We need to reallocate and copy
         // Note, does not matter if pgStart was already truncated, it is an idempotent operation
         result = tlsfMalloc(pgStart, size);
@@ -956,17 +973,21 @@ static u64 tlsfRealloc(u64 pgStart, u64 ptr, u64 size) {
     } else {
         if(realReqSize > tempSz) {
             // This means we need to extend to the other block
+            // The block keeps its own prev-free bit; the block after the
+            // absorbed one now follows a used block
             removeFreeBlock(pgStart, nextBlock);
             ST_SIZE(ADDR_OF(header_t, blockAddr, sizeBlock), realAvailSize);
             FENCE_STORE;
-            markBlockUsed(pgStart, blockAddr);
+            markPrevBlockUsed(GET_ADDRESS(getNextBlock(pgStart, blockAddr)));
         } else {
             realAvailSize = tempSz;
         }
         // We can trim to just the size used to create a new
-        // free block and reduce internal fragmentation
+        // free block and reduce internal fragmentation. When shrinking,
+        // the next block may be free as well: merge them
         if(realAvailSize > realReqSize + GminBlockRealSize) {
             headerAddr_t remainingBlock = splitBlock(pgStart, bl, realReqSize);
+            remainingBlock = mergeNext(pgStart, remainingBlock);
             addFreeBlock(pgStart, remainingBlock);
         }
         result = ptr;
@@ -975,10 +996,305 @@ static u64 tlsfRealloc(u64 pgStart, u64 ptr, u64 size) {
     return result;
 }
 
+/* Gives the pages of a free block back to the OS. Only the whole pages
+ * between the header of the block and the size at its end are released;
+ * they read as zeros when touched again
+ */
+static void tlsfReleaseBlock(u64 block /* header_t* */) {
+    tlsfSize_t size;
+    LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+    FENCE_LOAD;
+    u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+    u64 start = (block + sizeof(header_t) + pageSize - 1) & ~(pageSize - 1);
+    u64 end = (addressForBlock(block) + (size << ELEMENT_SIZE_LOG2) - sizeof(tlsfSize_t)) & ~(pageSize - 1);
+    if(end > start) {
+        // Memory that cannot be released (huge pages not wholly covered) simply stays
+        if(madvise((void*)start, end - start, MADV_DONTNEED) == 0) {
+            DPRINTF(DEBUG_LVL_VERB, "TLSF released 0x%"PRIx64" bytes @ 0x%"PRIx64"\n", end - start, start);
+        }
+    }
+}
+
+// Usable size of the chunk at 'ptr'
+static u64 tlsfUsableSize(u64 pgStart, u64 ptr) {
+    tlsfSize_t size;
+    LD_SIZE(size, ADDR_OF(header_t, GET_ADDRESS(blockForAddress(pgStart, ptr)), sizeBlock));
+    FENCE_LOAD;
+    return size << ELEMENT_SIZE_LOG2;
+}
+
+/******************************************************/
+/* HEAP INTROSPECTION                                 */
+/******************************************************/
+
+typedef void (*tlsf_walkerAction)(u64 pgStart, u64 block /* header_t* */, void* extra);
+
+// Calls 'action' on each block of the pool, free or used, in address order
+static void tlsf_walk_heap(u64 pgStart, tlsf_walkerAction action, void* extra) {
+    u64 block = ADDR_OF(pool_t, pgStart, mainBlock);
+    tlsfSize_t size;
+    LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+    FENCE_LOAD;
+    // The sentinel ending the pool is the only block of size 0
+    while(size != 0) {
+        action(pgStart, block, extra);
+        block = GET_ADDRESS(getNextBlock(pgStart, block));
+        LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+        FENCE_LOAD;
+    }
+}
+
+#ifdef OCR_DEBUG
+static void printBlock(u64 pgStart, u64 block, void* extra) {
+    u64 *count = (u64*)extra;
+    tlsfSize_t size;
+    LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+    FENCE_LOAD;
+    DPRINTF(DEBUG_LVL_VVERB, "Block %"PRIu64" @ 0x%"PRIx64" (user: 0x%"PRIx64") of %"PRIu64" bytes %s\n",
+            *count, block, addressForBlock(block), (u64)size << ELEMENT_SIZE_LOG2,
+            isBlockFree(block) ? "free" : "used");
+    *count += 1;
+}
+#endif /* OCR_DEBUG */
+
+typedef struct flagVerifier_t {
+    u64 countConsecutiveFrees;
+    bool isPrevFree;
+    u64 countErrors;
+} flagVerifier_t;
+
+// Checks that each block knows whether the previous one is free and
+// that no two free blocks follow each other
+static void verifyFlags(u64 pgStart, u64 block, void* extra) {
+    flagVerifier_t* verif = (flagVerifier_t*)extra;
+
+    if(isPrevBlockFree(block) != verif->isPrevFree) {
+        verif->countErrors += 1;
+        DPRINTF(DEBUG_LVL_WARN, "Mismatch in free flag for block 0x%"PRIx64"\n", block);
+    }
+    if(isBlockFree(block)) {
+        verif->countConsecutiveFrees += 1;
+        if(verif->countConsecutiveFrees > 1) {
+            DPRINTF(DEBUG_LVL_WARN, "Blocks did not coalesce (count of %"PRIu64" at 0x%"PRIx64")\n",
+                    verif->countConsecutiveFrees, block);
+            verif->countErrors += 1;
+        }
+        verif->isPrevFree = true;
+    } else {
+        verif->countConsecutiveFrees = 0;
+        verif->isPrevFree = false;
+    }
+}
+
+typedef struct {
+    ocrMemoryStats_t *stats;
+    flagVerifier_t verif;
+    u64 count;
+} tlsfWalkStats_t;
+
+static void countBlock(u64 pgStart, u64 block, void* extra) {
+    tlsfWalkStats_t *walk = (tlsfWalkStats_t*)extra;
+    verifyFlags(pgStart, block, &(walk->verif));
+#ifdef OCR_DEBUG
+    printBlock(pgStart, block, &(walk->count));
+#endif
+    if(!isBlockFree(block)) {
+        tlsfSize_t size;
+        LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+        FENCE_LOAD;
+        walk->stats->usedCount += 1;
+        walk->stats->usedHistogram[ocrMemoryStatsClass((u64)size << ELEMENT_SIZE_LOG2)] += 1;
+    }
+}
+
+/* Adds the free blocks of the pool to 'stats' going through the
+ * free-lists. With 'check', also makes sure each block is free, in the
+ * right list and followed by a used block that knows it.
+ * Returns the number of errors found
+ */
+static u64 tlsfFreeListStats(u64 pgStart, ocrMemoryStats_t *stats, bool check) {
+    u64 errors = 0;
+    u64 nullBlock = ADDR_OF(pool_t, pgStart, nullBlock);
+    tlsfSize_t flBitMap, slBitMap;
+    int fl, sl;
+
+    LD_SIZE(flBitMap, ADDR_OF(pool_t, pgStart, flAvailOrNot));
+    FENCE_LOAD;
+    for(fl = 0; fl < FL_COUNT; ++fl) {
+        LD_SIZE(slBitMap, ADDR_OF_1(pool_t, pgStart, tlsfSize_t, slAvailOrNot, fl));
+        FENCE_LOAD;
+        if(check && ((slBitMap != 0) != ((flBitMap & BIT(fl)) != 0))) {
+            DPRINTF(DEBUG_LVL_WARN, "FL and SL lists do not match for %d\n", fl);
+            ++errors;
+        }
+        while(slBitMap != 0) {
+            headerAddr_t head = { .address = 0ULL };
+            sl = FFS(slBitMap);
+            slBitMap &= ~BIT(sl);
+            LD_SIZE(head.value, ADDR_OF_2(pool_t, pgStart, tlsfSize_t, blocks, fl, SL_COUNT, sl));
+            FENCE_LOAD;
+            u64 block = GET_ADDRESS(head);
+            if(check && (block == nullBlock)) {
+                DPRINTF(DEBUG_LVL_WARN, "Empty list marked as available for (%d, %d)\n", fl, sl);
+                ++errors;
+            }
+            while(block != nullBlock) {
+                tlsfSize_t size;
+                int tf, ts;
+                LD_SIZE(size, ADDR_OF(header_t, block, sizeBlock));
+                FENCE_LOAD;
+                if(check) {
+                    u64 next = GET_ADDRESS(getNextBlock(pgStart, block));
+                    mappingInsert(size, &tf, &ts);
+                    if(!isBlockFree(block) || (tf != fl) || (ts != sl) ||
+                       isBlockFree(next) || !isPrevBlockFree(next)) {
+                        DPRINTF(DEBUG_LVL_WARN, "Block 0x%"PRIx64" does not belong in free list (%d, %d)\n",
+                                block, fl, sl);
+                        // Its links cannot be trusted either
+                        ++errors;
+                        break;
+                    }
+                }
+                u64 bytes = (u64)size << ELEMENT_SIZE_LOG2;
+                stats->freeSize += bytes;
+                stats->freeCount += 1;
+                stats->freeHistogram[ocrMemoryStatsClass(bytes)] += 1;
+                if(bytes > stats->largestFree) {
+                    stats->largestFree = bytes;
+                }
+                block = GET_ADDRESS(getNextFreeBlock(block));
+            }
+        }
+    }
+    return errors;
+}
+
+void tlsfPoolStats(u64 pool, u64 size, ocrMemoryStats_t *stats, bool walk) {
+    u64 maxSize = ((u64)GmaxBlockRealSize) << ELEMENT_SIZE_LOG2;
+    u64 freeBefore = stats->freeSize;
+    if(size > maxSize) {
+        size = maxSize;
+    }
+    stats->errors += tlsfFreeListStats(pool, stats, walk);
+    stats->totalSize += size;
+    stats->usedSize += size - (stats->freeSize - freeBefore);
+    if(walk) {
+        tlsfWalkStats_t walker = { stats, { 0, false, 0 }, 0 };
+        tlsf_walk_heap(pool, countBlock, &walker);
+        stats->errors += walker.verif.countErrors;
+    }
+    ocrMemoryStatsUpdate(stats);
+}
+
+/******************************************************/
+/* OCR ALLOCATOR TLSF                                 */
+/******************************************************/
+
+// Pools are added in multiples of this size
+#define TLSF_POOL_GRANULE (2*1024*1024ULL)
+
+// Index of the pool holding 'address'. The allocator must be locked
+static u64 tlsfPoolOf(ocrAllocatorTlsf_t *rself, u64 address) {
+    u64 i;
+    for(i = 0; i < rself->poolCount; ++i) {
+        u64 idx = (rself->lastPool + i) % rself->poolCount;
+        if((address >= rself->pools[idx].addr) &&
+           (address < rself->pools[idx].addr + rself->pools[idx].size)) {
+            return idx;
+        }
+    }
+    ASSERT(0);
+    return 0;
+}
+
+// Adds a pool of 'poolSize' bytes. The allocator must be locked
+static bool tlsfAddPool(ocrAllocatorTlsf_t *rself, u64 poolSize) {
+    ocrAllocator_t *self = (ocrAllocator_t*)rself;
+    u64 i, addr = 0;
+    ocrMemTarget_t *memory = NULL;
+    for(i = 0; (addr == 0) && (i < self->memoryCount); ++i) {
+        // Spread the pools over the memories
+        memory = self->memories[(rself->poolCount + i) % self->memoryCount];
+        addr = (u64)memory->fctPtrs->allocate(memory, poolSize);
+    }
+    if(addr == 0) {
+        DPRINTF(DEBUG_LVL_INFO, "TLSF allocator cannot get 0x%"PRIx64" more bytes\n", poolSize);
+        return false;
+    }
+    if(tlsfInit(addr, poolSize) != 0) {
+        memory->fctPtrs->free(memory, (void*)addr);
+        return false;
+    }
+
+    if(rself->poolCount == rself->poolCapacity) {
+        rself->poolCapacity = (rself->poolCapacity == 0) ? 4 : 2*rself->poolCapacity;
+        rself->pools = (ocrAllocatorTlsfPool_t*) realloc(rself->pools,
+                                                         rself->poolCapacity*sizeof(ocrAllocatorTlsfPool_t));
+        ASSERT(rself->pools);
+    }
+    rself->pools[rself->poolCount].addr = addr;
+    rself->pools[rself->poolCount].size = poolSize;
+    rself->pools[rself->poolCount].memory = memory;
+    rself->lastPool = rself->poolCount++;
+    rself->totalSize += poolSize;
+    DPRINTF(DEBUG_LVL_INFO, "TLSF allocator added 0x%"PRIx64" bytes @ 0x%"PRIx64", now 0x%"PRIx64" bytes in %"PRIu64" pools\n",
+            poolSize, addr, rself->totalSize, rself->poolCount);
+    return true;
+}
+
+// Largest pool a single TLSF heap can manage
+static u64 tlsfMaxPoolSize() {
+    return (((u64)GmaxBlockRealSize) << ELEMENT_SIZE_LOG2) & ~(TLSF_POOL_GRANULE - 1);
+}
+
+// Adds a pool from which 'size' bytes can be allocated. The allocator must be locked
+static bool tlsfGrow(ocrAllocatorTlsf_t *rself, u64 size) {
+    // Room for the meta-data of the pool, the block and the sentinel
+    u64 needed = size + sizeof(pool_t) + ((u64)(GminBlockRealSize + 2*GusedBlockOverhead) << ELEMENT_SIZE_LOG2);
+    u64 poolSize = (needed > rself->growSize) ? needed : rself->growSize;
+    poolSize = (poolSize + TLSF_POOL_GRANULE - 1) & ~(TLSF_POOL_GRANULE - 1);
+    if(rself->maxSize != 0) {
+        if(rself->totalSize + needed > rself->maxSize) {
+            return false;
+        }
+        if(rself->totalSize + poolSize > rself->maxSize) {
+            poolSize = rself->maxSize - rself->totalSize;
+        }
+    }
+    if(needed > tlsfMaxPoolSize()) {
+        return false;
+    }
+    if(poolSize > tlsfMaxPoolSize()) {
+        poolSize = tlsfMaxPoolSize();
+    }
+    return tlsfAddPool(rself, poolSize);
+}
+
+// Allocates from the pools, adding one if they are all full. The allocator must be locked
+static u64 tlsfAllocateLocked(ocrAllocatorTlsf_t *rself, u64 size) {
+    u64 i;
+    for(i = 0; i < rself->poolCount; ++i) {
+        u64 idx = (rself->lastPool + i) % rself->poolCount;
+        u64 result = tlsfMalloc(rself->pools[idx].addr, size);
+        if(result) {
+            rself->lastPool = idx;
+            return result;
+        }
+    }
+    if(tlsfGrow(rself, size)) {
+        return tlsfMalloc(rself->pools[rself->lastPool].addr, size);
+    }
+    return _NULL;
+}
+
 static void tlsfDestruct(ocrAllocator_t *self) {
     ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
-    if(self->memoryCount)
-        self->memories[0]->fctPtrs->free(self->memories[0], (void*)rself->addr);
+    u64 i;
+    for(i = 0; i < rself->poolCount; ++i) {
+        ocrMemTarget_t *memory = rself->pools[i].memory;
+        memory->fctPtrs->free(memory, (void*)rself->pools[i].addr);
+    }
+    free(rself->pools);
     rself->lock->fctPtrs->destruct(rself->lock);
     free(self->memories);
 
@@ -992,13 +1308,15 @@ static void tlsfDestruct(ocrAllocator_t *self) {
 }
 
 static void tlsfStart(ocrAllocator_t *self, ocrPolicyDomain_t * PD ) {
-    // Do the allocation
+    // Do the allocation of the first pool
     ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
-    ASSERT(self->memoryCount == 1);
-    rself->addr = rself->poolAddr = (u64)(rself->base.memories[0]->fctPtrs->allocate(
-                                              rself->base.memories[0], rself->totalSize));
-    ASSERT(rself->addr);
-    RESULT_ASSERT(tlsfInit(rself->addr, rself->totalSize), ==, 0);
+    ASSERT(self->memoryCount >= 1);
+    u64 poolSize = rself->growSize;
+    if(poolSize > tlsfMaxPoolSize()) {
+        // The rest is added as more pools when needed
+        poolSize = tlsfMaxPoolSize();
+    }
+    RESULT_ASSERT(tlsfAddPool(rself, poolSize), ==, true);
 }
 
 static void tlsfStop(ocrAllocator_t *self) { }
@@ -1006,7 +1324,7 @@ static void tlsfStop(ocrAllocator_t *self) { }
 static void* tlsfAllocate(ocrAllocator_t *self, u64 size) {
     ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
     rself->lock->fctPtrs->lock(rself->lock);
-    void* toReturn = (void*)tlsfMalloc(rself->addr, size);
+    void* toReturn = (void*)tlsfAllocateLocked(rself, size);
     rself->lock->fctPtrs->unlock(rself->lock);
     return toReturn;
 }
@@ -1014,16 +1332,166 @@ static void* tlsfAllocate(ocrAllocator_t *self, u64 size) {
 static void tlsfDeallocate(ocrAllocator_t *self, void* address) {
     ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
     rself->lock->fctPtrs->lock(rself->lock);
-    tlsfFree(rself->addr, (u64)address);
+    u64 pgStart = rself->pools[tlsfPoolOf(rself, (u64)address)].addr;
+    // Freeing a large chunk releases the pages of the free block it ends up in
+    bool release = (rself->releaseSize != 0) && (tlsfUsableSize(pgStart, (u64)address) >= rself->releaseSize);
+    u64 block = tlsfFree(pgStart, (u64)address);
+    if(release) {
+        tlsfReleaseBlock(block);
+    }
     rself->lock->fctPtrs->unlock(rself->lock);
 }
 
 static void* tlsfReallocate(ocrAllocator_t *self, void* address, u64 size) {
     ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
     rself->lock->fctPtrs->lock(rself->lock);
-    void* toReturn = (void*)(tlsfRealloc(rself->addr, (u64)address, size));
+    u64 toReturn;
+    if(address == NULL) {
+        toReturn = tlsfAllocateLocked(rself, size);
+    } else {
+        u64 pgStart = rself->pools[tlsfPoolOf(rself, (u64)address)].addr;
+        toReturn = tlsfRealloc(pgStart, (u64)address, size);
+        if((toReturn == _NULL) && (size != 0)) {
+            // Move to another pool
+            toReturn = tlsfAllocateLocked(rself, size);
+            if(toReturn) {
+                u64 oldSize = tlsfUsableSize(pgStart, (u64)address);
+                MALLOC_COPY((void*)toReturn, address, (oldSize < size) ? oldSize : size);
+                tlsfFree(pgStart, (u64)address);
+            }
+        }
+    }
     rself->lock->fctPtrs->unlock(rself->lock);
-    return toReturn;
+    return (void*)toReturn;
+}
+
+static u8 tlsfGetStats(ocrAllocator_t *self, ocrMemoryStats_t *stats, bool walk) {
+    ocrAllocatorTlsf_t *rself = (ocrAllocatorTlsf_t*)self;
+    u64 i;
+    rself->lock->fctPtrs->lock(rself->lock);
+    for(i = 0; i < rself->poolCount; ++i) {
+        tlsfPoolStats(rself->pools[i].addr, rself->pools[i].size, stats, walk);
+    }
+    if((rself->maxSize == 0) || (stats->growableSize == (u64)-1)) {
+        stats->growableSize = (u64)-1;
+    } else if(rself->maxSize > rself->totalSize) {
+        stats->growableSize += rself->maxSize - rself->totalSize;
+    }
+    rself->lock->fctPtrs->unlock(rself->lock);
+    return 0;
+}
+
+/******************************************************/
+/* TLSF HEAPS IN A MEMORY REGION                      */
+/******************************************************/
+
+// Header of a heap laid out in a region; the TLSF pool follows it
+typedef struct {
+    volatile u32 lock;
+    u32 _padding;
+    tlsfSize_t poolRealSize;    /**< Number of elements managed by the pool */
+} tlsfRegionHeader_t;
+
+myStaticAssert(sizeof(tlsfRegionHeader_t) % ALIGN_BYTES == 0);
+
+#define REGION_POOL(region) ((u64)(region) + sizeof(tlsfRegionHeader_t))
+
+static void tlsfRegionLock(void* region) {
+    tlsfRegionHeader_t *header = (tlsfRegionHeader_t*)region;
+    while(!__sync_bool_compare_and_swap(&(header->lock), 0, 1)) ;
+}
+
+static void tlsfRegionUnlock(void* region) {
+    tlsfRegionHeader_t *header = (tlsfRegionHeader_t*)region;
+    __sync_lock_release(&(header->lock));
+}
+
+u8 tlsfRegionInit(void* region, u64 size) {
+    u64 maxSize = ((u64)GmaxBlockRealSize) << ELEMENT_SIZE_LOG2;
+    if(size > maxSize) {
+        size = maxSize;
+    }
+    // Leave room for the header, the pool and at least a minimal block
+    if(size < sizeof(tlsfRegionHeader_t) + sizeof(pool_t) +
+       ((u64)(GminBlockRealSize + 2*GusedBlockOverhead) << ELEMENT_SIZE_LOG2)) {
+        return ENOMEM;
+    }
+    ((tlsfRegionHeader_t*)region)->lock = 0;
+    ((tlsfRegionHeader_t*)region)->poolRealSize = tlsfPoolRealSize(size - sizeof(tlsfRegionHeader_t));
+    if(tlsfInit(REGION_POOL(region), size - sizeof(tlsfRegionHeader_t)) != 0) {
+        return ENOMEM;
+    }
+    return 0;
+}
+
+void tlsfRegionGrow(void* region, u64 size) {
+    tlsfRegionHeader_t *header = (tlsfRegionHeader_t*)region;
+    u64 maxSize = ((u64)GmaxBlockRealSize) << ELEMENT_SIZE_LOG2;
+    if(size > maxSize) {
+        size = maxSize;
+    }
+    u64 pgStart = REGION_POOL(region);
+    tlsfSize_t poolRealSize = tlsfPoolRealSize(size - sizeof(tlsfRegionHeader_t));
+    tlsfRegionLock(region);
+    tlsfSize_t oldRealSize = header->poolRealSize;
+    // Tails too small to hold a block are picked up by a later growth
+    if(poolRealSize >= oldRealSize + GminBlockRealSize + GusedBlockOverhead) {
+        u64 mainBlock = ADDR_OF(pool_t, pgStart, mainBlock);
+        u64 tail = mainBlock + ((oldRealSize - GusedBlockOverhead) << ELEMENT_SIZE_LOG2);
+        u64 sentinel = mainBlock + ((poolRealSize - GusedBlockOverhead) << ELEMENT_SIZE_LOG2);
+        ST_SIZE(ADDR_OF(header_t, sentinel, sizeBlock), 0);
+        ST_SIZE(ADDR_OF(header_t, sentinel, prevFreeBlock), 0);
+        // The old sentinel becomes a used block spanning the new
+        // space up to the new sentinel, then is freed like any other
+        ST_SIZE(ADDR_OF(header_t, tail, sizeBlock), poolRealSize - oldRealSize - GusedBlockOverhead);
+        FENCE_STORE;
+        tlsfFree(pgStart, addressForBlock(tail));
+        header->poolRealSize = poolRealSize;
+    }
+    tlsfRegionUnlock(region);
+}
+
+u64 tlsfRegionMalloc(void* region, u64 size) {
+    tlsfRegionLock(region);
+    u64 result = tlsfMalloc(REGION_POOL(region), size);
+    tlsfRegionUnlock(region);
+    return (result == _NULL) ? 0 : (result - (u64)region);
+}
+
+void tlsfRegionFree(void* region, u64 offset) {
+    tlsfRegionLock(region);
+    tlsfFree(REGION_POOL(region), (u64)region + offset);
+    tlsfRegionUnlock(region);
+}
+
+/******************************************************/
+/* TLSF POOLS SERIALIZED BY THE CALLER                */
+/******************************************************/
+
+u8 tlsfPoolInit(u64 pool, u64 size) {
+    u64 maxSize = ((u64)GmaxBlockRealSize) << ELEMENT_SIZE_LOG2;
+    if(size > maxSize) {
+        size = maxSize;
+    }
+    if(size < sizeof(pool_t) + ((u64)(GminBlockRealSize + 2*GusedBlockOverhead) << ELEMENT_SIZE_LOG2)) {
+        return ENOMEM;
+    }
+    if(tlsfInit(pool, size) != 0) {
+        return ENOMEM;
+    }
+    return 0;
+}
+
+u64 tlsfPoolMalloc(u64 pool, u64 size) {
+    return tlsfMalloc(pool, size);
+}
+
+void tlsfPoolFree(u64 pool, u64 ptr) {
+    tlsfFree(pool, ptr);
+}
+
+u64 tlsfPoolRealloc(u64 pool, u64 ptr, u64 size) {
+    return tlsfRealloc(pool, ptr, size);
 }
 
 // Method to create the TLSF allocator
@@ -1039,8 +1507,12 @@ static ocrAllocator_t * newAllocatorTlsf(ocrAllocatorFactory_t * factory, ocrPar
 
     paramListAllocatorInst_t *perInstanceReal = (paramListAllocatorInst_t*)perInstance;
 
-    result->addr = result->poolAddr = 0ULL;
-    result->totalSize = result->poolSize = perInstanceReal->size;
+    result->pools = NULL;
+    result->poolCount = result->poolCapacity = result->lastPool = 0;
+    result->totalSize = 0;
+    result->growSize = perInstanceReal->size;
+    result->maxSize = perInstanceReal->maxSize;
+    result->releaseSize = perInstanceReal->releaseSize;
 
     ocrPolicyDomain_t *pd = getCurrentPD();
     ocrPolicyCtx_t *ctx = getCurrentWorkerContext();
@@ -1071,140 +1543,6 @@ ocrAllocatorFactory_t * newAllocatorFactoryTlsf(ocrParamList_t *perType) {
     base->allocFcts.allocate = &tlsfAllocate;
     base->allocFcts.free = &tlsfDeallocate;
     base->allocFcts.reallocate = &tlsfReallocate;
+    base->allocFcts.getStats = &tlsfGetStats;
     return base;
 }
-// Deactivated for now. Need to clean-up
-#if 0 && defined(OCR_DEBUG)
-/* Some debug functions to see what is going on */
-
-
-static void printBlock(void *block_, void* extra) {
-    header_t *bl = (header_t*)block_;
-    int *count = (int*)extra;
-    fprintf(stderr, "\tBlock %d starts at 0x%lx (user: 0x%lx) of size %d (user: %d) %s\n",
-            *count, bl, (char*)bl + (GusedBlockOverhead << ELEMENT_SIZE_LOG2),
-            bl->sizeBlock, (bl->sizeBlock << ELEMENT_SIZE_LOG2),
-            isBlockFree(bl)?"free":"used");
-    *count += 1;
-}
-
-typedef struct flagVerifier_t {
-    int countConsecutiveFrees;
-    BOOL isPrevFree;
-    int countErrors;
-} flagVerifier_t;
-
-static void verifyFlags(void *block_, void* extra) {
-    header_t *bl = (header_t*)block_;
-    flagVerifier_t* verif = (flagVerifier_t*)extra;
-
-    if(isPrevBlockFree(bl) != verif->isPrevFree) {
-        verif->countErrors += 1;
-        fprintf(stderr, "Mismatch in free flag for block 0x%x\n", bl);
-    }
-    if(isBlockFree(bl)) {
-        verif->countConsecutiveFrees += 1;
-        if(verif->countConsecutiveFrees > 1) {
-            fprintf(stderr, "Blocks did not coalesce (count of %d at 0x%x)\n",
-                    verif->countConsecutiveFrees, bl);
-            verif->countErrors += 1;
-        }
-        verif->isPrevFree = TRUE;
-    } else {
-        verif->countConsecutiveFrees = 0;
-        verif->isPrevFree = FALSE;
-    }
-}
-
-void tlsf_walk_heap(u64 pgStart, tlsf_walkerAction action, void* extra) {
-    pool_t *poolToUse = (pool_t*)pgStart;
-    if(action == 0) {
-        action = (tlsf_walkerAction)printBlock;
-    }
-    header_t *bl = &(poolToUse->mainBlock);
-
-    while(bl && !(bl->sizeBlock == 0)) {
-        action(bl, extra);
-        bl = GET_ADDRESS(getNextBlock(pgStart, bl));
-    }
-}
-
-/* Will check to make sure the heap is properly maintained
- *
- * Return the number of errors
- */
-int tlsf_check_heap(u64 pgStart, unsigned int *freeRemaining) {
-    pool_t *poolToUse = (pool_t*)pgStart;
-    int errCount = 0;
-    unsigned int countFree = 0;
-    flagVerifier_t verif = {0, FALSE, 0};
-
-    tlsf_walk_heap(pgStart, verifyFlags, &verif);
-    if(verif.countErrors) {
-        errCount += verif.countErrors;
-        fprintf(stderr, "Mismatch in free flags or coalescing\n");
-    }
-
-    // Check the bitmaps
-    for(int i=0; i < FL_COUNT; ++i) {
-        bool hasFlAvail = poolToUse->flAvailOrNot & (1 << i);
-        for(int j=0; j < SL_COUNT; ++j) {
-            bool hasSlAvail = poolToUse->slAvailOrNot[i] & (1 << j);
-
-            headerAddr_t blockHead;
-            blockHead.value = poolToUse->blocks[i][j];
-
-            if(!hasFlAvail && hasSlAvail) {
-                ++errCount;
-                fprintf(stderr, "FL and SL lists do not match for (%d, %d)\n", i, j);
-            }
-
-            if(!hasSlAvail && (GET_ADDRESS(blockHead) != &(poolToUse->nullBlock))) {
-                ++errCount;
-                fprintf(stderr, "Empty list does not start with nullBLock for (%d, %d)\n", i, j);
-            }
-            if(hasSlAvail) {
-                // We now check all the blocks
-                header_t *blockHeadPtr = GET_ADDRESS(blockHead);
-                while(blockHeadPtr != &(poolToUse->nullBlock)) {
-                    if(!isBlockFree(blockHeadPtr)) {
-                        fprintf(stderr, "Block 0x%x should be free for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-                    if(isBlockFree(GET_ADDRESS(getNextBlock(pgStart, blockHeadPtr)))) {
-                        fprintf(stderr, "Block 0x%x should have coalesced with next for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-                    if(!isPrevBlockFree(GET_ADDRESS(getNextBlock(pgStart, blockHeadPtr)))) {
-                        fprintf(stderr, "Block 0x%x is not prevFree for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-                    if(blockHeadPtr != GET_ADDRESS(getPrevBlock(pgStart, GET_ADDRESS(getNextBlock(pgStart, blockHeadPtr))))) {
-
-                        fprintf(stderr, "Block 0x%x cannot be back-reached for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-                    if(blockHeadPtr->sizeBlock < (GminBlockRealSize - GusedBlockOverhead)
-                       || blockHeadPtr->sizeBlock > GmaxBlockRealSize) {
-
-                        fprintf(stderr, "Block 0x%x has illegal size for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-
-                    int tf, ts;
-                    mappingInsert(blockHeadPtr->sizeBlock, &tf, &ts);
-                    if(tf != i || ts != j) {
-                        fprintf(stderr, "Block 0x%x is in wrong bucket for (%d, %d)\n", blockHeadPtr, i, j);
-                        ++errCount;
-                    }
-                    countFree += blockHeadPtr->sizeBlock;
-                    blockHead = getNextFreeBlock(blockHeadPtr);
-                    blockHeadPtr = GET_ADDRESS(blockHead);
-                }
-            }
-        }
-    }
-    *freeRemaining = countFree << ELEMENT_SIZE_LOG2;
-    return errCount;
-}
-#endif /* OCR_DEBUG */
@@ -20,11 +20,118 @@ typedef struct {
     ocrAllocatorFactory_t base;
 } ocrAllocatorFactoryTlsf_t;
 
+/**
+ * @brief Chunk of memory obtained from a memory target and managed as
+ * one TLSF pool
+ */
+typedef struct {
+    u64 addr, size;
+    struct _ocrMemTarget_t *memory;
+} ocrAllocatorTlsfPool_t;
+
+/**
+ * @brief TLSF allocator over a growing set of pools
+ *
+ * The first pool has the size given at creation. When no pool has room
+ * for a request, the allocator asks its memory targets for a new pool
+ * of at least that size, until the pools reach maxSize. Freeing a chunk
+ * of at least releaseSize bytes gives the pages of the free block it
+ * ends up in back to the OS
+ */
 typedef struct {
     ocrAllocator_t base;
-    u64 addr, totalSize, poolAddr, poolSize;
-    ocrLock_t* lock; /**< Currently needs a lock. The idea is to have multiple allocators but currently only one */
+    ocrAllocatorTlsfPool_t *pools;
+    u64 poolCount, poolCapacity;
+    u64 lastPool;       /**< Pool of the last allocation, tried first */
+    u64 totalSize;      /**< Size of all the pools */
+    u64 growSize;       /**< Minimum size of a pool */
+    u64 maxSize;        /**< Bound on totalSize, 0 for none */
+    u64 releaseSize;    /**< Smallest free releasing pages, 0 to never release */
+    ocrLock_t* lock;    /**< Serializes the calls on all the pools */
 } ocrAllocatorTlsf_t;
 
 extern ocrAllocatorFactory_t* newAllocatorFactoryTlsf(ocrParamList_t *perType);
+
+/**
+ * @brief Functions managing a TLSF heap laid out in a memory region
+ * given by the caller, such as the memory of a data-block
+ *
+ * The heap's lock and meta-data live in the region itself and only
+ * hold offsets so the region can be moved or copied as a whole.
+ * Allocations are identified by their offset from the start of the
+ * region. Offset 0 is never returned for an allocation
+ */
+
+/**
+ * @brief Lays out an empty heap over 'size' bytes at 'region'
+ *
+ * Regions larger than what TLSF can address only have their
+ * beginning managed
+ *
+ * @return 0 on success or ENOMEM if the region is too small
+ */
+u8 tlsfRegionInit(void* region, u64 size);
+
+/**
+ * @brief Adds the space of a region grown to 'size' bytes to its heap
+ *
+ * The heap keeps its allocations; the new tail becomes a free block
+ */
+void tlsfRegionGrow(void* region, u64 size);
+
+/**
+ * @brief Allocates 'size' bytes in the heap at 'region'
+ * @return The offset of the allocated chunk or 0 on failure
+ */
+u64 tlsfRegionMalloc(void* region, u64 size);
+
+/**
+ * @brief Frees the chunk at 'offset' in the heap at 'region'
+ */
+void tlsfRegionFree(void* region, u64 offset);
+
+/**
+ * @brief Functions managing a TLSF pool laid out at a given address
+ *
+ * Unlike the heaps in a region, these do no locking: the caller
+ * serializes all the calls on a given pool. Pointers are absolute
+ * addresses and 0 means failure
+ */
+
+/**
+ * @brief Lays out an empty pool over 'size' bytes at 'pool'
+ *
+ * Pools larger than what TLSF can address only have their
+ * beginning managed
+ *
+ * @return 0 on success or ENOMEM if the space is too small
+ */
+u8 tlsfPoolInit(u64 pool, u64 size);
+
+/**
+ * @brief Allocates 'size' bytes in the pool at 'pool'
+ * @return The address of the allocated chunk or 0 on failure
+ */
+u64 tlsfPoolMalloc(u64 pool, u64 size);
+
+/**
+ * @brief Frees the chunk at 'ptr' in the pool at 'pool'
+ */
+void tlsfPoolFree(u64 pool, u64 ptr);
+
+/**
+ * @brief Resizes the chunk at 'ptr' within the pool at 'pool'
+ *
+ * Follows the rules of realloc() on a 0 'ptr' or 'size'
+ * @return The address of the resized chunk or 0 on failure
+ */
+u64 tlsfPoolRealloc(u64 pool, u64 ptr, u64 size);
+
+/**
+ * @brief Adds the state of the pool of 'size' bytes at 'pool' to 'stats'
+ *
+ * See ocrAllocatorFcts_t.getStats. Only the free-lists are visited
+ * unless 'walk' is true
+ */
+void tlsfPoolStats(u64 pool, u64 size, ocrMemoryStats_t *stats, bool walk);
 #endif /* __TLSF_ALLOCATOR_H__ */
@@ -10,24 +10,87 @@
 
 
 #include "debug.h"
+#include "allocator/tlsf/tlsf-allocator.h"
+#include "datablock/cow/db-cow.h"
+#include "datablock/spill/db-spill.h"
 #include "ocr-allocator.h"
 #include "ocr-datablock.h"
 #include "ocr-db.h"
+#include "ocr-edt.h"
+#include "ocr-macros.h"
+#include "ocr-parallel.h"
 #include "ocr-policy-domain-getter.h"
 #include "ocr-policy-domain.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #if (__STDC_HOSTED__ == 1)
 #include <string.h>
 #endif
 
+#if defined(__SSE2__) && (__STDC_HOSTED__ == 1)
+#include <emmintrin.h>
+#endif
+
 #ifdef OCR_ENABLE_STATISTICS
 #include "ocr-statistics.h"
 #include "ocr-stat-user.h"
 #endif
 
 
+// Registers a data-block that was just created and acquires it for the current EDT
+static void dbCreated(ocrDataBlock_t *createdDb, ocrGuid_t *db, void** addr) {
+    *db = createdDb->guid;
+
+#ifdef OCR_ENABLE_STATISTICS
+    // Create the statistics process for this DB.
+    ocrStatsProcessCreate(&(createdDb->statProcess), createdDb->guid);
+    ocrStatsFilter_t *t = NEW_FILTER(simple);
+    t->create(t, GocrFilterAggregator, NULL);
+    ocrStatsProcessRegisterFilter(&(createdDb->statProcess), (0x3F<<((u32)STATS_DB_CREATE-1)), t);
+#endif
+
+    ocrGuid_t edtGuid = getCurrentEDT();
+#ifdef OCR_ENABLE_STATISTICS
+    {
+        ocrTask_t *task = NULL;
+        deguidify(getCurrentPD(), edtGuid, (u64*)&task, NULL);
+        ocrStatsProcess_t *srcProcess = edtGuid==0?&GfakeProcess:&(task->statProcess);
+
+        ocrStatsMessage_t *mess = NEW_MESSAGE(simple);
+        mess->create(mess, STATS_DB_CREATE, 0, edtGuid, createdDb->guid, NULL);
+        ocrStatsAsyncMessage(srcProcess, &(createdDb->statProcess), mess);
+
+        // Acquire part
+        *addr = createdDb->fctPtrs->acquire(createdDb, edtGuid, false);
+        ocrStatsMessage_t *mess2 = NEW_MESSAGE(simple);
+        mess2->create(mess2, STATS_DB_ACQ, 0, edtGuid, createdDb->guid, NULL);
+        ocrStatsSyncMessage(srcProcess, &(createdDb->statProcess), mess2);
+    }
+#else
+    *addr = createdDb->fctPtrs->acquire(createdDb, edtGuid, false);
+#endif
+    if(*addr != NULL) {
+        *addr = ocrDbPin(createdDb, edtGuid, false);
+    }
+}
+
+// Creates a data-block on the copy-on-write mapping 'cow'
+static ocrDataBlock_t * dbCreateCow(ocrPolicyDomain_t *policy, ocrDbCow_t *cow, u64 len, u16 flags) {
+    if(cow == NULL) {
+        return NULL;
+    }
+    ocrDataBlock_t *createdDb = policy->dbFactory->instantiate(
+        policy->dbFactory, NULL_GUID, policy->guid, len, cow->addr, flags | DB_PROP_SNAPSHOT, NULL);
+    createdDb->cow = cow;
+    return createdDb;
+}
+
 u8 ocrDbCreate(ocrGuid_t *db, void** addr, u64 len, u16 flags,
                ocrGuid_t affinity, ocrInDbAllocator_t allocator) {
 
@@ -40,43 +103,24 @@ u8 ocrDbCreate(ocrGuid_t *db, void** addr, u64 len, u16 flags,
     //
     ocrPolicyDomain_t* policy = getCurrentPD();
     ocrPolicyCtx_t* ctx = getCurrentWorkerContext();
-    // TODO: Pass ocrInDbAllocator_t down to the DB factory
-    if(policy->allocateDb(
+    if(flags & DB_PROP_SNAPSHOT) {
+        ocrDataBlock_t *createdDb = dbCreateCow(policy, newDbCow(len), len, flags);
+        if((createdDb == NULL) ||
+           ((allocator == TLSF_ALLOC) && (tlsfRegionInit(createdDb->ptr, len) != 0))) {
+            if(createdDb != NULL) {
+                createdDb->fctPtrs->free(createdDb, NULL_GUID);
+            }
+            *addr = NULL;
+            return ENOMEM;
+        }
+        createdDb->inDbAllocator = allocator;
+        dbCreated(createdDb, db, addr);
+    } else if(policy->allocateDb(
            policy, db, addr, len, flags, affinity, allocator, ctx) == 0) {
 
         ocrDataBlock_t* createdDb;
         deguidify(policy, *db, (u64*)&createdDb, NULL);
-        
-        *db = createdDb->guid;
-
-#ifdef OCR_ENABLE_STATISTICS
-        // Create the statistics process for this DB.
-        ocrStatsProcessCreate(&(createdDb->statProcess), createdDb->guid);
-        ocrStatsFilter_t *t = NEW_FILTER(simple);
-        t->create(t, GocrFilterAggregator, NULL);
-        ocrStatsProcessRegisterFilter(&(createdDb->statProcess), (0x3F<<((u32)STATS_DB_CREATE-1)), t);
-#endif
-
-        ocrGuid_t edtGuid = getCurrentEDT();
-#ifdef OCR_ENABLE_STATISTICS
-        {
-            ocrTask_t *task = NULL;
-            deguidify(getCurrentPD(), edtGuid, (u64*)&task, NULL);
-            ocrStatsProcess_t *srcProcess = edtGuid==0?&GfakeProcess:&(task->statProcess);
-            
-            ocrStatsMessage_t *mess = NEW_MESSAGE(simple);
-            mess->create(mess, STATS_DB_CREATE, 0, edtGuid, createdDb->guid, NULL);
-            ocrStatsAsyncMessage(srcProcess, &(createdDb->statProcess), mess);
-
-            // Acquire part
-            *addr = createdDb->fctPtrs->acquire(createdDb, edtGuid, false);
-            ocrStatsMessage_t *mess2 = NEW_MESSAGE(simple);
-            mess2->create(mess2, STATS_DB_ACQ, 0, edtGuid, createdDb->guid, NULL);
-            ocrStatsSyncMessage(srcProcess, &(createdDb->statProcess), mess2);
-        }
-#else
-        *addr = createdDb->fctPtrs->acquire(createdDb, edtGuid, false);
-#endif
+        dbCreated(createdDb, db, addr);
     } else {
         *addr = NULL;
     }
@@ -85,6 +129,152 @@ u8 ocrDbCreate(ocrGuid_t *db, void** addr, u64 len, u16 flags,
     return 0;
 }
 
+u8 ocrDbCreateFromFile(ocrGuid_t *db, void** addr, const char* path, u64 offset, u64 len,
+                       u16 flags, ocrGuid_t affinity) {
+    *addr = NULL;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return errno;
+    }
+    struct stat fileStat;
+    if((fstat(fd, &fileStat) != 0) || (offset > (u64)fileStat.st_size)) {
+        close(fd);
+        return EINVAL;
+    }
+    if(len == 0) {
+        len = (u64)fileStat.st_size - offset;
+    }
+    if((len == 0) || (len > ((u64)fileStat.st_size - offset))) {
+        close(fd);
+        return EINVAL;
+    }
+
+    // mmap() needs a page-aligned offset: map from the page holding
+    // the start of the range and point the data-block inside it
+    u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+    u64 mapOffset = offset & ~(pageSize - 1);
+    bool isPrivate = (flags & DB_PROP_MAP_PRIVATE) != 0;
+    void * map = mmap(NULL, len + (offset - mapOffset),
+                      isPrivate ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                      isPrivate ? MAP_PRIVATE : MAP_SHARED, fd, (off_t)mapOffset);
+    close(fd);
+    if(map == MAP_FAILED) {
+        return ENOMEM;
+    }
+    if(flags & DB_PROP_MAP_SEQUENTIAL) {
+        madvise(map, len + (offset - mapOffset), MADV_SEQUENTIAL);
+    } else if(flags & DB_PROP_MAP_RANDOM) {
+        madvise(map, len + (offset - mapOffset), MADV_RANDOM);
+    }
+
+    ocrPolicyDomain_t* policy = getCurrentPD();
+    ocrDataBlock_t *createdDb = policy->dbFactory->instantiate(
+        policy->dbFactory, NULL_GUID, policy->guid, len, (char*)map + (offset - mapOffset),
+        flags | DB_PROP_MAPPED, NULL);
+    dbCreated(createdDb, db, addr);
+    return 0;
+}
+
+u8 ocrDbCreateView(ocrGuid_t *view, void** addr, ocrGuid_t parent, u64 offset, u64 len,
+                   u16 flags) {
+    *addr = NULL;
+    if(!isDatablockGuid(parent)) {
+        return EINVAL;
+    }
+    ocrPolicyDomain_t* policy = getCurrentPD();
+    ocrDataBlock_t *parentDb = NULL;
+    deguidify(policy, parent, (u64*)&parentDb, NULL);
+    if((len == 0) || (offset > parentDb->size) || (len > (parentDb->size - offset))) {
+        return EINVAL;
+    }
+    ocrDataBlock_t *createdDb = policy->dbFactory->instantiate(
+        policy->dbFactory, NULL_GUID, policy->guid, len, NULL, flags, NULL);
+    // The view holds its parent until it is destroyed, which also
+    // keeps the parent from being evicted
+    if(parentDb->fctPtrs->acquire(parentDb, createdDb->guid, false) == NULL) {
+        createdDb->fctPtrs->free(createdDb, NULL_GUID);
+        return EPERM;
+    }
+    void *parentPtr = ocrDbPin(parentDb, createdDb->guid, false);
+    if(parentPtr == NULL) {
+        parentDb->fctPtrs->release(parentDb, createdDb->guid, false);
+        createdDb->fctPtrs->free(createdDb, NULL_GUID);
+        return ENOMEM;
+    }
+    createdDb->ptr = (char*)parentPtr + offset;
+    createdDb->parent = parent;
+    dbCreated(createdDb, view, addr);
+    return 0;
+}
+
+u8 ocrDbCreateView2D(ocrGuid_t *view, void** addr, ocrGuid_t parent, u64 offset,
+                     u64 rowSize, u64 rows, u64 stride, u16 flags) {
+    if((rowSize == 0) || (rows == 0) || (stride < rowSize)) {
+        *addr = NULL;
+        return EINVAL;
+    }
+    // The view spans from its first byte to the end of its last row
+    return ocrDbCreateView(view, addr, parent, offset, (rows - 1)*stride + rowSize, flags);
+}
+
+u8 ocrDbSnapshot(ocrGuid_t *snapshot, void** addr, ocrGuid_t source) {
+    *addr = NULL;
+    if(!isDatablockGuid(source)) {
+        return EINVAL;
+    }
+    ocrPolicyDomain_t* policy = getCurrentPD();
+    ocrDataBlock_t *sourceDb = NULL;
+    deguidify(policy, source, (u64*)&sourceDb, NULL);
+    if(sourceDb->cow == NULL) {
+        // Nothing to share with: the copy can be snapshotted cheaply in turn
+        u8 status = ocrDbCreate(snapshot, addr, sourceDb->size, DB_PROP_SNAPSHOT, NULL_GUID, NO_ALLOC);
+        if(status == 0) {
+            memcpy(*addr, sourceDb->ptr, sourceDb->size);
+            ocrDataBlock_t *createdDb = NULL;
+            deguidify(policy, *snapshot, (u64*)&createdDb, NULL);
+            createdDb->inDbAllocator = sourceDb->inDbAllocator;
+        }
+        return status;
+    }
+    ocrDataBlock_t *createdDb = dbCreateCow(policy, dbCowSnapshot(sourceDb->cow), sourceDb->size, 0);
+    if(createdDb == NULL) {
+        return ENOMEM;
+    }
+    createdDb->inDbAllocator = sourceDb->inDbAllocator;
+    dbCreated(createdDb, snapshot, addr);
+    return 0;
+}
+
+void ocrDbReleaseMemory(ocrDataBlock_t *self) {
+    if(self->parent != NULL_GUID) {
+        ocrDataBlock_t *parentDb = NULL;
+        deguidify(getCurrentPD(), self->parent, (u64*)&parentDb, NULL);
+        ocrDbUnpin(parentDb, self->guid, false);
+        parentDb->fctPtrs->release(parentDb, self->guid, false);
+    } else if(self->cow != NULL) {
+        destructDbCow(self->cow);
+        self->cow = NULL;
+    } else if(self->properties & DB_PROP_MAPPED) {
+        u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+        u64 start = ((u64)self->ptr) & ~(pageSize - 1);
+        munmap((void*)start, self->size + (((u64)self->ptr) - start));
+    } else if((self->allocator != NULL_GUID) &&
+              ((self->spill == NULL) || dbSpillUnregister(self))) {
+        // Tell the allocator to free the data-block, unless it is evicted
+        ocrAllocator_t *allocator = NULL;
+        deguidify(getCurrentPD(), self->allocator, (u64*)&allocator, NULL);
+        allocator->fctPtrs->free(allocator, self->ptr);
+    }
+}
+
+void ocrDbAdvise(ocrDataBlock_t *self) {
+    if(self->properties & DB_PROP_MAPPED) {
+        u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+        u64 start = ((u64)self->ptr) & ~(pageSize - 1);
+        madvise((void*)start, self->size + (((u64)self->ptr) - start), MADV_WILLNEED);
+    }
+}
+
 u8 ocrDbDestroy(ocrGuid_t db) {
     ocrDataBlock_t *dataBlock = NULL;
 
@@ -107,6 +297,7 @@ u8 ocrDbDestroy(ocrGuid_t db) {
 #endif
     // Make sure you do the free *AFTER* sending the message because the free could
     // destroy the datablock (and the stat process).
+    ocrDbUnpin(dataBlock, edtGuid, false);
     u8 status = dataBlock->fctPtrs->free(dataBlock, edtGuid);
     return status;
 }
@@ -118,6 +309,14 @@ u8 ocrDbAcquire(ocrGuid_t db, void** addr, u16 flags) {
     ocrGuid_t edtGuid = getCurrentEDT();
 
     *addr = dataBlock->fctPtrs->acquire(dataBlock, edtGuid, false);
+    if(*addr != NULL) {
+        *addr = ocrDbPin(dataBlock, edtGuid, false);
+        if(*addr == NULL) {
+            // Evicted and no memory to read it back
+            dataBlock->fctPtrs->release(dataBlock, edtGuid, false);
+            return ENOMEM;
+        }
+    }
 #ifdef OCR_ENABLE_STATISTICS
     {
         ocrTask_t *task = NULL;
@@ -139,6 +338,7 @@ u8 ocrDbRelease(ocrGuid_t db) {
     deguidify(getCurrentPD(), db, (u64*)&dataBlock, NULL);
 
     ocrGuid_t edtGuid = getCurrentEDT();
+    ocrDbUnpin(dataBlock, edtGuid, false);
 #ifdef OCR_ENABLE_STATISTICS
     {
         ocrTask_t *task = NULL;
@@ -160,95 +360,263 @@ u8 ocrDbRelease(ocrGuid_t db) {
 #endif
 }
 
-u8 ocrDbMalloc(ocrGuid_t guid, u64 size, void** addr) {
-    return EINVAL; /* not yet implemented */
+u8 ocrDbResize(ocrGuid_t db, u64 size, void** addr) {
+    if(!isDatablockGuid(db) || (size == 0)) {
+        return EINVAL;
+    }
+    ocrDataBlock_t *dataBlock = NULL;
+    deguidify(getCurrentPD(), db, (u64*)&dataBlock, NULL);
+    // Views, file mappings and snapshots do not own allocator memory
+    if(dataBlock->allocator == NULL_GUID) {
+        return EPERM;
+    }
+    if((dataBlock->inDbAllocator == TLSF_ALLOC) && (size < dataBlock->size)) {
+        return EINVAL;
+    }
+    u64 oldSize = dataBlock->size;
+    u8 status = dataBlock->fctPtrs->resize(dataBlock, getCurrentEDT(), size);
+    if(status == 0) {
+        if((dataBlock->inDbAllocator == TLSF_ALLOC) && (size > oldSize)) {
+            tlsfRegionGrow(dataBlock->ptr, size);
+        }
+        *addr = dataBlock->ptr;
+    }
+    return status;
 }
 
-u8 ocrDbMallocOffset(ocrGuid_t guid, u64 size, u64* offset) {
-    return EINVAL; /* not yet implemented */
+// Returns the data-block 'guid' if it holds a heap, NULL otherwise
+static ocrDataBlock_t * dbHeap(ocrGuid_t guid) {
+    ocrDataBlock_t *dataBlock = NULL;
+    if (!isDatablockGuid(guid)) {
+        return NULL;
+    }
+    deguidify(getCurrentPD(), guid, (u64*)&dataBlock, NULL);
+    return (dataBlock->inDbAllocator == TLSF_ALLOC) ? dataBlock : NULL;
 }
 
-struct ocrDbCopy_args {
-    ocrGuid_t destination;
-    u64 destinationOffset;
-    ocrGuid_t source;
-    u64 sourceOffset;
-    u64 size;
-} ocrDbCopy_args;
-
-// TODO: Re-enable
-/*
-ocrGuid_t ocrDbCopy_edt ( u32 paramc, u64 * params, void* paramv[], u32 depc, ocrEdtDep_t depv[]) {
-    char *sptr, *dptr;
-    struct ocrDbCopy_args * pv = (struct ocrDbCopy_args *) depv[0].ptr;
-    ocrGuid_t destination = pv->destination;
-    u64 destinationOffset = pv->destinationOffset;
-    ocrGuid_t source = pv->source;
-    u64 sourceOffset = pv->sourceOffset;
-    u64 size = pv->size;
+u8 ocrDbMalloc(ocrGuid_t guid, u64 size, void** addr) {
+    u64 offset;
+    *addr = NULL;
+    u8 status = ocrDbMallocOffset(guid, size, &offset);
+    if (status == 0) {
+        ocrDataBlock_t *dataBlock = dbHeap(guid);
+        *addr = (void*)((u64)dataBlock->ptr + offset);
+    }
+    return status;
+}
 
-    ocrDbAcquire(source, (void *) &sptr, 0);
-    ocrDbAcquire(destination, (void *) &dptr, 0);
+u8 ocrDbMallocOffset(ocrGuid_t guid, u64 size, u64* offset) {
+    ocrDataBlock_t *dataBlock = dbHeap(guid);
+    if (dataBlock == NULL) {
+        return EINVAL;
+    }
+    *offset = tlsfRegionMalloc(dataBlock->ptr, size);
+    return (*offset == 0) ? ENOMEM : 0;
+}
 
-    sptr += sourceOffset;
-    dptr += destinationOffset;
+u8 ocrDbMemoryStats(ocrMemoryStats_t *stats, bool walk) {
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrMemoryStats_t empty = { 0 };
+    u64 i;
+    *stats = empty;
+    for (i = 0; i < pd->allocatorCount; i++) {
+        u8 status = pd->allocators[i]->fctPtrs->getStats(pd->allocators[i], stats, walk);
+        if (status != 0) {
+            return status;
+        }
+    }
+    return 0;
+}
 
+// Copies larger than this are split in chunks that idle workers can pick up
+#define DB_COPY_CHUNK_SIZE (1ULL << 20)
+
+// Copies larger than this bypass the caches: the destination would not fit
+// in them anyway and would only evict the data of other EDTs
+#define DB_COPY_NON_TEMPORAL_SIZE (1ULL << 23)
+
+typedef struct {
+    char * destination;
+    const char * source;
+    bool nonTemporal;
+} ocrDbCopyChunks_t;
+
+static void dbCopyBytes(char * destination, const char * source, u64 size, bool nonTemporal) {
+#if defined(__SSE2__) && (__STDC_HOSTED__ == 1)
+    if (nonTemporal) {
+        // Align the destination on 16 bytes, then stream whole vectors
+        u64 head = (16 - ((u64) destination & 15)) & 15;
+        if (head > size) {
+            head = size;
+        }
+        memcpy(destination, source, head);
+        destination += head;
+        source += head;
+        size -= head;
+        while (size >= 64) {
+            __m128i a = _mm_loadu_si128((const __m128i *) source);
+            __m128i b = _mm_loadu_si128((const __m128i *) (source + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *) (source + 32));
+            __m128i d = _mm_loadu_si128((const __m128i *) (source + 48));
+            _mm_stream_si128((__m128i *) destination, a);
+            _mm_stream_si128((__m128i *) (destination + 16), b);
+            _mm_stream_si128((__m128i *) (destination + 32), c);
+            _mm_stream_si128((__m128i *) (destination + 48), d);
+            destination += 64;
+            source += 64;
+            size -= 64;
+        }
+        // Streamed stores must be visible before the copy is reported complete
+        _mm_sfence();
+    }
+#endif
 #if (__STDC_HOSTED__ == 1)
-    memcpy((void *)dptr, (const void *)sptr, size);
+    memcpy(destination, source, size);
 #else
-    int i;
+    u64 i;
     for (i = 0; i < size; i++) {
-        dptr[i] = sptr[i];
+        destination[i] = source[i];
     }
 #endif
+}
+
+static void dbCopyChunk(u64 first, u64 last, void * arg) {
+    ocrDbCopyChunks_t * chunks = (ocrDbCopyChunks_t *) arg;
+    dbCopyBytes(chunks->destination + first, chunks->source + first, last - first,
+                chunks->nonTemporal);
+}
 
-    ocrDbRelease(source);
-    ocrDbRelease(destination);
+/* paramv: template, chunks, destination, completion event, source */
+static ocrGuid_t dbCopyDoneEdt(u32 paramc, u64 * paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrEdtTemplateDestroy((ocrGuid_t) paramv[0]);
+    free((void *) paramv[1]);
+    u32 i;
+    for (i = 0; i < 2; i++) {
+        ocrDataBlock_t * db = NULL;
+        deguidify(getCurrentPD(), (ocrGuid_t) paramv[(i == 0) ? 2 : 4], (u64*)&db, NULL);
+        ocrDbUnpin(db, getCurrentEDT(), false);
+        // A copy within a data-block holds it once
+        if ((i == 0) || (paramv[4] != paramv[2])) {
+            RESULT_ASSERT(db->fctPtrs->release(db, getCurrentEDT(), true), ==, 0);
+        }
+    }
+    if ((ocrGuid_t) paramv[3] != NULL_GUID) {
+        ocrEventSatisfy((ocrGuid_t) paramv[3], (ocrGuid_t) paramv[2]);
+    }
+    return NULL_GUID;
+}
 
-    ocrGuid_t paramDbGuid = (ocrGuid_t)depv[0].guid;
-    ocrDbDestroy(paramDbGuid);
+/* paramv: template, destination offset, source offset, size, completion event
+ * depv: source, destination */
+static ocrGuid_t dbCopyEdt(u32 paramc, u64 * paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrEdtTemplateDestroy((ocrGuid_t) paramv[0]);
+    u64 destinationOffset = paramv[1];
+    u64 sourceOffset = paramv[2];
+    u64 size = paramv[3];
+    ocrGuid_t completionEvt = (ocrGuid_t) paramv[4];
+    ASSERT(depv[0].ptr != NULL && depv[1].ptr != NULL);
+    ocrDataBlock_t * sourceDb = NULL;
+    deguidify(getCurrentPD(), depv[0].guid, (u64*)&sourceDb, NULL);
+    ASSERT((sourceOffset <= sourceDb->size) && (size <= (sourceDb->size - sourceOffset)));
+    char * destination = ((char *) depv[1].ptr) + destinationOffset;
+    const char * source = ((const char *) depv[0].ptr) + sourceOffset;
+    bool nonTemporal = (size >= DB_COPY_NON_TEMPORAL_SIZE);
+
+    if (size <= DB_COPY_CHUNK_SIZE) {
+        dbCopyBytes(destination, source, size, nonTemporal);
+        if (completionEvt != NULL_GUID) {
+            ocrEventSatisfy(completionEvt, depv[1].guid);
+        }
+        return NULL_GUID;
+    }
 
+    // Split the copy over the idle workers. The data-blocks must not be
+    // destroyed before the completion event is satisfied. Until then, the
+    // done EDT holds them in place of this EDT, which releases them when it
+    // returns, so that no exclusive access is granted in the middle of the
+    // copy. They are also kept from being evicted
+    ocrDbCopyChunks_t * chunks = (ocrDbCopyChunks_t *) checkedMalloc(chunks, sizeof(ocrDbCopyChunks_t));
+    chunks->destination = destination;
+    chunks->source = source;
+    chunks->nonTemporal = nonTemporal;
+    ocrGuid_t chunksDone, doneTemplate, doneEdt;
+    ocrEventCreate(&chunksDone, OCR_EVENT_ONCE_T, false);
+    ocrEdtTemplateCreate(&doneTemplate, dbCopyDoneEdt, 5, 1);
+    u64 doneParamv[5] = {(u64) doneTemplate, (u64) chunks, (u64) depv[1].guid, (u64) completionEvt,
+                         (u64) depv[0].guid};
+    ocrEdtCreate(&doneEdt, doneTemplate, EDT_PARAM_DEF, doneParamv, EDT_PARAM_DEF, &chunksDone,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrDataBlock_t * destinationDb = NULL;
+    deguidify(getCurrentPD(), depv[1].guid, (u64*)&destinationDb, NULL);
+    RESULT_ASSERT(destinationDb->fctPtrs->acquire(destinationDb, doneEdt, true), !=, NULL);
+    if (sourceDb != destinationDb) {
+        RESULT_ASSERT(sourceDb->fctPtrs->acquire(sourceDb, doneEdt, true), !=, NULL);
+    }
+    ocrDbPin(sourceDb, doneEdt, false);
+    ocrDbPin(destinationDb, doneEdt, false);
+    ocrParallelFor(0, size, DB_COPY_CHUNK_SIZE, dbCopyChunk, chunks, chunksDone);
     return NULL_GUID;
 }
-*/
 
 u8 ocrDbCopy(ocrGuid_t destination, u64 destinationOffset, ocrGuid_t source,
              u64 sourceOffset, u64 size, u64 copyType, ocrGuid_t *completionEvt) {
-    ASSERT(0);
-
-    // // Create the event
-    // ocrGuid_t eventGuid;
-    // ocrEventCreate(&eventGuid, OCR_EVENT_STICKY_T, TRUE); /*TODO: Replace with ONCE after that is supported */
-
-    // // Create the EDT
-    // ocrGuid_t edtGuid;
-    // ocrEdtCreate(&edtGuid, ocrDbCopy_edt, 0, NULL, NULL, 0, 1, &eventGuid, completionEvt);
-    // ocrEdtSchedule(edtGuid);
-
-    // // Create the copy params
-    // ocrGuid_t paramDbGuid;
-    // struct ocrDbCopy_args * dbArgs = NULL;
-    // void * ptr = (void *) dbArgs;
-    // // Warning: directly casting dbArgs to (void **) causes a type-punning warning with gcc-4.1.2
-    // ocrDbCreate(&paramDbGuid, &ptr, sizeof(ocrDbCopy_args), 0xdead, NULL, NO_ALLOC);
-
-    // dbArgs->destination = destination;
-    // dbArgs->destinationOffset = destinationOffset;
-    // dbArgs->source = source;
-    // dbArgs->sourceOffset = sourceOffset;
-    // dbArgs->size = size;
-
-    // ocrEventSatisfy(eventGuid, paramDbGuid);
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    if (!isDatablockGuid(destination) || !(isDatablockGuid(source) || isEventGuid(source))) {
+        return EINVAL;
+    }
+    ocrDataBlock_t * destinationDb = NULL;
+    deguidify(pd, destination, (u64*)&destinationDb, NULL);
+    if ((destinationOffset > destinationDb->size) || (size > (destinationDb->size - destinationOffset))) {
+        return ENOMEM;
+    }
+    // Read-only file mapping
+    if ((destinationDb->properties & DB_PROP_MAPPED) && !(destinationDb->properties & DB_PROP_MAP_PRIVATE)) {
+        return EPERM;
+    }
+    // A source given through an event can only be checked once the copy runs
+    if (isDatablockGuid(source)) {
+        ocrDataBlock_t * sourceDb = NULL;
+        deguidify(pd, source, (u64*)&sourceDb, NULL);
+        if ((sourceOffset > sourceDb->size) || (size > (sourceDb->size - sourceOffset))) {
+            return ENOMEM;
+        }
+        if ((source == destination) && (sourceOffset < (destinationOffset + size)) &&
+            (destinationOffset < (sourceOffset + size))) {
+            return EPERM;
+        }
+    }
 
-    // /* ocrDbRelease(paramDbGuid); TODO: BUG: Release tries to free */
+    ocrGuid_t eventGuid = NULL_GUID;
+    if (completionEvt != NULL) {
+        ocrEventCreate(&eventGuid, OCR_EVENT_STICKY_T, true);
+        *completionEvt = eventGuid;
+    }
 
+    // The copy runs once the source is available, with the source shared
+    // and the destination written
+    ocrGuid_t copyTemplate, copyEdt;
+    ocrEdtTemplateCreate(&copyTemplate, dbCopyEdt, 5, 2);
+    u64 paramv[5] = {(u64) copyTemplate, destinationOffset, sourceOffset, size, (u64) eventGuid};
+    ocrEdtCreate(&copyEdt, copyTemplate, EDT_PARAM_DEF, paramv, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrAddDependence(source, copyEdt, 0, DB_MODE_RO);
+    ocrAddDependence(destination, copyEdt, 1, DB_MODE_ITW);
     return 0;
 }
 
 u8 ocrDbFree(ocrGuid_t guid, void* addr) {
-    return EINVAL; /* not yet implemented */
+    ocrDataBlock_t *dataBlock = dbHeap(guid);
+    if ((dataBlock == NULL) || ((u64)addr < (u64)dataBlock->ptr)) {
+        return EINVAL;
+    }
+    return ocrDbFreeOffset(guid, (u64)addr - (u64)dataBlock->ptr);
 }
 
 u8 ocrDbFreeOffset(ocrGuid_t guid, u64 offset) {
-    return EINVAL; /* not yet implemented */
+    ocrDataBlock_t *dataBlock = dbHeap(guid);
+    if ((dataBlock == NULL) || (offset == 0) || (offset >= dataBlock->size)) {
+        return EINVAL;
+    }
+    tlsfRegionFree(dataBlock->ptr, offset);
+    return 0;
 }
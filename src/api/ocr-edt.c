@@ -11,12 +11,19 @@
 #include "ocr-policy-domain.h"
 #include "ocr-runtime.h"
 
+#include <errno.h>
+
 #ifdef OCR_ENABLE_STATISTICS
 #include "ocr-statistics.h"
 #include "ocr-stat-user.h"
 #endif
 
 u8 ocrEventCreate(ocrGuid_t *guid, ocrEventTypes_t eventType, bool takesArg) {
+    // Events created while recording a task graph belong to the graph
+    ocrGuid_t graph = graphCurrentCapture();
+    if (graph != NULL_GUID) {
+        return graphCaptureEvent(graph, guid, eventType);
+    }
     ocrPolicyDomain_t * pd = getCurrentPD();
     ocrPolicyCtx_t *context = getCurrentWorkerContext();
     pd->createEvent(pd, guid,eventType, takesArg, context);
@@ -45,9 +52,7 @@ u8 ocrEventSatisfy(ocrGuid_t eventGuid, ocrGuid_t dataGuid /*= INVALID_GUID*/) {
 u8 ocrEdtTemplateCreate(ocrGuid_t *guid, ocrEdt_t funcPtr, u32 paramc, u32 depc) {
     ocrPolicyDomain_t *pd = getCurrentPD();
     ocrPolicyCtx_t *context = getCurrentWorkerContext();
-    pd->createEdtTemplate(pd, guid, funcPtr, paramc, depc, context);
-
-    return 0;
+    return pd->createEdtTemplate(pd, guid, funcPtr, paramc, depc, context);
 }
 
 u8 ocrEdtTemplateDestroy(ocrGuid_t guid) {
@@ -81,9 +86,34 @@ u8 ocrEdtCreate(ocrGuid_t* edtGuid, ocrGuid_t templateGuid,
     // If paramc are expected, double check paramv is not NULL
     ASSERT((paramc > 0) ? (paramv != NULL) : true);
 
+    // EDTs created while recording a task graph belong to the graph
+    ocrGuid_t graph = graphCurrentCapture();
+    if (graph != NULL_GUID) {
+        u8 returnCode = graphCaptureEdt(graph, edtGuid, taskTemplate, paramc, paramv,
+                                        depc, properties, outputEvent);
+        u32 i = 0;
+        while((returnCode == 0) && (depv != NULL) && (i < depc)) {
+            returnCode = graphCaptureDependence(graph, depv[i], *edtGuid, i, DB_DEFAULT_MODE);
+            i++;
+        }
+        return returnCode;
+    }
+
+    if (depv != NULL) {
+        u32 i;
+        for (i = 0; i < depc; i++) {
+            if (isEventGuidOfKind(depv[i], OCR_EVENT_GRAPH_T)) {
+                return EINVAL;
+            }
+        }
+    }
+
     ocrPolicyCtx_t *context = getCurrentWorkerContext();
-    pd->createEdt(pd, edtGuid, taskTemplate, paramc, paramv, depc,
-                  properties, affinity, outputEvent, context);
+    u8 returnCode = pd->createEdt(pd, edtGuid, taskTemplate, paramc, paramv, depc,
+                                  properties, affinity, outputEvent, context);
+    if (returnCode != 0) {
+        return returnCode;
+    }
 
 #ifdef OCR_ENABLE_STATISTICS
     ocrTask_t * task = NULL;
@@ -122,6 +152,28 @@ u8 ocrEdtCreate(ocrGuid_t* edtGuid, ocrGuid_t templateGuid,
     return 0;
 }
 
+u8 ocrEdtCreateBulk(ocrGuid_t* guids, ocrGuid_t templateGuid, u32 count,
+                    u32 paramc, u64* paramv, u64* paramStride,
+                    u16 properties, ocrGuid_t affinity) {
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    ocrTaskTemplate_t *taskTemplate = NULL;
+    deguidify(pd, templateGuid, (u64*)&taskTemplate, NULL);
+    ASSERT(((taskTemplate->paramc == EDT_PARAM_UNK) && paramc != EDT_PARAM_DEF) ||
+           (taskTemplate->paramc != EDT_PARAM_UNK && (paramc == EDT_PARAM_DEF || taskTemplate->paramc == paramc)));
+    if(paramc == EDT_PARAM_DEF) {
+        paramc = taskTemplate->paramc;
+    }
+    ASSERT((paramc > 0) ? (paramv != NULL) : true);
+
+    // Bulk EDTs are independent: they cannot have any dependence
+    if((count == 0) || ((taskTemplate->depc != 0) && (taskTemplate->depc != EDT_PARAM_UNK)) ||
+       (properties & EDT_PROP_FINISH) || (graphCurrentCapture() != NULL_GUID)) {
+        return EINVAL;
+    }
+    return edtCreateBulk(guids, taskTemplate, count, paramc, paramv, paramStride,
+                         properties, affinity);
+}
+
 u8 ocrEdtDestroy(ocrGuid_t edtGuid) {
     ocrPolicyDomain_t * pd = getCurrentPD();
     ocrTask_t * task = NULL;
@@ -130,10 +182,17 @@ u8 ocrEdtDestroy(ocrGuid_t edtGuid) {
     return 0;
 }
 
-// TODO: Pass down the mode information!!
 u8 ocrAddDependence(ocrGuid_t source, ocrGuid_t destination, u32 slot,
                     ocrDbAccessMode_t mode) {
-    registerDependence(source, destination, slot);
+    ocrGuid_t graph = graphCurrentCapture();
+    if (graph != NULL_GUID) {
+        return graphCaptureDependence(graph, source, destination, slot, mode);
+    }
+    // Events of a task graph are only connected when the graph is recorded
+    if (isEventGuidOfKind(source, OCR_EVENT_GRAPH_T) || isEventGuidOfKind(destination, OCR_EVENT_GRAPH_T)) {
+        return EINVAL;
+    }
+    registerDependence(source, destination, slot, mode);
     return 0;
 }
 
@@ -0,0 +1,32 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "debug.h"
+#include "ocr-graph.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+#include "ocr-task.h"
+
+u8 ocrGraphBegin(ocrGuid_t *graph, u32 paramc) {
+    return graphBegin(graph, paramc);
+}
+
+u8 ocrGraphEnd(ocrGuid_t graph) {
+    return graphEnd(graph);
+}
+
+u8 ocrGraphReplay(ocrGuid_t graph, u32 paramc, u64 *paramv, u32 depc,
+                  ocrGuid_t *depv, ocrGuid_t completionEvent) {
+    // If parameters are expected, double check paramv is not NULL
+    ASSERT((paramc > 0) ? (paramv != NULL) : true);
+    ASSERT((depc > 0) ? (depv != NULL) : true);
+    return graphReplay(graph, paramc, paramv, depc, depv, completionEvent);
+}
+
+u8 ocrGraphDestroy(ocrGuid_t graph) {
+    return graphDestroy(graph);
+}
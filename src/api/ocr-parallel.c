@@ -0,0 +1,223 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "debug.h"
+#include "ocr-db.h"
+#include "ocr-edt.h"
+#include "ocr-macros.h"
+#include "ocr-parallel.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// When no grain is given, ranges are checked for
+// splitting this many times over the whole loop
+#define PARALLEL_DEFAULT_CHUNKS 256
+
+/**
+ * @brief Node of the splitting tree of a loop
+ *
+ * Each range EDT owns a node. Splitting a range creates a child node for
+ * the upper half. A node completes once its EDT and all its children have
+ * completed; the results of its children are then folded into its own.
+ */
+typedef struct _parallelNode_t {
+    struct _parallelNode_t * parent;
+    struct _parallelNode_t * children; /**< Most recent split (lowest iterations) first */
+    struct _parallelNode_t * sibling;
+    volatile u32 pending;              /**< The node's EDT and its children still running */
+    u64 result[];                      /**< Partial result of a reduction */
+} parallelNode_t;
+
+typedef struct {
+    ocrParallelForBody_t forBody;
+    ocrParallelReduceBody_t reduceBody;
+    ocrParallelCombine_t combine;
+    void * arg;
+    u64 grain;
+    u64 size;                          /**< Size of a result, 0 for a parallel loop */
+    void * identity;
+    ocrGuid_t rangeTemplate;
+    ocrGuid_t completionEvent;
+    volatile u32 unstarted;            /**< Range EDTs created but not started yet */
+} parallelLoop_t;
+
+static parallelNode_t * parallelNewNode(parallelLoop_t * loop, parallelNode_t * parent) {
+    parallelNode_t * node = (parallelNode_t *) checkedMalloc(node, sizeof(parallelNode_t) + loop->size);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->parent = parent;
+    node->children = NULL;
+    node->sibling = NULL;
+    node->pending = 1;
+    if (loop->size != 0) {
+        memcpy(node->result, loop->identity, loop->size);
+    }
+    return node;
+}
+
+static u8 parallelSpawn(parallelLoop_t * loop, parallelNode_t * node, u64 first, u64 last) {
+    u64 paramv[4] = {(u64) loop, (u64) node, first, last};
+    ocrGuid_t edtGuid;
+    __sync_fetch_and_add(&(loop->unstarted), 1);
+    u8 returnCode = ocrEdtCreate(&edtGuid, loop->rangeTemplate, EDT_PARAM_DEF, paramv,
+                                 EDT_PARAM_DEF, NULL, EDT_PROP_NONE, NULL_GUID, NULL);
+    if (returnCode != 0) {
+        __sync_fetch_and_sub(&(loop->unstarted), 1);
+    }
+    return returnCode;
+}
+
+// Splitting only pays off if there are idle workers
+// that are not about to pick up a range already given away
+static bool parallelShouldSplit(parallelLoop_t * loop) {
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    return pd->idleWorkers(pd, NULL) > loop->unstarted;
+}
+
+// Called once all the iterations have run. If the result data-block
+// cannot be created, the completion event is satisfied with NULL_GUID.
+static void parallelComplete(parallelLoop_t * loop, parallelNode_t * root) {
+    if (loop->size != 0) {
+        void * ptr = NULL;
+        ocrGuid_t resultGuid = NULL_GUID;
+        u8 returnCode = ocrDbCreate(&resultGuid, &ptr, loop->size, 0, NULL_GUID, NO_ALLOC);
+        if ((returnCode != 0) || (ptr == NULL)) {
+            resultGuid = NULL_GUID;
+        } else {
+            memcpy(ptr, root->result, loop->size);
+        }
+        ocrEventSatisfy(loop->completionEvent, resultGuid);
+    } else if (loop->completionEvent != NULL_GUID) {
+        ocrEventSatisfy(loop->completionEvent, NULL_GUID);
+    }
+    free(root);
+    ocrEdtTemplateDestroy(loop->rangeTemplate);
+    free(loop);
+}
+
+// Called when a node's EDT or one of its children completes
+static void parallelNodeDone(parallelLoop_t * loop, parallelNode_t * node) {
+    while (__sync_sub_and_fetch(&(node->pending), 1) == 0) {
+        // The whole subtree has run, fold the children in iteration order
+        parallelNode_t * child = node->children;
+        while (child != NULL) {
+            parallelNode_t * next = child->sibling;
+            if (loop->size != 0) {
+                loop->combine(node->result, child->result, loop->arg);
+            }
+            free(child);
+            child = next;
+        }
+        if (node->parent == NULL) {
+            parallelComplete(loop, node);
+            return;
+        }
+        node = node->parent;
+    }
+}
+
+/* paramv: loop, node, first, last */
+static ocrGuid_t parallelRangeEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    parallelLoop_t * loop = (parallelLoop_t *) paramv[0];
+    parallelNode_t * node = (parallelNode_t *) paramv[1];
+    u64 first = paramv[2];
+    u64 last = paramv[3];
+    bool canSplit = true;
+    __sync_fetch_and_sub(&(loop->unstarted), 1);
+    while (first < last) {
+        if (canSplit && ((last - first) > loop->grain) && parallelShouldSplit(loop)) {
+            // Give the upper half away. Only this EDT adds children to
+            // its node and the node cannot complete while it runs.
+            u64 mid = first + (last - first)/2;
+            parallelNode_t * child = parallelNewNode(loop, node);
+            if (child != NULL) {
+                __sync_fetch_and_add(&(node->pending), 1);
+                if (parallelSpawn(loop, child, mid, last) == 0) {
+                    child->sibling = node->children;
+                    node->children = child;
+                    last = mid;
+                    continue;
+                }
+                __sync_fetch_and_sub(&(node->pending), 1);
+                free(child);
+            }
+            // Out of resources, run the whole range here
+            canSplit = false;
+            continue;
+        }
+        u64 end = ((last - first) > loop->grain) ? (first + loop->grain) : last;
+        if (loop->size != 0) {
+            loop->reduceBody(first, end, loop->arg, node->result);
+        } else {
+            loop->forBody(first, end, loop->arg);
+        }
+        first = end;
+    }
+    parallelNodeDone(loop, node);
+    return NULL_GUID;
+}
+
+static u8 parallelStart(u64 first, u64 last, u64 grain, ocrParallelForBody_t forBody,
+                        ocrParallelReduceBody_t reduceBody, ocrParallelCombine_t combine,
+                        const void * identity, u64 size, void * arg, ocrGuid_t completionEvent) {
+    parallelLoop_t * loop = (parallelLoop_t *) checkedMalloc(loop, sizeof(parallelLoop_t) + size);
+    if (loop == NULL) {
+        return ENOMEM;
+    }
+    loop->forBody = forBody;
+    loop->reduceBody = reduceBody;
+    loop->combine = combine;
+    loop->arg = arg;
+    if (grain == 0) {
+        grain = (last - first)/PARALLEL_DEFAULT_CHUNKS;
+    }
+    loop->grain = (grain == 0) ? 1 : grain;
+    loop->size = size;
+    loop->identity = (void *) (loop + 1);
+    if (size != 0) {
+        memcpy(loop->identity, identity, size);
+    }
+    loop->completionEvent = completionEvent;
+    loop->unstarted = 0;
+    u8 returnCode = ocrEdtTemplateCreate(&(loop->rangeTemplate), parallelRangeEdt, 4, 0);
+    if (returnCode != 0) {
+        free(loop);
+        return returnCode;
+    }
+    parallelNode_t * root = parallelNewNode(loop, NULL);
+    returnCode = (root == NULL) ? ENOMEM : parallelSpawn(loop, root, first, last);
+    if (returnCode != 0) {
+        free(root);
+        ocrEdtTemplateDestroy(loop->rangeTemplate);
+        free(loop);
+    }
+    return returnCode;
+}
+
+u8 ocrParallelFor(u64 first, u64 last, u64 grain, ocrParallelForBody_t body,
+                  void *arg, ocrGuid_t completionEvent) {
+    if ((body == NULL) || (last < first)) {
+        return EINVAL;
+    }
+    return parallelStart(first, last, grain, body, NULL, NULL, NULL, 0, arg, completionEvent);
+}
+
+u8 ocrParallelReduce(u64 first, u64 last, u64 grain, ocrParallelReduceBody_t body,
+                     ocrParallelCombine_t combine, const void *identity, u64 size,
+                     void *arg, ocrGuid_t completionEvent) {
+    if ((body == NULL) || (combine == NULL) || (identity == NULL) || (size == 0) ||
+        (completionEvent == NULL_GUID) || (last < first)) {
+        return EINVAL;
+    }
+    return parallelStart(first, last, grain, NULL, body, combine, identity, size, arg,
+                         completionEvent);
+}
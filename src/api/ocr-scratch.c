@@ -0,0 +1,25 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "allocator/scratch/scratch-allocator.h"
+#include "ocr-guid.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+#include "ocr-scratch.h"
+#include "ocr-worker.h"
+
+#include <errno.h>
+
+u8 ocrScratchMalloc(u64 size, void** addr) {
+    ocrPolicyCtx_t * ctx = getCurrentWorkerContext();
+    ocrWorker_t * worker = NULL;
+    deguidify(ctx->PD, ctx->sourceObj, (u64*)&worker, NULL);
+    ocrScratch_t * scratch = (worker->fctPtrs->getScratch == NULL) ? NULL :
+        worker->fctPtrs->getScratch(worker);
+    *addr = (scratch == NULL) ? NULL : scratchMalloc(scratch, size);
+    return (*addr == NULL) ? ENOMEM : 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * @brief Copy-on-write data-block snapshots
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+// For memfd_create()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "datablock/cow/db-cow.h"
+#include "debug.h"
+#include "ocr-macros.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define DEBUG_TYPE DATABLOCK
+
+// Bits of the entries of /proc/self/pagemap
+#define PAGEMAP_PRESENT (1ULL << 63)
+#define PAGEMAP_SWAPPED (1ULL << 62)
+#define PAGEMAP_FILE    (1ULL << 61)
+
+// A private mapping moves to a file of its own rather than copying into
+// each snapshot the pages it wrote once they exceed 1/COW_MOVE_RATIO of it
+#define COW_MOVE_RATIO 8
+
+/******************************************************/
+/* FILES                                              */
+/******************************************************/
+
+static void cowLock(ocrDbCowFile_t *file) {
+    while(!__sync_bool_compare_and_swap(&(file->lock), 0, 1)) ;
+}
+
+static void cowUnlock(ocrDbCowFile_t *file) {
+    __sync_lock_release(&(file->lock));
+}
+
+static ocrDbCowFile_t * cowNewFile(u64 size) {
+#ifdef MFD_CLOEXEC
+    int fd = memfd_create("ocr-db", MFD_CLOEXEC);
+#else
+    int fd = -1;
+    errno = ENOSYS;
+#endif
+    if(fd < 0) {
+        DPRINTF(DEBUG_LVL_WARN, "Cannot create the file of a copy-on-write data-block (errno %d)\n", errno);
+        return NULL;
+    }
+    if(ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return NULL;
+    }
+    ocrDbCowFile_t *file = (ocrDbCowFile_t*) checkedMalloc(file, sizeof(ocrDbCowFile_t));
+    file->fd = fd;
+    file->lock = 0;
+    file->users = 1;
+    return file;
+}
+
+// Drops a user of 'file' and closes it after the last one
+static void cowReleaseFile(ocrDbCowFile_t *file) {
+    cowLock(file);
+    u32 users = --file->users;
+    cowUnlock(file);
+    if(users == 0) {
+        close(file->fd);
+        free(file);
+    }
+}
+
+// Writes 'size' bytes of 'ptr' at 'offset' in 'fd'
+static bool cowWrite(int fd, const char *ptr, u64 size, u64 offset) {
+    while(size > 0) {
+        ssize_t done = pwrite(fd, ptr, size, (off_t)offset);
+        if(done <= 0) {
+            if((done < 0) && (errno == EINTR)) {
+                continue;
+            }
+            return false;
+        }
+        ptr += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
+/******************************************************/
+/* MAPPINGS                                           */
+/******************************************************/
+
+static u64 cowPageSize() {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+
+// Maps 'file' privately, at 'addr' if it is not NULL
+static void * cowMapPrivate(ocrDbCowFile_t *file, void *addr, u64 mapSize) {
+    void *map = mmap(addr, mapSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | ((addr != NULL) ? MAP_FIXED : 0), file->fd, 0);
+    return (map == MAP_FAILED) ? NULL : map;
+}
+
+// Finds the pages a private mapping wrote to, which do not come from its
+// file any more. Returns false if the kernel does not tell
+static bool cowDirtyPages(ocrDbCow_t *self, u64 pages, bool *dirty) {
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    u64 entries[512];
+    u64 first = (u64)self->addr / cowPageSize();
+    u64 i = 0;
+    while(i < pages) {
+        u64 count = (pages - i < 512) ? (pages - i) : 512;
+        ssize_t done = pread(fd, entries, count*sizeof(u64), (off_t)((first + i)*sizeof(u64)));
+        if(done < (ssize_t)(count*sizeof(u64))) {
+            close(fd);
+            return false;
+        }
+        u64 j;
+        for(j = 0; j < count; j++) {
+            u64 entry = entries[j];
+            dirty[i + j] = ((entry & PAGEMAP_SWAPPED) != 0) ||
+                ((entry & PAGEMAP_PRESENT) && !(entry & PAGEMAP_FILE));
+        }
+        i += count;
+    }
+    close(fd);
+    return true;
+}
+
+ocrDbCow_t * newDbCow(u64 size) {
+    u64 pageSize = cowPageSize();
+    u64 mapSize = (size + pageSize - 1) & ~(pageSize - 1);
+    if(mapSize == 0) {
+        mapSize = pageSize;
+    }
+    ocrDbCowFile_t *file = cowNewFile(mapSize);
+    if(file == NULL) {
+        return NULL;
+    }
+    void *addr = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if(addr == MAP_FAILED) {
+        cowReleaseFile(file);
+        return NULL;
+    }
+    ocrDbCow_t *self = (ocrDbCow_t*) checkedMalloc(self, sizeof(ocrDbCow_t));
+    self->file = file;
+    self->addr = addr;
+    self->mapSize = mapSize;
+    self->isPrivate = false;
+    return self;
+}
+
+void destructDbCow(ocrDbCow_t *self) {
+    munmap(self->addr, self->mapSize);
+    cowReleaseFile(self->file);
+    free(self);
+}
+
+ocrDbCow_t * dbCowSnapshot(ocrDbCow_t *source) {
+    u64 pageSize = cowPageSize();
+    u64 pages = source->mapSize / pageSize;
+    ocrDbCowFile_t *file = source->file;
+    bool *dirty = NULL;
+    u64 dirtyCount = 0;
+
+    cowLock(file);
+    if(source->isPrivate) {
+        dirty = (bool*) checkedMalloc(dirty, pages*sizeof(bool));
+        if(!cowDirtyPages(source, pages, dirty)) {
+            memset(dirty, 1, pages*sizeof(bool));
+        }
+        u64 i;
+        for(i = 0; i < pages; i++) {
+            dirtyCount += dirty[i] ? 1 : 0;
+        }
+    }
+
+    if(source->isPrivate && (file->users > 1) && (COW_MOVE_RATIO*dirtyCount > pages)) {
+        // Snapshots read the current file: move the source to a copy of
+        // its content rather than copying the pages it wrote in every
+        // snapshot from now on
+        ocrDbCowFile_t *copy = cowNewFile(source->mapSize);
+        if((copy == NULL) || !cowWrite(copy->fd, (const char*)source->addr, source->mapSize, 0) ||
+           (cowMapPrivate(copy, source->addr, source->mapSize) == NULL)) {
+            cowUnlock(file);
+            if(copy != NULL) {
+                cowReleaseFile(copy);
+            }
+            free(dirty);
+            return NULL;
+        }
+        --file->users;
+        cowUnlock(file);
+        DPRINTF(DEBUG_LVL_INFO, "Copy-on-write region @ 0x%"PRIx64" moved to a new file (0x%"PRIx64" bytes)\n",
+                (u64)source->addr, source->mapSize);
+        source->file = copy;
+        file = copy;
+        cowLock(file);
+        dirtyCount = 0;
+    } else if(source->isPrivate && (file->users == 1)) {
+        // Nothing else reads the file: fold the written pages back into it
+        // and start again from clean pages
+        u64 i;
+        for(i = 0; i < pages; i++) {
+            if(dirty[i] && !cowWrite(file->fd, (const char*)source->addr + i*pageSize,
+                                     pageSize, i*pageSize)) {
+                cowUnlock(file);
+                free(dirty);
+                return NULL;
+            }
+        }
+        DPRINTF(DEBUG_LVL_VERB, "Folded %"PRIu64" pages of copy-on-write region @ 0x%"PRIx64"\n",
+                dirtyCount, (u64)source->addr);
+        cowMapPrivate(file, source->addr, source->mapSize);
+        dirtyCount = 0;
+    } else if(!source->isPrivate) {
+        // The file holds the current content. The source stops writing to it
+        ASSERT(file->users == 1);
+        cowMapPrivate(file, source->addr, source->mapSize);
+        source->isPrivate = true;
+    }
+
+    void *addr = cowMapPrivate(file, NULL, source->mapSize);
+    if(addr == NULL) {
+        cowUnlock(file);
+        free(dirty);
+        return NULL;
+    }
+    ++file->users;
+    cowUnlock(file);
+
+    // The snapshot still needs the pages the source wrote since the file
+    // was last brought up to date
+    if(dirtyCount > 0) {
+        u64 i;
+        for(i = 0; i < pages; i++) {
+            if(dirty[i]) {
+                memcpy((char*)addr + i*pageSize, (const char*)source->addr + i*pageSize, pageSize);
+            }
+        }
+        DPRINTF(DEBUG_LVL_VERB, "Copied %"PRIu64" pages into snapshot of copy-on-write region @ 0x%"PRIx64"\n",
+                dirtyCount, (u64)source->addr);
+    }
+    free(dirty);
+
+    ocrDbCow_t *self = (ocrDbCow_t*) checkedMalloc(self, sizeof(ocrDbCow_t));
+    self->file = file;
+    self->addr = addr;
+    self->mapSize = source->mapSize;
+    self->isPrivate = true;
+    return self;
+}
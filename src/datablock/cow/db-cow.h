@@ -0,0 +1,71 @@
+/**
+ * @brief Copy-on-write data-block snapshots
+ *
+ * The memory of a data-block created with DB_PROP_SNAPSHOT is a mapping
+ * of an anonymous in-memory file. Snapshots map the same file privately
+ * so that pages are shared until either side writes to them, at which
+ * point the kernel copies the page being written.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __DB_COW_H__
+#define __DB_COW_H__
+
+#include "ocr-types.h"
+
+/**
+ * @brief In-memory file shared by a data-block and its snapshots
+ *
+ * The file is never written while more than one mapping reads from it
+ */
+typedef struct _ocrDbCowFile_t {
+    int fd;
+    volatile u32 lock;
+    u32 users;              /**< Mappings of the file */
+} ocrDbCowFile_t;
+
+/**
+ * @brief Mapping backing a copy-on-write data-block
+ *
+ * A data-block that was never snapshotted maps its file shared and writes
+ * straight to it. Once snapshotted, it maps the file privately: the pages
+ * it writes are its own and the file keeps the content of the snapshot.
+ */
+typedef struct _ocrDbCow_t {
+    ocrDbCowFile_t * file;
+    void * addr;            /**< Start of the mapping, page-aligned */
+    u64 mapSize;            /**< Size of the mapping, whole pages */
+    bool isPrivate;
+} ocrDbCow_t;
+
+/**
+ * @brief Maps a zeroed copy-on-write region of at least 'size' bytes
+ *
+ * @return NULL if the file cannot be created or mapped
+ */
+ocrDbCow_t * newDbCow(u64 size);
+
+/**
+ * @brief Unmaps the region and closes the file if it was its last user
+ */
+void destructDbCow(ocrDbCow_t * self);
+
+/**
+ * @brief Maps a snapshot of the current content of 'source'
+ *
+ * Pages written by 'source' since its previous snapshot are either folded
+ * back into its file, when no other snapshot reads from it, or copied into
+ * the new snapshot. When most of the pages were written, 'source' moves to
+ * a file of its own instead.
+ *
+ * @warning Nothing must write to 'source' during the call
+ * @return NULL if the snapshot cannot be mapped
+ */
+ocrDbCow_t * dbCowSnapshot(ocrDbCow_t * source);
+
+#endif /* __DB_COW_H__ */
@@ -18,18 +18,23 @@
 typedef enum _dataBlockType_t {
     dataBlockRegular_id,
     dataBlockPlaced_id,
+    dataBlockLockfree_id,
     dataBlockMax_id
 } dataBlockType_t;
 
 const char * dataBlock_types [] = {
     "Regular",
     "Placed",
+    "Lockfree",
     NULL
 };
 
 // Regular datablock
 #include "datablock/regular/regular-datablock.h"
 
+// Lock-free datablock
+#include "datablock/lockfree/lockfree-datablock.h"
+
 // Placed datablock (not ported as of now)
 // #include "datablock/placed/placed-datablock.h"
 
@@ -39,6 +44,9 @@ ocrDataBlockFactory_t* newDataBlockFactory(dataBlockType_t type, ocrParamList_t
     case dataBlockRegular_id:
         return newDataBlockFactoryRegular(typeArg);
         break;
+    case dataBlockLockfree_id:
+        return newDataBlockFactoryLockfree(typeArg);
+        break;
     case dataBlockPlaced_id:
 //        return newDataBlockFactoryPlaced(typeArg);
 //        break;
@@ -0,0 +1,475 @@
+/**
+ * @brief Data-block implementation tracking its users with an atomic
+ * reference count.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/meta/meta-allocator.h"
+#include "datablock/lockfree/lockfree-datablock.h"
+#include "debug.h"
+#include "ocr-comp-platform.h"
+#include "ocr-datablock.h"
+#include "ocr-macros.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+#include "ocr-sync.h"
+#include "ocr-utils.h"
+
+#ifdef OCR_ENABLE_STATISTICS
+#include "ocr-statistics.h"
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+
+#define DEBUG_TYPE DATABLOCK
+
+/******************************************************/
+/* OWNER TABLES                                       */
+/******************************************************/
+
+static void lockfreeOwnersInit(ocrDataBlockLockfreeOwners_t *owners) {
+    owners->count = 0;
+    owners->capacity = LOCKFREE_INLINE_OWNERS;
+    owners->entries = owners->inlineEntries;
+}
+
+static void lockfreeOwnersDestruct(ocrDataBlockLockfreeOwners_t *owners) {
+    if(owners->entries != owners->inlineEntries) {
+        metaFree(owners->entries);
+    }
+}
+
+// Returns owners->count if 'edt' does not own the data-block
+static u32 lockfreeOwnersFind(ocrDataBlockLockfreeOwners_t *owners, ocrGuid_t edt) {
+    u32 i;
+    for(i = 0; i < owners->count; ++i) {
+        if(owners->entries[i].edt == edt)
+            break;
+    }
+    return i;
+}
+
+static void lockfreeOwnersAdd(ocrDataBlockLockfreeOwners_t *owners, ocrGuid_t edt) {
+    u32 i = lockfreeOwnersFind(owners, edt);
+    if(i < owners->count) {
+        owners->entries[i].count += 1;
+        return;
+    }
+    if(owners->count == owners->capacity) {
+        ocrDataBlockLockfreeOwner_t *entries = (ocrDataBlockLockfreeOwner_t*)
+            metaMalloc(sizeof(ocrDataBlockLockfreeOwner_t)*owners->capacity*2);
+        memcpy(entries, owners->entries, sizeof(ocrDataBlockLockfreeOwner_t)*owners->count);
+        lockfreeOwnersDestruct(owners);
+        owners->entries = entries;
+        owners->capacity *= 2;
+    }
+    owners->entries[owners->count].edt = edt;
+    owners->entries[owners->count].count = 1;
+    owners->count += 1;
+}
+
+static void lockfreeOwnersRemove(ocrDataBlockLockfreeOwners_t *owners, u32 id) {
+    ASSERT(id < owners->count);
+    owners->count -= 1;
+    owners->entries[id] = owners->entries[owners->count];
+}
+
+/******************************************************/
+/* OCR DATABLOCK LOCKFREE                             */
+/******************************************************/
+
+// Adds 'increment' to the state unless one of the 'blocking' flags is set
+static bool lockfreeAddUser(ocrDataBlockLockfree_t *rself, u64 increment, u64 blocking) {
+    u64 old = rself->state;
+    while(!(old & blocking)) {
+        u64 seen = __sync_val_compare_and_swap(&(rself->state), old, old + increment);
+        if(seen == old)
+            return true;
+        old = seen;
+    }
+    return false;
+}
+
+static void lockfreeDebugAddOwner(ocrDataBlockLockfree_t *rself, ocrGuid_t edt) {
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+    lockfreeOwnersAdd(&(rself->internalOwners), edt);
+#endif
+}
+
+// Grants the waiters whose mode is compatible with the current holders,
+// in FIFO order. Called with the lock held. Returns the granted waiters.
+static ocrDbWaiter_t * lockfreeGrantWaiters(ocrDataBlockLockfree_t *rself) {
+    ocrDbWaiter_t * granted = NULL;
+    ocrDbWaiter_t ** grantedTail = &granted;
+    while(rself->waitersHead != NULL) {
+        ocrDbWaiter_t * waiter = rself->waitersHead;
+        u64 state = rself->state;
+        if(!(state & LOCKFREE_FREE_REQUESTED)) {
+            if(waiter->mode == DB_MODE_EW) {
+                if(state & (LOCKFREE_EXCLUSIVE | LOCKFREE_HOLDERS_MASK))
+                    break;
+                rself->exclusiveOwner = waiter->edt;
+                __sync_fetch_and_add(&(rself->state), LOCKFREE_EXCLUSIVE + LOCKFREE_HOLDER);
+            } else {
+                if(state & LOCKFREE_EXCLUSIVE)
+                    break;
+                __sync_fetch_and_add(&(rself->state), LOCKFREE_HOLDER);
+            }
+            lockfreeDebugAddOwner(rself, waiter->edt);
+        } else {
+            // Requests still waiting when the data-block is freed fail
+            waiter->mode = (ocrDbAccessMode_t) -1;
+        }
+        rself->waitersHead = waiter->next;
+        waiter->next = NULL;
+        *grantedTail = waiter;
+        grantedTail = &(waiter->next);
+    }
+    if(rself->waitersHead == NULL) {
+        rself->waitersTail = NULL;
+        __sync_fetch_and_and(&(rself->state), ~LOCKFREE_QUEUED);
+    }
+    return granted;
+}
+
+static void lockfreeNotifyWaiters(ocrDataBlockLockfree_t *rself, ocrDbWaiter_t * granted) {
+    while(granted != NULL) {
+        ocrDbWaiter_t * next = granted->next;
+        DPRINTF(DEBUG_LVL_VERB, "Granting DB (GUID 0x%"PRIdPTR") to EDT 0x%"PRIdPTR" (mode %d)\n",
+                rself->base.guid, granted->edt, (u32)granted->mode);
+        granted->granted(granted->edt,
+                         (granted->mode == (ocrDbAccessMode_t) -1) ? NULL : rself->base.ptr);
+        metaFree(granted);
+        granted = next;
+    }
+}
+
+// Removes 'decrement' from the state, grants the waiters it may unblock and
+// destroys the data-block if it was the last user and a free has been requested
+static void lockfreeRemoveUser(ocrDataBlockLockfree_t *rself, u64 decrement) {
+    u64 old = rself->state;
+    while(!(old & LOCKFREE_QUEUED)) {
+        u64 seen = __sync_val_compare_and_swap(&(rself->state), old, old - decrement);
+        if(seen == old) {
+            DPRINTF(DEBUG_LVL_VVERB, "DB attributes: users %d; holders %d; flags 0x%x\n",
+                    (u32)((old - decrement) & LOCKFREE_USERS_MASK),
+                    (u32)(((old - decrement) & LOCKFREE_HOLDERS_MASK) >> 32), (u32)((old - decrement) >> 61));
+            if((old - decrement) == LOCKFREE_FREE_REQUESTED)
+                rself->base.fctPtrs->destruct(&(rself->base));
+            return;
+        }
+        old = seen;
+    }
+
+    // Some requests are waiting. Keep this user until the lock is held so
+    // that no other thread can destroy the data-block while we wait for it
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    __sync_fetch_and_sub(&(rself->state), decrement);
+    ocrDbWaiter_t * granted = lockfreeGrantWaiters(rself);
+    bool destroy = (rself->state == LOCKFREE_FREE_REQUESTED);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+    lockfreeNotifyWaiters(rself, granted);
+    if(destroy)
+        rself->base.fctPtrs->destruct(&(rself->base));
+}
+
+void* lockfreeAcquire(ocrDataBlock_t *self, ocrGuid_t edt, bool isInternal) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Acquiring DB @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR") from EDT 0x%"PRIdPTR" (isInternal %d)\n",
+                (u64)self->ptr, rself->base.guid, edt, (u32)isInternal);
+
+    if(isInternal) {
+        if(!lockfreeAddUser(rself, LOCKFREE_HOLDER, LOCKFREE_FREE_REQUESTED))
+            return NULL;
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+        rself->lock->fctPtrs->lock(rself->lock);
+        lockfreeDebugAddOwner(rself, edt);
+        rself->lock->fctPtrs->unlock(rself->lock);
+#endif
+        return self->ptr;
+    }
+
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    if(lockfreeOwnersFind(&(rself->explicitOwners), edt) < rself->explicitOwners.count) {
+        DPRINTF(DEBUG_LVL_VVERB, "EDT already had acquired DB\n");
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return self->ptr;
+    }
+    if(!lockfreeAddUser(rself, LOCKFREE_USER, LOCKFREE_FREE_REQUESTED)) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return NULL;
+    }
+    lockfreeOwnersAdd(&(rself->explicitOwners), edt);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+    return self->ptr;
+}
+
+u8 lockfreeAcquireMode(ocrDataBlock_t *self, ocrGuid_t edt, ocrDbAccessMode_t mode,
+                       ocrDbGrantFct_t granted) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Acquiring DB @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR") from EDT 0x%"PRIdPTR" (mode %d)\n",
+                (u64)self->ptr, rself->base.guid, edt, (u32)mode);
+
+    // Shared acquires do not need the lock unless
+    // an exclusive access is held or requested
+    if(mode != DB_MODE_EW) {
+        if(lockfreeAddUser(rself, LOCKFREE_HOLDER,
+                           LOCKFREE_FREE_REQUESTED | LOCKFREE_EXCLUSIVE | LOCKFREE_QUEUED)) {
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+            rself->lock->fctPtrs->lock(rself->lock);
+            lockfreeDebugAddOwner(rself, edt);
+            rself->lock->fctPtrs->unlock(rself->lock);
+#endif
+            return 0;
+        }
+    }
+
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    // Releases seeing this flag grant the waiters under the lock
+    u64 state = __sync_fetch_and_or(&(rself->state), LOCKFREE_QUEUED);
+    if(state & LOCKFREE_FREE_REQUESTED) {
+        if(rself->waitersHead == NULL)
+            __sync_fetch_and_and(&(rself->state), ~LOCKFREE_QUEUED);
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EPERM;
+    }
+    ocrDbWaiter_t * waiter = (ocrDbWaiter_t *) metaMalloc(sizeof(ocrDbWaiter_t));
+    waiter->edt = edt;
+    waiter->mode = mode;
+    waiter->granted = granted;
+    waiter->next = NULL;
+    if(rself->waitersTail == NULL)
+        rself->waitersHead = waiter;
+    else
+        rself->waitersTail->next = waiter;
+    rself->waitersTail = waiter;
+    // The holders may have released the data-block in the meantime
+    ocrDbWaiter_t * grantedNow = lockfreeGrantWaiters(rself);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+
+    // Only our request can have been granted: the earlier waiters
+    // were granted by the release that made them compatible
+    u8 result = EBUSY;
+    if(grantedNow != NULL) {
+        ASSERT(grantedNow == waiter && waiter->next == NULL);
+        result = 0;
+        metaFree(waiter);
+    }
+    return result;
+}
+
+u8 lockfreeRelease(ocrDataBlock_t *self, ocrGuid_t edt, bool isInternal) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Releasing DB @ 0x%"PRIx64" (GUID 0x%"PRIdPTR") from EDT 0x%"PRIdPTR" (internal: %d)\n",
+                (u64)self->ptr, rself->base.guid, edt, (u32)isInternal);
+
+    if(isInternal) {
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+        rself->lock->fctPtrs->lock(rself->lock);
+        u32 id = lockfreeOwnersFind(&(rself->internalOwners), edt);
+        ASSERT(id < rself->internalOwners.count);
+        if(--(rself->internalOwners.entries[id].count) == 0)
+            lockfreeOwnersRemove(&(rself->internalOwners), id);
+        rself->lock->fctPtrs->unlock(rself->lock);
+#endif
+        // Only the exclusive owner itself can change 'exclusiveOwner'
+        // while it holds the data-block
+        if((rself->state & LOCKFREE_EXCLUSIVE) && (rself->exclusiveOwner == edt)) {
+            rself->exclusiveOwner = NULL_GUID;
+            lockfreeRemoveUser(rself, LOCKFREE_EXCLUSIVE + LOCKFREE_HOLDER);
+        } else {
+            lockfreeRemoveUser(rself, LOCKFREE_HOLDER);
+        }
+        return 0;
+    }
+
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    u32 id = lockfreeOwnersFind(&(rself->explicitOwners), edt);
+    if(id == rself->explicitOwners.count) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return (u8)EACCES;
+    }
+    lockfreeOwnersRemove(&(rself->explicitOwners), id);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+
+    lockfreeRemoveUser(rself, LOCKFREE_USER);
+    return 0;
+}
+
+void lockfreeDestruct(ocrDataBlock_t *self) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+    ASSERT(rself->state == LOCKFREE_FREE_REQUESTED);
+    ASSERT(rself->explicitOwners.count == 0);
+    ASSERT(rself->waitersHead == NULL);
+    lockfreeOwnersDestruct(&(rself->explicitOwners));
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+    ASSERT(rself->internalOwners.count == 0);
+    lockfreeOwnersDestruct(&(rself->internalOwners));
+#endif
+    rself->lock->fctPtrs->destruct(rself->lock);
+
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t *orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->type = PD_MSG_GUID_REL;
+    DPRINTF(DEBUG_LVL_VERB, "Freeing DB @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR")\n", (u64)self->ptr, rself->base.guid);
+    ocrDbReleaseMemory(self);
+
+#ifdef OCR_ENABLE_STATISTICS
+    ocrStatsProcessDestruct(&(rself->base.statProcess));
+#endif
+
+    pd->inform(pd, self->guid, ctx);
+    ctx->destruct(ctx);
+    metaFree(rself);
+}
+
+u8 lockfreeFree(ocrDataBlock_t *self, ocrGuid_t edt) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Requesting a free for DB @ 0x%"PRIx64" (GUID 0x%"PRIdPTR")\n",
+            (u64)self->ptr, rself->base.guid);
+
+    // Hold a reference while requesting the free so that
+    // the last user cannot destroy the data-block under us
+    if(!lockfreeAddUser(rself, LOCKFREE_USER, LOCKFREE_FREE_REQUESTED))
+        return EPERM;
+
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    if(__sync_fetch_and_or(&(rself->state), LOCKFREE_FREE_REQUESTED) & LOCKFREE_FREE_REQUESTED) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        lockfreeRemoveUser(rself, LOCKFREE_USER);
+        return EPERM;
+    }
+    // A free releases the explicit acquire of the EDT
+    u32 id = lockfreeOwnersFind(&(rself->explicitOwners), edt);
+    bool isOwner = id < rself->explicitOwners.count;
+    if(isOwner)
+        lockfreeOwnersRemove(&(rself->explicitOwners), id);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+
+    lockfreeRemoveUser(rself, isOwner ? (2*LOCKFREE_USER) : LOCKFREE_USER);
+    return 0;
+}
+
+u8 lockfreeResize(ocrDataBlock_t *self, ocrGuid_t edt, u64 size) {
+    ocrDataBlockLockfree_t *rself = (ocrDataBlockLockfree_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Resizing DB @ 0x%"PRIx64" (GUID 0x%"PRIdPTR") to %"PRIu64" bytes for EDT 0x%"PRIdPTR"\n",
+            (u64)self->ptr, rself->base.guid, size, edt);
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    u64 state = rself->state;
+    if(state & LOCKFREE_FREE_REQUESTED) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EPERM;
+    }
+    // Internal acquires are not tracked: the only one left is the caller's
+    if(((state & LOCKFREE_USERS_MASK) != 1) ||
+       ((rself->explicitOwners.count == 1) && (rself->explicitOwners.entries[0].edt != edt))) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EBUSY;
+    }
+    // Hold the data-block exclusively unless the caller already does, so
+    // that acquireMode() requests wait for the new memory
+    bool takeExclusive = (state & LOCKFREE_EXCLUSIVE) == 0;
+    if(takeExclusive &&
+       (__sync_val_compare_and_swap(&(rself->state), state, state | LOCKFREE_EXCLUSIVE) != state)) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EBUSY;
+    }
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    u8 status = pd->resizeDb(pd, self->guid, size, getCurrentWorkerContext());
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+
+    if(takeExclusive)
+        lockfreeRemoveUser(rself, LOCKFREE_EXCLUSIVE);
+    return status;
+}
+
+ocrDataBlock_t* newDataBlockLockfree(ocrDataBlockFactory_t *factory, ocrGuid_t allocator,
+                                     ocrGuid_t allocatorPD, u64 size, void* ptr,
+                                     u16 properties, ocrParamList_t *perInstance) {
+
+    ocrDataBlockLockfree_t *result = (ocrDataBlockLockfree_t*)
+        metaMalloc(sizeof(ocrDataBlockLockfree_t));
+
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t *ctx = getCurrentWorkerContext();
+
+    result->base.guid = UNINITIALIZED_GUID;
+    result->base.allocator = allocator;
+    result->base.allocatorPD = allocatorPD;
+    result->base.size = size;
+    result->base.ptr = ptr;
+    result->base.properties = properties;
+    result->base.inDbAllocator = NO_ALLOC;
+    result->base.parent = NULL_GUID;
+    result->base.spill = NULL;
+    result->base.cow = NULL;
+    result->base.fctPtrs = &(factory->dataBlockFcts);
+
+    guidify(pd, (u64)result, &(result->base.guid), OCR_GUID_DB);
+    result->lock = pd->getLock(pd, ctx);
+
+    result->state = 0;
+    result->exclusiveOwner = NULL_GUID;
+    result->waitersHead = NULL;
+    result->waitersTail = NULL;
+    lockfreeOwnersInit(&(result->explicitOwners));
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+    lockfreeOwnersInit(&(result->internalOwners));
+#endif
+
+    DPRINTF(DEBUG_LVL_VERB, "Creating a datablock of size %"PRIu64" @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR")\n",
+            size, (u64)result->base.ptr, result->base.guid);
+
+    return (ocrDataBlock_t*)result;
+}
+
+/******************************************************/
+/* OCR DATABLOCK LOCKFREE FACTORY                     */
+/******************************************************/
+
+static void destructLockfreeFactory(ocrDataBlockFactory_t *factory) {
+    free(factory);
+}
+
+ocrDataBlockFactory_t *newDataBlockFactoryLockfree(ocrParamList_t *perType) {
+    ocrDataBlockFactory_t *base = (ocrDataBlockFactory_t*)
+        checkedMalloc(base, sizeof(ocrDataBlockFactoryLockfree_t));
+
+    base->instantiate = &newDataBlockLockfree;
+    base->destruct = &destructLockfreeFactory;
+    base->dataBlockFcts.destruct = &lockfreeDestruct;
+    base->dataBlockFcts.acquire = &lockfreeAcquire;
+    base->dataBlockFcts.acquireMode = &lockfreeAcquireMode;
+    base->dataBlockFcts.release = &lockfreeRelease;
+    base->dataBlockFcts.free = &lockfreeFree;
+    base->dataBlockFcts.resize = &lockfreeResize;
+
+    return base;
+}
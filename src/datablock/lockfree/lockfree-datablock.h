@@ -0,0 +1,95 @@
+/**
+ * @brief Data-block implementation tracking its users with an atomic
+ * reference count.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __DATABLOCK_LOCKFREE_H__
+#define __DATABLOCK_LOCKFREE_H__
+
+#include "ocr-allocator.h"
+#include "ocr-datablock.h"
+#include "ocr-sync.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+// Layout of 'state':
+//  - FREE_REQUESTED: set once a free has been requested
+//  - EXCLUSIVE: an EDT holds the data-block in DB_MODE_EW
+//  - QUEUED: acquireMode() requests are waiting in 'waiters'
+//  - HOLDERS: internal acquires not released yet
+//  - USERS: all the acquires not released yet
+#define LOCKFREE_FREE_REQUESTED (1ULL << 63)
+#define LOCKFREE_EXCLUSIVE      (1ULL << 62)
+#define LOCKFREE_QUEUED         (1ULL << 61)
+#define LOCKFREE_HOLDERS_MASK   (((1ULL << 29) - 1) << 32)
+#define LOCKFREE_USERS_MASK     ((1ULL << 32) - 1)
+
+// Increments of 'state' for an explicit and an internal acquire
+#define LOCKFREE_USER           (1ULL)
+#define LOCKFREE_HOLDER         ((1ULL << 32) + LOCKFREE_USER)
+
+// Owners stored in the data-block itself before
+// an owner table needs to allocate memory
+#define LOCKFREE_INLINE_OWNERS 2
+
+typedef struct {
+    ocrDataBlockFactory_t base;
+} ocrDataBlockFactoryLockfree_t;
+
+typedef struct {
+    ocrGuid_t edt;
+    u32 count;              /**< Number of acquires held by 'edt' */
+} ocrDataBlockLockfreeOwner_t;
+
+/**
+ * @brief Unbounded set of the EDTs holding a data-block
+ *
+ * @warning Not thread safe. Accesses are protected by the data-block's lock
+ **/
+typedef struct {
+    u32 count;
+    u32 capacity;
+    ocrDataBlockLockfreeOwner_t * entries;
+    ocrDataBlockLockfreeOwner_t inlineEntries[LOCKFREE_INLINE_OWNERS];
+} ocrDataBlockLockfreeOwners_t;
+
+/**
+ * @brief Data-block whose internal acquires and releases (the ones the
+ * runtime performs for the dependences of EDTs) are a single atomic
+ * operation on 'state'.
+ *
+ * Shared (DB_MODE_RO and DB_MODE_ITW) acquires stay lock-free as long as
+ * no EDT holds or waits for an exclusive access. Exclusive acquires and
+ * the requests that have to wait go through 'lock' and 'waiters'.
+ *
+ * Explicit acquires (ocrDbCreate(), ocrDbAcquire()) are rare. They have
+ * no effect when repeated by the same EDT and are released by a free from
+ * their EDT so they are recorded in 'explicitOwners', under 'lock'.
+ *
+ * When built with OCR_DEBUG_DATABLOCK_OWNERS, internal acquires are also
+ * recorded in 'internalOwners' to check that releases match them.
+ **/
+typedef struct _ocrDataBlockLockfree_t {
+    ocrDataBlock_t base;
+
+    /* Data for the data-block */
+    volatile u64 state;     /**< Acquire counts and flags (see LOCKFREE_*) */
+    ocrLock_t* lock;        /**< Lock for the owner tables and the waiters */
+    ocrGuid_t exclusiveOwner; /**< EDT holding the data-block in DB_MODE_EW */
+    ocrDbWaiter_t * waitersHead;
+    ocrDbWaiter_t * waitersTail;
+    ocrDataBlockLockfreeOwners_t explicitOwners;
+#ifdef OCR_DEBUG_DATABLOCK_OWNERS
+    ocrDataBlockLockfreeOwners_t internalOwners;
+#endif
+} ocrDataBlockLockfree_t;
+
+extern ocrDataBlockFactory_t* newDataBlockFactoryLockfree(ocrParamList_t *perType);
+
+#endif /* __DATABLOCK_LOCKFREE_H__ */
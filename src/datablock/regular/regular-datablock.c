@@ -8,6 +8,7 @@
  * removed or modified.
  */
 
+#include "allocator/meta/meta-allocator.h"
 #include "datablock/regular/regular-datablock.h"
 #include "debug.h"
 #include "ocr-comp-platform.h"
@@ -29,6 +30,90 @@
 
 #define DEBUG_TYPE DATABLOCK
 
+// Returns true if the EDT is a user. Called with the lock held
+static bool regularIsUser(ocrDataBlockRegular_t *rself, ocrGuid_t edt) {
+    if(ocrGuidTrackerFind(&(rself->usersTracker), edt) <= 63)
+        return true;
+    ocrDbRegularUser_t * user = rself->overflowUsers;
+    while((user != NULL) && (user->edt != edt))
+        user = user->next;
+    return user != NULL;
+}
+
+// Registers an EDT as a user. Called with the lock held
+static void regularAddUser(ocrDataBlockRegular_t *rself, ocrGuid_t edt, bool isInternal) {
+    if(regularIsUser(rself, edt)) {
+        DPRINTF(DEBUG_LVL_VVERB, "EDT already had acquired DB\n");
+        return;
+    }
+    u32 idForEdt = ocrGuidTrackerTrack(&(rself->usersTracker), edt);
+    if(idForEdt > 63) {
+        // The tracker is full, keep the EDT aside
+        ocrDbRegularUser_t * user = (ocrDbRegularUser_t *) metaMalloc(sizeof(ocrDbRegularUser_t));
+        user->edt = edt;
+        user->next = rself->overflowUsers;
+        rself->overflowUsers = user;
+    }
+    rself->attributes.numUsers += 1;
+    if(isInternal)
+        rself->attributes.internalUsers += 1;
+    DPRINTF(DEBUG_LVL_VERB, "Added EDT GUID 0x%"PRIx64" at position %d. Have %d users and %d internal\n",
+                (u64)edt, idForEdt, rself->attributes.numUsers, rself->attributes.internalUsers);
+}
+
+// Unregisters an EDT tracked in overflowUsers. Called with the lock held.
+// Returns false if the EDT is not there
+static bool regularRemoveOverflowUser(ocrDataBlockRegular_t *rself, ocrGuid_t edt) {
+    ocrDbRegularUser_t ** user = &(rself->overflowUsers);
+    while((*user != NULL) && ((*user)->edt != edt))
+        user = &((*user)->next);
+    if(*user == NULL)
+        return false;
+    ocrDbRegularUser_t * removed = *user;
+    *user = removed->next;
+    metaFree(removed);
+    return true;
+}
+
+// Grants the waiters whose mode is compatible with the current users,
+// in FIFO order. Called with the lock held. Returns the granted waiters.
+static ocrDbWaiter_t * regularGrantWaiters(ocrDataBlockRegular_t *rself) {
+    ocrDbWaiter_t * granted = NULL;
+    ocrDbWaiter_t ** grantedTail = &granted;
+    while(rself->waitersHead != NULL) {
+        ocrDbWaiter_t * waiter = rself->waitersHead;
+        if(rself->exclusiveOwner != NULL_GUID)
+            break;
+        if((waiter->mode == DB_MODE_EW) && (rself->attributes.internalUsers != 0))
+            break;
+        if(rself->attributes.freeRequested) {
+            // The request fails
+            waiter->mode = (ocrDbAccessMode_t) -1;
+        } else {
+            regularAddUser(rself, waiter->edt, true);
+            if(waiter->mode == DB_MODE_EW)
+                rself->exclusiveOwner = waiter->edt;
+        }
+        rself->waitersHead = waiter->next;
+        waiter->next = NULL;
+        *grantedTail = waiter;
+        grantedTail = &(waiter->next);
+    }
+    if(rself->waitersHead == NULL)
+        rself->waitersTail = NULL;
+    return granted;
+}
+
+static void regularNotifyWaiters(ocrDataBlockRegular_t *rself, ocrDbWaiter_t * granted) {
+    while(granted != NULL) {
+        ocrDbWaiter_t * next = granted->next;
+        granted->granted(granted->edt,
+                         (granted->mode == (ocrDbAccessMode_t) -1) ? NULL : rself->base.ptr);
+        metaFree(granted);
+        granted = next;
+    }
+}
+
 void* regularAcquire(ocrDataBlock_t *self, ocrGuid_t edt, bool isInternal) {
     ocrDataBlockRegular_t *rself = (ocrDataBlockRegular_t*)self;
 
@@ -41,28 +126,46 @@ void* regularAcquire(ocrDataBlock_t *self, ocrGuid_t edt, bool isInternal) {
         rself->lock->fctPtrs->unlock(rself->lock);
         return NULL;
     }
-    u32 idForEdt = ocrGuidTrackerFind(&(rself->usersTracker), edt);
-    if(idForEdt > 63)
-        idForEdt = ocrGuidTrackerTrack(&(rself->usersTracker), edt);
-    else {
-        DPRINTF(DEBUG_LVL_VVERB, "EDT already had acquired DB (pos %d)\n", idForEdt);
+    regularAddUser(rself, edt, isInternal);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+    return self->ptr;
+}
+
+u8 regularAcquireMode(ocrDataBlock_t *self, ocrGuid_t edt, ocrDbAccessMode_t mode,
+                      ocrDbGrantFct_t granted) {
+    ocrDataBlockRegular_t *rself = (ocrDataBlockRegular_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Acquiring DB @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR") from EDT 0x%"PRIdPTR" (mode %d)\n",
+                (u64)self->ptr, rself->base.guid, edt, (u32)mode);
+
+    // Critical section
+    rself->lock->fctPtrs->lock(rself->lock);
+    if(rself->attributes.freeRequested) {
         rself->lock->fctPtrs->unlock(rself->lock);
-        return self->ptr;
+        return EPERM;
     }
-
-    if(idForEdt > 63) {
+    if((rself->waitersHead == NULL) && (rself->exclusiveOwner == NULL_GUID) &&
+       ((mode != DB_MODE_EW) || (rself->attributes.internalUsers == 0))) {
+        regularAddUser(rself, edt, true);
+        if(mode == DB_MODE_EW)
+            rself->exclusiveOwner = edt;
         rself->lock->fctPtrs->unlock(rself->lock);
-        return NULL;
+        return 0;
     }
-    rself->attributes.numUsers += 1;
-    if(isInternal)
-        rself->attributes.internalUsers += 1;
-
+    ocrDbWaiter_t * waiter = (ocrDbWaiter_t *) metaMalloc(sizeof(ocrDbWaiter_t));
+    waiter->edt = edt;
+    waiter->mode = mode;
+    waiter->granted = granted;
+    waiter->next = NULL;
+    if(rself->waitersTail == NULL)
+        rself->waitersHead = waiter;
+    else
+        rself->waitersTail->next = waiter;
+    rself->waitersTail = waiter;
     rself->lock->fctPtrs->unlock(rself->lock);
     // End critical section
-    DPRINTF(DEBUG_LVL_VERB, "Added EDT GUID 0x%"PRIx64" at position %d. Have %d users and %d internal\n",
-                (u64)edt, idForEdt, rself->attributes.numUsers, rself->attributes.internalUsers);
-    return self->ptr;
+    return EBUSY;
 }
 
 u8 regularRelease(ocrDataBlock_t *self, ocrGuid_t edt,
@@ -76,7 +179,9 @@ u8 regularRelease(ocrDataBlock_t *self, ocrGuid_t edt,
                 (u64)self->ptr, rself->base.guid, edt, edtId, (u32)isInternal);
     // Start critical section
     rself->lock->fctPtrs->lock(rself->lock);
-    if(edtId > 63 || rself->usersTracker.slots[edtId] != edt) {
+    if((edtId <= 63) && (rself->usersTracker.slots[edtId] == edt)) {
+        ocrGuidTrackerRemove(&(rself->usersTracker), edt, edtId);
+    } else if(!regularRemoveOverflowUser(rself, edt)) {
         // We did not find it. The runtime may be
         // re-releasing it
         if(isInternal) {
@@ -91,26 +196,29 @@ u8 regularRelease(ocrDataBlock_t *self, ocrGuid_t edt,
     }
 
     if(isTracked) {
-        ocrGuidTrackerRemove(&(rself->usersTracker), edt, edtId);
         rself->attributes.numUsers -= 1;
         if(isInternal) {
             rself->attributes.internalUsers -= 1;
         }
     }
+    if(isInternal && (rself->exclusiveOwner == edt)) {
+        rself->exclusiveOwner = NULL_GUID;
+    }
+    ocrDbWaiter_t * granted = regularGrantWaiters(rself);
     DPRINTF(DEBUG_LVL_VVERB, "DB attributes: numUsers %d; internalUsers %d; freeRequested %d\n",
             rself->attributes.numUsers, rself->attributes.internalUsers, rself->attributes.freeRequested);
     // Check if we need to free the block
-    if(rself->attributes.numUsers == 0  &&
-       rself->attributes.internalUsers == 0 &&
-       rself->attributes.freeRequested == 1) {
+    bool destroy = (rself->attributes.numUsers == 0  &&
+                    rself->attributes.internalUsers == 0 &&
+                    rself->attributes.freeRequested == 1);
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+
+    regularNotifyWaiters(rself, granted);
+    if(destroy) {
         // We need to actually free the data-block
-        rself->lock->fctPtrs->unlock(rself->lock);
         self->fctPtrs->destruct(self);
-    } else {
-        rself->lock->fctPtrs->unlock(rself->lock);
     }
-    // End critical section
-
     return 0;
 }
 
@@ -125,12 +233,8 @@ void regularDestruct(ocrDataBlock_t *self) {
     ocrPolicyCtx_t *orgCtx = getCurrentWorkerContext();
     ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
     ctx->type = PD_MSG_GUID_REL;
-    // Tell the allocator to free the data-block
-    ocrAllocator_t *allocator = NULL;
-    deguidify(getCurrentPD(), rself->base.allocator, (u64*)&allocator, NULL);
-
     DPRINTF(DEBUG_LVL_VERB, "Freeing DB @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR")\n", (u64)self->ptr, rself->base.guid);
-    allocator->fctPtrs->free(allocator, self->ptr);
+    ocrDbReleaseMemory(self);
 
     // TODO: This is not pretty to be here but I can't put this in the ocrDbFree because
     // the semantics of ocrDbFree is that it will wait for all acquire/releases to have
@@ -142,13 +246,12 @@ void regularDestruct(ocrDataBlock_t *self) {
 
     pd->inform(pd, self->guid, ctx);
     ctx->destruct(ctx);
-    free(rself);
+    metaFree(rself);
 }
 
 u8 regularFree(ocrDataBlock_t *self, ocrGuid_t edt) {
     ocrDataBlockRegular_t *rself = (ocrDataBlockRegular_t*)self;
 
-    u32 id = ocrGuidTrackerFind(&(rself->usersTracker), edt);
     DPRINTF(DEBUG_LVL_VERB, "Requesting a free for DB @ 0x%"PRIx64" (GUID 0x%"PRIdPTR")\n",
             (u64)self->ptr, rself->base.guid);
     // Begin critical section
@@ -158,11 +261,12 @@ u8 regularFree(ocrDataBlock_t *self, ocrGuid_t edt) {
         return EPERM;
     }
     rself->attributes.freeRequested = 1;
+    bool isUser = regularIsUser(rself, edt);
     rself->lock->fctPtrs->unlock(rself->lock);
     // End critical section
 
 
-    if(id < 64) {
+    if(isUser) {
         regularRelease(self, edt, false);
     } else {
         // We can call free without having acquired the block
@@ -182,12 +286,35 @@ u8 regularFree(ocrDataBlock_t *self, ocrGuid_t edt) {
     return 0;
 }
 
+u8 regularResize(ocrDataBlock_t *self, ocrGuid_t edt, u64 size) {
+    ocrDataBlockRegular_t *rself = (ocrDataBlockRegular_t*)self;
+
+    DPRINTF(DEBUG_LVL_VERB, "Resizing DB @ 0x%"PRIx64" (GUID 0x%"PRIdPTR") to %"PRIu64" bytes for EDT 0x%"PRIdPTR"\n",
+            (u64)self->ptr, rself->base.guid, size, edt);
+    // Critical section: acquires wait for the resize to get the new memory
+    rself->lock->fctPtrs->lock(rself->lock);
+    if(rself->attributes.freeRequested) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EPERM;
+    }
+    // Queued acquireMode() requests get the new memory when granted
+    if((rself->attributes.numUsers != 1) || !regularIsUser(rself, edt)) {
+        rself->lock->fctPtrs->unlock(rself->lock);
+        return EBUSY;
+    }
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    u8 status = pd->resizeDb(pd, self->guid, size, getCurrentWorkerContext());
+    rself->lock->fctPtrs->unlock(rself->lock);
+    // End critical section
+    return status;
+}
+
 ocrDataBlock_t* newDataBlockRegular(ocrDataBlockFactory_t *factory, ocrGuid_t allocator,
                                     ocrGuid_t allocatorPD, u64 size, void* ptr,
                                     u16 properties, ocrParamList_t *perInstance) {
 
     ocrDataBlockRegular_t *result = (ocrDataBlockRegular_t*)
-        checkedMalloc(result, sizeof(ocrDataBlockRegular_t));
+        metaMalloc(sizeof(ocrDataBlockRegular_t));
 
     ocrPolicyDomain_t *pd = getCurrentPD();
     ocrPolicyCtx_t *ctx = getCurrentWorkerContext();
@@ -198,6 +325,10 @@ ocrDataBlock_t* newDataBlockRegular(ocrDataBlockFactory_t *factory, ocrGuid_t al
     result->base.size = size;
     result->base.ptr = ptr;
     result->base.properties = properties;
+    result->base.inDbAllocator = NO_ALLOC;
+    result->base.parent = NULL_GUID;
+    result->base.spill = NULL;
+    result->base.cow = NULL;
     result->base.fctPtrs = &(factory->dataBlockFcts);
 
 
@@ -209,6 +340,10 @@ ocrDataBlock_t* newDataBlockRegular(ocrDataBlockFactory_t *factory, ocrGuid_t al
     result->attributes.internalUsers = 0;
     result->attributes.freeRequested = 0;
     ocrGuidTrackerInit(&(result->usersTracker));
+    result->overflowUsers = NULL;
+    result->exclusiveOwner = NULL_GUID;
+    result->waitersHead = NULL;
+    result->waitersTail = NULL;
 
 
     DPRINTF(DEBUG_LVL_VERB, "Creating a datablock of size %"PRIu64" @ 0x%"PRIx64" (GUID: 0x%"PRIdPTR")\n",
@@ -232,8 +367,10 @@ ocrDataBlockFactory_t *newDataBlockFactoryRegular(ocrParamList_t *perType) {
     base->destruct = &destructRegularFactory;
     base->dataBlockFcts.destruct = &regularDestruct;
     base->dataBlockFcts.acquire = &regularAcquire;
+    base->dataBlockFcts.acquireMode = &regularAcquireMode;
     base->dataBlockFcts.release = &regularRelease;
     base->dataBlockFcts.free = &regularFree;
+    base->dataBlockFcts.resize = &regularResize;
 
     return base;
 }
@@ -32,6 +32,14 @@ typedef union {
     u64 data;
 } ocrDataBlockRegularAttr_t;
 
+/**
+ * @brief User of a data-block that did not fit in its tracker
+ */
+typedef struct _ocrDbRegularUser_t {
+    ocrGuid_t edt;
+    struct _ocrDbRegularUser_t * next;
+} ocrDbRegularUser_t;
+
 typedef struct _ocrDataBlockRegular_t {
     ocrDataBlock_t base;
 
@@ -40,6 +48,11 @@ typedef struct _ocrDataBlockRegular_t {
     ocrDataBlockRegularAttr_t attributes; /**< Attributes for this data-block */
 
     ocrGuidTracker_t usersTracker;
+    ocrDbRegularUser_t * overflowUsers; /**< Users beyond the 64 of usersTracker */
+
+    ocrGuid_t exclusiveOwner; /**< EDT holding the data-block in DB_MODE_EW */
+    ocrDbWaiter_t * waitersHead; /**< acquireMode() requests waiting */
+    ocrDbWaiter_t * waitersTail;
 } ocrDataBlockRegular_t;
 
 extern ocrDataBlockFactory_t* newDataBlockFactoryRegular(ocrParamList_t *perType);
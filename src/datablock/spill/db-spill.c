@@ -0,0 +1,358 @@
+/**
+ * @brief Eviction of unused data-blocks to a scratch file
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+// For fallocate()
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "datablock/spill/db-spill.h"
+#include "debug.h"
+#include "ocr-allocator.h"
+#include "ocr-datablock.h"
+#include "ocr-macros.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEBUG_TYPE DATABLOCK
+
+#define SPILL_NO_SLOT ((u64)-1)
+#define SPILL_FILE_NAME "/ocr-spill-XXXXXX"
+
+/******************************************************/
+/* LISTS OF ENTRIES (called with the lock held)       */
+/******************************************************/
+
+static void spillUnlink(ocrDbSpill_t *self, ocrDbSpillEntry_t *entry) {
+    if(entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else if(entry->resident) {
+        self->residentHead = entry->next;
+    } else {
+        self->evicted = entry->next;
+    }
+    if(entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else if(entry->resident) {
+        self->residentTail = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+// Makes 'entry' the most recently used resident data-block
+static void spillPushResident(ocrDbSpill_t *self, ocrDbSpillEntry_t *entry) {
+    entry->next = self->residentHead;
+    if(self->residentHead != NULL) {
+        self->residentHead->prev = entry;
+    } else {
+        self->residentTail = entry;
+    }
+    self->residentHead = entry;
+}
+
+static void spillPushEvicted(ocrDbSpill_t *self, ocrDbSpillEntry_t *entry) {
+    entry->next = self->evicted;
+    if(self->evicted != NULL) {
+        self->evicted->prev = entry;
+    }
+    self->evicted = entry;
+}
+
+/******************************************************/
+/* EVICTION AND FAULTS (called with the lock held)    */
+/******************************************************/
+
+// Transfers 'size' bytes between 'ptr' and the scratch file
+static bool spillTransfer(int fd, char *ptr, u64 size, u64 offset, bool isWrite) {
+    while(size > 0) {
+        ssize_t done = isWrite ? pwrite(fd, ptr, size, (off_t)offset) :
+                                 pread(fd, ptr, size, (off_t)offset);
+        if(done <= 0) {
+            if((done < 0) && (errno == EINTR)) {
+                continue;
+            }
+            return false;
+        }
+        ptr += done;
+        size -= done;
+        offset += done;
+    }
+    return true;
+}
+
+static ocrAllocator_t * spillAllocator(ocrDataBlock_t *db) {
+    ocrAllocator_t *allocator = NULL;
+    deguidify(getCurrentPD(), db->allocator, (u64*)&allocator, NULL);
+    return allocator;
+}
+
+// Gives the disk space of the slot of 'entry' back. Slots are never reused
+static void spillFreeSlot(ocrDbSpill_t *self, ocrDbSpillEntry_t *entry) {
+#ifdef FALLOC_FL_PUNCH_HOLE
+    if(entry->fileOffset != SPILL_NO_SLOT) {
+        fallocate(self->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  (off_t)entry->fileOffset, (off_t)entry->db->size);
+    }
+#endif
+    entry->fileOffset = SPILL_NO_SLOT;
+}
+
+static bool spillEvictLocked(ocrDbSpill_t *self) {
+    // The least recently used data-block no dependence waits
+    // for or, failing that, the least recently used one
+    ocrDbSpillEntry_t *victim = NULL;
+    ocrDbSpillEntry_t *entry;
+    for(entry = self->residentTail; entry != NULL; entry = entry->prev) {
+        if((entry->internalHolders == 0) && (entry->explicitCount == 0)) {
+            if(entry->pending == 0) {
+                victim = entry;
+                break;
+            }
+            if(victim == NULL) {
+                victim = entry;
+            }
+        }
+    }
+    if(victim == NULL) {
+        return false;
+    }
+
+    ocrDataBlock_t *db = victim->db;
+    if(victim->fileOffset == SPILL_NO_SLOT) {
+        victim->fileOffset = self->fileSize;
+        self->fileSize += db->size;
+    }
+    if(!spillTransfer(self->fd, (char*)db->ptr, db->size, victim->fileOffset, true)) {
+        DPRINTF(DEBUG_LVL_WARN, "Could not write DB 0x%"PRIx64" to the scratch file (errno %d)\n",
+                (u64)db->guid, errno);
+        return false;
+    }
+    DPRINTF(DEBUG_LVL_VERB, "Evicted DB 0x%"PRIx64" @ 0x%"PRIx64" (%"PRIu64" bytes, %"PRIu32" pending)\n",
+            (u64)db->guid, (u64)db->ptr, db->size, victim->pending);
+    ocrAllocator_t *allocator = spillAllocator(db);
+    // db->ptr keeps its stale value: acquires made while the data-block
+    // is evicted still succeed and the EDTs read it back when they run
+    allocator->fctPtrs->free(allocator, db->ptr);
+    spillUnlink(self, victim);
+    victim->resident = false;
+    spillPushEvicted(self, victim);
+    self->evictions++;
+    return true;
+}
+
+static bool spillFaultLocked(ocrDbSpill_t *self, ocrDbSpillEntry_t *entry) {
+    ocrDataBlock_t *db = entry->db;
+    ocrAllocator_t *allocator = spillAllocator(db);
+    void *ptr;
+    while((ptr = allocator->fctPtrs->allocate(allocator, db->size)) == NULL) {
+        if(!spillEvictLocked(self)) {
+            DPRINTF(DEBUG_LVL_WARN, "No memory to read back DB 0x%"PRIx64"\n", (u64)db->guid);
+            return false;
+        }
+    }
+    if(!spillTransfer(self->fd, (char*)ptr, db->size, entry->fileOffset, false)) {
+        DPRINTF(DEBUG_LVL_WARN, "Could not read DB 0x%"PRIx64" from the scratch file (errno %d)\n",
+                (u64)db->guid, errno);
+        allocator->fctPtrs->free(allocator, ptr);
+        return false;
+    }
+    DPRINTF(DEBUG_LVL_VERB, "Read back DB 0x%"PRIx64" @ 0x%"PRIx64"\n", (u64)db->guid, (u64)ptr);
+    db->ptr = ptr;
+    spillUnlink(self, entry);
+    entry->resident = true;
+    spillPushResident(self, entry);
+    self->faults++;
+    return true;
+}
+
+/******************************************************/
+/* DATA-BLOCK INTERFACE                               */
+/******************************************************/
+
+void* ocrDbPin(ocrDataBlock_t *self, ocrGuid_t holder, bool isInternal) {
+    ocrDbSpillEntry_t *entry = self->spill;
+    if(entry == NULL) {
+        return self->ptr;
+    }
+    ocrDbSpill_t *spill = entry->spill;
+    spill->lock->fctPtrs->lock(spill->lock);
+    if(!entry->resident && !spillFaultLocked(spill, entry)) {
+        spill->lock->fctPtrs->unlock(spill->lock);
+        return NULL;
+    }
+    if(isInternal) {
+        entry->internalHolders++;
+    } else {
+        // Repeated explicit acquires have no effect
+        u32 i;
+        for(i = 0; (i < entry->explicitCount) && (entry->explicitHolders[i] != holder); ++i) ;
+        if(i == entry->explicitCount) {
+            if(entry->explicitCount == entry->explicitCapacity) {
+                entry->explicitCapacity = (entry->explicitCapacity == 0) ? 2 : 2*entry->explicitCapacity;
+                entry->explicitHolders = (ocrGuid_t*)realloc(entry->explicitHolders,
+                                                             entry->explicitCapacity*sizeof(ocrGuid_t));
+                ASSERT(entry->explicitHolders != NULL);
+            }
+            entry->explicitHolders[entry->explicitCount++] = holder;
+        }
+    }
+    spillUnlink(spill, entry);
+    spillPushResident(spill, entry);
+    void *ptr = self->ptr;
+    spill->lock->fctPtrs->unlock(spill->lock);
+    return ptr;
+}
+
+void ocrDbUnpin(ocrDataBlock_t *self, ocrGuid_t holder, bool isInternal) {
+    ocrDbSpillEntry_t *entry = self->spill;
+    if(entry == NULL) {
+        return;
+    }
+    ocrDbSpill_t *spill = entry->spill;
+    spill->lock->fctPtrs->lock(spill->lock);
+    if(isInternal) {
+        ASSERT(entry->internalHolders > 0);
+        entry->internalHolders--;
+    } else {
+        // Explicit releases of internal acquires have no effect
+        u32 i;
+        for(i = 0; i < entry->explicitCount; ++i) {
+            if(entry->explicitHolders[i] == holder) {
+                entry->explicitHolders[i] = entry->explicitHolders[--entry->explicitCount];
+                break;
+            }
+        }
+    }
+    spill->lock->fctPtrs->unlock(spill->lock);
+}
+
+void ocrDbPending(ocrDataBlock_t *self, s32 delta) {
+    ocrDbSpillEntry_t *entry = self->spill;
+    if(entry == NULL) {
+        return;
+    }
+    ocrDbSpill_t *spill = entry->spill;
+    spill->lock->fctPtrs->lock(spill->lock);
+    ASSERT((delta > 0) || (entry->pending >= (u32)(-delta)));
+    entry->pending += delta;
+    spill->lock->fctPtrs->unlock(spill->lock);
+}
+
+/******************************************************/
+/* EVICTION LAYER                                     */
+/******************************************************/
+
+void dbSpillRegister(ocrDbSpill_t *self, ocrDataBlock_t *db, ocrGuid_t creator) {
+    ocrDbSpillEntry_t *entry = (ocrDbSpillEntry_t*)checkedMalloc(entry, sizeof(ocrDbSpillEntry_t));
+    entry->db = db;
+    entry->spill = self;
+    entry->resident = true;
+    entry->internalHolders = 0;
+    entry->pending = 0;
+    // The creator holds the data-block as soon as it exists
+    entry->explicitCount = 1;
+    entry->explicitCapacity = 2;
+    entry->explicitHolders = (ocrGuid_t*)checkedMalloc(entry->explicitHolders,
+                                                        entry->explicitCapacity*sizeof(ocrGuid_t));
+    entry->explicitHolders[0] = creator;
+    entry->fileOffset = SPILL_NO_SLOT;
+    db->spill = entry;
+
+    self->lock->fctPtrs->lock(self->lock);
+    spillPushResident(self, entry);
+    self->lock->fctPtrs->unlock(self->lock);
+}
+
+bool dbSpillUnregister(ocrDataBlock_t *db) {
+    ocrDbSpillEntry_t *entry = db->spill;
+    ocrDbSpill_t *self = entry->spill;
+    self->lock->fctPtrs->lock(self->lock);
+    spillUnlink(self, entry);
+    bool resident = entry->resident;
+    spillFreeSlot(self, entry);
+    self->lock->fctPtrs->unlock(self->lock);
+    db->spill = NULL;
+    free(entry->explicitHolders);
+    free(entry);
+    return resident;
+}
+
+void dbSpillResize(ocrDataBlock_t *db) {
+    ocrDbSpillEntry_t *entry = db->spill;
+    ocrDbSpill_t *self = entry->spill;
+    self->lock->fctPtrs->lock(self->lock);
+    ASSERT(entry->resident);
+    // The slot only fits the old size: the next eviction takes a new one
+    spillFreeSlot(self, entry);
+    self->lock->fctPtrs->unlock(self->lock);
+}
+
+bool dbSpillEvict(ocrDbSpill_t *self) {
+    self->lock->fctPtrs->lock(self->lock);
+    bool evicted = spillEvictLocked(self);
+    self->lock->fctPtrs->unlock(self->lock);
+    return evicted;
+}
+
+ocrDbSpill_t * newDbSpill(const char *directory, ocrLockFactory_t *lockFactory) {
+    u64 length = strlen(directory);
+    char *path = (char*)checkedMalloc(path, length + sizeof(SPILL_FILE_NAME));
+    memcpy(path, directory, length);
+    memcpy(path + length, SPILL_FILE_NAME, sizeof(SPILL_FILE_NAME));
+    int fd = mkstemp(path);
+    if(fd < 0) {
+        DPRINTF(DEBUG_LVL_WARN, "Cannot create a scratch file in %s (errno %d), eviction disabled\n",
+                directory, errno);
+        free(path);
+        return NULL;
+    }
+    // The file goes away with the process
+    unlink(path);
+    free(path);
+
+    ocrDbSpill_t *self = (ocrDbSpill_t*)checkedMalloc(self, sizeof(ocrDbSpill_t));
+    self->lock = lockFactory->instantiate(lockFactory, NULL);
+    self->fd = fd;
+    self->fileSize = 0;
+    self->residentHead = NULL;
+    self->residentTail = NULL;
+    self->evicted = NULL;
+    self->evictions = 0;
+    self->faults = 0;
+    return self;
+}
+
+void destructDbSpill(ocrDbSpill_t *self) {
+    DPRINTF(DEBUG_LVL_INFO, "%"PRIu64" data-blocks evicted, %"PRIu64" read back\n",
+            self->evictions, self->faults);
+    // Data-blocks never destroyed
+    ocrDbSpillEntry_t *lists[2] = {self->residentHead, self->evicted};
+    u32 i;
+    for(i = 0; i < 2; ++i) {
+        while(lists[i] != NULL) {
+            ocrDbSpillEntry_t *entry = lists[i];
+            lists[i] = entry->next;
+            entry->db->spill = NULL;
+            free(entry->explicitHolders);
+            free(entry);
+        }
+    }
+    close(self->fd);
+    self->lock->fctPtrs->destruct(self->lock);
+    free(self);
+}
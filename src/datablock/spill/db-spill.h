@@ -0,0 +1,99 @@
+/**
+ * @brief Eviction of unused data-blocks to a scratch file
+ *
+ * When the allocators of a policy domain run out of memory, data-blocks
+ * nobody holds are written to a scratch file, least recently used first,
+ * and their memory goes back to their allocator. They are read back the
+ * next time they are acquired.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#ifndef __DB_SPILL_H__
+#define __DB_SPILL_H__
+
+#include "ocr-datablock.h"
+#include "ocr-sync.h"
+#include "ocr-types.h"
+
+/**
+ * @brief Eviction state of a data-block
+ *
+ * @warning Protected by the lock of the ocrDbSpill_t owning the entry
+ **/
+typedef struct _ocrDbSpillEntry_t {
+    ocrDataBlock_t * db;
+    struct _ocrDbSpill_t * spill;
+    struct _ocrDbSpillEntry_t * prev; /**< In 'resident' or 'evicted' */
+    struct _ocrDbSpillEntry_t * next;
+    bool resident;          /**< The memory of the data-block is allocated */
+    u32 internalHolders;    /**< EDTs running on (or about to run on) the data-block */
+    u32 pending;            /**< EDT dependences on the data-block not acquired yet */
+    u32 explicitCount;      /**< Explicit acquires (ocrDbCreate(), ocrDbAcquire()) */
+    u32 explicitCapacity;
+    ocrGuid_t * explicitHolders;
+    u64 fileOffset;         /**< Location in the scratch file or (u64)-1 if never evicted */
+} ocrDbSpillEntry_t;
+
+/**
+ * @brief Eviction layer of a policy domain
+ *
+ * Data-blocks created by the allocators of the policy domain are kept in
+ * 'resident' from the most to the least recently acquired. Each of them
+ * has a slot in the scratch file the first time it is evicted and keeps
+ * it until it is destroyed.
+ **/
+typedef struct _ocrDbSpill_t {
+    ocrLock_t * lock;
+    int fd;                 /**< Scratch file, already unlinked */
+    u64 fileSize;           /**< End of the last slot of the scratch file */
+    ocrDbSpillEntry_t * residentHead;
+    ocrDbSpillEntry_t * residentTail;
+    ocrDbSpillEntry_t * evicted;
+    u64 evictions;
+    u64 faults;
+} ocrDbSpill_t;
+
+/**
+ * @brief Creates an eviction layer writing to a scratch file in 'directory'
+ *
+ * @return NULL if the scratch file cannot be created
+ */
+ocrDbSpill_t * newDbSpill(const char * directory, ocrLockFactory_t * lockFactory);
+
+void destructDbSpill(ocrDbSpill_t * self);
+
+/**
+ * @brief Makes a data-block just allocated evictable
+ *
+ * @param creator       EDT holding the data-block as its creator
+ */
+void dbSpillRegister(ocrDbSpill_t * self, ocrDataBlock_t * db, ocrGuid_t creator);
+
+/**
+ * @brief Forgets a data-block being destroyed
+ *
+ * @return true if the memory of the data-block is still allocated
+ */
+bool dbSpillUnregister(ocrDataBlock_t * db);
+
+/**
+ * @brief Forgets the scratch file slot of a resident data-block whose
+ * size is about to change
+ */
+void dbSpillResize(ocrDataBlock_t * db);
+
+/**
+ * @brief Evicts the data-block that should be needed the latest
+ *
+ * Data-blocks no EDT dependence waits for go first, in LRU order
+ *
+ * @return false if no data-block can be evicted
+ */
+bool dbSpillEvict(ocrDbSpill_t * self);
+
+#endif /* __DB_SPILL_H__ */
@@ -4,6 +4,7 @@
  * removed or modified.
  */
 
+#include "allocator/meta/meta-allocator.h"
 #include "debug.h"
 #include "event/hc/hc-event.h"
 #include "ocr-datablock.h"
@@ -83,13 +84,13 @@ static ocrEvent_t* eventConstructorInternal(ocrPolicyDomain_t * pd, ocrEventFact
     ocrEvent_t* base = NULL;
     ocrEventFcts_t * eventFctPtrs = NULL;
     if (eventType == OCR_EVENT_FINISH_LATCH_T) {
-        ocrEventHcFinishLatch_t * eventImpl = (ocrEventHcFinishLatch_t*) checkedMalloc(eventImpl, sizeof(ocrEventHcFinishLatch_t));
+        ocrEventHcFinishLatch_t * eventImpl = (ocrEventHcFinishLatch_t*) metaMalloc(sizeof(ocrEventHcFinishLatch_t));
         eventImpl->counter = 0;
         //Note: waiters are initialized afterwards
         eventFctPtrs = &(((ocrEventFactoryHc_t*)factory)->finishLatchFcts);
         base = (ocrEvent_t*)eventImpl;
     } else if (eventType == OCR_EVENT_LATCH_T) {
-        ocrEventHcLatch_t * eventImpl = (ocrEventHcLatch_t*) checkedMalloc(eventImpl, sizeof(ocrEventHcLatch_t));
+        ocrEventHcLatch_t * eventImpl = (ocrEventHcLatch_t*) metaMalloc(sizeof(ocrEventHcLatch_t));
         (eventImpl->base).waiters = END_OF_LIST;
         (eventImpl->base).signalers = END_OF_LIST;
         (eventImpl->base).data = NULL_GUID;
@@ -103,11 +104,11 @@ static ocrEvent_t* eventConstructorInternal(ocrPolicyDomain_t * pd, ocrEventFact
                 "error: Unsupported type of event");
         ocrEventHcSingle_t* eventImpl;
         if (eventType == OCR_EVENT_ONCE_T) {
-            ocrEventHcOnce_t* onceImpl = (ocrEventHcOnce_t*) checkedMalloc(eventImpl, sizeof(ocrEventHcOnce_t));        
+            ocrEventHcOnce_t* onceImpl = (ocrEventHcOnce_t*) metaMalloc(sizeof(ocrEventHcOnce_t));
             onceImpl->nbEdtRegistered = pd->getAtomic64(pd, NULL);
             eventImpl = (ocrEventHcSingle_t*) onceImpl;
         } else {
-            eventImpl = (ocrEventHcSingle_t*) checkedMalloc(eventImpl, sizeof(ocrEventHcSingle_t));
+            eventImpl = (ocrEventHcSingle_t*) metaMalloc(sizeof(ocrEventHcSingle_t));
         }
         (eventImpl->base).waiters = END_OF_LIST;
         (eventImpl->base).signalers = END_OF_LIST;
@@ -142,7 +143,7 @@ static void destructEventHc ( ocrEvent_t* base ) {
         onceEvent->nbEdtRegistered->fctPtrs->destruct(onceEvent->nbEdtRegistered);
     }
     ctx->destruct(ctx);
-    free(derived);
+    metaFree(derived);
 }
 
 
@@ -197,7 +198,7 @@ static void singleEventSatisfy(ocrEvent_t * base, ocrGuid_t data, u32 slotEvent)
             signalWaiter(waiter->guid, self->data, waiter->slot);
             waiters = waiter;
             waiter = waiter->next;
-            free(waiters); // Release waiter node
+            metaFree(waiters); // Release waiter node
         }
     } else {
         // once-events cannot survive down here
@@ -253,14 +254,16 @@ static void latchEventSatisfy(ocrEvent_t * base, ocrGuid_t data, u32 slot) {
             signalWaiter(waiter->guid, NULL_GUID, waiter->slot);
             waiters = waiter;
             waiter = waiter->next;
-            free((regNode_t*) waiters); // Release waiter node
+            metaFree((regNode_t*) waiters); // Release waiter node
         }
     }
 }
 
-// Latch-event doesn't have an output value
+// Latch-event doesn't have an output value, only
+// tell whether it has been satisfied or not
 static ocrGuid_t latchEventGet(ocrEvent_t * base, u32 slot) {
-    return NULL_GUID;
+    ocrEventHcAwaitable_t * self = (ocrEventHcAwaitable_t *) base;
+    return (self->waiters == SEALED_LIST) ? NULL_GUID : ERROR_GUID;
 }
 
 
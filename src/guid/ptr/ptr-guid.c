@@ -8,10 +8,12 @@
  * removed or modified.
  */
 
+#include "allocator/meta/meta-allocator.h"
 #include "debug.h"
 #include "guid/ptr/ptr-guid.h"
 #include "ocr-macros.h"
 
+#include <errno.h>
 #include <stdlib.h>
 
 typedef struct {
@@ -25,13 +27,30 @@ static void ptrDestruct(ocrGuidProvider_t* self) {
 }
 
 static u8 ptrGetGuid(ocrGuidProvider_t* self, ocrGuid_t* guid, u64 val, ocrGuidKind kind) {
-    ocrGuidImpl_t * guidInst = malloc(sizeof(ocrGuidImpl_t));
+    ocrGuidImpl_t * guidInst = metaMalloc(sizeof(ocrGuidImpl_t));
     guidInst->guid = (ocrGuid_t)val;
     guidInst->kind = kind;
     *guid = (u64) guidInst;
     return 0;
 }
 
+// The GUIDs of a range are laid out contiguously so that
+// the first one is also the address of the whole block
+static u8 ptrGetGuidRange(ocrGuidProvider_t* self, ocrGuid_t* guids, u64 val,
+                          u64 stride, u32 count, ocrGuidKind kind) {
+    ocrGuidImpl_t * guidInsts = metaMalloc(sizeof(ocrGuidImpl_t)*count);
+    if (guidInsts == NULL) {
+        return ENOMEM;
+    }
+    u32 i = 0;
+    for ( ; i < count; ++i) {
+        guidInsts[i].guid = (ocrGuid_t)(val + i*stride);
+        guidInsts[i].kind = kind;
+        guids[i] = (u64) &(guidInsts[i]);
+    }
+    return 0;
+}
+
 static u8 ptrGetVal(ocrGuidProvider_t* self, ocrGuid_t guid, u64* val, ocrGuidKind* kind) {
     ocrGuidImpl_t * guidInst = (ocrGuidImpl_t *) guid;
     *val = (u64) guidInst->guid;
@@ -47,7 +66,12 @@ static u8 ptrGetKind(ocrGuidProvider_t* self, ocrGuid_t guid, ocrGuidKind* kind)
 }
 
 static u8 ptrReleaseGuid(ocrGuidProvider_t *self, ocrGuid_t guid) {
-    free((ocrGuidImpl_t*) guid);
+    metaFree((ocrGuidImpl_t*) guid);
+    return 0;
+}
+
+static u8 ptrReleaseGuidRange(ocrGuidProvider_t *self, ocrGuid_t guid) {
+    metaFree((ocrGuidImpl_t*) guid);
     return 0;
 }
 
@@ -74,9 +98,11 @@ ocrGuidProviderFactory_t *newGuidProviderFactoryPtr(ocrParamList_t *typeArg) {
     base->destruct = &destructGuidProviderFactoryPtr;
     base->providerFcts.destruct = &ptrDestruct;
     base->providerFcts.getGuid = &ptrGetGuid;
+    base->providerFcts.getGuidRange = &ptrGetGuidRange;
     base->providerFcts.getVal = &ptrGetVal;
     base->providerFcts.getKind = &ptrGetKind;
     base->providerFcts.releaseGuid = &ptrReleaseGuid;
+    base->providerFcts.releaseGuidRange = &ptrReleaseGuidRange;
 
     return base;
 }
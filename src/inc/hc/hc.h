@@ -8,11 +8,14 @@
 #ifndef HC_H_
 #define HC_H_
 
+#include "ocr-edt.h"
 #include "ocr-types.h"
 
 typedef struct _regNode_t {
     ocrGuid_t guid;
     u32 slot;
+    ocrDbAccessMode_t mode; /**< Access mode of an EDT's dependence */
+    bool pending;           /**< The data-block's pending count includes this dependence */
     struct _regNode_t* next ;
 } regNode_t;
 
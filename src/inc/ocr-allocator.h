@@ -35,6 +35,8 @@ typedef struct _paramListAllocatorFact_t {
 typedef struct _paramListAllocatorInst_t {
     ocrParamList_t base;
     u64 size;
+    u64 maxSize;        /**< Size the allocator may grow to, 0 for no bound */
+    u64 releaseSize;    /**< Frees at least this large return pages to the OS, 0 never */
 } paramListAllocatorInst_t;
 
 
@@ -102,8 +104,42 @@ typedef struct _ocrAllocatorFcts_t {
      *   - if size is 0, equivalent to free
      */
     void* (*reallocate)(struct _ocrAllocator_t *self, void* address, u64 size);
+
+    /**
+     * @brief Adds the state of the memory of this allocator to 'stats'
+     *
+     * Sizes and counts are added to the ones already in 'stats', so
+     * that the caller can sum all its allocators; the largest free
+     * block is the largest of all and the fragmentation is updated
+     * accordingly. Only the free blocks are visited unless 'walk' is
+     * true, which is cheap enough to sample periodically
+     *
+     * @param self              Pointer to this allocator
+     * @param stats             Stats to add to
+     * @param walk              Also visit the allocated chunks and check
+     *                          the consistency of the meta-data
+     * @return 0 on success
+     */
+    u8 (*getStats)(struct _ocrAllocator_t *self, ocrMemoryStats_t *stats, bool walk);
 } ocrAllocatorFcts_t;
 
+/**
+ * @brief Recomputes the fragmentation of 'stats' from its free sizes
+ */
+static inline void ocrMemoryStatsUpdate(ocrMemoryStats_t *stats) {
+    stats->fragmentation = (stats->freeSize == 0) ? 0 :
+        ((stats->freeSize - stats->largestFree)*1000)/stats->freeSize;
+}
+
+/**
+ * @brief Size class of the histograms of ocrMemoryStats_t of a
+ * block of 'size' bytes
+ */
+static inline u32 ocrMemoryStatsClass(u64 size) {
+    u32 sizeClass = fls64(size);
+    return (sizeClass < OCR_MEMORY_STATS_CLASSES) ? sizeClass : (OCR_MEMORY_STATS_CLASSES - 1);
+}
+
 struct _ocrMemTarget_t;
 
 /**
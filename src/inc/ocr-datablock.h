@@ -12,6 +12,7 @@
 #define __OCR_DATABLOCK_H__
 
 #include "ocr-allocator.h"
+#include "ocr-edt.h"
 #include "ocr-types.h"
 #include "ocr-utils.h"
 
@@ -43,6 +44,31 @@ typedef struct _paramListDataBlockInst_t {
 /****************************************************/
 
 struct _ocrDataBlock_t;
+struct _ocrDbSpillEntry_t;
+struct _ocrDbCow_t;
+
+/**
+ * @brief Function called when a queued acquireMode() request is granted
+ *
+ * @param edt           EDT that requested the access
+ * @param ptr           Address of the data-block or NULL if the data-block
+ *                      was freed before the access could be granted
+ */
+typedef void (*ocrDbGrantFct_t)(ocrGuid_t edt, void* ptr);
+
+/**
+ * @brief acquireMode() request waiting for its access mode to be compatible
+ * with the EDTs holding the data-block
+ */
+typedef struct _ocrDbWaiter_t {
+    ocrGuid_t edt;
+    ocrDbAccessMode_t mode;
+    ocrDbGrantFct_t granted;
+    struct _ocrDbWaiter_t * next;
+} ocrDbWaiter_t;
+
+// Internal data-block properties, above those of ocr-db.h
+#define DB_PROP_MAPPED ((u16)0x8000) /**< The memory is a file mapping, not an allocation */
 
 typedef struct _ocrDataBlockFcts_t {
     /**
@@ -73,6 +99,29 @@ typedef struct _ocrDataBlockFcts_t {
      */
     void* (*acquire)(struct _ocrDataBlock_t *self, ocrGuid_t edt, bool isInternal);
 
+    /**
+     * @brief Internally acquires the data-block for an EDT in an access mode
+     *
+     * EDTs acquiring the data-block in DB_MODE_RO or DB_MODE_ITW hold it
+     * together. An EDT acquiring it in DB_MODE_EW holds it alone. Requests
+     * that cannot be granted right away are queued in FIFO order and
+     * 'granted' is called once they are. The acquire is released like
+     * an internal acquire().
+     *
+     * Explicit acquires (isInternal false) are not accounted for: they
+     * neither delay nor are delayed by exclusive accesses.
+     *
+     * @param self          Pointer for this data-block
+     * @param edt           EDT seeking registration
+     * @param mode          Access mode of the EDT's dependence
+     * @param granted       Called if the request is queued
+     * @return 0 if the access is granted (the address is self->ptr),
+     * EBUSY if the request is queued and EPERM if the data-block is
+     * being freed
+     */
+    u8 (*acquireMode)(struct _ocrDataBlock_t *self, ocrGuid_t edt, ocrDbAccessMode_t mode,
+                      ocrDbGrantFct_t granted);
+
     /**
      * @brief Releases a data-block previously acquired
      *
@@ -99,6 +148,23 @@ typedef struct _ocrDataBlockFcts_t {
      * @return 0 on success and an error code on failure (see ocr-db.h)
      */
     u8 (*free)(struct _ocrDataBlock_t *self, ocrGuid_t edt);
+
+    /**
+     * @brief Changes the size of the data-block's memory
+     *
+     * The policy domain grows the memory in place if it can and moves it
+     * otherwise. 'edt' must be the only holder of the data-block so that
+     * no one keeps using the old memory; EDTs acquiring it later get
+     * the new one.
+     *
+     * @param self          Pointer to this data-block
+     * @param edt           EDT holding the data-block
+     * @param size          New size in bytes
+     * @return 0 on success, EBUSY if others hold the data-block, EPERM
+     * if it is being freed and ENOMEM if there is no memory for it. The
+     * data-block is left as it was on failure
+     */
+    u8 (*resize)(struct _ocrDataBlock_t *self, ocrGuid_t edt, u64 size);
 } ocrDataBlockFcts_t;
 
 /**
@@ -116,11 +182,64 @@ typedef struct _ocrDataBlock_t {
     ocrGuid_t allocator;    /**< Allocator that created this data-block */
     ocrGuid_t allocatorPD;  /**< Policy domain of the creating allocator */
     u64 size;               /**< Size of the data-block */
-    void* ptr;              /**< Current location for this data-block */
+    void* ptr;              /**< Current location for this data-block (stale while evicted) */
     u16 properties;         /**< Properties for the data-block */
+    ocrInDbAllocator_t inDbAllocator; /**< Allocator managing the data-block's memory */
+    ocrGuid_t parent;       /**< Data-block this view aliases or NULL_GUID */
+    struct _ocrDbSpillEntry_t *spill; /**< Eviction state or NULL if never evicted */
+    struct _ocrDbCow_t *cow;   /**< Copy-on-write mapping or NULL (DB_PROP_SNAPSHOT) */
     ocrDataBlockFcts_t *fctPtrs; /**< Function Pointers for this data-block */
 } ocrDataBlock_t;
 
+/**
+ * @brief Releases the memory of a data-block being destroyed
+ *
+ * Called by the data-block implementations once the last user is gone.
+ * The memory goes back to the allocator that created it, file and
+ * copy-on-write mappings are unmapped and views release their parent
+ */
+void ocrDbReleaseMemory(ocrDataBlock_t *self);
+
+/**
+ * @brief Tells the OS that an EDT about to run will access a data-block
+ *
+ * This only has an effect on data-blocks created by ocrDbCreateFromFile(),
+ * whose pages start being read in from the file
+ */
+void ocrDbAdvise(ocrDataBlock_t *self);
+
+/**
+ * @brief Keeps the memory of a data-block resident while it is held
+ *
+ * Called once a data-block is acquired, internally for the dependence of
+ * an EDT or explicitly. If the data-block was evicted to the scratch file
+ * of its policy domain, it is read back first. Data-blocks that cannot be
+ * evicted are left untouched.
+ *
+ * @param self          Pointer for this data-block
+ * @param holder        EDT (or view) holding the data-block
+ * @param isInternal    True if the acquire is internal
+ * @return Current address of the data-block, NULL if it could not be
+ * read back
+ */
+void* ocrDbPin(ocrDataBlock_t *self, ocrGuid_t holder, bool isInternal);
+
+/**
+ * @brief Lets a data-block be evicted again once 'holder' releases it
+ *
+ * Called before the matching release since the release may destroy
+ * the data-block
+ */
+void ocrDbUnpin(ocrDataBlock_t *self, ocrGuid_t holder, bool isInternal);
+
+/**
+ * @brief Counts the EDT dependences on a data-block that are not acquired
+ * yet. Data-blocks EDTs wait for are evicted last
+ *
+ * @param delta         1 when a dependence is added, -1 when it is acquired
+ */
+void ocrDbPending(ocrDataBlock_t *self, s32 delta);
+
 
 /****************************************************/
 /* OCR DATABLOCK FACTORY                            */
@@ -24,6 +24,8 @@
 
 // Define internal finish-latch event id after user-level events
 #define OCR_EVENT_FINISH_LATCH_T OCR_EVENT_T_MAX+1
+// Define internal task graph event id after the finish latch
+#define OCR_EVENT_GRAPH_T OCR_EVENT_T_MAX+2
 
 
 /*******************************************
@@ -36,8 +38,10 @@
     * @param signalerGuid          Guid 'signaling'
     * @param waiterGuid            The guid to be satisfied
     * @param slot                  The slot to signal the waiterGuid on.
+    * @param mode                  Access mode of the data-block for an EDT waiter
     */
-void registerDependence(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot);
+void registerDependence(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot,
+                        ocrDbAccessMode_t mode);
 
 
 /****************************************************/
@@ -24,7 +24,8 @@ typedef enum {
     OCR_GUID_EDT_TEMPLATE = 4,
     OCR_GUID_EVENT = 5,
     OCR_GUID_POLICY = 6,
-    OCR_GUID_WORKER = 7
+    OCR_GUID_WORKER = 7,
+    OCR_GUID_GRAPH = 8
 } ocrGuidKind;
 
 
@@ -86,6 +87,23 @@ typedef struct _ocrGuidProviderFcts_t {
     u8 (*getGuid)(struct _ocrGuidProvider_t* self, ocrGuid_t* guid, u64 val,
                   ocrGuidKind kind);
 
+    /**
+     * @brief Allocates 'count' GUIDs of kind 'kind' at once
+     *
+     * The i-th GUID is associated with the value val + i*stride. The GUIDs
+     * of a range cannot be released individually, see releaseGuidRange.
+     *
+     * \param[in] self          Pointer to this GUID provider
+     * \param[out] guids        Array of 'count' GUIDs returned
+     * \param[in] val           Value associated with the first GUID
+     * \param[in] stride        Difference between the values of two consecutive GUIDs
+     * \param[in] count         Number of GUIDs to allocate
+     * \param[in] kind          Kind of the objects that will be associated with the GUIDs
+     * @return 0 on success or an error code
+     */
+    u8 (*getGuidRange)(struct _ocrGuidProvider_t* self, ocrGuid_t* guids, u64 val,
+                       u64 stride, u32 count, ocrGuidKind kind);
+
     /**
      * @brief Resolve the associated value to the GUID 'guid'
      *
@@ -119,6 +137,15 @@ typedef struct _ocrGuidProviderFcts_t {
      * @return 0 on success or an error code
      */
     u8 (*releaseGuid)(struct _ocrGuidProvider_t *self, ocrGuid_t guid);
+
+    /**
+     * @brief Releases all the GUIDs of a range at once
+     *
+     * @param self          Pointer to this GUID provider
+     * @param guid          First GUID of the range returned by getGuidRange
+     * @return 0 on success or an error code
+     */
+    u8 (*releaseGuidRange)(struct _ocrGuidProvider_t *self, ocrGuid_t guid);
 } ocrGuidProviderFcts_t;
 
 /**
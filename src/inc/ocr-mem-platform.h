@@ -97,6 +97,7 @@ typedef struct _ocrMemPlatformFcts_t {
 typedef struct _ocrMemPlatform_t {
     ocrMappable_t module; /**< Base "class" for ocrMemPlatform */
     ocrMemPlatformFcts_t *fctPtrs; /**< Function pointers for this instance */
+    s32 node; /**< NUMA node the memory is bound to, -1 if none */
 } ocrMemPlatform_t;
 
 
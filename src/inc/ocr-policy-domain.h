@@ -33,6 +33,8 @@ typedef struct _paramListPolicyDomainFact_t {
 
 typedef struct _paramListPolicyDomainInst_t {
     ocrParamList_t base;
+    const char * spillDirectory;    /**< Where to evict data-blocks when memory
+                                     * runs out, NULL to never evict them */
 } paramListPolicyDomainInst_t;
 
 
@@ -57,6 +59,7 @@ typedef enum {
     PD_MSG_MSG_TAKE    =13, 
     PD_MSG_MSG_GIVE    =14, 
     PD_MSG_INJECT_EDT  =15, 
+    PD_MSG_GUID_RANGE_REL=16, /**< Release a range of GUIDs */
 } ocrPolicyMsgType_t;
 
 
@@ -169,6 +172,12 @@ typedef struct _ocrPolicyDomain_t {
                                                  * Currently a placeholder for future
                                                  * objective driven scheduling */
 
+    struct _ocrDbSpill_t *dbSpill;              /**< Evicts data-blocks when the allocators
+                                                 * run out of memory, NULL if disabled */
+
+    struct _ocrMetaAlloc_t *metaAlloc;          /**< Allocator of the runtime objects,
+                                                 * NULL until the policy domain starts */
+
     /**
      * @brief Destroys (and frees any associated memory) this
      * policy domain
@@ -244,6 +253,25 @@ typedef struct _ocrPolicyDomain_t {
                      ocrGuid_t affinity, ocrInDbAllocator_t allocator,
                      ocrPolicyCtx_t *context);
 
+    /**
+     * @brief Request a new size for the memory of a data-block
+     *
+     * Called by the data-block once its only holder asks for it. The
+     * memory is grown or shrunk in place if its allocator can, otherwise
+     * it is moved to memory from any allocator and its content copied.
+     * The data-block's ptr, size and allocator are updated.
+     *
+     * @param self              This policy domain
+     * @param guid              GUID of the data-block to resize
+     * @param size              New size of the data-block
+     * @param context           Context for this call
+     *
+     * @return 0 on success or ENOMEM, in which case the data-block is
+     * unchanged
+     */
+    u8 (*resizeDb)(struct _ocrPolicyDomain_t *self, ocrGuid_t guid, u64 size,
+                   ocrPolicyCtx_t *context);
+
     /**
      * @brief Request the creation of a task metadata (EDT)
      *
@@ -296,6 +324,16 @@ typedef struct _ocrPolicyDomain_t {
     u8 (*getGuid)(struct _ocrPolicyDomain_t *self, ocrGuid_t *guid, u64 val,
                   ocrGuidKind type, ocrPolicyCtx_t *context);
 
+    /**
+     * @brief Gets 'count' GUIDs at once, the i-th one being associated
+     * with the value val + i*stride
+     *
+     * The GUIDs of a range are released all together by informing the
+     * policy domain of a PD_MSG_GUID_RANGE_REL on the first one.
+     */
+    u8 (*getGuidRange)(struct _ocrPolicyDomain_t *self, ocrGuid_t *guids, u64 val,
+                       u64 stride, u32 count, ocrGuidKind type, ocrPolicyCtx_t *context);
+
     u8 (*getInfoForGuid)(struct _ocrPolicyDomain_t *self, ocrGuid_t guid, u64* val,
                          ocrGuidKind* type, ocrPolicyCtx_t *context);
 
@@ -350,6 +388,15 @@ typedef struct _ocrPolicyDomain_t {
     u8 (*giveDb)(struct _ocrPolicyDomain_t *self, u32 count, ocrGuid_t *dbs,
                  ocrPolicyCtx_t *context);
 
+    /**
+     * @brief Returns an estimate of the number of workers of this policy
+     * domain that are currently looking for EDTs to execute
+     *
+     * Runtime code can use it to decide whether exposing more parallelism
+     * is worth its cost.
+     */
+    u32 (*idleWorkers)(struct _ocrPolicyDomain_t *self, ocrPolicyCtx_t *context);
+
     /**
      * @brief Inform the policy domain a worker is waiting for an event to complete
      */
@@ -54,6 +54,12 @@ typedef struct _ocrSchedulerFcts_t {
     u8 (*giveEdt)(struct _ocrScheduler_t *self, u32 count,
                   ocrGuid_t *edts, struct _ocrPolicyCtx_t *context);
 
+    /**
+     * @brief Returns the number of workers of this scheduler that
+     * are currently looking for EDTs to execute
+     */
+    u32 (*idleWorkers)(struct _ocrScheduler_t *self);
+
     // TODO: We will need to add the DB functions here
 } ocrSchedulerFcts_t;
 
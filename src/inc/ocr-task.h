@@ -99,11 +99,16 @@ typedef struct _ocrTaskFcts_t {
     /*! \brief Interface to schedule the underlying computation of a task
      */
     void (*schedule) (struct _ocrTask_t* self);
+    /*! \brief Interface to start loading the data-blocks of a ready task
+     *  into the caches: the first 'lines' cache lines of each data-block
+     *  and one line in each of its first 'pages' pages of 'pageSize' bytes
+     */
+    void (*prefetch) (struct _ocrTask_t* self, u32 lines, u32 pages, u64 pageSize);
 } ocrTaskFcts_t;
 
-// ELS runtime size is one to support finish-edt
+// ELS runtime size is two to support finish-edt and task graph capture
 // ELS_USER_SIZE is defined by configure
-#define ELS_RUNTIME_SIZE 1
+#define ELS_RUNTIME_SIZE 2
 #define ELS_SIZE (ELS_RUNTIME_SIZE + ELS_USER_SIZE)
 
 /*! \brief Abstract class to represent OCR tasks.
@@ -120,6 +125,7 @@ typedef struct _ocrTask_t {
     u32 paramc;
     u64* paramv;
     u64 depc;
+    u16 properties; /**< EDT_PROP_* bits given at creation */
     // depv and the associated bookeeping are implementation specific
     ocrGuid_t outputEvent; // Event to notify when the EDT is done
     ocrGuid_t els[ELS_SIZE];
@@ -158,5 +164,50 @@ typedef struct _ocrTaskFactory_t {
 
     ocrTaskFcts_t taskFcts;
 } ocrTaskFactory_t;
+
+/****************************************************/
+/* OCR TASK GRAPHS                                  */
+/****************************************************/
+
+// Task graphs record the EDTs, events and dependences created by an EDT
+// so that they can be replayed without creating runtime objects.
+// See ocr-graph.h for the semantic.
+
+/*! \brief Returns the graph the current EDT is recording, NULL_GUID if none
+ */
+ocrGuid_t graphCurrentCapture();
+
+u8 graphBegin(ocrGuid_t *graph, u32 paramc);
+u8 graphEnd(ocrGuid_t graph);
+u8 graphReplay(ocrGuid_t graph, u32 paramc, u64 *paramv, u32 depc,
+               ocrGuid_t *depv, ocrGuid_t completionEvent);
+u8 graphDestroy(ocrGuid_t graph);
+
+/*! \brief Record the creation of an EDT in a graph being captured
+ */
+u8 graphCaptureEdt(ocrGuid_t graph, ocrGuid_t *edtGuid, ocrTaskTemplate_t *taskTemplate,
+                   u32 paramc, u64 *paramv, u32 depc, u16 properties,
+                   ocrGuid_t *outputEvent);
+
+/*! \brief Record the creation of an event in a graph being captured
+ */
+u8 graphCaptureEvent(ocrGuid_t graph, ocrGuid_t *eventGuid, ocrEventTypes_t eventType);
+
+/*! \brief Record a dependence in a graph being captured
+ */
+u8 graphCaptureDependence(ocrGuid_t graph, ocrGuid_t source, ocrGuid_t destination, u32 slot,
+                          ocrDbAccessMode_t mode);
+
+/****************************************************/
+/* OCR BULK EDTS                                    */
+/****************************************************/
+
+/*! \brief Create 'count' independent EDTs out of a single template
+ *  See ocrEdtCreateBulk for the semantic.
+ */
+u8 edtCreateBulk(ocrGuid_t *guids, ocrTaskTemplate_t *taskTemplate, u32 count,
+                 u32 paramc, u64 *paramv, u64 *paramStride, u16 properties,
+                 ocrGuid_t affinity);
+
 #endif /* __OCR_TASK_H__ */
 
@@ -62,9 +62,45 @@ void ocr_exit();
 /**
  * @brief Bit operations used to manipulate bit
  * vectors. Currently used in the regular
- * implementation of data-blocks
+ * implementation of data-blocks and in the bitmaps
+ * of the TLSF allocator
+ *
+ * With GCC-compatible compilers, each scan compiles to a
+ * single instruction (bsr/bsf, or lzcnt/tzcnt when built
+ * with -mlzcnt/-mbmi). Define OCR_PORTABLE_BITSCAN to use
+ * the plain C versions instead. All of them return 0 for 0
  */
+#if defined(__GNUC__) && !defined(OCR_PORTABLE_BITSCAN)
+#define OCR_BUILTIN_BITSCAN 1
+#endif
+
+#ifdef OCR_BUILTIN_BITSCAN
+
+static inline u32 fls16(u16 val) {
+    return (val == 0) ? 0 : 31 - __builtin_clz((u32)val);
+}
+
+static inline u32 fls32(u32 val) {
+    return (val == 0) ? 0 : 31 - __builtin_clz(val);
+}
+
+static inline u32 fls64(u64 val) {
+    return (val == 0) ? 0 : 63 - __builtin_clzll(val);
+}
+
+static inline u32 ffs16(u16 val) {
+    return (val == 0) ? 0 : __builtin_ctz((u32)val);
+}
+
+static inline u32 ffs32(u32 val) {
+    return (val == 0) ? 0 : __builtin_ctz(val);
+}
 
+static inline u32 ffs64(u64 val) {
+    return (val == 0) ? 0 : __builtin_ctzll(val);
+}
+
+#else
 
 /**
  * @brief Finds the position of the MSB that
@@ -93,6 +129,35 @@ u32 fls32(u32 val);
  */
 u32 fls64(u64 val);
 
+/**
+ * @brief Finds the position of the LSB that
+ * is 1
+ *
+ * @param val  Value to look at
+ * @return  LSB set to 1 (from 0 to 15)
+ */
+u32 ffs16(u16 val);
+
+/**
+ * @brief Finds the position of the LSB that
+ * is 1
+ *
+ * @param val  Value to look at
+ * @return  LSB set to 1 (from 0 to 31)
+ */
+u32 ffs32(u32 val);
+
+/**
+ * @brief Finds the position of the LSB that
+ * is 1
+ *
+ * @param val  Value to look at
+ * @return  LSB set to 1 (from 0 to 63)
+ */
+u32 ffs64(u64 val);
+
+#endif /* OCR_BUILTIN_BITSCAN */
+
 /**
  * @brief Convenient structure to keep track
  * of GUIDs in a way that is indexable.
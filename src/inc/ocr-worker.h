@@ -31,6 +31,7 @@ typedef struct _paramListWorkerInst_t {
 
 struct _ocrWorker_t;
 struct _ocrTask_t;
+struct _ocrScratch_t;
 
 typedef struct _ocrWorkerFcts_t {
     void (*destruct) (struct _ocrWorker_t *self);
@@ -73,6 +74,28 @@ typedef struct _ocrWorkerFcts_t {
      * @return GUID for the currently running EDT
      */
      void (*setCurrentEDT)(struct _ocrWorker_t *self, ocrGuid_t currEDT);
+
+    /**
+     * @brief Suspends the caller until an event is satisfied
+     *
+     * The worker keeps executing other EDTs while the caller is
+     * suspended and resumes it once 'eventGuid' has been satisfied.
+     * @param self              OCR Worker
+     * @param eventGuid         Event to wait for
+     * @param currEDT           GUID of the EDT that is waiting (may be NULL_GUID)
+     * @return The GUID the event was satisfied with or ERROR_GUID if the
+     * worker stopped before the event got satisfied
+     */
+    ocrGuid_t (*waitForEvent)(struct _ocrWorker_t *self, ocrGuid_t eventGuid, ocrGuid_t currEDT);
+
+    /**
+     * @brief Returns the scratch arena of the EDT the caller runs
+     *
+     * What is allocated from it is freed once the EDT returns.
+     * @param self              OCR Worker
+     * @return The arena, NULL if the worker has none
+     */
+    struct _ocrScratch_t * (*getScratch)(struct _ocrWorker_t *self);
 } ocrWorkerFcts_t;
 
 typedef struct _ocrWorker_t {
@@ -25,6 +25,7 @@
 #include "workpile/workpile-all.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 
@@ -44,6 +45,10 @@
         DPRINTF(DEBUG_LVL_WARN, "Key %s not found or invalid!\n", KEY); \
     }
 
+// Sizes may exceed an int and take a K, M, G or T suffix
+#define INI_GET_SIZE(KEY, VAR, DEF) \
+    VAR = iniparser_find_entry(dict, KEY) ? parseSize(iniparser_getstring(dict, KEY, "")) : (DEF)
+
 #define INI_GET_STR(KEY, VAR, DEF) \
     VAR = (char *) iniparser_getstring(dict, KEY, DEF); \
     if (!strcmp(VAR, DEF)) {\
@@ -65,6 +70,27 @@
 #define INI_GET_RANGE(KEY, LOW, HIGH) \
     sscanf(iniparser_getstring(dict, KEY, ""), "%d-%d", &LOW, &HIGH)
 
+static u64 parseSize(const char *str) {
+    char *end;
+    u64 size = strtoull(str, &end, 0);
+    switch(*end) {
+    case 'T': case 't':
+        size <<= 10;
+        // Fall through
+    case 'G': case 'g':
+        size <<= 10;
+        // Fall through
+    case 'M': case 'm':
+        size <<= 10;
+        // Fall through
+    case 'K': case 'k':
+        size <<= 10;
+    default:
+        break;
+    }
+    return size;
+}
+
 typedef enum value_type_t {
     TYPE_UNKNOWN,
     TYPE_CSV,
@@ -164,8 +190,23 @@ char* populate_type(ocrParamList_t **type_param, type_enum index, dictionary *di
     case guid_type:
         ALLOC_PARAM_LIST(*type_param, paramListGuidProviderFact_t);
         break;
-    case memplatform_type:
-        ALLOC_PARAM_LIST(*type_param, paramListMemPlatformFact_t);
+    case memplatform_type: {
+            memPlatformType_t mytype = -1;
+            TO_ENUM (mytype, typestr, memPlatformType_t, memplatform_types, memPlatformMax_id);
+            switch (mytype) {
+                case memPlatformHugepage_id: {
+                    ALLOC_PARAM_LIST(*type_param, paramListMemPlatformHugepage_t);
+                    snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "pagesize");
+                    INI_GET_INT (key, value, -1);
+                    // In KB in the configuration file
+                    ((paramListMemPlatformHugepage_t *)(*type_param))->pageSize = (value==-1)?0:((u64)value)*1024;
+                }
+                break;
+                default:
+                    ALLOC_PARAM_LIST(*type_param, paramListMemPlatformFact_t);
+                break;
+            }
+        }
         break;
     case memtarget_type:
         ALLOC_PARAM_LIST(*type_param, paramListMemTargetFact_t);
@@ -496,7 +537,21 @@ s32 populate_inst(ocrParamList_t **inst_param, ocrMappable_t **instance, s32 *ty
         break;
     case memplatform_type:
         for (j = low; j<=high; j++) {
-            ALLOC_PARAM_LIST(inst_param[j], paramListMemPlatformInst_t);
+            memPlatformType_t mytype = -1;
+            TO_ENUM (mytype, inststr, memPlatformType_t, memplatform_types, memPlatformMax_id);
+            switch (mytype) {
+                case memPlatformNuma_id: {
+                    ALLOC_PARAM_LIST(inst_param[j], paramListMemPlatformNumaInst_t);
+                    // Optional, interleaved over all the nodes without one
+                    snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "node");
+                    value = iniparser_getint(dict, key, -1);
+                    ((paramListMemPlatformNumaInst_t *)inst_param[j])->node = value;
+                }
+                break;
+                default:
+                    ALLOC_PARAM_LIST(inst_param[j], paramListMemPlatformInst_t);
+                break;
+            }
             instance[j] = (ocrMappable_t *)((ocrMemPlatformFactory_t *)factory)->instantiate(factory, inst_param[j]);
             if (instance[j])
                 DPRINTF(DEBUG_LVL_INFO, "Created memplatform of type %s, index %d\n", inststr, j);
@@ -513,9 +568,15 @@ s32 populate_inst(ocrParamList_t **inst_param, ocrMappable_t **instance, s32 *ty
     case allocator_type:
         for (j = low; j<=high; j++) {
             ALLOC_PARAM_LIST(inst_param[j], paramListAllocatorInst_t);
+            paramListAllocatorInst_t *allocatorParam = (paramListAllocatorInst_t *)inst_param[j];
             snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "size");
-            INI_GET_INT (key, value, -1);
-            ((paramListAllocatorInst_t *)inst_param[j])->size = value;
+            INI_GET_SIZE (key, allocatorParam->size, 0);
+            // Allocators do not grow unless given a larger maxsize or 0 for no bound
+            snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "maxsize");
+            INI_GET_SIZE (key, allocatorParam->maxSize, allocatorParam->size);
+            // Freed pages stay with the process unless a release size is given
+            snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "releasesize");
+            INI_GET_SIZE (key, allocatorParam->releaseSize, 0);
             instance[j] = (ocrMappable_t *)((ocrAllocatorFactory_t *)factory)->instantiate(factory, inst_param[j]);
             if (instance[j])
                 DPRINTF(DEBUG_LVL_INFO, "Created allocator of type %s, index %d\n", inststr, j);
@@ -601,6 +662,17 @@ s32 populate_inst(ocrParamList_t **inst_param, ocrMappable_t **instance, s32 *ty
                     snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "workeridfirst");
                     INI_GET_INT (key, value, -1);
                     ((paramListSchedulerHcInst_t *)inst_param[j])->workerIdFirst = value;
+                    // Optional, 0 disables inlining
+                    snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "inlinelimit");
+                    value = iniparser_getint(dict, key, HC_SCHEDULER_INLINE_LIMIT);
+                    ((paramListSchedulerHcInst_t *)inst_param[j])->inlineLimit = value;
+                    // Optional, 0 for both disables prefetching
+                    snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "prefetchlines");
+                    value = iniparser_getint(dict, key, HC_SCHEDULER_PREFETCH_LINES);
+                    ((paramListSchedulerHcInst_t *)inst_param[j])->prefetchLines = value;
+                    snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "prefetchpages");
+                    value = iniparser_getint(dict, key, HC_SCHEDULER_PREFETCH_PAGES);
+                    ((paramListSchedulerHcInst_t *)inst_param[j])->prefetchPages = value;
                 }
                 break;
                 default:
@@ -668,6 +740,9 @@ s32 populate_inst(ocrParamList_t **inst_param, ocrMappable_t **instance, s32 *ty
             ASSERT (gf);
 
             ALLOC_PARAM_LIST(inst_param[j], paramListPolicyDomainInst_t);
+            // Optional, data-blocks are never evicted without it
+            snprintf(key, MAX_KEY_SZ, "%s:%s", secname, "spilldir");
+            ((paramListPolicyDomainInst_t *)inst_param[j])->spillDirectory = iniparser_getstring(dict, key, NULL);
             instance[j] = (ocrMappable_t *)((ocrPolicyDomainFactory_t *)factory)->instantiate(factory, schedulerCount,
                             workerCount, computeCount, workpileCount, allocatorCount, memoryCount,
                             tf, ttf, dbf, ef, cf, gf, lf, af, NULL, inst_param[j]);
@@ -0,0 +1,185 @@
+/**
+ * @brief Memory platform backing its chunks with huge pages
+ *
+ * Chunks are first requested from the pool of huge pages reserved in the
+ * kernel (MAP_HUGETLB). If none are available, the chunk is mapped with
+ * regular pages aligned on the huge page size and the kernel is asked to
+ * back it with transparent huge pages. If that fails as well, the chunk
+ * simply uses regular pages.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "debug.h"
+#include "mem-platform/hugepage/hugepage-mem-platform.h"
+#include "ocr-macros.h"
+#include "ocr-mappable.h"
+#include "ocr-mem-platform.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define DEBUG_TYPE MEM_PLATFORM
+
+// 2MB pages unless configured otherwise
+#define HUGEPAGE_DEFAULT_SIZE (2ULL*1024*1024)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/******************************************************/
+/* OCR MEM PLATFORM HUGEPAGE IMPLEMENTATION           */
+/******************************************************/
+
+static void hugepageLock(ocrMemPlatformHugepage_t *rself) {
+    while(!__sync_bool_compare_and_swap(&(rself->lock), 0, 1)) ;
+}
+
+static void hugepageUnlock(ocrMemPlatformHugepage_t *rself) {
+    __sync_lock_release(&(rself->lock));
+}
+
+void hugepageDestruct(ocrMemPlatform_t *self) {
+    ocrMemPlatformHugepage_t *rself = (ocrMemPlatformHugepage_t*)self;
+    // Chunks may outlive the allocators that requested them
+    while(rself->mappings != NULL) {
+        ocrHugepageMapping_t *mapping = rself->mappings;
+        rself->mappings = mapping->next;
+        munmap(mapping->addr, mapping->size);
+        free(mapping);
+    }
+    free(self);
+}
+
+struct _ocrPolicyDomain_t;
+static void hugepageStart(ocrMemPlatform_t *self, struct _ocrPolicyDomain_t * PD ) { }
+
+static void hugepageStop(ocrMemPlatform_t *self) { }
+
+// Maps 'size' bytes aligned on 'alignment' with regular pages
+static void* hugepageMapAligned(u64 size, u64 alignment) {
+    char * map = (char*) mmap(NULL, size + alignment, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(map == MAP_FAILED) {
+        return NULL;
+    }
+    char * aligned = (char*) (((u64)map + alignment - 1) & ~(alignment - 1));
+    if(aligned != map) {
+        munmap(map, aligned - map);
+    }
+    if(aligned + size != map + size + alignment) {
+        munmap(aligned + size, (map + size + alignment) - (aligned + size));
+    }
+    return aligned;
+}
+
+void* hugepageAllocate(ocrMemPlatform_t *self, u64 size) {
+    ocrMemPlatformHugepage_t *rself = (ocrMemPlatformHugepage_t*)self;
+    u64 pageSize = rself->pageSize;
+    size = (size + pageSize - 1) & ~(pageSize - 1);
+
+    void * addr = NULL;
+#ifdef MAP_HUGETLB
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (fls64(pageSize) << MAP_HUGE_SHIFT),
+                -1, 0);
+    if(addr == MAP_FAILED) {
+        addr = NULL;
+    } else {
+        DPRINTF(DEBUG_LVL_INFO, "Mapped 0x%"PRIx64" bytes of reserved huge pages @ 0x%"PRIx64"\n",
+                size, (u64)addr);
+    }
+#endif
+    if(addr == NULL) {
+        addr = hugepageMapAligned(size, pageSize);
+        if(addr == NULL) {
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        if(madvise(addr, size, MADV_HUGEPAGE) == 0) {
+            DPRINTF(DEBUG_LVL_INFO, "Mapped 0x%"PRIx64" bytes of transparent huge pages @ 0x%"PRIx64"\n",
+                    size, (u64)addr);
+        } else
+#endif
+        {
+            DPRINTF(DEBUG_LVL_WARN, "No huge pages available, mapped 0x%"PRIx64" bytes of regular pages @ 0x%"PRIx64"\n",
+                    size, (u64)addr);
+        }
+    }
+
+    ocrHugepageMapping_t *mapping = (ocrHugepageMapping_t*)
+        checkedMalloc(mapping, sizeof(ocrHugepageMapping_t));
+    mapping->addr = addr;
+    mapping->size = size;
+    hugepageLock(rself);
+    mapping->next = rself->mappings;
+    rself->mappings = mapping;
+    hugepageUnlock(rself);
+    return addr;
+}
+
+void hugepageFree(ocrMemPlatform_t *self, void *addr) {
+    ocrMemPlatformHugepage_t *rself = (ocrMemPlatformHugepage_t*)self;
+    hugepageLock(rself);
+    ocrHugepageMapping_t **prev = &(rself->mappings);
+    while((*prev != NULL) && ((*prev)->addr != addr)) {
+        prev = &((*prev)->next);
+    }
+    ocrHugepageMapping_t *mapping = *prev;
+    ASSERT(mapping != NULL);
+    *prev = mapping->next;
+    hugepageUnlock(rself);
+    munmap(mapping->addr, mapping->size);
+    free(mapping);
+}
+
+ocrMemPlatform_t* newMemPlatformHugepage(ocrMemPlatformFactory_t * factory,
+                                         ocrParamList_t *perInstance) {
+
+    ocrMemPlatformHugepage_t *result = (ocrMemPlatformHugepage_t*)
+        checkedMalloc(result, sizeof(ocrMemPlatformHugepage_t));
+
+    result->base.fctPtrs = &(factory->platformFcts);
+    result->base.node = -1;
+    result->pageSize = ((ocrMemPlatformFactoryHugepage_t*)factory)->pageSize;
+    result->lock = 0;
+    result->mappings = NULL;
+
+    return (ocrMemPlatform_t*)result;
+}
+
+/******************************************************/
+/* OCR MEM PLATFORM HUGEPAGE FACTORY                  */
+/******************************************************/
+
+static void destructMemPlatformFactoryHugepage(ocrMemPlatformFactory_t *factory) {
+    free(factory);
+}
+
+ocrMemPlatformFactory_t *newMemPlatformFactoryHugepage(ocrParamList_t *perType) {
+    ocrMemPlatformFactoryHugepage_t *derived = (ocrMemPlatformFactoryHugepage_t*)
+        checkedMalloc(derived, sizeof(ocrMemPlatformFactoryHugepage_t));
+    ocrMemPlatformFactory_t *base = (ocrMemPlatformFactory_t*)derived;
+
+    paramListMemPlatformHugepage_t *params = (paramListMemPlatformHugepage_t*)perType;
+    derived->pageSize = ((params != NULL) && (params->pageSize > 0)) ? params->pageSize : HUGEPAGE_DEFAULT_SIZE;
+    // Huge pages are powers of 2
+    ASSERT((derived->pageSize & (derived->pageSize - 1)) == 0);
+
+    base->instantiate = &newMemPlatformHugepage;
+    base->destruct = &destructMemPlatformFactoryHugepage;
+    base->platformFcts.destruct = &hugepageDestruct;
+    base->platformFcts.start = &hugepageStart;
+    base->platformFcts.stop = &hugepageStop;
+    base->platformFcts.allocate = &hugepageAllocate;
+    base->platformFcts.free = &hugepageFree;
+
+    return base;
+}
@@ -0,0 +1,47 @@
+/**
+ * @brief Memory platform backed by huge pages
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __MEM_PLATFORM_HUGEPAGE_H__
+#define __MEM_PLATFORM_HUGEPAGE_H__
+
+#include "ocr-mem-platform.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+typedef struct {
+    paramListMemPlatformFact_t base;
+    u64 pageSize;           /**< Size of the huge pages in bytes, 0 for the default */
+} paramListMemPlatformHugepage_t;
+
+typedef struct {
+    ocrMemPlatformFactory_t base;
+    u64 pageSize;
+} ocrMemPlatformFactoryHugepage_t;
+
+/**
+ * @brief Chunk mapped by the platform
+ */
+typedef struct _ocrHugepageMapping_t {
+    void * addr;
+    u64 size;
+    struct _ocrHugepageMapping_t * next;
+} ocrHugepageMapping_t;
+
+typedef struct {
+    ocrMemPlatform_t base;
+    u64 pageSize;
+    volatile u32 lock;                  /**< Protects mappings */
+    ocrHugepageMapping_t * mappings;    /**< Chunks to unmap on free */
+} ocrMemPlatformHugepage_t;
+
+extern ocrMemPlatformFactory_t* newMemPlatformFactoryHugepage(ocrParamList_t *perType);
+
+#endif /* __MEM_PLATFORM_HUGEPAGE_H__ */
@@ -48,6 +48,7 @@ ocrMemPlatform_t* newMemPlatformMalloc(ocrMemPlatformFactory_t * factory,
         checkedMalloc(result, sizeof(ocrMemPlatformMalloc_t));
 
     result->fctPtrs = &(factory->platformFcts);
+    result->node = -1;
 
     return result;
 }
@@ -17,23 +17,44 @@
 
 typedef enum _memPlatformType_t {
     memPlatformMalloc_id,
+    memPlatformHugepage_id,
+    memPlatformNuma_id,
+    memPlatformMmap_id,
     memPlatformMax_id
 } memPlatformType_t;
 
 const char * memplatform_types[] = {
     "malloc",
+    "hugepage",
+    "numa",
+    "mmap",
     NULL
 };
 
 // Malloc memory platform
 #include "mem-platform/malloc/malloc-mem-platform.h"
 
+// Huge page memory platform
+#include "mem-platform/hugepage/hugepage-mem-platform.h"
+
+// NUMA memory platform
+#include "mem-platform/numa/numa-mem-platform.h"
+
+// Lazily committed memory platform
+#include "mem-platform/mmap/mmap-mem-platform.h"
+
 // Add other memory platforms using the same pattern as above
 
 inline ocrMemPlatformFactory_t *newMemPlatformFactory(memPlatformType_t type, ocrParamList_t *typeArg) {
     switch(type) {
     case memPlatformMalloc_id:
         return newMemPlatformFactoryMalloc(typeArg);
+    case memPlatformHugepage_id:
+        return newMemPlatformFactoryHugepage(typeArg);
+    case memPlatformNuma_id:
+        return newMemPlatformFactoryNuma(typeArg);
+    case memPlatformMmap_id:
+        return newMemPlatformFactoryMmap(typeArg);
     default:
         ASSERT(0);
         return NULL;
@@ -0,0 +1,136 @@
+/**
+ * @brief Memory platform reserving its chunks with mmap
+ *
+ * Chunks are anonymous mappings without swap reserved for them, so they
+ * only take address space until their pages are first touched. The
+ * pages allocators give back with madvise are committed again when
+ * touched again.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "debug.h"
+#include "mem-platform/mmap/mmap-mem-platform.h"
+#include "ocr-macros.h"
+#include "ocr-mappable.h"
+#include "ocr-mem-platform.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define DEBUG_TYPE MEM_PLATFORM
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+/******************************************************/
+/* OCR MEM PLATFORM MMAP IMPLEMENTATION               */
+/******************************************************/
+
+static void mmapLock(ocrMemPlatformMmap_t *rself) {
+    while(!__sync_bool_compare_and_swap(&(rself->lock), 0, 1)) ;
+}
+
+static void mmapUnlock(ocrMemPlatformMmap_t *rself) {
+    __sync_lock_release(&(rself->lock));
+}
+
+void mmapDestruct(ocrMemPlatform_t *self) {
+    ocrMemPlatformMmap_t *rself = (ocrMemPlatformMmap_t*)self;
+    // Chunks may outlive the allocators that requested them
+    while(rself->mappings != NULL) {
+        ocrMmapMapping_t *mapping = rself->mappings;
+        rself->mappings = mapping->next;
+        munmap(mapping->addr, mapping->size);
+        free(mapping);
+    }
+    free(self);
+}
+
+struct _ocrPolicyDomain_t;
+static void mmapStart(ocrMemPlatform_t *self, struct _ocrPolicyDomain_t * PD ) { }
+
+static void mmapStop(ocrMemPlatform_t *self) { }
+
+void* mmapAllocate(ocrMemPlatform_t *self, u64 size) {
+    ocrMemPlatformMmap_t *rself = (ocrMemPlatformMmap_t*)self;
+    u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+    size = (size + pageSize - 1) & ~(pageSize - 1);
+
+    void * addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(addr == MAP_FAILED) {
+        return NULL;
+    }
+    DPRINTF(DEBUG_LVL_INFO, "Reserved 0x%"PRIx64" bytes @ 0x%"PRIx64"\n", size, (u64)addr);
+
+    ocrMmapMapping_t *mapping = (ocrMmapMapping_t*)
+        checkedMalloc(mapping, sizeof(ocrMmapMapping_t));
+    mapping->addr = addr;
+    mapping->size = size;
+    mmapLock(rself);
+    mapping->next = rself->mappings;
+    rself->mappings = mapping;
+    mmapUnlock(rself);
+    return addr;
+}
+
+void mmapFree(ocrMemPlatform_t *self, void *addr) {
+    ocrMemPlatformMmap_t *rself = (ocrMemPlatformMmap_t*)self;
+    mmapLock(rself);
+    ocrMmapMapping_t **prev = &(rself->mappings);
+    while((*prev != NULL) && ((*prev)->addr != addr)) {
+        prev = &((*prev)->next);
+    }
+    ocrMmapMapping_t *mapping = *prev;
+    ASSERT(mapping != NULL);
+    *prev = mapping->next;
+    mmapUnlock(rself);
+    munmap(mapping->addr, mapping->size);
+    free(mapping);
+}
+
+ocrMemPlatform_t* newMemPlatformMmap(ocrMemPlatformFactory_t * factory,
+                                     ocrParamList_t *perInstance) {
+
+    ocrMemPlatformMmap_t *result = (ocrMemPlatformMmap_t*)
+        checkedMalloc(result, sizeof(ocrMemPlatformMmap_t));
+
+    result->base.fctPtrs = &(factory->platformFcts);
+    result->base.node = -1;
+    result->lock = 0;
+    result->mappings = NULL;
+
+    return (ocrMemPlatform_t*)result;
+}
+
+/******************************************************/
+/* OCR MEM PLATFORM MMAP FACTORY                      */
+/******************************************************/
+
+static void destructMemPlatformFactoryMmap(ocrMemPlatformFactory_t *factory) {
+    free(factory);
+}
+
+ocrMemPlatformFactory_t *newMemPlatformFactoryMmap(ocrParamList_t *perType) {
+    ocrMemPlatformFactory_t *base = (ocrMemPlatformFactory_t*)
+        checkedMalloc(base, sizeof(ocrMemPlatformFactoryMmap_t));
+
+    base->instantiate = &newMemPlatformMmap;
+    base->destruct = &destructMemPlatformFactoryMmap;
+    base->platformFcts.destruct = &mmapDestruct;
+    base->platformFcts.start = &mmapStart;
+    base->platformFcts.stop = &mmapStop;
+    base->platformFcts.allocate = &mmapAllocate;
+    base->platformFcts.free = &mmapFree;
+
+    return base;
+}
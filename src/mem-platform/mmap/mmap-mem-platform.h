@@ -0,0 +1,40 @@
+/**
+ * @brief Memory platform reserving its chunks with mmap
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __MEM_PLATFORM_MMAP_H__
+#define __MEM_PLATFORM_MMAP_H__
+
+#include "ocr-mem-platform.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+typedef struct {
+    ocrMemPlatformFactory_t base;
+} ocrMemPlatformFactoryMmap_t;
+
+/**
+ * @brief Chunk mapped by the platform
+ */
+typedef struct _ocrMmapMapping_t {
+    void * addr;
+    u64 size;
+    struct _ocrMmapMapping_t * next;
+} ocrMmapMapping_t;
+
+typedef struct {
+    ocrMemPlatform_t base;
+    volatile u32 lock;              /**< Protects mappings */
+    ocrMmapMapping_t * mappings;    /**< Chunks to unmap on free */
+} ocrMemPlatformMmap_t;
+
+extern ocrMemPlatformFactory_t* newMemPlatformFactoryMmap(ocrParamList_t *perType);
+
+#endif /* __MEM_PLATFORM_MMAP_H__ */
@@ -0,0 +1,175 @@
+/**
+ * @brief Memory platform binding its chunks to a NUMA node
+ *
+ * Chunks are mapped anonymously and bound to the node of the instance
+ * with mbind before they are touched, so that their pages come from
+ * that node whichever thread touches them first. Without a node, the
+ * pages are interleaved over all the nodes. If the kernel refuses the
+ * policy (no NUMA support, or no such node), the chunk keeps the
+ * default first-touch placement.
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#include "debug.h"
+#include "mem-platform/numa/numa-mem-platform.h"
+#include "ocr-macros.h"
+#include "ocr-mappable.h"
+#include "ocr-mem-platform.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define DEBUG_TYPE MEM_PLATFORM
+
+// From <numaif.h>, which is only installed with libnuma
+#define NUMA_MPOL_BIND 2
+#define NUMA_MPOL_INTERLEAVE 3
+
+// Nodes a mask covers
+#define NUMA_MAX_NODES 64
+
+/******************************************************/
+/* OCR MEM PLATFORM NUMA IMPLEMENTATION               */
+/******************************************************/
+
+static void numaLock(ocrMemPlatformNuma_t *rself) {
+    while(!__sync_bool_compare_and_swap(&(rself->lock), 0, 1)) ;
+}
+
+static void numaUnlock(ocrMemPlatformNuma_t *rself) {
+    __sync_lock_release(&(rself->lock));
+}
+
+s32 numaNodeOfCaller() {
+#ifdef SYS_getcpu
+    unsigned cpu, node;
+    if(syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (s32)node;
+    }
+#endif
+    return -1;
+}
+
+// Sets the policy of the pages of a chunk not touched yet
+static void numaBind(void *addr, u64 size, s32 node) {
+#ifdef SYS_mbind
+    unsigned long mask;
+    int mode;
+    if(node >= 0) {
+        ASSERT(node < NUMA_MAX_NODES);
+        mask = 1UL << node;
+        mode = NUMA_MPOL_BIND;
+    } else {
+        // The kernel only keeps the nodes with memory
+        mask = ~0UL;
+        mode = NUMA_MPOL_INTERLEAVE;
+    }
+    if(syscall(SYS_mbind, addr, size, mode, &mask, NUMA_MAX_NODES + 1, 0) == 0) {
+        return;
+    }
+#endif
+    DPRINTF(DEBUG_LVL_WARN, "Cannot bind 0x%"PRIx64" bytes @ 0x%"PRIx64" to NUMA node %d\n",
+            size, (u64)addr, node);
+}
+
+void numaDestruct(ocrMemPlatform_t *self) {
+    ocrMemPlatformNuma_t *rself = (ocrMemPlatformNuma_t*)self;
+    // Chunks may outlive the allocators that requested them
+    while(rself->mappings != NULL) {
+        ocrNumaMapping_t *mapping = rself->mappings;
+        rself->mappings = mapping->next;
+        munmap(mapping->addr, mapping->size);
+        free(mapping);
+    }
+    free(self);
+}
+
+struct _ocrPolicyDomain_t;
+static void numaStart(ocrMemPlatform_t *self, struct _ocrPolicyDomain_t * PD ) { }
+
+static void numaStop(ocrMemPlatform_t *self) { }
+
+void* numaAllocate(ocrMemPlatform_t *self, u64 size) {
+    ocrMemPlatformNuma_t *rself = (ocrMemPlatformNuma_t*)self;
+    u64 pageSize = (u64)sysconf(_SC_PAGESIZE);
+    size = (size + pageSize - 1) & ~(pageSize - 1);
+
+    void * addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(addr == MAP_FAILED) {
+        return NULL;
+    }
+    numaBind(addr, size, self->node);
+    DPRINTF(DEBUG_LVL_INFO, "Mapped 0x%"PRIx64" bytes @ 0x%"PRIx64" on NUMA node %d\n",
+            size, (u64)addr, self->node);
+
+    ocrNumaMapping_t *mapping = (ocrNumaMapping_t*)
+        checkedMalloc(mapping, sizeof(ocrNumaMapping_t));
+    mapping->addr = addr;
+    mapping->size = size;
+    numaLock(rself);
+    mapping->next = rself->mappings;
+    rself->mappings = mapping;
+    numaUnlock(rself);
+    return addr;
+}
+
+void numaFree(ocrMemPlatform_t *self, void *addr) {
+    ocrMemPlatformNuma_t *rself = (ocrMemPlatformNuma_t*)self;
+    numaLock(rself);
+    ocrNumaMapping_t **prev = &(rself->mappings);
+    while((*prev != NULL) && ((*prev)->addr != addr)) {
+        prev = &((*prev)->next);
+    }
+    ocrNumaMapping_t *mapping = *prev;
+    ASSERT(mapping != NULL);
+    *prev = mapping->next;
+    numaUnlock(rself);
+    munmap(mapping->addr, mapping->size);
+    free(mapping);
+}
+
+ocrMemPlatform_t* newMemPlatformNuma(ocrMemPlatformFactory_t * factory,
+                                     ocrParamList_t *perInstance) {
+
+    ocrMemPlatformNuma_t *result = (ocrMemPlatformNuma_t*)
+        checkedMalloc(result, sizeof(ocrMemPlatformNuma_t));
+
+    result->base.fctPtrs = &(factory->platformFcts);
+    result->base.node = ((paramListMemPlatformNumaInst_t*)perInstance)->node;
+    result->lock = 0;
+    result->mappings = NULL;
+
+    return (ocrMemPlatform_t*)result;
+}
+
+/******************************************************/
+/* OCR MEM PLATFORM NUMA FACTORY                      */
+/******************************************************/
+
+static void destructMemPlatformFactoryNuma(ocrMemPlatformFactory_t *factory) {
+    free(factory);
+}
+
+ocrMemPlatformFactory_t *newMemPlatformFactoryNuma(ocrParamList_t *perType) {
+    ocrMemPlatformFactory_t *base = (ocrMemPlatformFactory_t*)
+        checkedMalloc(base, sizeof(ocrMemPlatformFactoryNuma_t));
+
+    base->instantiate = &newMemPlatformNuma;
+    base->destruct = &destructMemPlatformFactoryNuma;
+    base->platformFcts.destruct = &numaDestruct;
+    base->platformFcts.start = &numaStart;
+    base->platformFcts.stop = &numaStop;
+    base->platformFcts.allocate = &numaAllocate;
+    base->platformFcts.free = &numaFree;
+
+    return base;
+}
@@ -0,0 +1,50 @@
+/**
+ * @brief Memory platform binding its chunks to a NUMA node
+ **/
+
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __MEM_PLATFORM_NUMA_H__
+#define __MEM_PLATFORM_NUMA_H__
+
+#include "ocr-mem-platform.h"
+#include "ocr-types.h"
+#include "ocr-utils.h"
+
+typedef struct {
+    paramListMemPlatformInst_t base;
+    s32 node;               /**< NUMA node of the memory, -1 to interleave over all nodes */
+} paramListMemPlatformNumaInst_t;
+
+typedef struct {
+    ocrMemPlatformFactory_t base;
+} ocrMemPlatformFactoryNuma_t;
+
+/**
+ * @brief Chunk mapped by the platform
+ */
+typedef struct _ocrNumaMapping_t {
+    void * addr;
+    u64 size;
+    struct _ocrNumaMapping_t * next;
+} ocrNumaMapping_t;
+
+typedef struct {
+    ocrMemPlatform_t base;
+    volatile u32 lock;              /**< Protects mappings */
+    ocrNumaMapping_t * mappings;    /**< Chunks to unmap on free */
+} ocrMemPlatformNuma_t;
+
+extern ocrMemPlatformFactory_t* newMemPlatformFactoryNuma(ocrParamList_t *perType);
+
+/**
+ * @brief Returns the NUMA node of the CPU the caller runs on, -1 if unknown
+ */
+extern s32 numaNodeOfCaller();
+
+#endif /* __MEM_PLATFORM_NUMA_H__ */
@@ -11,11 +11,13 @@
  */
 
 
+#include <errno.h>
 #include <string.h>
 
 #include "debug.h"
 #include "ocr-macros.h"
 #include "ocr-policy-domain.h"
+#include "allocator/tlsf/tlsf-allocator.h"
 #include "policy-domain/fsim/fsim-policy.h"
 
 static ocrPolicyCtx_t * cloneOcrPolicyCtxXE (ocrPolicyCtx_t * ctxIn) {
@@ -249,14 +251,36 @@ static u8 fsimAllocateDb(ocrPolicyDomain_t *self, ocrGuid_t *guid, void** ptr, u
         if(result) break;
     }
     // TODO: return error code. Requires our own errno to be clean
+    if((allocator == TLSF_ALLOC) && (tlsfRegionInit(result, size) != 0)) {
+        self->allocators[i]->fctPtrs->free(self->allocators[i], result);
+        return ENOMEM;
+    }
     ocrDataBlock_t *block = self->dbFactory->instantiate(self->dbFactory,
                                                          self->allocators[i]->guid, self->guid,
                                                          size, result, properties, NULL);
+    block->inDbAllocator = allocator;
     *ptr = result;
     *guid = block->guid;
     return 0;
 }
 
+static u8 fsimResizeDb(ocrPolicyDomain_t *self, ocrGuid_t guid, u64 size,
+                       ocrPolicyCtx_t *context) {
+
+    // Currently only resizes within the allocator of the data-block
+    ocrDataBlock_t *db = NULL;
+    ocrAllocator_t *allocator = NULL;
+    deguidify(self, guid, (u64*)&db, NULL);
+    deguidify(self, db->allocator, (u64*)&allocator, NULL);
+    void* result = allocator->fctPtrs->reallocate(allocator, db->ptr, size);
+    if(result == NULL) {
+        return ENOMEM;
+    }
+    db->ptr = result;
+    db->size = size;
+    return 0;
+}
+
 static u8 fsimCreateEdt(ocrPolicyDomain_t *self, ocrGuid_t *guid,
                       ocrTaskTemplate_t * edtTemplate, u32 paramc, u64* paramv,
                       u32 depc, u16 properties, ocrGuid_t affinity,
@@ -293,6 +317,10 @@ static u8 fsimCreateEvent(ocrPolicyDomain_t *self, ocrGuid_t *guid,
     return 0;
 }
 
+static u32 fsimIdleWorkers(ocrPolicyDomain_t *self, ocrPolicyCtx_t *context) {
+    return self->schedulers[0]->fctPtrs->idleWorkers(self->schedulers[0]);
+}
+
 static u8 fsimWaitForEvent(ocrPolicyDomain_t *self, ocrGuid_t workerGuid,
                        ocrGuid_t yieldingEdtGuid, ocrGuid_t eventToYieldForGuid,
                        ocrGuid_t * returnGuid, ocrPolicyCtx_t *context) {
@@ -316,6 +344,10 @@ static void fsimInform(ocrPolicyDomain_t *self, ocrGuid_t obj, const ocrPolicyCt
         self->guidProvider->fctPtrs->releaseGuid(self->guidProvider, obj);
         return;
     }
+    if(context->type == PD_MSG_GUID_RANGE_REL) {
+        self->guidProvider->fctPtrs->releaseGuidRange(self->guidProvider, obj);
+        return;
+    }
     //TODO not yet implemented
     ASSERT(false);
 }
@@ -326,6 +358,12 @@ static u8 fsimGetGuid(ocrPolicyDomain_t *self, ocrGuid_t *guid, u64 val, ocrGuid
     return 0;
 }
 
+static u8 fsimGetGuidRange(ocrPolicyDomain_t *self, ocrGuid_t *guids, u64 val, u64 stride,
+                         u32 count, ocrGuidKind type, ocrPolicyCtx_t *ctx) {
+    return self->guidProvider->fctPtrs->getGuidRange(self->guidProvider, guids, val, stride,
+                                                     count, type);
+}
+
 static u8 fsimGetInfoForGuid(ocrPolicyDomain_t *self, ocrGuid_t guid, u64* val,
                            ocrGuidKind* type, ocrPolicyCtx_t *ctx) {
     self->guidProvider->fctPtrs->getVal(self->guidProvider, guid, val, type);
@@ -394,13 +432,16 @@ ocrPolicyDomain_t * newPolicyDomainXE(ocrPolicyDomainFactory_t * policy,
     base->stop = fsimNonMasteredPolicyDomainStop;
     base->finish = fsimPolicyDomainFinish;
     base->allocateDb = fsimAllocateDb;
+    base->resizeDb = fsimResizeDb;
     base->createEdt = fsimCreateEdt;
     base->createEdtTemplate = fsimCreateEdtTemplate;
     base->createEvent = fsimCreateEvent;
     base->inform = fsimInform;
     base->getGuid = fsimGetGuid;
+    base->getGuidRange = fsimGetGuidRange;
     base->getInfoForGuid = fsimGetInfoForGuid;
     base->waitForEvent = fsimWaitForEvent;
+    base->idleWorkers = fsimIdleWorkers;
     base->takeEdt = fsimTakeEdt;
     base->takeDb = NULL;
     base->giveEdt = xeGiveEdt;
@@ -412,6 +453,8 @@ ocrPolicyDomain_t * newPolicyDomainXE(ocrPolicyDomainFactory_t * policy,
 
     base->neighbors = NULL;
     base->neighborCount = 0;
+    base->dbSpill = NULL;
+    base->metaAlloc = NULL;
 
     //TODO populated by ini file factories. Need setters or something ?
     base->schedulers = NULL;
@@ -461,13 +504,16 @@ ocrPolicyDomain_t * newPolicyDomainCE(ocrPolicyDomainFactory_t * policy,
     base->stop = fsimNonMasteredPolicyDomainStop;
     base->finish = fsimPolicyDomainFinish;
     base->allocateDb = fsimAllocateDb;
+    base->resizeDb = fsimResizeDb;
     base->createEdt = fsimCreateEdt;
     base->createEdtTemplate = fsimCreateEdtTemplate;
     base->createEvent = fsimCreateEvent;
     base->inform = fsimInform;
     base->getGuid = fsimGetGuid;
+    base->getGuidRange = fsimGetGuidRange;
     base->getInfoForGuid = fsimGetInfoForGuid;
     base->waitForEvent = fsimWaitForEvent;
+    base->idleWorkers = fsimIdleWorkers;
     base->takeEdt = fsimTakeEdt;
     base->takeDb = NULL;
     base->giveEdt = fsimGiveEdt;
@@ -479,6 +525,8 @@ ocrPolicyDomain_t * newPolicyDomainCE(ocrPolicyDomainFactory_t * policy,
 
     base->neighbors = NULL;
     base->neighborCount = 0;
+    base->dbSpill = NULL;
+    base->metaAlloc = NULL;
 
     //TODO populated by ini file factories. Need setters or something ?
     base->schedulers = NULL;
@@ -528,13 +576,16 @@ ocrPolicyDomain_t * newPolicyDomainMasteredCE(ocrPolicyDomainFactory_t * policy,
     base->stop = fsimMasteredPolicyDomainStop;
     base->finish = fsimPolicyDomainFinish;
     base->allocateDb = fsimAllocateDb;
+    base->resizeDb = fsimResizeDb;
     base->createEdt = fsimCreateEdt;
     base->createEdtTemplate = fsimCreateEdtTemplate;
     base->createEvent = fsimCreateEvent;
     base->inform = fsimInform;
     base->getGuid = fsimGetGuid;
+    base->getGuidRange = fsimGetGuidRange;
     base->getInfoForGuid = fsimGetInfoForGuid;
     base->waitForEvent = fsimWaitForEvent;
+    base->idleWorkers = fsimIdleWorkers;
     base->takeEdt = fsimTakeEdt;
     base->takeDb = NULL;
     base->giveEdt = fsimGiveEdt;
@@ -546,6 +597,8 @@ ocrPolicyDomain_t * newPolicyDomainMasteredCE(ocrPolicyDomainFactory_t * policy,
 
     base->neighbors = NULL;
     base->neighborCount = 0;
+    base->dbSpill = NULL;
+    base->metaAlloc = NULL;
 
     //TODO populated by ini file factories. Need setters or something ?
     base->schedulers = NULL;
@@ -5,20 +5,36 @@
  */
 
 
+#include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 
 #include "debug.h"
 #include "ocr-macros.h"
 #include "ocr-policy-domain.h"
+#include "allocator/meta/meta-allocator.h"
+#include "allocator/tlsf/tlsf-allocator.h"
+#include "datablock/spill/db-spill.h"
+#include "mem-platform/numa/numa-mem-platform.h"
 #include "policy-domain/hc/hc-policy.h"
 
+#define DEBUG_TYPE POLICY
+
 static void destructOcrPolicyCtxHC ( ocrPolicyCtx_t* self ) {
     free(self);
 }
 
+static void destructClonedOcrPolicyCtxHC ( ocrPolicyCtx_t* self ) {
+    metaFree(self);
+}
+
+// Contexts are cloned for each message and come from the metadata
+// allocator. The instantiated ones belong to the workers and live as
+// long as the runtime, so they stay on calloc
 static ocrPolicyCtx_t * cloneOcrPolicyCtxHC (ocrPolicyCtx_t * ctxIn) {
-    ocrPolicyCtxHc_t* ctxOut = checkedMalloc (ctxOut, sizeof(ocrPolicyCtxHc_t));
+    ocrPolicyCtxHc_t* ctxOut = metaMalloc(sizeof(ocrPolicyCtxHc_t));
     memcpy(ctxOut, ctxIn, sizeof(ocrPolicyCtxHc_t));
+    ctxOut->base.destruct = destructClonedOcrPolicyCtxHC;
     return (ocrPolicyCtx_t*) ctxOut;
 }
 
@@ -57,6 +73,23 @@ static void hcPolicyDomainStart(ocrPolicyDomain_t * policy) {
         policy->allocators[i]->fctPtrs->start(policy->allocators[i], policy);
     }
 
+    // Runtime objects are allocated in the memory of the policy domain from now on
+    policy->metaAlloc = newMetaAlloc(policy);
+
+    // Record the NUMA node of each allocator, from the platform of its first memory
+    ocrPolicyDomainHc_t * rself = (ocrPolicyDomainHc_t *) policy;
+    rself->allocatorNodes = (s32 *) checkedMalloc(rself->allocatorNodes, sizeof(s32)*policy->allocatorCount);
+    rself->numaAware = false;
+    for(i = 0; i < policy->allocatorCount; ++i) {
+        ocrAllocator_t * allocator = policy->allocators[i];
+        s32 node = -1;
+        if((allocator->memoryCount > 0) && (allocator->memories[0]->memoryCount > 0)) {
+            node = allocator->memories[0]->memories[0]->node;
+        }
+        rself->allocatorNodes[i] = node;
+        rself->numaAware |= (node >= 0);
+    }
+
     // Start schedulers
     for(i = 0; i < schedulerCount; i++) {
         policy->schedulers[i]->fctPtrs->start(policy->schedulers[i], policy);
@@ -125,10 +158,21 @@ static void hcPolicyDomainDestruct(ocrPolicyDomain_t * policy) {
     for ( i = 0; i < policy->workpileCount; ++i ) {
         workpiles[i]->fctPtrs->destruct(workpiles[i]);
     }
+    if (policy->dbSpill != NULL) {
+        destructDbSpill(policy->dbSpill);
+    }
     ocrAllocator_t ** allocators = policy->allocators;
     for ( i = 0; i < policy->allocatorCount; ++i ) {
         allocators[i]->fctPtrs->destruct(allocators[i]);
     }
+    free(((ocrPolicyDomainHc_t *) policy)->allocatorNodes);
+    // The objects still in use (the contexts of the workers, the GUIDs of
+    // the memories) were allocated with calloc, the chunks can go back
+    if (policy->metaAlloc != NULL) {
+        ocrMetaAlloc_t * metaAlloc = policy->metaAlloc;
+        policy->metaAlloc = NULL;
+        destructMetaAlloc(metaAlloc);
+    }
     ocrMemTarget_t ** memories = policy->memories;
     for ( i = 0; i < policy->memoryCount; ++i ) {
         memories[i]->fctPtrs->destruct(memories[i]);
@@ -157,30 +201,139 @@ static void hcPolicyDomainDestruct(ocrPolicyDomain_t * policy) {
     free(policy);
 }
 
+// Index of the allocator to try first for a data-block: the one of the
+// data-block given as affinity, else one bound to the NUMA node of the caller
+static u64 hcFirstAllocator(ocrPolicyDomain_t *self, ocrGuid_t affinity) {
+    ocrPolicyDomainHc_t * rself = (ocrPolicyDomainHc_t *) self;
+    u64 i;
+    if(affinity != NULL_GUID) {
+        u64 val;
+        ocrGuidKind kind;
+        self->getInfoForGuid(self, affinity, &val, &kind, NULL);
+        ocrGuid_t allocatorGuid = affinity;
+        if(kind == OCR_GUID_DB) {
+            allocatorGuid = ((ocrDataBlock_t *) val)->allocator;
+        }
+        if((kind == OCR_GUID_DB) || (kind == OCR_GUID_ALLOCATOR)) {
+            for(i = 0; i < self->allocatorCount; ++i) {
+                if(self->allocators[i]->guid == allocatorGuid) {
+                    return i;
+                }
+            }
+        }
+    }
+    if(rself->numaAware) {
+        s32 node = numaNodeOfCaller();
+        for(i = 0; i < self->allocatorCount; ++i) {
+            if(rself->allocatorNodes[i] == node) {
+                return i;
+            }
+        }
+    }
+    return 0;
+}
+
+#ifdef OCR_DEBUG
+// Shows whether a data-block did not fit for lack of memory or because
+// the free memory is fragmented
+static void hcDumpAllocators(ocrPolicyDomain_t *self, u64 size) {
+    u64 i, c;
+    DPRINTF(DEBUG_LVL_WARN, "No allocator can hold a data-block of %"PRIu64" bytes\n", size);
+    for(i = 0; i < self->allocatorCount; ++i) {
+        ocrMemoryStats_t stats = { 0 };
+        self->allocators[i]->fctPtrs->getStats(self->allocators[i], &stats, true);
+        DPRINTF(DEBUG_LVL_WARN, "Allocator %"PRIu64": %"PRIu64" bytes, %"PRIu64" used by %"PRIu64" chunks, "
+                "%"PRIu64" free in %"PRIu64" blocks, largest %"PRIu64", fragmentation %"PRIu64"/1000, "
+                "%"PRIu64" errors\n", i, stats.totalSize, stats.usedSize, stats.usedCount, stats.freeSize,
+                stats.freeCount, stats.largestFree, stats.fragmentation, stats.errors);
+        for(c = 0; c < OCR_MEMORY_STATS_CLASSES; ++c) {
+            if((stats.usedHistogram[c] != 0) || (stats.freeHistogram[c] != 0)) {
+                DPRINTF(DEBUG_LVL_WARN, "  %"PRIu64" bytes and more: %"PRIu64" used, %"PRIu64" free\n",
+                        (u64)1 << c, stats.usedHistogram[c], stats.freeHistogram[c]);
+            }
+        }
+    }
+}
+#endif /* OCR_DEBUG */
+
 static u8 hcAllocateDb(ocrPolicyDomain_t *self, ocrGuid_t *guid, void** ptr, u64 size,
                        u16 properties, ocrGuid_t affinity, ocrInDbAllocator_t allocator,
                        ocrPolicyCtx_t *context) {
 
-    // Currently a very simple model of just going through all allocators
-    u64 i;
+    // Go through all allocators starting with the local one.
+    // When they are all full, evict data-blocks until one has room
+    u64 first = (self->allocatorCount > 1) ? hcFirstAllocator(self, affinity) : 0;
+    u64 i, k;
     void* result;
-    for(i=0; i < self->allocatorCount; ++i) {
-        result = self->allocators[i]->fctPtrs->allocate(self->allocators[i],
-                                                        size);
-        if(result) break;
-    }
+    do {
+        for(k=0; k < self->allocatorCount; ++k) {
+            i = (first + k) % self->allocatorCount;
+            result = self->allocators[i]->fctPtrs->allocate(self->allocators[i],
+                                                            size);
+            if(result) break;
+        }
+    } while((k == self->allocatorCount) && (self->dbSpill != NULL) && dbSpillEvict(self->dbSpill));
     // TODO: return error code. Requires our own errno to be clean
-    if(i < self->allocatorCount) {
+    if(k < self->allocatorCount) {
+        if((allocator == TLSF_ALLOC) && (tlsfRegionInit(result, size) != 0)) {
+            self->allocators[i]->fctPtrs->free(self->allocators[i], result);
+            return ENOMEM;
+        }
         ocrDataBlock_t *block = self->dbFactory->instantiate(self->dbFactory,
                                                              self->allocators[i]->guid, self->guid,
                                                              size, result, properties, NULL);
+        block->inDbAllocator = allocator;
+        if(self->dbSpill != NULL) {
+            dbSpillRegister(self->dbSpill, block, getCurrentEDT());
+        }
         *ptr = result;
         *guid = block->guid;
         return 0;
-    } 
+    }
+#ifdef OCR_DEBUG
+    hcDumpAllocators(self, size);
+#endif
     return 1; // TODO: Return ENOMEM
 }
 
+static u8 hcResizeDb(ocrPolicyDomain_t *self, ocrGuid_t guid, u64 size,
+                     ocrPolicyCtx_t *context) {
+    ocrDataBlock_t *db = NULL;
+    deguidify(self, guid, (u64*)&db, NULL);
+
+    // The allocator of the data-block may resize it in place. Otherwise
+    // move it to the other allocators, then evict like hcAllocateDb. The
+    // data-block is held so it is not evicted itself
+    u64 first = hcFirstAllocator(self, guid);
+    ocrAllocator_t *current = self->allocators[first];
+    ASSERT(current->guid == db->allocator);
+    u64 i, k;
+    void* result;
+    do {
+        result = current->fctPtrs->reallocate(current, db->ptr, size);
+        for(k=1; (result == NULL) && (k < self->allocatorCount); ++k) {
+            i = (first + k) % self->allocatorCount;
+            result = self->allocators[i]->fctPtrs->allocate(self->allocators[i], size);
+            if(result) {
+                memcpy(result, db->ptr, (size < db->size) ? size : db->size);
+                current->fctPtrs->free(current, db->ptr);
+                db->allocator = self->allocators[i]->guid;
+            }
+        }
+    } while((result == NULL) && (self->dbSpill != NULL) && dbSpillEvict(self->dbSpill));
+    if(result == NULL) {
+        return ENOMEM;
+    }
+    DPRINTF(DEBUG_LVL_VERB, "Resized DB 0x%"PRIx64" from %"PRIu64" bytes @ 0x%"PRIx64" to %"PRIu64" bytes @ 0x%"PRIx64"\n",
+            (u64)guid, db->size, (u64)db->ptr, size, (u64)result);
+    if(db->spill != NULL) {
+        dbSpillResize(db);
+    }
+    db->ptr = result;
+    db->size = size;
+    return 0;
+}
+
 static u8 hcCreateEdt(ocrPolicyDomain_t *self, ocrGuid_t *guid,
                       ocrTaskTemplate_t * edtTemplate, u32 paramc, u64* paramv,
                       u32 depc, u16 properties, ocrGuid_t affinity,
@@ -217,6 +370,10 @@ static u8 hcCreateEvent(ocrPolicyDomain_t *self, ocrGuid_t *guid,
     return 0;
 }
 
+static u32 hcIdleWorkers(ocrPolicyDomain_t *self, ocrPolicyCtx_t *context) {
+    return self->schedulers[0]->fctPtrs->idleWorkers(self->schedulers[0]);
+}
+
 static u8 hcWaitForEvent(ocrPolicyDomain_t *self, ocrGuid_t workerGuid,
                        ocrGuid_t yieldingEdtGuid, ocrGuid_t eventToYieldForGuid,
                        ocrGuid_t * returnGuid, ocrPolicyCtx_t *context) {
@@ -240,6 +397,10 @@ static void hcInform(ocrPolicyDomain_t *self, ocrGuid_t obj, const ocrPolicyCtx_
         self->guidProvider->fctPtrs->releaseGuid(self->guidProvider, obj);
         return;
     }
+    if(context->type == PD_MSG_GUID_RANGE_REL) {
+        self->guidProvider->fctPtrs->releaseGuidRange(self->guidProvider, obj);
+        return;
+    }
     //TODO not yet implemented
     ASSERT(false);
 }
@@ -250,6 +411,12 @@ static u8 hcGetGuid(ocrPolicyDomain_t *self, ocrGuid_t *guid, u64 val, ocrGuidKi
     return 0;
 }
 
+static u8 hcGetGuidRange(ocrPolicyDomain_t *self, ocrGuid_t *guids, u64 val, u64 stride,
+                         u32 count, ocrGuidKind type, ocrPolicyCtx_t *ctx) {
+    return self->guidProvider->fctPtrs->getGuidRange(self->guidProvider, guids, val, stride,
+                                                     count, type);
+}
+
 static u8 hcGetInfoForGuid(ocrPolicyDomain_t *self, ocrGuid_t guid, u64* val,
                            ocrGuidKind* type, ocrPolicyCtx_t *ctx) {
     self->guidProvider->fctPtrs->getVal(self->guidProvider, guid, val, type);
@@ -306,13 +473,16 @@ ocrPolicyDomain_t * newPolicyDomainHc(ocrPolicyDomainFactory_t * policy,
     base->stop = hcPolicyDomainStop;
     base->finish = hcPolicyDomainFinish;
     base->allocateDb = hcAllocateDb;
+    base->resizeDb = hcResizeDb;
     base->createEdt = hcCreateEdt;
     base->createEdtTemplate = hcCreateEdtTemplate;
     base->createEvent = hcCreateEvent;
     base->inform = hcInform;
     base->getGuid = hcGetGuid;
+    base->getGuidRange = hcGetGuidRange;
     base->getInfoForGuid = hcGetInfoForGuid;
     base->waitForEvent = hcWaitForEvent;
+    base->idleWorkers = hcIdleWorkers;
     base->takeEdt = hcTakeEdt;
     base->takeDb = NULL;
     base->giveEdt = hcGiveEdt;
@@ -326,6 +496,10 @@ ocrPolicyDomain_t * newPolicyDomainHc(ocrPolicyDomainFactory_t * policy,
     base->neighbors = NULL;
     base->neighborCount = 0;
 
+    const char * spillDirectory = ((paramListPolicyDomainInst_t *) perInstance)->spillDirectory;
+    base->dbSpill = (spillDirectory != NULL) ? newDbSpill(spillDirectory, lockFactory) : NULL;
+    base->metaAlloc = NULL;
+
     //TODO populated by ini file factories. Need setters or something ?
     base->schedulers = NULL;
     base->workers = NULL;
@@ -333,6 +507,9 @@ ocrPolicyDomain_t * newPolicyDomainHc(ocrPolicyDomainFactory_t * policy,
     base->workpiles = NULL;
     base->allocators = NULL;
     base->memories = NULL;
+    // Set when the allocators are started
+    derived->allocatorNodes = NULL;
+    derived->numaAware = false;
 
     base->guid = UNINITIALIZED_GUID;
     guidify(base, (u64)base, &(base->guid), OCR_GUID_POLICY);
@@ -28,6 +28,8 @@ typedef struct {
 
 typedef struct {
     ocrPolicyDomain_t base;
+    s32 * allocatorNodes;   /**< NUMA node of the memory of each allocator, -1 if none */
+    bool numaAware;         /**< Whether some allocators are bound to a node */
 } ocrPolicyDomainHc_t;
 
 ocrPolicyDomainFactory_t *newPolicyDomainFactoryHc(ocrParamList_t *perType);
@@ -168,6 +168,11 @@ static void xeSchedulerStop(ocrScheduler_t * self) {
     assert ( 0 && "xe scheduler stop should not have been called");
 }
 
+// Idle workers are not tracked
+static u32 xeSchedulerIdleWorkers(ocrScheduler_t * self) {
+    return 0;
+}
+
 ocrSchedulerFactory_t * newOcrSchedulerFactoryXE (ocrParamList_t *perType) {
     ocrSchedulerFactoryXE_t* xeFactoryDerived = (ocrSchedulerFactoryXE_t*) checkedMalloc(xeFactoryDerived, sizeof(ocrSchedulerFactoryXE_t));
     ocrSchedulerFactory_t* baseFactory = (ocrSchedulerFactory_t*) xeFactoryDerived;
@@ -179,6 +184,7 @@ ocrSchedulerFactory_t * newOcrSchedulerFactoryXE (ocrParamList_t *perType) {
     baseFactory->schedulerFcts.destruct = xeSchedulerDestruct;
     baseFactory->schedulerFcts.takeEdt = xeSchedulerTake;
     baseFactory->schedulerFcts.giveEdt = xeSchedulerGive;
+    baseFactory->schedulerFcts.idleWorkers = xeSchedulerIdleWorkers;
     return baseFactory;
 }
 
@@ -312,6 +318,11 @@ static void ceSchedulerStop(ocrScheduler_t * self) {
     assert ( 0 && "ce scheduler stop should not have been called");
 }
 
+// Idle workers are not tracked
+static u32 ceSchedulerIdleWorkers(ocrScheduler_t * self) {
+    return 0;
+}
+
 ocrSchedulerFactory_t * newOcrSchedulerFactoryCE (ocrParamList_t *perType) {
     ocrSchedulerFactoryCE_t* ceFactoryDerived = (ocrSchedulerFactoryCE_t*) checkedMalloc(ceFactoryDerived, sizeof(ocrSchedulerFactoryCE_t));
     ocrSchedulerFactory_t* baseFactory = (ocrSchedulerFactory_t*) ceFactoryDerived;
@@ -323,5 +334,6 @@ ocrSchedulerFactory_t * newOcrSchedulerFactoryCE (ocrParamList_t *perType) {
     baseFactory->schedulerFcts.destruct = ceSchedulerDestruct;
     baseFactory->schedulerFcts.takeEdt = ceSchedulerTake;
     baseFactory->schedulerFcts.giveEdt = ceSchedulerGive;
+    baseFactory->schedulerFcts.idleWorkers = ceSchedulerIdleWorkers;
     return baseFactory;
 }
@@ -5,6 +5,7 @@
  */
 
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "debug.h"
 #include "ocr-macros.h"
@@ -48,6 +49,17 @@ static void hcSchedulerStart(ocrScheduler_t * self, ocrPolicyDomain_t * PD) {
         i++;
     }
     derived->stealIterators = stealIteratorsCache;
+    // One inline counter per worker
+    derived->inlineCount = checkedMalloc(derived->inlineCount, sizeof(u32)*workpileCount);
+    for(i = 0; i < workpileCount; ++i) {
+        derived->inlineCount[i] = 0;
+    }
+    derived->idle = checkedMalloc(derived->idle, sizeof(bool)*workpileCount);
+    for(i = 0; i < workpileCount; ++i) {
+        derived->idle[i] = false;
+    }
+    derived->idleCount = 0;
+    derived->pageSize = (u64) sysconf(_SC_PAGESIZE);
 }
 
 static void hcSchedulerStop(ocrScheduler_t * self) {
@@ -58,34 +70,19 @@ static u8 hcSchedulerYield (ocrScheduler_t* self, ocrGuid_t workerGuid,
                             ocrGuid_t yieldingEdtGuid, ocrGuid_t eventToYieldForGuid,
                             ocrGuid_t * returnGuid,
                             ocrPolicyCtx_t *context) {
-    // We do not yet take advantage of knowing which EDT we are yielding for.
     ocrPolicyDomain_t * pd = context->PD;
     ocrWorker_t * worker = NULL;
     deguidify(pd, workerGuid, (u64*)&(worker), NULL);
-    // Retrieve currently executing edt's guid
     ocrEvent_t * eventToYieldFor = NULL;
     deguidify(pd, eventToYieldForGuid, (u64*)&(eventToYieldFor), NULL);
 
-    ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
-    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
-    ctx->type = PD_MSG_EDT_TAKE;
-
-    ocrGuid_t result = ERROR_GUID;
-    //This only works for single events, not latches
-    ASSERT(isEventSingleGuid(eventToYieldForGuid));
-    while((result = eventToYieldFor->fctPtrs->get(eventToYieldFor, 0)) == ERROR_GUID) {
-        u32 count;
-        ocrGuid_t taskGuid;
-        pd->takeEdt(pd, NULL, &count, &taskGuid, ctx);
-        ASSERT(count <= 1); // >1 not yet supported
-        if (count != 0) {
-            ocrTask_t* task = NULL;
-            deguidify(pd, taskGuid, (u64*)&(task), NULL);
-            worker->fctPtrs->execute(worker, task, taskGuid, yieldingEdtGuid);
-        }
+    ocrGuid_t result = eventToYieldFor->fctPtrs->get(eventToYieldFor, 0);
+    if (result == ERROR_GUID) {
+        // The worker suspends the yielding EDT and keeps executing
+        // other EDTs until the event is satisfied.
+        result = worker->fctPtrs->waitForEvent(worker, eventToYieldForGuid, yieldingEdtGuid);
     }
     *returnGuid = result;
-    ctx->destruct(ctx);
     return 0;
 }
 
@@ -95,6 +92,10 @@ static u8 hcSchedulerTake (ocrScheduler_t *self, struct _ocrCost_t *cost, u32 *c
     // Source must be a worker guid and we rely on indices to map
     // workers to workpiles (one-to-one)
     u64 workerId = context->sourceId;
+    // The worker starts a new EDT: renew its inline budget
+    ocrSchedulerHc_t * derived = (ocrSchedulerHc_t *) self;
+    u64 idx = workerId - derived->workerIdFirst;
+    derived->inlineCount[idx] = 0;
     // First try to pop
     ocrWorkpile_t * wp_to_pop = popMappingOneToOne(self, workerId);
     // TODO sagnak, just to get it to compile, I am trickling down the 'cost' though it most probably is not the same
@@ -119,15 +120,73 @@ static u8 hcSchedulerTake (ocrScheduler_t *self, struct _ocrCost_t *cost, u32 *c
     } else {
       *count = 0;
     }
+    // Only update the idle count when the worker's state changes
+    // so that spinning idle workers do not contend on it
+    if ((NULL_GUID != popped) == derived->idle[idx]) {
+        derived->idle[idx] = !derived->idle[idx];
+        __sync_fetch_and_add(&(derived->idleCount), derived->idle[idx] ? 1 : -1);
+    }
     return 0;
 }
 
+static u32 hcSchedulerIdleWorkers(ocrScheduler_t * self) {
+    return ((ocrSchedulerHc_t *) self)->idleCount;
+}
+
+/**
+ * @brief Executes an EDT marked with EDT_PROP_INLINE on the worker that
+ * satisfied its last dependence, saving the trip through the workpiles.
+ * EDTs without dependences are ready as soon as they are created and
+ * still go through the workpiles: running them inline would delay the
+ * creator and keep the work they spawn away from thieves.
+ * Inlining only happens from within an EDT and each worker executes at
+ * most 'inlineLimit' EDTs inline per EDT it takes, which bounds nesting.
+ * @return true if the EDT has been executed
+ */
+static bool hcSchedulerTryInline(ocrScheduler_t * base, ocrGuid_t edtGuid, ocrPolicyCtx_t * context) {
+    ocrSchedulerHc_t * derived = (ocrSchedulerHc_t *) base;
+    u64 idx = context->sourceId - derived->workerIdFirst;
+    if (derived->inlineCount[idx] >= derived->inlineLimit) {
+        return false;
+    }
+    ocrPolicyDomain_t * pd = context->PD;
+    ocrTask_t * task = NULL;
+    deguidify(pd, edtGuid, (u64*)&task, NULL);
+    if (!(task->properties & EDT_PROP_INLINE) || (task->depc == 0)) {
+        return false;
+    }
+    ocrWorker_t * worker = NULL;
+    deguidify(pd, context->sourceObj, (u64*)&worker, NULL);
+    ocrGuid_t currentEdt = worker->fctPtrs->getCurrentEDT(worker);
+    if (currentEdt == NULL_GUID) {
+        return false;
+    }
+    // Same sequence as the worker loop: finish-scope and output
+    // event handling are done by the task's execute function.
+    derived->inlineCount[idx]++;
+    worker->fctPtrs->execute(worker, task, edtGuid, currentEdt);
+    task->fctPtrs->destruct(task);
+    return true;
+}
+
 static u8 hcSchedulerGive (ocrScheduler_t* base, u32 count, ocrGuid_t* edts, struct _ocrPolicyCtx_t *context ) {
     // Source must be a worker guid
     u64 workerId = context->sourceId;
+    if ((count == 1) && hcSchedulerTryInline(base, edts[0], context)) {
+        return 0;
+    }
+    ocrSchedulerHc_t * derived = (ocrSchedulerHc_t *) base;
+    bool prefetch = (derived->prefetchLines != 0) || (derived->prefetchPages != 0);
     ocrWorkpile_t * wp_to_push = pushMappingOneToOne(base, workerId);
     u32 i = 0;
     for ( ; i < count; ++i ) {
+        if (prefetch) {
+            // The EDT may run as soon as it is pushed: prefetch first
+            ocrTask_t * task = NULL;
+            deguidify(context->PD, edts[i], (u64*)&task, NULL);
+            task->fctPtrs->prefetch(task, derived->prefetchLines, derived->prefetchPages,
+                                    derived->pageSize);
+        }
         wp_to_push->fctPtrs->push(wp_to_push,edts[i]);
     }
     return 0;
@@ -145,6 +204,8 @@ static void destructSchedulerHc(ocrScheduler_t * scheduler) {
         i++;
     }
     free(stealIterators);
+    free(derived->inlineCount);
+    free(derived->idle);
     // free self (workpiles are not allocated by the scheduler)
     free(scheduler);
 }
@@ -155,6 +216,13 @@ static ocrScheduler_t* newSchedulerHc(ocrSchedulerFactory_t * factory, ocrParamL
     base->fctPtrs = &(factory->schedulerFcts);
     paramListSchedulerHcInst_t *mapper = (paramListSchedulerHcInst_t*)perInstance;
     derived->workerIdFirst = mapper->workerIdFirst;
+    derived->inlineCount = NULL;
+    derived->idle = NULL;
+    derived->idleCount = 0;
+    derived->inlineLimit = mapper->inlineLimit;
+    derived->prefetchLines = mapper->prefetchLines;
+    derived->prefetchPages = mapper->prefetchPages;
+    derived->pageSize = 0;
     return base;
 }
 
@@ -173,5 +241,6 @@ ocrSchedulerFactory_t * newOcrSchedulerFactoryHc(ocrParamList_t *perType) {
     base->schedulerFcts.destruct = destructSchedulerHc;
     base->schedulerFcts.takeEdt = hcSchedulerTake;
     base->schedulerFcts.giveEdt = hcSchedulerGive;
+    base->schedulerFcts.idleWorkers = hcSchedulerIdleWorkers;
     return base;
 }
@@ -12,6 +12,14 @@
 #include "ocr-utils.h"
 #include "ocr-workpile.h"
 
+// Default number of EDTs a worker may execute inline for each EDT it takes
+#define HC_SCHEDULER_INLINE_LIMIT 32
+
+// Data-blocks of the EDTs pushed to the workpiles are not prefetched
+// unless configured otherwise
+#define HC_SCHEDULER_PREFETCH_LINES 0
+#define HC_SCHEDULER_PREFETCH_PAGES 0
+
 typedef struct {
     ocrSchedulerFactory_t base;
 } ocrSchedulerFactoryHc_t;
@@ -23,11 +31,24 @@ typedef struct {
     // a sheduler's construction time.
     ocrWorkpileIterator_t ** stealIterators;
     u64 workerIdFirst;
+    // Number of EDTs each worker executed inline since it last took one
+    u32 * inlineCount;
+    u32 inlineLimit;
+    // Cache lines and pages of their data-blocks prefetched when EDTs are pushed
+    u32 prefetchLines;
+    u32 prefetchPages;
+    u64 pageSize;
+    // Workers whose last attempt to take an EDT failed
+    bool * idle;
+    volatile u32 idleCount;
 } ocrSchedulerHc_t;
 
 typedef struct _paramListSchedulerHcInst_t {
     paramListSchedulerInst_t base;
     u64 workerIdFirst;
+    u32 inlineLimit;
+    u32 prefetchLines;
+    u32 prefetchPages;
 } paramListSchedulerHcInst_t;
 
 ocrSchedulerFactory_t * newOcrSchedulerFactoryHc(ocrParamList_t *perType);
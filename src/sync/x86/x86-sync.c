@@ -9,6 +9,7 @@
  */
 
 
+#include "allocator/meta/meta-allocator.h"
 #include "debug.h"
 #include "ocr-macros.h"
 #include "ocr-types.h"
@@ -18,7 +19,7 @@
 
 /* x86 lock */
 static void destructLockX86(ocrLock_t* self) {
-    free(self);
+    metaFree(self);
 }
 
 static void lockX86(ocrLock_t* self) {
@@ -42,7 +43,7 @@ static u8 tryLockX86(ocrLock_t* self) {
 
 /* x86 lock factory */
 static ocrLock_t* newLockX86(ocrLockFactory_t *factory, ocrParamList_t* perInstance) {
-    ocrLockX86_t *result = (ocrLockX86_t*)checkedMalloc(result, sizeof(ocrLockX86_t));
+    ocrLockX86_t *result = (ocrLockX86_t*)metaMalloc(sizeof(ocrLockX86_t));
 
     result->base.fctPtrs = &(factory->lockFcts);
     result->val = 0;
@@ -69,7 +70,7 @@ ocrLockFactory_t* newLockFactoryX86(ocrParamList_t* perType) {
 
 /* x86 atomic */
 static void destructAtomic64X86(ocrAtomic64_t *self) {
-    free(self);
+    metaFree(self);
 }
 
 static u64 xadd64X86(ocrAtomic64_t *self, u64 addValue) {
@@ -89,8 +90,7 @@ static u64 val64X86(ocrAtomic64_t *self) {
 
 /* x86 atomic factory */
 static ocrAtomic64_t* newAtomic64X86(ocrAtomic64Factory_t *factory, ocrParamList_t* perInstance) {
-    ocrAtomic64X86_t *result = (ocrAtomic64X86_t*)checkedMalloc(
-        result, sizeof(ocrAtomic64X86_t));
+    ocrAtomic64X86_t *result = (ocrAtomic64X86_t*)metaMalloc(sizeof(ocrAtomic64X86_t));
 
     result->base.fctPtrs = &(factory->atomicFcts);
     result->val = 0ULL;
@@ -118,8 +118,8 @@ ocrAtomic64Factory_t* newAtomic64FactoryX86(ocrParamList_t *perType) {
 
 static void destructQueueX86(ocrQueue_t *self) {
     ocrQueueX86_t *rself = (ocrQueueX86_t*)self;
-    free(rself->content);
-    free(rself);
+    metaFree(rself->content);
+    metaFree(rself);
 }
 
 static u64 popHeadX86(ocrQueue_t *self) {
@@ -164,7 +164,7 @@ static u64 pushTailX86(ocrQueue_t *self, u64 val) {
 
 /* x86 queue factory */
 static ocrQueue_t* newQueueX86(ocrQueueFactory_t *factory, ocrParamList_t *perInstance) {
-    ocrQueueX86_t *result = (ocrQueueX86_t*)checkedMalloc(result, sizeof(ocrQueueX86_t));
+    ocrQueueX86_t *result = (ocrQueueX86_t*)metaMalloc(sizeof(ocrQueueX86_t));
 //    u64 reqSize = (u64)config;
     u64 reqSize = 32; // TODO: Add config if needed and if we want to keep this!!
 //    if(!reqSize) reqSize = 32; // Hard coded for now, make a constant somewhere
@@ -173,7 +173,7 @@ static ocrQueue_t* newQueueX86(ocrQueueFactory_t *factory, ocrParamList_t *perIn
     result->base.fctPtrs = &(factory->queueFcts);
     result->head = result->tail = 0ULL;
     result->size = reqSize;
-    result->content = (u64*)checkedMalloc(result->content, sizeof(u64)*reqSize);
+    result->content = (u64*)metaMalloc(sizeof(u64)*reqSize);
     result->lock = 0;
 
     return (ocrQueue_t*)result;
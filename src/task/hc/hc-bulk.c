@@ -0,0 +1,214 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "allocator/meta/meta-allocator.h"
+#include "debug.h"
+#include "ocr-event.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+#include "ocr-task.h"
+#include "ocr-utils.h"
+#include "task/hc/hc-bulk.h"
+#include "task/hc/hc-task.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define DEBUG_TYPE TASK
+
+static void bulkTaskDestruct(ocrTask_t * base);
+static void bulkTaskExecute(ocrTask_t * base);
+static void bulkTaskSchedule(ocrTask_t * base);
+static void bulkTaskPrefetch(ocrTask_t * base, u32 lines, u32 pages, u64 pageSize);
+
+// Bulk EDTs are not instantiated through the task factory,
+// they share these function pointers instead.
+static ocrTaskFcts_t bulkTaskFcts = {
+    .destruct = bulkTaskDestruct,
+    .execute = bulkTaskExecute,
+    .schedule = bulkTaskSchedule,
+    .prefetch = bulkTaskPrefetch
+};
+
+static void giveEdts(u32 count, ocrGuid_t * edts) {
+    ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->destPD = orgCtx->sourcePD;
+    ctx->destObj = NULL_GUID;
+    ctx->type = PD_MSG_EDT_READY;
+    orgCtx->PD->giveEdt(orgCtx->PD, count, edts, ctx);
+    ctx->destruct(ctx);
+}
+
+/******************************************************/
+/* OCR-HC Bulk EDTs                                   */
+/******************************************************/
+
+// Schedules the EDT with the range it is responsible for
+static void bulkTaskSchedule(ocrTask_t * base) {
+    DPRINTF(DEBUG_LVL_INFO, "Schedule bulk EDT 0x%lx\n", base->guid);
+    giveEdts(1, &(base->guid));
+}
+
+// Bulk EDTs have no dependences
+static void bulkTaskPrefetch(ocrTask_t * base, u32 lines, u32 pages, u64 pageSize) {
+}
+
+static void bulkTaskExecute(ocrTask_t * base) {
+    ocrBulkHcTask_t * self = (ocrBulkHcTask_t *) base;
+    ocrBulkHc_t * bulk = self->bulk;
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    DPRINTF(DEBUG_LVL_INFO, "Execute bulk EDT 0x%lx range [%d,%d)\n", base->guid,
+            self->index, self->rangeEnd);
+
+    // Split the range in halves and give the upper ones away, largest
+    // first so that they are the first ones stolen. Ranges hold less
+    // than 2^32 EDTs, which bounds the number of halves.
+    ocrGuid_t halves[32];
+    u32 nbHalves = 0;
+    while ((self->rangeEnd - self->index) > 1) {
+        u32 mid = self->index + (self->rangeEnd - self->index)/2;
+        bulk->tasks[mid].rangeEnd = self->rangeEnd;
+        self->rangeEnd = mid;
+        halves[nbHalves++] = bulk->tasks[mid].base.guid;
+    }
+    if (nbHalves != 0) {
+        giveEdts(nbHalves, halves);
+    }
+
+    // Each EDT gets its own copy of the parameters
+    u32 paramc = base->paramc;
+    u64 stackParams[BULK_MAX_STACK_PARAMS];
+    u64 * paramv = stackParams;
+    if (paramc > BULK_MAX_STACK_PARAMS) {
+        paramv = metaMalloc(sizeof(u64)*paramc);
+    }
+    if (paramc != 0) {
+        u32 i = 0;
+        for ( ; i < paramc; ++i) {
+            paramv[i] = bulk->paramv[i];
+            if (bulk->paramStride != NULL) {
+                paramv[i] += self->index*bulk->paramStride[i];
+            }
+        }
+    }
+
+    ocrTaskTemplate_t * taskTemplate;
+    deguidify(pd, base->templateGuid, (u64*)&taskTemplate, NULL);
+    taskTemplate->executePtr(paramc, paramv, 0, NULL);
+
+    if (paramc > BULK_MAX_STACK_PARAMS) {
+        metaFree(paramv);
+    }
+    // The bulk checked in its finish scope once, the last
+    // EDT to complete checks out on behalf of all of them
+    if ((__sync_sub_and_fetch(&(bulk->running), 1) == 0) && (bulk->finishLatch != NULL_GUID)) {
+        ocrEvent_t * latch = NULL;
+        deguidify(pd, bulk->finishLatch, (u64*)&latch, NULL);
+        DPRINTF(DEBUG_LVL_INFO, "Checkout bulk of 0x%lx on flatch 0x%lx\n", base->guid, latch->guid);
+        latch->fctPtrs->satisfy(latch, NULL_GUID, OCR_EVENT_LATCH_DECR_SLOT);
+    }
+}
+
+// Called by the worker once the EDT has executed. The EDTs of a bulk
+// and their GUIDs are deallocated with the last of them.
+static void bulkTaskDestruct(ocrTask_t * base) {
+    ocrBulkHc_t * bulk = ((ocrBulkHcTask_t *) base)->bulk;
+    if (__sync_sub_and_fetch(&(bulk->allocated), 1) == 0) {
+        DPRINTF(DEBUG_LVL_INFO, "Destroy bulk of 0x%lx\n", bulk->tasks[0].base.guid);
+        ocrPolicyDomain_t *pd = getCurrentPD();
+        ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
+        ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+        ctx->type = PD_MSG_GUID_RANGE_REL;
+        pd->inform(pd, bulk->tasks[0].base.guid, ctx);
+        ctx->destruct(ctx);
+        metaFree(bulk);
+    }
+}
+
+u8 edtCreateBulk(ocrGuid_t *guids, ocrTaskTemplate_t *taskTemplate, u32 count,
+                 u32 paramc, u64 *paramv, u64 *paramStride, u16 properties,
+                 ocrGuid_t affinity) {
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    // Header, EDTs, parameters and their strides in a single block
+    u32 nbParams = (paramStride != NULL) ? 2*paramc : paramc;
+    ocrBulkHc_t * bulk = (ocrBulkHc_t *) metaMalloc(sizeof(ocrBulkHc_t) +
+        sizeof(ocrBulkHcTask_t)*count + sizeof(u64)*nbParams);
+    if (bulk == NULL) {
+        return ENOMEM;
+    }
+    bulk->tasks = (ocrBulkHcTask_t *) (bulk + 1);
+    bulk->count = count;
+    bulk->paramv = (u64 *) (bulk->tasks + count);
+    memcpy(bulk->paramv, paramv, sizeof(u64)*paramc);
+    if (paramStride != NULL) {
+        bulk->paramStride = bulk->paramv + paramc;
+        memcpy(bulk->paramStride, paramStride, sizeof(u64)*paramc);
+    } else {
+        bulk->paramStride = NULL;
+    }
+    bulk->running = count;
+    bulk->allocated = count;
+
+    // Reserve all the GUIDs at once
+    ocrGuid_t * taskGuids = guids;
+    if (taskGuids == NULL) {
+        taskGuids = (ocrGuid_t *) metaMalloc(sizeof(ocrGuid_t)*count);
+        if (taskGuids == NULL) {
+            metaFree(bulk);
+            return ENOMEM;
+        }
+    }
+    u8 returnCode = pd->getGuidRange(pd, taskGuids, (u64) bulk->tasks, sizeof(ocrBulkHcTask_t),
+                                     count, OCR_GUID_EDT, NULL);
+    if (returnCode != 0) {
+        if (guids == NULL) {
+            metaFree(taskGuids);
+        }
+        metaFree(bulk);
+        return returnCode;
+    }
+
+    // The bulk's EDTs belong to the current finish scope
+    ocrEvent_t * curLatch = getFinishLatch(getCurrentTask());
+    bulk->finishLatch = (curLatch != NULL) ? curLatch->guid : NULL_GUID;
+    u32 i = 0;
+    for ( ; i < count; ++i) {
+        ocrBulkHcTask_t * task = &(bulk->tasks[i]);
+        ocrTask_t * base = (ocrTask_t *) task;
+        base->guid = taskGuids[i];
+        base->templateGuid = taskTemplate->guid;
+        base->paramc = paramc;
+        base->paramv = NULL; // Computed when the EDT runs
+        base->depc = 0;
+        base->properties = properties;
+        base->outputEvent = NULL_GUID;
+        u32 j = 0;
+        while (j < ELS_SIZE) {
+            base->els[j++] = NULL_GUID;
+        }
+        setFinishLatch(base, bulk->finishLatch);
+        base->fctPtrs = &bulkTaskFcts;
+        base->addedDepCounter = NULL;
+        task->bulk = bulk;
+        task->index = i;
+        task->rangeEnd = i+1;
+    }
+    if (guids == NULL) {
+        metaFree(taskGuids);
+    }
+    DPRINTF(DEBUG_LVL_INFO, "Create bulk of %d EDTs from 0x%lx\n", count, bulk->tasks[0].base.guid);
+
+    if (curLatch != NULL) {
+        DPRINTF(DEBUG_LVL_INFO, "Checkin bulk of 0x%lx on current flatch 0x%lx\n",
+                bulk->tasks[0].base.guid, curLatch->guid);
+        curLatch->fctPtrs->satisfy(curLatch, NULL_GUID, OCR_EVENT_LATCH_INCR_SLOT);
+    }
+    // The first EDT is responsible for the whole bulk
+    bulk->tasks[0].rangeEnd = count;
+    bulkTaskSchedule((ocrTask_t *) &(bulk->tasks[0]));
+    return 0;
+}
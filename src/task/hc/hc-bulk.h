@@ -0,0 +1,50 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __HC_BULK_H__
+#define __HC_BULK_H__
+
+#include "ocr-edt.h"
+#include "ocr-task.h"
+#include "ocr-types.h"
+
+// Above this number of parameters, a bulk EDT computes its
+// parameters in a heap buffer rather than on the stack
+#define BULK_MAX_STACK_PARAMS 16
+
+struct _ocrBulkHc_t;
+
+/*! \brief EDT created by ocrEdtCreateBulk
+ *
+ *  Bulk EDTs are not scheduled one by one. A single EDT is handed to the
+ *  scheduler for a whole range of EDTs of the bulk: when it starts, it
+ *  gives away halves of its range until it is the only EDT left in it.
+ *  Idle workers steal the oldest, hence largest, ranges.
+ */
+typedef struct _ocrBulkHcTask_t {
+    ocrTask_t base;
+    struct _ocrBulkHc_t * bulk;
+    u32 index;                 /**< Index of this EDT in the bulk */
+    u32 rangeEnd;              /**< End (excluded) of the range this EDT is responsible for */
+} ocrBulkHcTask_t;
+
+/*! \brief A block of EDTs created by a single call to ocrEdtCreateBulk
+ *
+ *  The header, the EDTs and the parameters are allocated together and
+ *  the EDTs' GUIDs are reserved as a single range.
+ */
+typedef struct _ocrBulkHc_t {
+    ocrBulkHcTask_t * tasks;
+    u32 count;
+    u64 * paramv;              /**< Parameters of the first EDT */
+    u64 * paramStride;         /**< Parameter increments, NULL if all EDTs share paramv */
+    ocrGuid_t finishLatch;     /**< Finish scope the bulk checked in, if any */
+    volatile u32 running;      /**< EDTs that have not completed yet */
+    volatile u32 allocated;    /**< EDTs that have not been destroyed yet */
+} ocrBulkHc_t;
+
+#endif /* __HC_BULK_H__ */
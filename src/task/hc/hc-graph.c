@@ -0,0 +1,724 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include "debug.h"
+#include "ocr-datablock.h"
+#include "ocr-event.h"
+#include "ocr-macros.h"
+#include "ocr-policy-domain-getter.h"
+#include "ocr-policy-domain.h"
+#include "ocr-task.h"
+#include "ocr-utils.h"
+#include "task/hc/hc-graph.h"
+#include "task/hc/hc-task.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNINITIALIZED_DATA ((ocrGuid_t) -2)
+
+#define DEBUG_TYPE TASK
+
+/******************************************************/
+/* OCR-HC ELS Slots Declaration                       */
+/******************************************************/
+
+// This must be consistent with the ELS size the runtime is compiled with
+#define ELS_SLOT_GRAPH 1
+
+static void graphTaskDestruct(ocrTask_t * base);
+static void graphTaskExecute(ocrTask_t * base);
+static void graphTaskSchedule(ocrTask_t * base);
+static void graphTaskPrefetch(ocrTask_t * base, u32 lines, u32 pages, u64 pageSize);
+static void graphEventDestruct(ocrEvent_t * base);
+static ocrGuid_t graphEventGet(ocrEvent_t * base, u32 slot);
+static void graphEventSatisfy(ocrEvent_t * base, ocrGuid_t data, u32 slot);
+
+// Graph EDTs and events are not instantiated through the task and event
+// factories, they share these function pointers instead.
+static ocrTaskFcts_t graphTaskFcts = {
+    .destruct = graphTaskDestruct,
+    .execute = graphTaskExecute,
+    .schedule = graphTaskSchedule,
+    .prefetch = graphTaskPrefetch
+};
+
+static ocrEventFcts_t graphEventFcts = {
+    .destruct = graphEventDestruct,
+    .get = graphEventGet,
+    .satisfy = graphEventSatisfy
+};
+
+static ocrGraphHc_t * getGraph(ocrGuid_t graphGuid) {
+    if (graphGuid == NULL_GUID) {
+        return NULL;
+    }
+    ocrGraphHc_t * graph = NULL;
+    ocrGuidKind kind;
+    deguidify(getCurrentPD(), graphGuid, (u64*)&graph, &kind);
+    return (kind == OCR_GUID_GRAPH) ? graph : NULL;
+}
+
+// Returns the graph EDT 'guid' refers to if it belongs to 'graph'
+static ocrGraphHcTask_t * getGraphTask(ocrGraphHc_t * graph, ocrGuid_t guid) {
+    if (isEdtGuid(guid)) {
+        ocrTask_t * task = NULL;
+        deguidify(getCurrentPD(), guid, (u64*)&task, NULL);
+        if ((task->fctPtrs == &graphTaskFcts) && (((ocrGraphHcTask_t *) task)->graph == graph)) {
+            return (ocrGraphHcTask_t *) task;
+        }
+    }
+    return NULL;
+}
+
+// Returns the graph event 'guid' refers to if it belongs to 'graph'
+static ocrGraphHcEvent_t * getGraphEvent(ocrGraphHc_t * graph, ocrGuid_t guid) {
+    if (isEventGuidOfKind(guid, OCR_EVENT_GRAPH_T)) {
+        ocrGraphHcEvent_t * event = NULL;
+        deguidify(getCurrentPD(), guid, (u64*)&event, NULL);
+        if (event->graph == graph) {
+            return event;
+        }
+    }
+    return NULL;
+}
+
+static void releaseGuid(ocrGuid_t guid) {
+    ocrPolicyDomain_t *pd = getCurrentPD();
+    ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->type = PD_MSG_GUID_REL;
+    pd->inform(pd, guid, ctx);
+    ctx->destruct(ctx);
+}
+
+// Returns the input index of a data-block, registering it on first use
+static u32 graphInput(ocrGraphHc_t * graph, ocrGuid_t dbGuid) {
+    u32 i = 0;
+    for ( ; i < graph->nbInputs; ++i) {
+        if (graph->inputs[i] == dbGuid) {
+            return i;
+        }
+    }
+    if (graph->nbInputs == graph->maxInputs) {
+        graph->maxInputs = (graph->maxInputs == 0) ? 4 : graph->maxInputs*2;
+        graph->inputs = (ocrGuid_t *) realloc(graph->inputs, sizeof(ocrGuid_t)*graph->maxInputs);
+        ASSERT(graph->inputs != NULL);
+    }
+    graph->inputs[graph->nbInputs] = dbGuid;
+    return graph->nbInputs++;
+}
+
+/******************************************************/
+/* OCR-HC Graph Replay                                */
+/******************************************************/
+
+static void graphComplete(ocrGraphHc_t * graph) {
+    ocrGuid_t completionEvent = graph->completionEvent;
+    DPRINTF(DEBUG_LVL_INFO, "Graph 0x%lx replay done\n", graph->guid);
+    // The graph can be replayed or destroyed as soon as its state is reset
+    graph->state = GRAPH_READY;
+    if (completionEvent != NULL_GUID) {
+        ocrEvent_t * event = NULL;
+        deguidify(getCurrentPD(), completionEvent, (u64*)&event, NULL);
+        event->fctPtrs->satisfy(event, NULL_GUID, 0);
+    }
+}
+
+// Orders the slots of a graph EDT by data-block GUID and, for the same
+// data-block, the most exclusive access mode first
+static void graphTaskSortSlots(ocrGraphHcTask_t * self) {
+    ocrEdtDep_t * depv = self->depv;
+    ocrDbAccessMode_t * modes = self->modes;
+    u32 * order = self->order;
+    u32 i;
+    for (i = 1; i < self->base.depc; ++i) {
+        u32 slot = order[i];
+        u32 j = i;
+        while ((j > 0) && ((depv[order[j-1]].guid > depv[slot].guid) ||
+                           ((depv[order[j-1]].guid == depv[slot].guid) && (modes[order[j-1]] < modes[slot])))) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = slot;
+    }
+}
+
+static void graphTaskDbGranted(ocrGuid_t edtGuid, void * ptr);
+
+/**
+ * @brief Acquires the data-blocks of a graph EDT in the access mode each
+ * slot was recorded with, in GUID order as EDTs do.
+ *
+ * Returns false if an access is queued: graphTaskDbGranted then resumes
+ * the acquisition and schedules the EDT.
+ */
+static bool graphTaskAcquireDbs(ocrGraphHcTask_t * self) {
+    ocrEdtDep_t * depv = self->depv;
+    u32 * order = self->order;
+    while (self->acquired < self->base.depc) {
+        u32 i = self->acquired;
+        ocrEdtDep_t * dep = &(depv[order[i]]);
+        if (dep->guid == NULL_GUID) {
+            dep->ptr = NULL;
+        } else if ((i != 0) && (depv[order[i-1]].guid == dep->guid)) {
+            // Same data-block on several slots, already acquired
+            dep->ptr = depv[order[i-1]].ptr;
+        } else {
+            ASSERT(isDatablockGuid(dep->guid));
+            ocrDataBlock_t * db = NULL;
+            deguidify(getCurrentPD(), dep->guid, (u64*)&db, NULL);
+            u8 status = db->fctPtrs->acquireMode(db, self->base.guid, self->modes[order[i]],
+                                                 &graphTaskDbGranted);
+            if (status == EBUSY) {
+                return false;
+            }
+            if (status == 0) {
+                ocrDbAdvise(db);
+            }
+            dep->ptr = (status == 0) ? db->ptr : NULL;
+        }
+        self->acquired++;
+    }
+    return true;
+}
+
+// Called by a data-block when it grants a queued access
+static void graphTaskDbGranted(ocrGuid_t edtGuid, void * ptr) {
+    ocrGraphHcTask_t * self = NULL;
+    deguidify(getCurrentPD(), edtGuid, (u64*)&self, NULL);
+    self->depv[self->order[self->acquired]].ptr = ptr;
+    self->acquired++;
+    if (graphTaskAcquireDbs(self)) {
+        graphTaskSchedule((ocrTask_t *) self);
+    }
+}
+
+// Starts acquiring the data-blocks of a graph EDT whose dependences
+// are all satisfied. Returns true if the EDT can be scheduled.
+static bool graphTaskReady(ocrGraphHcTask_t * self) {
+    self->acquired = 0;
+    graphTaskSortSlots(self);
+    return graphTaskAcquireDbs(self);
+}
+
+static void graphTaskSignaled(ocrGraphHcTask_t * self, ocrGuid_t data, u32 slot) {
+    self->depv[slot].guid = data;
+    if ((__sync_sub_and_fetch(&(self->pending), 1) == 0) && graphTaskReady(self)) {
+        graphTaskSchedule((ocrTask_t *) self);
+    }
+}
+
+static void graphEventSignaled(ocrGraphHcEvent_t * self, ocrGuid_t data) {
+    // Graph events are sticky for the duration of a replay
+    ASSERT(self->data == UNINITIALIZED_DATA);
+    self->data = data;
+    u32 i = 0;
+    for ( ; i < self->nbSuccessors; ++i) {
+        ocrGraphHcEdge_t * edge = &(self->successors[i]);
+        if (edge->isTask) {
+            graphTaskSignaled((ocrGraphHcTask_t *) edge->target, data, edge->slot);
+        } else {
+            graphEventSignaled((ocrGraphHcEvent_t *) edge->target, data);
+        }
+    }
+}
+
+static void graphTaskSchedule(ocrTask_t * base) {
+    DPRINTF(DEBUG_LVL_INFO, "Schedule graph EDT 0x%lx\n", base->guid);
+    ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
+    ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+    ctx->destPD = orgCtx->sourcePD;
+    ctx->destObj = NULL_GUID;
+    ctx->type = PD_MSG_EDT_READY;
+    orgCtx->PD->giveEdt(orgCtx->PD, 1, &(base->guid), ctx);
+    ctx->destruct(ctx);
+}
+
+// The data-blocks have been acquired when the EDT became ready
+static void graphTaskPrefetch(ocrTask_t * base, u32 lines, u32 pages, u64 pageSize) {
+    ocrGraphHcTask_t * self = (ocrGraphHcTask_t *) base;
+    ocrEdtDep_t * depv = self->depv;
+    u32 * order = self->order;
+    u32 i;
+    for (i = 0; i < base->depc; ++i) {
+        ocrEdtDep_t * dep = &(depv[order[i]]);
+        if ((dep->ptr == NULL) || ((i != 0) && (depv[order[i-1]].guid == dep->guid))) {
+            continue;
+        }
+        taskPrefetchDb(dep, self->modes[order[i]], lines, pages, pageSize);
+    }
+}
+
+static void graphTaskExecute(ocrTask_t * base) {
+    DPRINTF(DEBUG_LVL_INFO, "Execute graph EDT 0x%lx\n", base->guid);
+    ocrGraphHcTask_t * self = (ocrGraphHcTask_t *) base;
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    ocrEdtDep_t * depv = self->depv;
+    u32 * order = self->order;
+    u64 depc = base->depc;
+    // The data-blocks have been acquired when the EDT became ready,
+    // make them resident
+    u64 i = 0;
+    for ( ; i < depc; ++i) {
+        ocrEdtDep_t * dep = &(depv[order[i]]);
+        if (dep->ptr == NULL) {
+            continue;
+        }
+        if ((i != 0) && (depv[order[i-1]].guid == dep->guid)) {
+            dep->ptr = depv[order[i-1]].ptr;
+            continue;
+        }
+        ocrDataBlock_t * db = NULL;
+        deguidify(pd, dep->guid, (u64*)&db, NULL);
+        dep->ptr = ocrDbPin(db, base->guid, true);
+        if (dep->ptr == NULL) {
+            RESULT_ASSERT(db->fctPtrs->release(db, base->guid, true), ==, 0);
+        }
+    }
+
+    ocrTaskTemplate_t * taskTemplate;
+    deguidify(pd, base->templateGuid, (u64*)&taskTemplate, NULL);
+    ocrGuid_t retGuid = taskTemplate->executePtr(base->paramc, base->paramv,
+                                                 depc, depv);
+
+    for (i = 0; i < depc; ++i) {
+        ocrEdtDep_t * dep = &(depv[order[i]]);
+        // Skip failed acquires and data-blocks already released
+        if ((dep->ptr != NULL) && ((i == 0) || (depv[order[i-1]].guid != dep->guid))) {
+            ocrDataBlock_t * db = NULL;
+            deguidify(pd, dep->guid, (u64*)&db, NULL);
+            ocrDbUnpin(db, base->guid, true);
+            RESULT_ASSERT(db->fctPtrs->release(db, base->guid, true), ==, 0);
+        }
+    }
+    if (self->output != NULL) {
+        graphEventSignaled(self->output, retGuid);
+    }
+}
+
+// Called by the worker once the EDT has executed. Graph EDTs stay
+// allocated, this only accounts for the EDT completion in the replay.
+// This is done here rather than at the end of execute so that the
+// graph cannot be destroyed while the worker still refers to the EDT.
+static void graphTaskDestruct(ocrTask_t * base) {
+    ocrGraphHc_t * graph = ((ocrGraphHcTask_t *) base)->graph;
+    if (__sync_sub_and_fetch(&(graph->remaining), 1) == 0) {
+        graphComplete(graph);
+    }
+}
+
+// Graph events are deallocated with their graph
+static void graphEventDestruct(ocrEvent_t * base) {
+}
+
+static ocrGuid_t graphEventGet(ocrEvent_t * base, u32 slot) {
+    ocrGraphHcEvent_t * self = (ocrGraphHcEvent_t *) base;
+    return (self->data == UNINITIALIZED_DATA) ? ERROR_GUID : self->data;
+}
+
+static void graphEventSatisfy(ocrEvent_t * base, ocrGuid_t data, u32 slot) {
+    ocrGraphHcEvent_t * self = (ocrGraphHcEvent_t *) base;
+    if (self->graph->state == GRAPH_CAPTURING) {
+        // Satisfied while recording: replayed when each replay starts
+        ASSERT(self->source == GRAPH_SOURCE_NONE);
+        self->source = (data == NULL_GUID) ? GRAPH_SOURCE_NULL : graphInput(self->graph, data);
+    } else {
+        ASSERT(self->graph->state == GRAPH_RUNNING);
+        graphEventSignaled(self, data);
+    }
+}
+
+u8 graphReplay(ocrGuid_t graphGuid, u32 paramc, u64 *paramv, u32 depc,
+               ocrGuid_t *depv, ocrGuid_t completionEvent) {
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    if ((graph == NULL) || ((paramc != 0) && (paramc != graph->paramc))) {
+        return EINVAL;
+    }
+    if (!__sync_bool_compare_and_swap(&(graph->state), GRAPH_READY, GRAPH_RUNNING)) {
+        return EPERM;
+    }
+    if ((depc != 0) && (depc != graph->nbInputs)) {
+        graph->state = GRAPH_READY;
+        return EINVAL;
+    }
+    DPRINTF(DEBUG_LVL_INFO, "Graph 0x%lx replay\n", graphGuid);
+    u32 i;
+    for (i = 0; i < graph->nbInputs; ++i) {
+        graph->bindings[i] = (depc != 0) ? depv[i] : graph->inputs[i];
+    }
+    // Re-arm the EDTs: all the bookkeeping has been sized when recording
+    ocrGraphHcTask_t * task = graph->tasks;
+    while (task != NULL) {
+        ocrTask_t * base = (ocrTask_t *) task;
+        task->pending = task->nbEventSources;
+        if (paramc != 0) {
+            memcpy(base->paramv, paramv, sizeof(u64)*paramc);
+        }
+        for (i = 0; i < base->depc; ++i) {
+            u32 source = task->sources[i];
+            if (source == GRAPH_SOURCE_NULL) {
+                task->depv[i].guid = NULL_GUID;
+            } else if (source != GRAPH_SOURCE_EVENT) {
+                task->depv[i].guid = graph->bindings[source];
+            }
+        }
+        task = task->next;
+    }
+    ocrGraphHcEvent_t * event = graph->events;
+    while (event != NULL) {
+        event->data = UNINITIALIZED_DATA;
+        event = event->next;
+    }
+    graph->completionEvent = completionEvent;
+    // Hold the replay until all the sources have been fired
+    graph->remaining = graph->nbTasks + 1;
+
+    for (i = 0; i < graph->nbInitialEvents; ++i) {
+        event = graph->initialEvents[i];
+        graphEventSignaled(event, (event->source == GRAPH_SOURCE_NULL) ?
+                           NULL_GUID : graph->bindings[event->source]);
+    }
+    // Roots waiting for a data-block are scheduled when it is granted
+    u32 nbReady = 0;
+    for (i = 0; i < graph->nbRoots; ++i) {
+        if (graphTaskReady(graph->roots[i])) {
+            graph->readyRoots[nbReady++] = graph->roots[i]->base.guid;
+        }
+    }
+    if (nbReady != 0) {
+        ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
+        ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
+        ctx->destPD = orgCtx->sourcePD;
+        ctx->destObj = NULL_GUID;
+        ctx->type = PD_MSG_EDT_READY;
+        orgCtx->PD->giveEdt(orgCtx->PD, nbReady, graph->readyRoots, ctx);
+        ctx->destruct(ctx);
+    }
+    if (__sync_sub_and_fetch(&(graph->remaining), 1) == 0) {
+        graphComplete(graph);
+    }
+    return 0;
+}
+
+/******************************************************/
+/* OCR-HC Graph Capture                               */
+/******************************************************/
+
+ocrGuid_t graphCurrentCapture() {
+    ocrTask_t * task = getCurrentTask();
+    return (task != NULL) ? task->els[ELS_SLOT_GRAPH] : NULL_GUID;
+}
+
+u8 graphBegin(ocrGuid_t *graphGuid, u32 paramc) {
+    ocrTask_t * task = getCurrentTask();
+    if ((task == NULL) || (task->els[ELS_SLOT_GRAPH] != NULL_GUID)) {
+        return EINVAL;
+    }
+    ocrGraphHc_t * graph = (ocrGraphHc_t *) checkedMalloc(graph, sizeof(ocrGraphHc_t));
+    graph->guid = UNINITIALIZED_GUID;
+    guidify(getCurrentPD(), (u64)graph, &(graph->guid), OCR_GUID_GRAPH);
+    graph->ownerGuid = task->guid;
+    graph->state = GRAPH_CAPTURING;
+    graph->paramc = paramc;
+    graph->tasks = NULL;
+    graph->events = NULL;
+    graph->nbTasks = 0;
+    graph->roots = NULL;
+    graph->readyRoots = NULL;
+    graph->nbRoots = 0;
+    graph->initialEvents = NULL;
+    graph->nbInitialEvents = 0;
+    graph->inputs = NULL;
+    graph->bindings = NULL;
+    graph->nbInputs = 0;
+    graph->maxInputs = 0;
+    graph->remaining = 0;
+    graph->completionEvent = NULL_GUID;
+    task->els[ELS_SLOT_GRAPH] = graph->guid;
+    DPRINTF(DEBUG_LVL_INFO, "Graph 0x%lx capture begins in 0x%lx\n", graph->guid, task->guid);
+    *graphGuid = graph->guid;
+    return 0;
+}
+
+u8 graphEnd(ocrGuid_t graphGuid) {
+    ocrTask_t * task = getCurrentTask();
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    if ((graph == NULL) || (task == NULL) || (task->els[ELS_SLOT_GRAPH] != graphGuid)) {
+        return EINVAL;
+    }
+    // Every slot must have a source and the roots are the EDTs
+    // that do not wait on any event of the graph. The counts are only
+    // stored once the graph is valid so that the capture can go on
+    u32 nbRoots = 0;
+    ocrGraphHcTask_t * gtask = graph->tasks;
+    while (gtask != NULL) {
+        u32 i = 0;
+        for ( ; i < gtask->base.depc; ++i) {
+            if (gtask->sources[i] == GRAPH_SOURCE_NONE) {
+                DPRINTF(DEBUG_LVL_WARN, "Graph EDT 0x%lx slot %d is not connected\n", gtask->base.guid, i);
+                return EINVAL;
+            }
+        }
+        if (gtask->nbEventSources == 0) {
+            nbRoots++;
+        }
+        gtask = gtask->next;
+    }
+    u32 nbInitialEvents = 0;
+    ocrGraphHcEvent_t * event = graph->events;
+    while (event != NULL) {
+        if (event->source != GRAPH_SOURCE_NONE) {
+            nbInitialEvents++;
+        }
+        event = event->next;
+    }
+    graph->nbRoots = nbRoots;
+    graph->nbInitialEvents = nbInitialEvents;
+    if (graph->nbRoots != 0) {
+        graph->roots = (ocrGraphHcTask_t **) checkedMalloc(graph->roots,
+                                                          sizeof(ocrGraphHcTask_t *)*graph->nbRoots);
+        graph->readyRoots = (ocrGuid_t *) checkedMalloc(graph->readyRoots, sizeof(ocrGuid_t)*graph->nbRoots);
+    }
+    if (graph->nbInitialEvents != 0) {
+        graph->initialEvents = (ocrGraphHcEvent_t **) checkedMalloc(graph->initialEvents,
+                                                     sizeof(ocrGraphHcEvent_t *)*graph->nbInitialEvents);
+    }
+    if (graph->nbInputs != 0) {
+        graph->bindings = (ocrGuid_t *) checkedMalloc(graph->bindings, sizeof(ocrGuid_t)*graph->nbInputs);
+    }
+    u32 count = 0;
+    for (gtask = graph->tasks; gtask != NULL; gtask = gtask->next) {
+        if (gtask->nbEventSources == 0) {
+            graph->roots[count++] = gtask;
+        }
+    }
+    count = 0;
+    for (event = graph->events; event != NULL; event = event->next) {
+        if (event->source != GRAPH_SOURCE_NONE) {
+            graph->initialEvents[count++] = event;
+        }
+    }
+    task->els[ELS_SLOT_GRAPH] = NULL_GUID;
+    DPRINTF(DEBUG_LVL_INFO, "Graph 0x%lx captured %d EDTs, %d roots, %d inputs\n",
+            graphGuid, graph->nbTasks, graph->nbRoots, graph->nbInputs);
+    graph->state = GRAPH_READY;
+    return 0;
+}
+
+static ocrGraphHcEvent_t * newGraphEvent(ocrGraphHc_t * graph) {
+    ocrGraphHcEvent_t * event = (ocrGraphHcEvent_t *) checkedMalloc(event, sizeof(ocrGraphHcEvent_t));
+    ocrEvent_t * base = (ocrEvent_t *) event;
+    base->guid = UNINITIALIZED_GUID;
+    guidify(getCurrentPD(), (u64)base, &(base->guid), OCR_GUID_EVENT);
+    base->kind = OCR_EVENT_GRAPH_T;
+    base->fctPtrs = &graphEventFcts;
+    event->graph = graph;
+    event->successors = NULL;
+    event->nbSuccessors = 0;
+    event->maxSuccessors = 0;
+    event->source = GRAPH_SOURCE_NONE;
+    event->data = UNINITIALIZED_DATA;
+    event->next = graph->events;
+    graph->events = event;
+    return event;
+}
+
+static void graphEventAddSuccessor(ocrGraphHcEvent_t * self, void * target, bool isTask, u32 slot) {
+    if (self->nbSuccessors == self->maxSuccessors) {
+        self->maxSuccessors = (self->maxSuccessors == 0) ? 2 : self->maxSuccessors*2;
+        self->successors = (ocrGraphHcEdge_t *) realloc(self->successors,
+                                                         sizeof(ocrGraphHcEdge_t)*self->maxSuccessors);
+        ASSERT(self->successors != NULL);
+    }
+    ocrGraphHcEdge_t * edge = &(self->successors[self->nbSuccessors++]);
+    edge->target = target;
+    edge->isTask = isTask;
+    edge->slot = slot;
+}
+
+u8 graphCaptureEdt(ocrGuid_t graphGuid, ocrGuid_t *edtGuid, ocrTaskTemplate_t *taskTemplate,
+                   u32 paramc, u64 *paramv, u32 depc, u16 properties,
+                   ocrGuid_t *outputEvent) {
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    ASSERT(graph != NULL);
+    // Finish scopes cannot be replayed without allocating a latch
+    if ((properties & EDT_PROP_FINISH) || (paramc < graph->paramc)) {
+        return EINVAL;
+    }
+    ocrGraphHcTask_t * task = (ocrGraphHcTask_t *) checkedMalloc(task, sizeof(ocrGraphHcTask_t));
+    ocrTask_t * base = (ocrTask_t *) task;
+    base->guid = UNINITIALIZED_GUID;
+    guidify(getCurrentPD(), (u64)base, &(base->guid), OCR_GUID_EDT);
+    base->templateGuid = taskTemplate->guid;
+    base->paramc = paramc;
+    if (paramc) {
+        base->paramv = checkedMalloc(base->paramv, sizeof(u64)*paramc);
+        memcpy(base->paramv, paramv, sizeof(u64)*paramc);
+    } else {
+        base->paramv = NULL;
+    }
+    base->depc = depc;
+    base->properties = properties;
+    base->addedDepCounter = NULL;
+    base->fctPtrs = &graphTaskFcts;
+    u32 i = 0;
+    while (i < ELS_SIZE) {
+        base->els[i++] = NULL_GUID;
+    }
+    task->graph = graph;
+    task->sources = NULL;
+    task->modes = NULL;
+    task->depv = NULL;
+    task->order = NULL;
+    if (depc != 0) {
+        task->sources = (u32 *) checkedMalloc(task->sources, sizeof(u32)*depc);
+        task->modes = (ocrDbAccessMode_t *) checkedMalloc(task->modes, sizeof(ocrDbAccessMode_t)*depc);
+        task->depv = (ocrEdtDep_t *) checkedMalloc(task->depv, sizeof(ocrEdtDep_t)*depc);
+        task->order = (u32 *) checkedMalloc(task->order, sizeof(u32)*depc);
+        for (i = 0; i < depc; ++i) {
+            task->sources[i] = GRAPH_SOURCE_NONE;
+            task->modes[i] = DB_DEFAULT_MODE;
+            task->order[i] = i;
+        }
+    }
+    task->acquired = 0;
+    task->nbEventSources = 0;
+    task->pending = 0;
+    task->output = NULL;
+    base->outputEvent = NULL_GUID;
+    if (outputEvent != NULL) {
+        task->output = newGraphEvent(graph);
+        base->outputEvent = task->output->base.guid;
+        *outputEvent = base->outputEvent;
+    }
+    task->next = graph->tasks;
+    graph->tasks = task;
+    graph->nbTasks++;
+    DPRINTF(DEBUG_LVL_INFO, "Graph 0x%lx records EDT 0x%lx depc %d\n", graphGuid, base->guid, depc);
+    *edtGuid = base->guid;
+    return 0;
+}
+
+u8 graphCaptureEvent(ocrGuid_t graphGuid, ocrGuid_t *eventGuid, ocrEventTypes_t eventType) {
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    ASSERT(graph != NULL);
+    if (eventType == OCR_EVENT_LATCH_T) {
+        return EINVAL;
+    }
+    ocrGraphHcEvent_t * event = newGraphEvent(graph);
+    *eventGuid = event->base.guid;
+    return 0;
+}
+
+u8 graphCaptureDependence(ocrGuid_t graphGuid, ocrGuid_t source, ocrGuid_t destination, u32 slot,
+                          ocrDbAccessMode_t mode) {
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    ASSERT(graph != NULL);
+    u32 from;
+    ocrGraphHcEvent_t * sourceEvent = NULL;
+    if (source == NULL_GUID) {
+        from = GRAPH_SOURCE_NULL;
+    } else if (isDatablockGuid(source)) {
+        from = graphInput(graph, source);
+    } else if ((sourceEvent = getGraphEvent(graph, source)) != NULL) {
+        from = GRAPH_SOURCE_EVENT;
+    } else {
+        return EINVAL;
+    }
+
+    ocrGraphHcTask_t * task = getGraphTask(graph, destination);
+    if (task != NULL) {
+        if ((slot >= task->base.depc) || (task->sources[slot] != GRAPH_SOURCE_NONE)) {
+            return EINVAL;
+        }
+        task->sources[slot] = from;
+        task->modes[slot] = mode;
+        if (sourceEvent != NULL) {
+            graphEventAddSuccessor(sourceEvent, task, true, slot);
+            task->nbEventSources++;
+        }
+        return 0;
+    }
+    ocrGraphHcEvent_t * event = getGraphEvent(graph, destination);
+    if (event != NULL) {
+        if (sourceEvent != NULL) {
+            graphEventAddSuccessor(sourceEvent, event, false, 0);
+        } else {
+            if (event->source != GRAPH_SOURCE_NONE) {
+                return EINVAL;
+            }
+            event->source = from;
+        }
+        return 0;
+    }
+    return EINVAL;
+}
+
+/******************************************************/
+/* OCR-HC Graph Destruction                           */
+/******************************************************/
+
+u8 graphDestroy(ocrGuid_t graphGuid) {
+    ocrGraphHc_t * graph = getGraph(graphGuid);
+    if (graph == NULL) {
+        return EINVAL;
+    }
+    if (graph->state == GRAPH_RUNNING) {
+        return EPERM;
+    }
+    if (graph->state == GRAPH_CAPTURING) {
+        ocrTask_t * owner = getCurrentTask();
+        if ((owner == NULL) || (owner->guid != graph->ownerGuid)) {
+            return EPERM;
+        }
+        owner->els[ELS_SLOT_GRAPH] = NULL_GUID;
+    }
+    DPRINTF(DEBUG_LVL_INFO, "Destroy graph 0x%lx\n", graphGuid);
+    ocrGraphHcTask_t * task = graph->tasks;
+    while (task != NULL) {
+        ocrGraphHcTask_t * next = task->next;
+        releaseGuid(task->base.guid);
+        if (task->base.paramv != NULL) {
+            free(task->base.paramv);
+        }
+        if (task->sources != NULL) {
+            free(task->sources);
+            free(task->modes);
+            free(task->depv);
+            free(task->order);
+        }
+        free(task);
+        task = next;
+    }
+    ocrGraphHcEvent_t * event = graph->events;
+    while (event != NULL) {
+        ocrGraphHcEvent_t * next = event->next;
+        releaseGuid(event->base.guid);
+        if (event->successors != NULL) {
+            free(event->successors);
+        }
+        free(event);
+        event = next;
+    }
+    if (graph->roots != NULL) {
+        free(graph->roots);
+        free(graph->readyRoots);
+    }
+    if (graph->initialEvents != NULL) {
+        free(graph->initialEvents);
+    }
+    if (graph->inputs != NULL) {
+        free(graph->inputs);
+    }
+    if (graph->bindings != NULL) {
+        free(graph->bindings);
+    }
+    releaseGuid(graph->guid);
+    free(graph);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+
+#ifndef __HC_GRAPH_H__
+#define __HC_GRAPH_H__
+
+#include "ocr-edt.h"
+#include "ocr-event.h"
+#include "ocr-task.h"
+#include "ocr-types.h"
+
+// Source of a dependence slot of a graph EDT or of the initial
+// satisfaction of a graph event. Other values index the graph's inputs.
+#define GRAPH_SOURCE_NONE  ((u32)-1) /**< Not connected */
+#define GRAPH_SOURCE_NULL  ((u32)-2) /**< NULL_GUID */
+#define GRAPH_SOURCE_EVENT ((u32)-3) /**< Signaled by an event of the graph */
+
+struct _ocrGraphHc_t;
+
+/*! \brief Successor of a graph event: either a slot of a graph EDT or
+ *  another graph event to forward the satisfaction to
+ */
+typedef struct {
+    void * target;
+    bool isTask;
+    u32 slot;
+} ocrGraphHcEdge_t;
+
+/*! \brief EDT recorded in a task graph
+ *
+ *  Graph EDTs are never freed by the worker that executes them: they are
+ *  re-armed at each replay and deallocated with the graph.
+ */
+typedef struct _ocrGraphHcTask_t {
+    ocrTask_t base;
+    struct _ocrGraphHc_t * graph;
+    u32 * sources;             /**< Where each slot gets its data from */
+    ocrDbAccessMode_t * modes; /**< Access mode of each slot */
+    ocrEdtDep_t * depv;        /**< Preallocated dependences, filled on replay */
+    u32 * order;               /**< Slots by data-block GUID, sorted on replay */
+    u32 acquired;              /**< Entries of order acquired in the current replay */
+    u32 nbEventSources;        /**< Number of slots signaled by graph events */
+    volatile u32 pending;      /**< Signals still expected in the current replay */
+    struct _ocrGraphHcEvent_t * output;
+    struct _ocrGraphHcTask_t * next;
+} ocrGraphHcTask_t;
+
+/*! \brief Event recorded in a task graph
+ *
+ *  Graph events behave as sticky events that are reset at each replay.
+ *  Their successors are resolved when the graph is recorded.
+ */
+typedef struct _ocrGraphHcEvent_t {
+    ocrEvent_t base;
+    struct _ocrGraphHc_t * graph;
+    ocrGraphHcEdge_t * successors;
+    u32 nbSuccessors;
+    u32 maxSuccessors;
+    u32 source;                /**< Satisfaction performed when the replay starts */
+    volatile ocrGuid_t data;
+    struct _ocrGraphHcEvent_t * next;
+} ocrGraphHcEvent_t;
+
+typedef enum {
+    GRAPH_CAPTURING,
+    GRAPH_READY,
+    GRAPH_RUNNING
+} ocrGraphHcState_t;
+
+/*! \brief A recorded DAG of EDTs and events
+ */
+typedef struct _ocrGraphHc_t {
+    ocrGuid_t guid;
+    ocrGuid_t ownerGuid;       /**< EDT recording the graph */
+    volatile ocrGraphHcState_t state;
+    u32 paramc;                /**< Leading EDT parameters replaced on replay */
+    ocrGraphHcTask_t * tasks;
+    ocrGraphHcEvent_t * events;
+    u32 nbTasks;
+    // Computed when the capture ends
+    ocrGraphHcTask_t ** roots; /**< EDTs without any event source */
+    ocrGuid_t * readyRoots;    /**< Roots holding their data-blocks, on replay */
+    u32 nbRoots;
+    ocrGraphHcEvent_t ** initialEvents; /**< Events satisfied when the replay starts */
+    u32 nbInitialEvents;
+    // Data-blocks recorded as sources and their replay bindings
+    ocrGuid_t * inputs;
+    ocrGuid_t * bindings;
+    u32 nbInputs;
+    u32 maxInputs;
+    volatile u32 remaining;    /**< EDTs still to complete in the current replay, plus one
+                                    while the replay is being started */
+    ocrGuid_t completionEvent;
+} ocrGraphHc_t;
+
+#endif /* __HC_GRAPH_H__ */
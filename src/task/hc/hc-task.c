@@ -4,6 +4,7 @@
  * removed or modified.
  */
 
+#include "allocator/meta/meta-allocator.h"
 #include "debug.h"
 #include "event/hc/hc-event.h"
 #include "ocr-datablock.h"
@@ -20,18 +21,22 @@
 #include "ocr-statistics.h"
 #endif
 
+#include <errno.h>
 #include <string.h>
 
 #define SEALED_LIST ((void *) -1)
 #define END_OF_LIST NULL
 #define UNINITIALIZED_DATA ((ocrGuid_t) -2)
 
+// Granularity of data-block prefetches
+#define HC_TASK_CACHE_LINE 64
+
 #define DEBUG_TYPE TASK
 
 //
 // Convenience functions to get the EDT and deguidify it
 //
-static inline ocrTask_t * getCurrentTask() {
+ocrTask_t * getCurrentTask() {
     ocrGuid_t edtGuid = getCurrentEDT();
     // the bootstrap process launching mainEdt returns NULL_GUID for the current EDT
     if (edtGuid != NULL_GUID) {
@@ -67,12 +72,15 @@ static bool hasProperty(u16 properties, u16 property) {
 
 void signalWaiter(ocrGuid_t waiterGuid, ocrGuid_t data, int slot);
 
-void registerSignaler(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot);
+void registerSignaler(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot,
+                      ocrDbAccessMode_t mode);
 
 void registerWaiter(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot);
 
 static inline void taskSchedule(ocrGuid_t taskGuid);
 
+static void taskAcquireDbs(ocrTask_t * base);
+
 // Internal signal/wait notification
 // Signal a sticky event some data arrived (on its unique slot)
 static void singleEventSignaled(ocrEvent_t * self, ocrGuid_t data, int slot) {
@@ -128,14 +136,17 @@ static bool isFinishLatchOwner(ocrEvent_t * finishLatch, ocrGuid_t edtGuid) {
 
 static void newTaskHcInternalCommon (ocrPolicyDomain_t * pd, ocrTaskHc_t* derived,
                                      ocrTaskTemplate_t * taskTemplate, u32 paramc,
-                                     u64* paramv, u32 depc, ocrGuid_t outputEvent) {
+                                     u64* paramv, u32 depc, u16 properties,
+                                     ocrGuid_t outputEvent) {
     if (depc == 0) {
         derived->signalers = END_OF_LIST;
     } else {
         // Since we know how many dependences we have, preallocate signalers
-        derived->signalers = checkedMalloc(derived->signalers, sizeof(regNode_t)*depc);
+        derived->signalers = metaMalloc(sizeof(regNode_t)*depc);
     }
     derived->waiters = END_OF_LIST;
+    derived->depv = NULL;
+    derived->acquired = 0;
     // Initialize base
     ocrTask_t* base = (ocrTask_t*) derived;
     base->guid = UNINITIALIZED_GUID;
@@ -143,13 +154,14 @@ static void newTaskHcInternalCommon (ocrPolicyDomain_t * pd, ocrTaskHc_t* derive
     base->templateGuid = taskTemplate->guid;
     base->paramc = paramc;
     if(paramc) {
-        base->paramv = checkedMalloc(base->paramv, sizeof(u64)*base->paramc);
+        base->paramv = metaMalloc(sizeof(u64)*base->paramc);
         memcpy(base->paramv, paramv, sizeof(u64)*base->paramc);
     } else {
         base->paramv = NULL;
     }
     base->outputEvent = outputEvent;
     base->depc = depc;
+    base->properties = properties;
     base->addedDepCounter = pd->getAtomic64(pd, NULL /*Context*/);
     // Initialize ELS
     int i = 0;
@@ -162,8 +174,8 @@ static ocrTaskHc_t* newTaskHcInternal (ocrTaskFactory_t* factory, ocrPolicyDomai
                                        ocrTaskTemplate_t * taskTemplate, u32 paramc,
                                        u64* paramv, u32 depc, u16 properties,
                                        ocrGuid_t affinity, ocrGuid_t outputEvent) {
-    ocrTaskHc_t* newEdt = (ocrTaskHc_t*)checkedMalloc(newEdt, sizeof(ocrTaskHc_t));
-    newTaskHcInternalCommon(pd, newEdt, taskTemplate, paramc, paramv, depc, outputEvent);
+    ocrTaskHc_t* newEdt = (ocrTaskHc_t*)metaMalloc(sizeof(ocrTaskHc_t));
+    newTaskHcInternalCommon(pd, newEdt, taskTemplate, paramc, paramv, depc, properties, outputEvent);
     ocrTask_t * newEdtBase = (ocrTask_t *) newEdt;
     // If we are creating a finish-edt
     if (hasProperty(properties, EDT_PROP_FINISH)) {
@@ -229,7 +241,7 @@ static void destructTaskHc ( ocrTask_t* base ) {
     pd->inform(pd, base->guid, ctx);
     base->addedDepCounter->fctPtrs->destruct(base->addedDepCounter);
     ctx->destruct(ctx);
-    free(derived);
+    metaFree(derived);
 }
 
 // Signals an edt one of its dependence slot is satisfied
@@ -259,8 +271,9 @@ static void taskSignaled(ocrTask_t * base, ocrGuid_t data, u32 slot) {
     // and crucial for once-event since they are being destroyed on satisfy.
     self->signalers[slot].guid = data;
     if (slot == (base->depc-1)) {
-        // All dependencies have been satisfied, schedule the edt
-        taskSchedule(base->guid);
+        // All dependencies have been satisfied, schedule
+        // the edt once it has acquired its data-blocks
+        taskAcquireDbs(base);
     } else {
         // else register the edt on the next event to wait on
         slot++;
@@ -270,7 +283,8 @@ static void taskSignaled(ocrTask_t * base, ocrGuid_t data, u32 slot) {
 }
 
 //Registers an entity that will signal on one of the edt's slot.
-static void edtRegisterSignaler(ocrTask_t * base, ocrGuid_t signalerGuid, int slot) {
+static void edtRegisterSignaler(ocrTask_t * base, ocrGuid_t signalerGuid, int slot,
+                                ocrDbAccessMode_t mode) {
     // Only support event signals
     ASSERT((signalerGuid == NULL_GUID) || isEventGuid(signalerGuid) || isDatablockGuid(signalerGuid));
     //DESIGN would be nice to pre-allocate all of this since we know the edt
@@ -281,6 +295,15 @@ static void edtRegisterSignaler(ocrTask_t * base, ocrGuid_t signalerGuid, int sl
     regNode_t * node = &(self->signalers[slot]);
     node->guid = signalerGuid;
     node->slot = slot;
+    node->mode = mode;
+    // Data-blocks EDTs wait for are evicted last. Data-blocks given
+    // through events are only known once they are acquired
+    node->pending = isDatablockGuid(signalerGuid);
+    if (node->pending) {
+        ocrDataBlock_t * db = NULL;
+        deguidify(getCurrentPD(), signalerGuid, (u64*)&db, NULL);
+        ocrDbPending(db, 1);
+    }
     // No need to chain nodes here, will use index
     node->next = NULL;
     DPRINTF(DEBUG_LVL_INFO, "AddDependence from 0x%lx to 0x%lx slot %d\n", signalerGuid, base->guid, slot);
@@ -334,6 +357,173 @@ static void tryScheduleTask( ocrTask_t* base ) {
     }
 }
 
+// Orders the data-blocks of an EDT by GUID and, for the same
+// data-block, the most exclusive access mode first
+static void taskSortSignalers(regNode_t * signalers, u32 depc) {
+    u32 i;
+    for (i = 1; i < depc; ++i) {
+        regNode_t node = signalers[i];
+        u32 j = i;
+        while ((j > 0) && ((signalers[j-1].guid > node.guid) ||
+                           ((signalers[j-1].guid == node.guid) && (signalers[j-1].mode < node.mode)))) {
+            signalers[j] = signalers[j-1];
+            j--;
+        }
+        signalers[j] = node;
+    }
+}
+
+// Called by a data-block when it grants a queued access
+static void taskDbGranted(ocrGuid_t edtGuid, void * ptr) {
+    ocrTask_t * base = NULL;
+    deguidify(getCurrentPD(), edtGuid, (u64*)&base, NULL);
+    ocrTaskHc_t * derived = (ocrTaskHc_t *) base;
+    regNode_t * node = &(derived->signalers[derived->acquired]);
+    derived->depv[node->slot].ptr = ptr;
+    derived->acquired++;
+    taskAcquireDbs(base);
+}
+
+/**
+ * @brief Acquires the data-blocks of an EDT whose dependences are all
+ * satisfied, in the access mode of each dependence, and schedules the
+ * EDT once it holds all of them.
+ *
+ * An EDT waiting for an access does not occupy a worker: the data-block
+ * resumes the acquisition when it grants the access. Data-blocks are
+ * acquired in GUID order so that EDTs waiting for each other's exclusive
+ * accesses cannot deadlock.
+ */
+static void taskAcquireDbs(ocrTask_t * base) {
+    ocrTaskHc_t * derived = (ocrTaskHc_t *) base;
+    regNode_t * signalers = derived->signalers;
+    if (derived->depv == NULL) {
+        derived->depv = (ocrEdtDep_t *) metaMalloc(sizeof(ocrEdtDep_t) * base->depc);
+        taskSortSignalers(signalers, base->depc);
+    }
+    while (derived->acquired < base->depc) {
+        u32 i = derived->acquired;
+        ocrEdtDep_t * dep = &(derived->depv[signalers[i].slot]);
+        dep->guid = signalers[i].guid;
+        if (dep->guid == NULL_GUID) {
+            dep->ptr = NULL;
+        } else {
+            ASSERT(isDatablockGuid(dep->guid));
+            ocrDataBlock_t * db = NULL;
+            deguidify(getCurrentPD(), dep->guid, (u64*)&db, NULL);
+            if (signalers[i].pending) {
+                ocrDbPending(db, -1);
+            }
+            if ((i != 0) && (signalers[i-1].guid == dep->guid)) {
+                // Same data-block on several slots, already acquired
+                dep->ptr = derived->depv[signalers[i-1].slot].ptr;
+            } else {
+                // Copied for the log: the task may be gone once acquireMode returns
+                ocrGuid_t edtGuid = base->guid;
+#ifdef OCR_DEBUG
+                ocrGuid_t dbGuid = dep->guid;
+#endif
+                u8 status = db->fctPtrs->acquireMode(db, edtGuid, signalers[i].mode, &taskDbGranted);
+                if (status == EBUSY) {
+                    // taskDbGranted resumes the acquisition, possibly already
+                    // on another worker: 'derived' must not be accessed anymore
+                    DPRINTF(DEBUG_LVL_INFO, "0x%lx waits for DB 0x%lx\n", edtGuid, dbGuid);
+                    return;
+                }
+                if (status == 0) {
+                    ocrDbAdvise(db);
+                }
+                dep->ptr = (status == 0) ? db->ptr : NULL;
+            }
+        }
+        derived->acquired++;
+    }
+    taskSchedule(base->guid);
+}
+
+/**
+ * @brief Makes the data-blocks of an EDT about to run resident
+ *
+ * Data-blocks held by EDTs that are ready but not running yet may have
+ * been evicted: they are read back here and stay resident until the EDT
+ * releases them. A data-block that cannot be read back is released and
+ * the EDT sees a NULL pointer as for a failed acquire.
+ */
+static void taskPinDbs(ocrTask_t * base) {
+    ocrTaskHc_t * derived = (ocrTaskHc_t *) base;
+    regNode_t * signalers = derived->signalers;
+    ocrEdtDep_t * depv = derived->depv;
+    u32 i;
+    for (i = 0; i < base->depc; ++i) {
+        ocrEdtDep_t * dep = &(depv[signalers[i].slot]);
+        if (dep->ptr == NULL) {
+            continue;
+        }
+        if ((i != 0) && (signalers[i-1].guid == dep->guid)) {
+            dep->ptr = depv[signalers[i-1].slot].ptr;
+            continue;
+        }
+        ocrDataBlock_t * db = NULL;
+        deguidify(getCurrentPD(), dep->guid, (u64*)&db, NULL);
+        dep->ptr = ocrDbPin(db, base->guid, true);
+        if (dep->ptr == NULL) {
+            RESULT_ASSERT(db->fctPtrs->release(db, base->guid, true), ==, 0);
+        }
+    }
+}
+
+static inline void taskPrefetchLine(const char * ptr, bool write) {
+    // The access type must be a constant
+    if (write) {
+        __builtin_prefetch(ptr, 1, 3);
+    } else {
+        __builtin_prefetch(ptr, 0, 3);
+    }
+}
+
+/**
+ * @brief Starts loading an acquired data-block into the caches
+ *
+ * Touching one line per page also loads the TLB entries. Prefetches never
+ * fault: data-blocks evicted or freed in the meantime are harmless.
+ */
+void taskPrefetchDb(ocrEdtDep_t * dep, ocrDbAccessMode_t mode, u32 lines, u32 pages, u64 pageSize) {
+    ocrDataBlock_t * db = NULL;
+    deguidify(getCurrentPD(), dep->guid, (u64*)&db, NULL);
+    const char * ptr = (const char *) dep->ptr;
+    bool write = (mode != DB_MODE_RO);
+    u64 j;
+    for (j = 0; (j < lines) && (j*HC_TASK_CACHE_LINE < db->size); ++j) {
+        taskPrefetchLine(ptr + j*HC_TASK_CACHE_LINE, write);
+    }
+    for (j = (lines != 0) ? 1 : 0; (j < pages) && (j*pageSize < db->size); ++j) {
+        taskPrefetchLine(ptr + j*pageSize, write);
+    }
+}
+
+/**
+ * @brief Starts loading the data-blocks of a ready EDT into the caches
+ *
+ * Called when the EDT is queued so that the loads overlap with whatever
+ * the worker runs before it.
+ */
+static void taskPrefetchDbs(ocrTask_t * base, u32 lines, u32 pages, u64 pageSize) {
+    ocrTaskHc_t * derived = (ocrTaskHc_t *) base;
+    regNode_t * signalers = derived->signalers;
+    ocrEdtDep_t * depv = derived->depv;
+    if (depv == NULL) {
+        return;
+    }
+    u32 i;
+    for (i = 0; i < base->depc; ++i) {
+        ocrEdtDep_t * dep = &(depv[signalers[i].slot]);
+        if ((dep->ptr == NULL) || ((i != 0) && (signalers[i-1].guid == dep->guid))) {
+            continue;
+        }
+        taskPrefetchDb(dep, signalers[i].mode, lines, pages, pageSize);
+    }
+}
+
 static void taskExecute ( ocrTask_t* base ) {
     DPRINTF(DEBUG_LVL_INFO, "Execute 0x%lx\n", base->guid);
     ocrTaskHc_t* derived = (ocrTaskHc_t*)base;
@@ -343,31 +533,12 @@ static void taskExecute ( ocrTask_t* base ) {
     u64 * paramv = base->paramv;
     u64 depc = base->depc;
 
-    ocrEdtDep_t * depv = NULL;
-    // If any dependencies, acquire their data-blocks
+    // The data-blocks have been acquired when the EDT became ready
+    ocrEdtDep_t * depv = derived->depv;
+    // Double-check we're not rescheduling an already executed edt
+    ASSERT((depc == 0) || (derived->signalers != END_OF_LIST));
     if (depc != 0) {
-        u64 i = 0;
-        //TODO would be nice to resolve regNode into guids before
-        depv = (ocrEdtDep_t *) checkedMalloc(depv, sizeof(ocrEdtDep_t) * depc);
-        // Double-check we're not rescheduling an already executed edt
-        ASSERT(derived->signalers != END_OF_LIST);
-        while ( i < depc ) {
-            //TODO would be nice to standardize that on satisfy
-            regNode_t * regNode = &(derived->signalers[i]);
-            ocrGuid_t dbGuid = regNode->guid;
-            depv[i].guid = dbGuid;
-            if(dbGuid != NULL_GUID) {
-                ASSERT(isDatablockGuid(dbGuid));
-                ocrDataBlock_t * db = NULL;
-                deguidify(getCurrentPD(), dbGuid, (u64*)&db, NULL);
-                depv[i].ptr = db->fctPtrs->acquire(db, base->guid, true);
-            } else {
-                depv[i].ptr = NULL;
-            }
-            i++;
-        }
-        free(derived->signalers);
-        derived->signalers = END_OF_LIST;
+        taskPinDbs(base);
     }
 
     ocrTaskTemplate_t * taskTemplate;
@@ -378,18 +549,25 @@ static void taskExecute ( ocrTask_t* base ) {
 
     // edt user code is done, if any deps, release data-blocks
     if (depc != 0) {
+        regNode_t * signalers = derived->signalers;
         u64 i = 0;
         for(i=0; i<depc; ++i) {
-            if(depv[i].guid != NULL_GUID) {
+            ocrEdtDep_t * dep = &(depv[signalers[i].slot]);
+            // Skip failed acquires and data-blocks already released
+            if((dep->ptr != NULL) && ((i == 0) || (signalers[i-1].guid != dep->guid))) {
                 ocrDataBlock_t * db = NULL;
-                deguidify(getCurrentPD(), depv[i].guid, (u64*)&db, NULL);
+                deguidify(getCurrentPD(), dep->guid, (u64*)&db, NULL);
+                ocrDbUnpin(db, base->guid, true);
                 RESULT_ASSERT(db->fctPtrs->release(db, base->guid, true), ==, 0);
             }
         }
-        free(depv);
+        metaFree(signalers);
+        derived->signalers = END_OF_LIST;
+        metaFree(depv);
+        derived->depv = NULL;
     }
     if(paramv)
-        free(paramv); // Free the parameter array (we copied them in)
+        metaFree(paramv); // Free the parameter array (we copied them in)
     bool satisfyOutputEvent = (base->outputEvent != NULL_GUID);
     // check out from current finish scope
     ocrEvent_t * curLatch = getFinishLatch(base);
@@ -423,12 +601,12 @@ static void taskExecute ( ocrTask_t* base ) {
 /******************************************************/
 
 static void destructTaskTemplateHc(ocrTaskTemplate_t *self) {
-    free(self);
+    metaFree(self);
 }
 
 static ocrTaskTemplate_t * newTaskTemplateHc(ocrTaskTemplateFactory_t* factory,
                                       ocrEdt_t executePtr, u32 paramc, u32 depc, ocrParamList_t *perInstance) {
-    ocrTaskTemplateHc_t* template = (ocrTaskTemplateHc_t*) checkedMalloc(template, sizeof(ocrTaskTemplateHc_t));
+    ocrTaskTemplateHc_t* template = (ocrTaskTemplateHc_t*) metaMalloc(sizeof(ocrTaskTemplateHc_t));
     ocrTaskTemplate_t * base = (ocrTaskTemplate_t *) template;
     base->paramc = paramc;
     base->depc = depc;
@@ -497,6 +675,7 @@ ocrTaskFactory_t * newTaskFactoryHc(ocrParamList_t* perInstance) {
     base->taskFcts.destruct = destructTaskHc;
     base->taskFcts.execute = taskExecute;
     base->taskFcts.schedule = tryScheduleTask;
+    base->taskFcts.prefetch = taskPrefetchDbs;
     return base;
 }
 
@@ -512,7 +691,7 @@ static void awaitableEventRegisterWaiter(ocrEventHcAwaitable_t * self, ocrGuid_t
     // Try to insert 'waiter' at the beginning of the list
     regNode_t * curHead = (regNode_t *) self->waiters;
     if(curHead != SEALED_LIST) {
-        regNode_t * newHead = checkedMalloc(newHead, sizeof(regNode_t));
+        regNode_t * newHead = metaMalloc(sizeof(regNode_t));
         newHead->guid = waiter;
         newHead->slot = slot;
         newHead->next = (regNode_t *) curHead;
@@ -527,7 +706,7 @@ static void awaitableEventRegisterWaiter(ocrEventHcAwaitable_t * self, ocrGuid_t
         }
         //else list has been sealed by a concurrent satisfy
         //need to reclaim non-inserted node
-        free(newHead);
+        metaFree(newHead);
     }
     // Either the event was satisfied to begin with
     // or while we were trying to insert the waiter,
@@ -546,7 +725,8 @@ static void onceEventRegisterEdtWaiter(ocrEvent_t * self, ocrGuid_t waiter, int
 
 //These are essentially switches to dispatch call to the correct implementation
 
-void registerDependence(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot) {
+void registerDependence(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot,
+                        ocrDbAccessMode_t mode) {
     // Warning: signalerGuid can actually be a NULL_GUID.
     // This can happen when users declared a certain number of
     // depc but dynamically decide some are not used.
@@ -571,7 +751,7 @@ void registerDependence(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot)
     // SIGNAL MODE:
     //  - anything-to-edt registration
     //  - db-to-event registration
-    registerSignaler(signalerGuid, waiterGuid, slot);
+    registerSignaler(signalerGuid, waiterGuid, slot, mode);
 }
 
 // Registers a waiter on a signaler
@@ -593,7 +773,8 @@ void registerWaiter(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot) {
 }
 
 // register a signaler on a waiter
-void registerSignaler(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot) {
+void registerSignaler(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot,
+                      ocrDbAccessMode_t mode) {
     // anything to edt registration
     if (isEdtGuid(waiterGuid)) {
         // edt waiting for a signal from an event or a datablock
@@ -601,7 +782,7 @@ void registerSignaler(ocrGuid_t signalerGuid, ocrGuid_t waiterGuid, int slot) {
         ocrTask_t * target = NULL;
 
         deguidify(getCurrentPD(), waiterGuid, (u64*)&target, NULL);
-        edtRegisterSignaler(target, signalerGuid, slot);
+        edtRegisterSignaler(target, signalerGuid, slot, mode);
         if ( target->depc == target->addedDepCounter->fctPtrs->xadd(target->addedDepCounter,1) ) {
             // This function pointer is called once, when all the dependence have been added
             target->fctPtrs->schedule(target);
@@ -9,6 +9,7 @@
 #define __HC_TASK_H__
 
 #include "hc/hc.h"
+#include "ocr-event.h"
 #include "ocr-task.h"
 #include "ocr-utils.h"
 
@@ -24,6 +25,8 @@ typedef struct {
     ocrTask_t base;
     regNode_t * waiters;
     regNode_t * signalers; // Does not grow, set once when the task is created
+    ocrEdtDep_t * depv;    // Data-blocks acquired once all the dependences are satisfied
+    u32 acquired;          // Number of signalers whose data-block has been acquired
 } ocrTaskHc_t;
 
 typedef struct {
@@ -37,4 +40,22 @@ typedef struct {
 } ocrTaskFactoryHc_t;
 
 ocrTaskFactory_t * newTaskFactoryHc(ocrParamList_t* perType);
+
+/*! \brief Starts loading the first 'lines' cache lines and one line in each
+ *  of the first 'pages' pages of an acquired data-block into the caches
+ */
+void taskPrefetchDb(ocrEdtDep_t * dep, ocrDbAccessMode_t mode, u32 lines, u32 pages, u64 pageSize);
+
+/*! \brief Returns the EDT running on the current worker, NULL for the
+ *  bootstrap code launching mainEdt
+ */
+ocrTask_t * getCurrentTask();
+
+/*! \brief Returns the latch of the finish scope an EDT belongs to, NULL if none
+ */
+ocrEvent_t * getFinishLatch(ocrTask_t * edt);
+
+/*! \brief Places an EDT in the finish scope of a latch (NULL_GUID for none)
+ */
+void setFinishLatch(ocrTask_t * edt, ocrGuid_t latchGuid);
 #endif /* __HC_TASK_H__ */
@@ -28,6 +28,8 @@ void ocr_exit() {
 }
 
 
+#ifndef OCR_BUILTIN_BITSCAN
+
 u32 fls16(u16 val) {
     u32 bit = 15;
 
@@ -64,6 +66,21 @@ u32 fls64(u64 val) {
     return bit;
 }
 
+// Isolates the lowest bit set before looking for it
+u32 ffs16(u16 val) {
+    return fls16(val & (~val + 1));
+}
+
+u32 ffs32(u32 val) {
+    return fls32(val & (~val + 1));
+}
+
+u32 ffs64(u64 val) {
+    return fls64(val & (~val + 1));
+}
+
+#endif /* OCR_BUILTIN_BITSCAN */
+
 void ocrGuidTrackerInit(ocrGuidTracker_t *self) {
     self->slotsStatus = 0xFFFFFFFFFFFFFFFFULL;
 }
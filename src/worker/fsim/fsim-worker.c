@@ -169,6 +169,15 @@ void ceSetCurrentEDT (ocrWorker_t * base, ocrGuid_t curr_edt_guid) {
     ceWorker->currentEDTGuid = curr_edt_guid;
 }
 
+// XE and CE workers have no scratch arena
+static struct _ocrScratch_t * xeGetScratch (ocrWorker_t * base) {
+    return NULL;
+}
+
+static struct _ocrScratch_t * ceGetScratch (ocrWorker_t * base) {
+    return NULL;
+}
+
 ocrWorker_t* newWorkerXE (ocrWorkerFactory_t * factory, ocrParamList_t * perInstance) {
     ocrWorkerXE_t * worker = checkedMalloc(worker, sizeof(ocrWorkerXE_t));
     worker->run = false;
@@ -414,6 +423,7 @@ ocrWorkerFactory_t * newOcrWorkerFactoryXE (ocrParamList_t * perType) {
     base->workerFcts.isRunning = xeIsRunningWorker;
     base->workerFcts.getCurrentEDT = xeGetCurrentEDT;
     base->workerFcts.setCurrentEDT = xeSetCurrentEDT;
+    base->workerFcts.getScratch = xeGetScratch;
     return base;
 }
 
@@ -430,6 +440,7 @@ ocrWorkerFactory_t * newOcrWorkerFactoryCE (ocrParamList_t * perType) {
     base->workerFcts.isRunning = ceIsRunningWorker;
     base->workerFcts.getCurrentEDT = ceGetCurrentEDT;
     base->workerFcts.setCurrentEDT = ceSetCurrentEDT;
+    base->workerFcts.getScratch = ceGetScratch;
     return base;
 }
 
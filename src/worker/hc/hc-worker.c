@@ -7,6 +7,7 @@
 
 #include "debug.h"
 #include "ocr-comp-platform.h"
+#include "ocr-edt.h"
 #include "ocr-runtime.h"
 #include "ocr-types.h"
 #include "ocr-worker.h"
@@ -14,6 +15,8 @@
 
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
 
 
 #define DEBUG_TYPE WORKER
@@ -34,6 +37,20 @@ static void associate_comp_platform_and_worker(ocrPolicyDomain_t * policy, ocrWo
 }
 
 void destructWorkerHc ( ocrWorker_t * base ) {
+    ocrWorkerHc_t * hcWorker = (ocrWorkerHc_t *) base;
+    // Stacks of EDTs still suspended when the worker stopped are reclaimed here
+    hcWorkerStack_t * stack = hcWorker->allocStacks;
+    scratchDestruct(&(hcWorker->nativeStack.scratch));
+    while (stack != NULL) {
+        hcWorkerStack_t * next = stack->nextAlloc;
+        scratchDestruct(&(stack->scratch));
+        free(stack->mem);
+        free(stack);
+        stack = next;
+    }
+    if (hcWorker->resumeTemplateGuid != NULL_GUID) {
+        ocrEdtTemplateDestroy(hcWorker->resumeTemplateGuid);
+    }
     ocrGuidProvider_t * guidProvider = getCurrentPD()->guidProvider;
     guidProvider->fctPtrs->releaseGuid(guidProvider, base->guid);
     free(base);
@@ -112,6 +129,15 @@ ocrWorker_t* newWorkerHc (ocrWorkerFactory_t * factory, ocrParamList_t * perInst
     worker->run = false;
     worker->id = ((paramListWorkerHcInst_t*)perInstance)->workerId;
     worker->currentEDTGuid = NULL_GUID;
+    worker->nativeStack.mem = NULL;
+    worker->nativeStack.owner = worker;
+    worker->currentStack = &(worker->nativeStack);
+    worker->releaseStack = NULL;
+    worker->freeStacks = NULL;
+    worker->allocStacks = NULL;
+    worker->readyStacks = NULL;
+    worker->resumableStacks = NULL;
+    worker->resumeTemplateGuid = NULL_GUID;
     ocrWorker_t * base = (ocrWorker_t *) worker;
     base->guid = UNINITIALIZED_GUID;
     guidify(getCurrentPD(), (u64)base, &(base->guid), OCR_GUID_WORKER);
@@ -127,18 +153,156 @@ int get_worker_id(ocrWorker_t * worker) {
 }
 
 static void hcExecuteWorker(ocrWorker_t * worker, ocrTask_t* task, ocrGuid_t taskGuid, ocrGuid_t currentTaskGuid) {
+    // The task returns on the stack it started on, even if it waited
+    ocrScratch_t * scratch = &(((ocrWorkerHc_t *) worker)->currentStack->scratch);
+    ocrScratchMark_t mark = scratchMark(scratch);
     worker->fctPtrs->setCurrentEDT(worker, taskGuid);
     task->fctPtrs->execute(task);
     worker->fctPtrs->setCurrentEDT(worker, currentTaskGuid);
+    scratchRollBack(scratch, mark);
+}
+
+static ocrScratch_t * hcGetScratch(ocrWorker_t * worker) {
+    return &(((ocrWorkerHc_t *) worker)->currentStack->scratch);
+}
+
+/******************************************************/
+/* OCR-HC WORKER SUSPENDED STACKS                     */
+/******************************************************/
+
+// A waiting EDT suspends the stack it runs on and the worker goes on
+// executing EDTs on a fresh stack. When the awaited event is satisfied
+// a resume EDT hands the suspended stack back to its owner worker that
+// switches to it the next time it looks for work. Stacks are only ever
+// resumed by the worker that suspended them, so that the thread's own
+// stack never migrates to another thread.
+
+static void releaseSwitchedStack(ocrWorkerHc_t * hcWorker) {
+    hcWorkerStack_t * stack = hcWorker->releaseStack;
+    if (stack != NULL) {
+        stack->next = hcWorker->freeStacks;
+        hcWorker->freeStacks = stack;
+        hcWorker->releaseStack = NULL;
+    }
+}
+
+static hcWorkerStack_t * popResumableStack(ocrWorkerHc_t * hcWorker) {
+    if ((hcWorker->resumableStacks == NULL) && (hcWorker->readyStacks != NULL)) {
+        hcWorker->resumableStacks = __sync_lock_test_and_set(&(hcWorker->readyStacks), NULL);
+    }
+    hcWorkerStack_t * stack = hcWorker->resumableStacks;
+    if (stack != NULL) {
+        hcWorker->resumableStacks = stack->next;
+    }
+    return stack;
+}
+
+// Switches from the worker loop to a resumable stack. The loop running on
+// the thread's stack is parked as resumable, loops running on any other
+// stack are discarded and their stack recycled.
+static void switchToStack(ocrWorkerHc_t * hcWorker, hcWorkerStack_t * stack) {
+    hcWorkerStack_t * current = hcWorker->currentStack;
+    hcWorker->currentStack = stack;
+    if (current == &(hcWorker->nativeStack)) {
+        current->next = hcWorker->resumableStacks;
+        hcWorker->resumableStacks = current;
+        swapcontext(&(current->ctx), &(stack->ctx));
+        releaseSwitchedStack(hcWorker);
+    } else {
+        hcWorker->releaseStack = current;
+        setcontext(&(stack->ctx));
+    }
+}
+
+// Executes when the event a suspended stack waits on is satisfied
+static ocrGuid_t resumeStackEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    hcWorkerStack_t * stack = (hcWorkerStack_t *) paramv[0];
+    ocrWorkerHc_t * owner = stack->owner;
+    stack->data = depv[0].guid;
+    stack->ready = true;
+    hcWorkerStack_t * head;
+    do {
+        head = owner->readyStacks;
+        stack->next = head;
+    } while (!__sync_bool_compare_and_swap(&(owner->readyStacks), head, stack));
+    return NULL_GUID;
+}
+
+static void worker_stack_loop();
+
+static hcWorkerStack_t * newStack(ocrWorkerHc_t * hcWorker) {
+    hcWorkerStack_t * stack = hcWorker->freeStacks;
+    if (stack != NULL) {
+        hcWorker->freeStacks = stack->next;
+    } else {
+        stack = (hcWorkerStack_t *) checkedMalloc(stack, sizeof(hcWorkerStack_t));
+        stack->mem = (char *) malloc(HC_WORKER_STACK_SIZE);
+        ASSERT(stack->mem != NULL);
+        stack->owner = hcWorker;
+        stack->nextAlloc = hcWorker->allocStacks;
+        hcWorker->allocStacks = stack;
+    }
+    RESULT_ASSERT(getcontext(&(stack->ctx)), ==, 0);
+    stack->ctx.uc_stack.ss_sp = stack->mem;
+    stack->ctx.uc_stack.ss_size = HC_WORKER_STACK_SIZE;
+    stack->ctx.uc_link = NULL;
+    makecontext(&(stack->ctx), worker_stack_loop, 0);
+    return stack;
+}
+
+static ocrGuid_t hcWaitForEvent(ocrWorker_t * base, ocrGuid_t eventGuid, ocrGuid_t currentTaskGuid) {
+    // Events of a task graph cannot have waiters outside of the graph
+    if (isEventGuidOfKind(eventGuid, OCR_EVENT_GRAPH_T)) {
+        return ERROR_GUID;
+    }
+    ocrWorkerHc_t * hcWorker = (ocrWorkerHc_t *) base;
+    hcWorkerStack_t * current = hcWorker->currentStack;
+    current->ready = false;
+    current->data = ERROR_GUID;
+    // Setup the EDT that resumes us once the event is satisfied
+    if (hcWorker->resumeTemplateGuid == NULL_GUID) {
+        ocrEdtTemplateCreate(&(hcWorker->resumeTemplateGuid), resumeStackEdt, 1, 1);
+    }
+    u64 stackArg = (u64) current;
+    ocrGuid_t resumeEdtGuid;
+    // Not through ocrEdtCreate and ocrAddDependence: they would record the
+    // resume EDT in the task graph the suspended EDT may be capturing
+    ocrPolicyDomain_t * pd = getCurrentPD();
+    ocrTaskTemplate_t * resumeTemplate = NULL;
+    deguidify(pd, hcWorker->resumeTemplateGuid, (u64*)&resumeTemplate, NULL);
+    pd->createEdt(pd, &resumeEdtGuid, resumeTemplate, 1, &stackArg, 1, EDT_PROP_NONE,
+                  NULL_GUID, NULL, getCurrentWorkerContext());
+    registerDependence(eventGuid, resumeEdtGuid, 0, DB_MODE_RO);
+    DPRINTF(DEBUG_LVL_VERB, "Worker %d suspends EDT 0x%lx on event 0x%lx\n", hcWorker->id, currentTaskGuid, eventGuid);
+    // Keep on executing EDTs on another stack until resumed
+    hcWorkerStack_t * stack = newStack(hcWorker);
+    hcWorker->currentStack = stack;
+    swapcontext(&(current->ctx), &(stack->ctx));
+    // Either the event got satisfied or the worker is stopping
+    releaseSwitchedStack(hcWorker);
+    base->fctPtrs->setCurrentEDT(base, currentTaskGuid);
+    DPRINTF(DEBUG_LVL_VERB, "Worker %d resumes EDT 0x%lx\n", hcWorker->id, currentTaskGuid);
+    return current->ready ? current->data : ERROR_GUID;
 }
 
 void worker_loop(ocrPolicyDomain_t * pd, ocrWorker_t * worker) {
+    ocrWorkerHc_t * hcWorker = (ocrWorkerHc_t *) worker;
     // Build and cache a take context
     ocrPolicyCtx_t * orgCtx = getCurrentWorkerContext();
     ocrPolicyCtx_t * ctx = orgCtx->clone(orgCtx);
     ctx->type = PD_MSG_EDT_TAKE;
     // Entering the worker loop
     while(worker->fctPtrs->isRunning(worker)) {
+        // Resuming suspended EDTs takes precedence over starting new ones
+        hcWorkerStack_t * stack = popResumableStack(hcWorker);
+        if (stack != NULL) {
+            if (hcWorker->currentStack != &(hcWorker->nativeStack)) {
+                // Not coming back to this loop
+                ctx->destruct(ctx);
+            }
+            switchToStack(hcWorker, stack);
+            continue;
+        }
         ocrGuid_t taskGuid;
         u32 count;
         pd->takeEdt(pd, NULL, &count, &taskGuid, ctx);
@@ -156,6 +320,21 @@ void worker_loop(ocrPolicyDomain_t * pd, ocrWorker_t * worker) {
     ctx->destruct(ctx);
 }
 
+// Worker loop running on a stack allocated when an EDT got suspended
+static void worker_stack_loop() {
+    ocrPolicyCtx_t * ctx = getCurrentWorkerContext();
+    ocrPolicyDomain_t * pd = ctx->PD;
+    ocrWorker_t * worker = NULL;
+    deguidify(pd, ctx->sourceObj, (u64*)&(worker), NULL);
+    worker_loop(pd, worker);
+    // The worker is stopping: hand the thread back to whatever
+    // is suspended on its own stack so that it can unwind.
+    ocrWorkerHc_t * hcWorker = (ocrWorkerHc_t *) worker;
+    hcWorker->releaseStack = hcWorker->currentStack;
+    hcWorker->currentStack = &(hcWorker->nativeStack);
+    setcontext(&(hcWorker->nativeStack.ctx));
+}
+
 void * worker_computation_routine(void * arg) {
     // Need to pass down a data-structure
     launchArg_t * launchArg = (launchArg_t *) arg;
@@ -201,5 +380,7 @@ ocrWorkerFactory_t * newOcrWorkerFactoryHc(ocrParamList_t * perType) {
     base->workerFcts.isRunning = hc_is_running_worker;
     base->workerFcts.getCurrentEDT = hc_getCurrentEDT;
     base->workerFcts.setCurrentEDT = hc_setCurrentEDT;
+    base->workerFcts.waitForEvent = hcWaitForEvent;
+    base->workerFcts.getScratch = hcGetScratch;
     return base;
 }
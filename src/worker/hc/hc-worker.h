@@ -7,10 +7,16 @@
 #ifndef __HC_WORKER_H__
 #define __HC_WORKER_H__
 
+#include "allocator/scratch/scratch-allocator.h"
 #include "ocr-types.h"
 #include "ocr-utils.h"
 #include "ocr-worker.h"
 
+#include <ucontext.h>
+
+// Size of the stacks a worker switches to when an EDT waits
+#define HC_WORKER_STACK_SIZE 8388608
+
 typedef struct {
     ocrWorkerFactory_t base;
 } ocrWorkerFactoryHc_t;
@@ -20,7 +26,27 @@ typedef struct _paramListWorkerHcInst_t {
     u32 workerId;
 } paramListWorkerHcInst_t;
 
-typedef struct {
+struct _ocrWorkerHc_t;
+
+/**
+ * @brief Execution stack a waiting EDT is suspended on
+ *
+ * 'nativeStack' in the worker describes the thread's own stack, other
+ * stacks are allocated on demand when a wait suspends the code running
+ * on the current stack and recycled once it has been resumed.
+ */
+typedef struct _hcWorkerStack_t {
+    ucontext_t ctx; // Saved context while suspended
+    char * mem; // Stack memory, NULL for the thread's stack
+    volatile bool ready; // Set when the awaited event has been satisfied
+    ocrGuid_t data; // What the awaited event has been satisfied with
+    struct _ocrWorkerHc_t * owner; // Only the owner may resume the stack
+    struct _hcWorkerStack_t * next; // Link in the ready, resumable or free list
+    struct _hcWorkerStack_t * nextAlloc; // Link in the list of allocated stacks
+    ocrScratch_t scratch; // Scratch memory of the EDTs running on the stack
+} hcWorkerStack_t;
+
+typedef struct _ocrWorkerHc_t {
     ocrWorker_t worker;
     // The HC implementation relies on integer ids to
     // map workers, schedulers and workpiles together
@@ -29,6 +55,19 @@ typedef struct {
     bool run;
     // reference to the EDT this worker is currently executing
     ocrGuid_t currentEDTGuid;
+    // Stack the worker is currently running on
+    hcWorkerStack_t * currentStack;
+    hcWorkerStack_t nativeStack;
+    // Stack to recycle once the worker has switched away from it
+    hcWorkerStack_t * releaseStack;
+    hcWorkerStack_t * freeStacks;
+    hcWorkerStack_t * allocStacks;
+    // Stacks whose awaited event got satisfied, pushed from any worker
+    hcWorkerStack_t * volatile readyStacks;
+    // Stacks that can be resumed, only accessed by this worker
+    hcWorkerStack_t * resumableStacks;
+    // Template of the EDTs resuming stacks when events are satisfied
+    ocrGuid_t resumeTemplateGuid;
 } ocrWorkerHc_t;
 
 ocrWorkerFactory_t* newOcrWorkerFactoryHc(ocrParamList_t *perType);
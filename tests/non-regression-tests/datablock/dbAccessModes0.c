@@ -0,0 +1,97 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: EDTs accessing a data-block in exclusive-write mode run alone
+ * while the read-only ones share it
+ */
+
+#define N 40
+
+volatile u32 writers;
+volatile u32 readers;
+
+static void spin() {
+    volatile u32 i = 0;
+    for ( ; i < 100000; ++i) ;
+}
+
+ocrGuid_t writerEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * counter = (u64 *) depv[0].ptr;
+    assert(__sync_fetch_and_add(&writers, 1) == 0);
+    assert(readers == 0);
+    u64 value = *counter;
+    spin();
+    *counter = value + 1;
+    __sync_fetch_and_sub(&writers, 1);
+    return NULL_GUID;
+}
+
+ocrGuid_t readerEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    // The same data-block is given twice, in both modes
+    assert(depv[0].ptr == depv[1].ptr);
+    __sync_fetch_and_add(&readers, 1);
+    assert(writers == 0);
+    spin();
+    __sync_fetch_and_sub(&readers, 1);
+    return NULL_GUID;
+}
+
+ocrGuid_t spawnEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t dbGuid = (ocrGuid_t) paramv[0];
+    ocrGuid_t writerTemplateGuid, readerTemplateGuid;
+    ocrEdtTemplateCreate(&writerTemplateGuid, writerEdt, 0, 1);
+    ocrEdtTemplateCreate(&readerTemplateGuid, readerEdt, 0, 2);
+    u32 i = 0;
+    for ( ; i < N; ++i) {
+        ocrGuid_t edtGuid;
+        if (i % 2) {
+            ocrEdtCreate(&edtGuid, writerTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                         EDT_PROP_NONE, NULL_GUID, NULL);
+            ocrAddDependence(dbGuid, edtGuid, 0, DB_MODE_EW);
+        } else {
+            ocrEdtCreate(&edtGuid, readerTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                         EDT_PROP_NONE, NULL_GUID, NULL);
+            ocrAddDependence(dbGuid, edtGuid, 0, DB_MODE_RO);
+            ocrAddDependence(dbGuid, edtGuid, 1, DB_MODE_ITW);
+        }
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * counter = (u64 *) depv[1].ptr;
+    assert(*counter == N/2);
+    ocrDbDestroy(depv[1].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * counter;
+    ocrGuid_t dbGuid;
+    ocrDbCreate(&dbGuid, (void **) &counter, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    *counter = 0;
+    ocrDbRelease(dbGuid);
+
+    ocrGuid_t spawnTemplateGuid, spawnEdtGuid, outputEventGuid;
+    ocrEdtTemplateCreate(&spawnTemplateGuid, spawnEdt, 1, 0);
+    ocrEdtCreate(&spawnEdtGuid, spawnTemplateGuid, EDT_PARAM_DEF, (u64 *) &dbGuid, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_FINISH, NULL_GUID, &outputEventGuid);
+
+    ocrGuid_t checkTemplateGuid, checkEdtGuid;
+    ocrEdtTemplateCreate(&checkTemplateGuid, checkEdt, 0, 2);
+    ocrGuid_t checkDepv[2] = {outputEventGuid, dbGuid};
+    ocrEdtCreate(&checkEdtGuid, checkTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, checkDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
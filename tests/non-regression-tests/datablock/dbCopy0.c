@@ -0,0 +1,80 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Small and large asynchronous copies between data-blocks, with the
+ * source given directly or through an event
+ */
+
+// Large enough to be split in chunks and to use non-temporal stores
+#define LARGE (8*1024*1024 + 3)
+#define SMALL 1000
+
+/* depv: large destination, small destination, event-sourced destination */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u8 * large = (u8 *) depv[0].ptr;
+    u8 * small = (u8 *) depv[1].ptr;
+    u8 * fromEvent = (u8 *) depv[2].ptr;
+    u64 i;
+    for (i = 0; i < LARGE; ++i) {
+        assert(large[i + 5] == (u8) (i + 1));
+    }
+    for (i = 0; i < SMALL; ++i) {
+        assert(small[i] == (u8) (i + 1));
+        assert(fromEvent[i] == (u8) (i + 1));
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u8 * source;
+    ocrGuid_t sourceGuid;
+    ocrDbCreate(&sourceGuid, (void **) &source, LARGE + 1, 0, NULL_GUID, NO_ALLOC);
+    u64 i;
+    for (i = 0; i < LARGE + 1; ++i) {
+        source[i] = (u8) i;
+    }
+    ocrDbRelease(sourceGuid);
+
+    u8 * ptr;
+    ocrGuid_t largeGuid, smallGuid, fromEventGuid;
+    ocrDbCreate(&largeGuid, (void **) &ptr, LARGE + 5, 0, NULL_GUID, NO_ALLOC);
+    ocrDbRelease(largeGuid);
+    ocrDbCreate(&smallGuid, (void **) &ptr, SMALL, 0, NULL_GUID, NO_ALLOC);
+    ocrDbRelease(smallGuid);
+    ocrDbCreate(&fromEventGuid, (void **) &ptr, SMALL, 0, NULL_GUID, NO_ALLOC);
+    ocrDbRelease(fromEventGuid);
+
+    // Invalid copies
+    ocrGuid_t doneGuid;
+    assert(ocrDbCopy(smallGuid, 0, sourceGuid, 0, SMALL + 1, 0, &doneGuid) == ENOMEM);
+    assert(ocrDbCopy(largeGuid, 0, sourceGuid, LARGE, 2, 0, &doneGuid) == ENOMEM);
+    assert(ocrDbCopy(sourceGuid, 10, sourceGuid, 0, 20, 0, &doneGuid) == EPERM);
+    assert(ocrDbCopy(NULL_GUID, 0, sourceGuid, 0, 1, 0, &doneGuid) == EINVAL);
+
+    ocrGuid_t checkDepv[3];
+    assert(ocrDbCopy(largeGuid, 5, sourceGuid, 1, LARGE, 0, &checkDepv[0]) == 0);
+    assert(ocrDbCopy(smallGuid, 0, sourceGuid, 1, SMALL, 0, &checkDepv[1]) == 0);
+    // The source of this copy is only known once the event is satisfied
+    ocrGuid_t sourceEventGuid;
+    ocrEventCreate(&sourceEventGuid, OCR_EVENT_STICKY_T, true);
+    assert(ocrDbCopy(fromEventGuid, 0, sourceEventGuid, 1, SMALL, 0, &checkDepv[2]) == 0);
+
+    ocrGuid_t checkTemplateGuid, checkEdtGuid;
+    ocrEdtTemplateCreate(&checkTemplateGuid, checkEdt, 0, 3);
+    ocrEdtCreate(&checkEdtGuid, checkTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, checkDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrEventSatisfy(sourceEventGuid, sourceGuid);
+    return NULL_GUID;
+}
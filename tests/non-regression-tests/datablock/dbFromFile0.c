@@ -0,0 +1,86 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Read-only and private data-blocks mapping a range of a file,
+ * acquired by another EDT after the file is removed
+ */
+
+#define FILE_SIZE (3*4096 + 100)
+// Not page-aligned
+#define OFFSET 5000
+
+/* depv: read-only mapping, private mapping */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u8 * readOnly = (u8 *) depv[0].ptr;
+    u8 * private = (u8 *) depv[1].ptr;
+    u64 i;
+    for (i = 0; i < FILE_SIZE - OFFSET; ++i) {
+        assert(readOnly[i] == (u8) (OFFSET + i));
+    }
+    // Private mappings are writable but do not share their writes
+    for (i = 0; i < 10; ++i) {
+        assert(private[i] == (u8) ~(OFFSET + i));
+        assert(readOnly[i] == (u8) (OFFSET + i));
+    }
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    char path[] = "/tmp/ocrDbFromFileXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE * file = fdopen(fd, "w");
+    u64 i;
+    for (i = 0; i < FILE_SIZE; ++i) {
+        fputc((u8) i, file);
+    }
+    fclose(file);
+
+    ocrGuid_t readOnlyGuid, privateGuid, errorGuid;
+    u8 * readOnly, * private;
+    void * error;
+    assert(ocrDbCreateFromFile(&readOnlyGuid, (void **) &readOnly, path, OFFSET, 0,
+                               DB_PROP_MAP_SEQUENTIAL, NULL_GUID) == 0);
+    assert(ocrDbCreateFromFile(&privateGuid, (void **) &private, path, OFFSET, 10,
+                               DB_PROP_MAP_PRIVATE, NULL_GUID) == 0);
+    assert(ocrDbCreateFromFile(&errorGuid, &error, path, FILE_SIZE + 1, 0,
+                               DB_PROP_NONE, NULL_GUID) == EINVAL);
+    assert(ocrDbCreateFromFile(&errorGuid, &error, path, OFFSET, FILE_SIZE,
+                               DB_PROP_NONE, NULL_GUID) == EINVAL);
+    unlink(path);
+    assert(ocrDbCreateFromFile(&errorGuid, &error, path, 0, 0,
+                               DB_PROP_NONE, NULL_GUID) == ENOENT);
+
+    for (i = 0; i < 10; ++i) {
+        assert(readOnly[i] == (u8) (OFFSET + i));
+        private[i] = ~private[i];
+    }
+    // Read-only mappings cannot be written into
+    assert(ocrDbCopy(readOnlyGuid, 0, privateGuid, 0, 10, 0, NULL) == EPERM);
+
+    ocrGuid_t checkTemplate, checkGuid;
+    ocrEdtTemplateCreate(&checkTemplate, checkEdt, 0, 2);
+    ocrEdtCreate(&checkGuid, checkTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrDbRelease(readOnlyGuid);
+    ocrDbRelease(privateGuid);
+    ocrAddDependence(readOnlyGuid, checkGuid, 0, DB_MODE_RO);
+    ocrAddDependence(privateGuid, checkGuid, 1, DB_MODE_ITW);
+    return NULL_GUID;
+}
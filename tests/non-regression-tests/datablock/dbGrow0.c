@@ -0,0 +1,64 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Creates data-blocks adding up to several times the initial size
+ * of the allocator, including one larger than it, so that it has to grow.
+ * Does nothing if the allocators cannot grow enough (arena, slab or a
+ * bounded maxsize)
+ */
+
+#define MB (1024*1024)
+#define N 6
+// Sizes of the data-blocks, with room for the meta-data of the pools
+#define TOTAL ((N*16 + 48 + 16)*MB)
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t guids[N + 1];
+    u64 * ptrs[N + 1];
+    u64 sizes[N + 1];
+    u64 i, k;
+    ocrMemoryStats_t stats;
+    assert(ocrDbMemoryStats(&stats, false) == 0);
+    if ((stats.growableSize != (u64) -1) && (stats.totalSize + stats.growableSize < TOTAL)) {
+        printf("The allocators cannot grow to %d MB, nothing to test\n", TOTAL/MB);
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    for (i = 0; i <= N; ++i) {
+        // The last one is larger than the 32 MB the allocator starts with
+        sizes[i] = ((i == N) ? 48 : 16)*MB/sizeof(u64);
+        assert(ocrDbCreate(&guids[i], (void **) &ptrs[i], sizes[i]*sizeof(u64), 0,
+                           NULL_GUID, NO_ALLOC) == 0);
+        for (k = 0; k < sizes[i]; k += 512) {
+            ptrs[i][k] = i + k;
+        }
+    }
+    for (i = 0; i <= N; ++i) {
+        for (k = 0; k < sizes[i]; k += 512) {
+            assert(ptrs[i][k] == i + k);
+        }
+    }
+    // Memory freed in the pools added is allocated again
+    for (i = 0; i <= N; ++i) {
+        ocrDbDestroy(guids[i]);
+    }
+    for (i = 0; i <= N; ++i) {
+        assert(ocrDbCreate(&guids[i], (void **) &ptrs[i], sizes[i]*sizeof(u64), 0,
+                           NULL_GUID, NO_ALLOC) == 0);
+    }
+    for (i = 0; i <= N; ++i) {
+        ocrDbDestroy(guids[i]);
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
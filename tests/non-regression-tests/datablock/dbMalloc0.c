@@ -0,0 +1,99 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Packs a linked list in a data-block with ocrDbMallocOffset and
+ * walks and frees it in another EDT
+ */
+
+#define HEAP_SIZE (64*1024)
+#define N 1000
+
+typedef struct {
+    u64 value;
+    u64 next; /* Offset of the next node, 0 at the end */
+} node_t;
+
+/* paramv: offset of the head - depv: heap */
+ocrGuid_t walkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t heapGuid = depv[0].guid;
+    char * heap = (char *) depv[0].ptr;
+    u64 offset = paramv[0];
+    u64 sum = 0;
+    u64 count = 0;
+    while (offset != 0) {
+        node_t * node = (node_t *) (heap + offset);
+        u64 next = node->next;
+        sum += node->value;
+        count++;
+        // Free with both flavors
+        if (count & 1) {
+            assert(ocrDbFreeOffset(heapGuid, offset) == 0);
+        } else {
+            assert(ocrDbFree(heapGuid, node) == 0);
+        }
+        offset = next;
+    }
+    assert(count == N);
+    assert(sum == N*(N-1)/2);
+
+    // Freed chunks are merged back: most of the heap is available again
+    void * big;
+    assert(ocrDbMalloc(heapGuid, HEAP_SIZE - 4096, &big) == 0);
+    assert(big != NULL);
+    assert(ocrDbFree(heapGuid, big) == 0);
+    assert(ocrDbFree(heapGuid, heap + HEAP_SIZE) == EINVAL);
+    ocrDbDestroy(heapGuid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t heapGuid;
+    void * heap;
+    assert(ocrDbCreate(&heapGuid, &heap, HEAP_SIZE, 0, NULL_GUID, TLSF_ALLOC) == 0);
+
+    // Build the list backwards so that it is walked in increasing order
+    u64 head = 0;
+    u64 i;
+    for (i = 0; i < N; ++i) {
+        u64 offset;
+        assert(ocrDbMallocOffset(heapGuid, sizeof(node_t), &offset) == 0);
+        assert((offset != 0) && (offset < HEAP_SIZE));
+        node_t * node = (node_t *) ((char *) heap + offset);
+        node->value = N - 1 - i;
+        node->next = head;
+        head = offset;
+    }
+
+    // Larger than the whole heap
+    u64 offset;
+    assert(ocrDbMallocOffset(heapGuid, HEAP_SIZE, &offset) == ENOMEM);
+
+    // Data-blocks without a heap or too small for one
+    ocrGuid_t plainGuid, tinyGuid;
+    void * plain, * tiny;
+    assert(ocrDbCreate(&plainGuid, &plain, 1024, 0, NULL_GUID, NO_ALLOC) == 0);
+    assert(ocrDbMallocOffset(plainGuid, 16, &offset) == EINVAL);
+    assert(ocrDbFreeOffset(plainGuid, 16) == EINVAL);
+    ocrDbDestroy(plainGuid);
+    assert(ocrDbCreate(&tinyGuid, &tiny, 64, 0, NULL_GUID, TLSF_ALLOC) == ENOMEM);
+
+    ocrGuid_t walkTemplate, walkGuid;
+    ocrEdtTemplateCreate(&walkTemplate, walkEdt, 1, 1);
+    ocrEdtCreate(&walkGuid, walkTemplate, EDT_PARAM_DEF, &head, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrDbRelease(heapGuid);
+    ocrAddDependence(heapGuid, walkGuid, 0, DB_MODE_ITW);
+    return NULL_GUID;
+}
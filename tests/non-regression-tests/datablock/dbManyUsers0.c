@@ -0,0 +1,108 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+// Only tested when ocr-lib interface is available
+#ifdef OCR_LIBRARY_ITF
+
+#include "ocr-lib.h"
+
+/**
+ * DESC: More than 64 EDTs hold the same data-block at once, it is destroyed
+ * while they hold it and freed once the last one completes
+ */
+
+#define N 100
+
+u32 readers;
+
+/* paramv: arrived latch, go event */
+ocrGuid_t readerEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * ptr = (u64 *) depv[0].ptr;
+    assert(ptr != NULL);
+    assert(*ptr == 42);
+    // Keep the data-block acquired until all the readers have acquired it
+    ocrEventSatisfySlot((ocrGuid_t) paramv[0], NULL_GUID, OCR_EVENT_LATCH_DECR_SLOT);
+    ocrWait((ocrGuid_t) paramv[1]);
+    assert(*ptr == 42);
+    __sync_fetch_and_add(&readers, 1);
+    return NULL_GUID;
+}
+
+/* paramv: db, go event - runs once all the readers hold the data-block */
+ocrGuid_t destroyEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t dbGuid = (ocrGuid_t) paramv[0];
+    assert(readers == 0);
+    assert(ocrDbDestroy(dbGuid) == 0);
+    assert(ocrDbDestroy(dbGuid) == EPERM);
+    ocrEventSatisfy((ocrGuid_t) paramv[1], NULL_GUID);
+    return NULL_GUID;
+}
+
+/* paramv: db */
+ocrGuid_t spawnEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t arrivedGuid, goGuid;
+    ocrEventCreate(&arrivedGuid, OCR_EVENT_LATCH_T, false);
+    ocrEventCreate(&goGuid, OCR_EVENT_STICKY_T, false);
+
+    ocrGuid_t destroyTemplateGuid, destroyEdtGuid;
+    ocrEdtTemplateCreate(&destroyTemplateGuid, destroyEdt, 2, 1);
+    u64 destroyParamv[2] = {paramv[0], (u64) goGuid};
+    ocrEdtCreate(&destroyEdtGuid, destroyTemplateGuid, EDT_PARAM_DEF, destroyParamv, EDT_PARAM_DEF,
+                 &arrivedGuid, EDT_PROP_NONE, NULL_GUID, NULL);
+
+    ocrGuid_t readerTemplateGuid;
+    ocrEdtTemplateCreate(&readerTemplateGuid, readerEdt, 2, 1);
+    u64 readerParamv[2] = {(u64) arrivedGuid, (u64) goGuid};
+    u32 i = 0;
+    for ( ; i < N; ++i) {
+        ocrEventSatisfySlot(arrivedGuid, NULL_GUID, OCR_EVENT_LATCH_INCR_SLOT);
+        ocrGuid_t readerGuid;
+        ocrEdtCreate(&readerGuid, readerTemplateGuid, EDT_PARAM_DEF, readerParamv, EDT_PARAM_DEF,
+                     (ocrGuid_t *) &paramv[0], EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+    return NULL_GUID;
+}
+
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    assert(readers == N);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * ptr;
+    ocrGuid_t dbGuid;
+    ocrDbCreate(&dbGuid, (void **) &ptr, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    *ptr = 42;
+    ocrDbRelease(dbGuid);
+
+    ocrGuid_t spawnTemplateGuid, spawnEdtGuid, outputEventGuid;
+    ocrEdtTemplateCreate(&spawnTemplateGuid, spawnEdt, 1, 0);
+    ocrEdtCreate(&spawnEdtGuid, spawnTemplateGuid, EDT_PARAM_DEF, (u64 *) &dbGuid, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_FINISH, NULL_GUID, &outputEventGuid);
+
+    ocrGuid_t checkTemplateGuid, checkEdtGuid;
+    ocrEdtTemplateCreate(&checkTemplateGuid, checkEdt, 0, 1);
+    ocrEdtCreate(&checkEdtGuid, checkTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &outputEventGuid,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
+
+#else
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#endif
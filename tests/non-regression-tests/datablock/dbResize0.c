@@ -0,0 +1,120 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Grows a data-block in place into the free memory after it, then
+ * so that it must move, shrinks it and checks its content survives and
+ * that an EDT acquiring it afterwards sees the new memory and size. A
+ * data-block holding a heap gives the space it grows by to its heap
+ */
+
+#define SIZE (64*1024)
+#define LARGE (1024*1024)
+#define SMALL (16*1024)
+#define CHUNK (4*1024)
+
+static void check(u64 * data, u64 count) {
+    u64 i;
+    for (i = 0; i < count; ++i) {
+        assert(data[i] == i);
+    }
+}
+
+/* depv: resized data-block */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    check((u64 *) depv[0].ptr, SMALL/sizeof(u64));
+
+    // Resizing works from a dependence as well
+    u64 * data;
+    assert(ocrDbResize(depv[0].guid, SIZE, (void **) &data) == 0);
+    check(data, SMALL/sizeof(u64));
+    ocrDbDestroy(depv[0].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t dbGuid, nextGuid, guardGuid, viewGuid;
+    u64 * data, * resized;
+    void * next, * guard, * view;
+    u64 i;
+
+    assert(ocrDbCreate(&dbGuid, (void **) &data, SIZE, 0, NULL_GUID, NO_ALLOC) == 0);
+    assert(ocrDbCreate(&nextGuid, &next, SIZE, 0, NULL_GUID, NO_ALLOC) == 0);
+    assert(ocrDbCreate(&guardGuid, &guard, SIZE, 0, NULL_GUID, NO_ALLOC) == 0);
+    for (i = 0; i < SIZE/sizeof(u64); ++i) {
+        data[i] = i;
+    }
+
+    // The memory of the next data-block is free once it is destroyed
+    ocrDbDestroy(nextGuid);
+    assert(ocrDbResize(dbGuid, SIZE + SIZE/2, (void **) &resized) == 0);
+    assert(resized == data);
+    check(resized, SIZE/sizeof(u64));
+
+    // The guard is in the way
+    assert(ocrDbResize(dbGuid, LARGE, (void **) &resized) == 0);
+    assert(resized != data);
+    check(resized, SIZE/sizeof(u64));
+    data = resized;
+
+    assert(ocrDbResize(dbGuid, SMALL, (void **) &resized) == 0);
+    check(resized, SMALL/sizeof(u64));
+    ocrMemoryStats_t stats;
+    assert(ocrDbMemoryStats(&stats, true) == 0);
+    assert(stats.errors == 0);
+
+    // Views hold their parent and cannot be resized themselves
+    assert(ocrDbCreateView(&viewGuid, &view, dbGuid, 0, SMALL, 0) == 0);
+    assert(ocrDbResize(dbGuid, SIZE, (void **) &data) == EBUSY);
+    assert(ocrDbResize(viewGuid, SMALL/2, &view) == EPERM);
+    ocrDbDestroy(viewGuid);
+    assert(ocrDbResize(dbGuid, 0, (void **) &data) == EINVAL);
+
+    // Fill a heap, grow it a little (too little for a block) then by
+    // twice its size: the chunks keep their offsets and content
+    ocrGuid_t heapGuid;
+    void * heap;
+    u64 offsets[3*SIZE/CHUNK];
+    u32 count = 0, grown;
+    assert(ocrDbCreate(&heapGuid, &heap, SIZE, 0, NULL_GUID, TLSF_ALLOC) == 0);
+    while (ocrDbMallocOffset(heapGuid, CHUNK, &offsets[count]) == 0) {
+        ((u64 *) ((u64) heap + offsets[count]))[0] = count;
+        count++;
+    }
+    assert(ocrDbResize(heapGuid, SIZE + sizeof(u64), &heap) == 0);
+    assert(ocrDbResize(heapGuid, 3*SIZE, &heap) == 0);
+    grown = count;
+    while (ocrDbMallocOffset(heapGuid, CHUNK, &offsets[grown]) == 0) {
+        grown++;
+    }
+    assert(grown >= count + 2*SIZE/CHUNK - 1);
+    for (i = 0; i < count; ++i) {
+        assert(((u64 *) ((u64) heap + offsets[i]))[0] == i);
+    }
+    assert(ocrDbResize(heapGuid, SIZE, &heap) == EINVAL);
+    assert(ocrDbMemoryStats(&stats, true) == 0);
+    assert(stats.errors == 0);
+    ocrDbDestroy(heapGuid);
+
+    ocrDbRelease(dbGuid);
+    assert(ocrDbResize(dbGuid, SIZE, (void **) &data) == EBUSY);
+    ocrDbDestroy(guardGuid);
+
+    ocrGuid_t checkTemplate, checkGuid;
+    ocrEdtTemplateCreate(&checkTemplate, checkEdt, 0, 1);
+    ocrEdtCreate(&checkGuid, checkTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrAddDependence(dbGuid, checkGuid, 0, DB_MODE_ITW);
+    return NULL_GUID;
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Takes snapshots of a data-block while it changes and checks that
+ * the source and each snapshot keep their own content
+ */
+
+#define N (64*1024)
+
+static void check(u64 * data, u64 value, u64 first, u64 last, u64 other) {
+    u64 i;
+    for (i = 0; i < N; ++i) {
+        assert(data[i] == (((i >= first) && (i < last)) ? value : other));
+    }
+}
+
+/* depv: source, first snapshot */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    check((u64 *) depv[0].ptr, 8, 0, 1, 3);
+    check((u64 *) depv[1].ptr, 2, 0, 1, 1);
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t sourceGuid, firstGuid, secondGuid, thirdGuid, copyGuid, plainGuid, errorGuid;
+    u64 * source, * first, * second, * third, * copy, * plain;
+    void * error;
+    u64 i;
+    assert(ocrDbCreate(&sourceGuid, (void **) &source, N*sizeof(u64), DB_PROP_SNAPSHOT,
+                       NULL_GUID, NO_ALLOC) == 0);
+    check(source, 0, 0, 0, 0);
+    for (i = 0; i < N; ++i) {
+        source[i] = 1;
+    }
+
+    // The source writes to a page the first snapshot shares
+    assert(ocrDbSnapshot(&firstGuid, (void **) &first, sourceGuid) == 0);
+    source[0] = 2;
+    check(first, 1, 0, 0, 1);
+    check(source, 2, 0, 1, 1);
+
+    // The second snapshot gets the page written by the source
+    assert(ocrDbSnapshot(&secondGuid, (void **) &second, sourceGuid) == 0);
+    check(second, 2, 0, 1, 1);
+    first[0] = 2;
+    second[0] = 4;
+    check(first, 2, 0, 1, 1);
+    check(source, 2, 0, 1, 1);
+    check(second, 4, 0, 1, 1);
+    source[N - 1] = 5;
+    check(second, 4, 0, 1, 1);
+
+    // Snapshot of a snapshot
+    assert(ocrDbSnapshot(&thirdGuid, (void **) &third, secondGuid) == 0);
+    check(third, 4, 0, 1, 1);
+    ocrDbDestroy(secondGuid);
+    check(third, 4, 0, 1, 1);
+    ocrDbDestroy(thirdGuid);
+
+    // The source rewrites all its pages
+    for (i = 0; i < N; ++i) {
+        source[i] = 3;
+    }
+    check(first, 2, 0, 1, 1);
+    assert(ocrDbSnapshot(&copyGuid, (void **) &copy, sourceGuid) == 0);
+    check(copy, 3, 0, N, 0);
+    ocrDbDestroy(copyGuid);
+
+    // Nothing else reads the pages of the source any more
+    source[0] = 8;
+    assert(ocrDbSnapshot(&copyGuid, (void **) &copy, sourceGuid) == 0);
+    check(copy, 8, 0, 1, 3);
+    copy[1] = 9;
+    check(source, 8, 0, 1, 3);
+    ocrDbDestroy(copyGuid);
+
+    // Data-blocks created without DB_PROP_SNAPSHOT are copied
+    ocrDbCreate(&plainGuid, (void **) &plain, N*sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    for (i = 0; i < N; ++i) {
+        plain[i] = 6;
+    }
+    assert(ocrDbSnapshot(&copyGuid, (void **) &copy, plainGuid) == 0);
+    plain[0] = 7;
+    check(copy, 6, 0, N, 0);
+    ocrDbDestroy(plainGuid);
+    ocrDbDestroy(copyGuid);
+
+    assert(ocrDbSnapshot(&errorGuid, &error, NULL_GUID) == EINVAL);
+
+    ocrDbRelease(sourceGuid);
+    ocrDbRelease(firstGuid);
+    ocrGuid_t checkTemplate, checkGuid;
+    ocrGuid_t checkDepv[2] = {sourceGuid, firstGuid};
+    ocrEdtTemplateCreate(&checkTemplate, checkEdt, 0, 2);
+    ocrEdtCreate(&checkGuid, checkTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, checkDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
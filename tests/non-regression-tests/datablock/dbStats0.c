@@ -0,0 +1,63 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Creates data-blocks then destroys every other one and checks
+ * the memory stats see the allocated chunks, the holes left and the
+ * fragmentation they cause
+ */
+
+#define SIZE (64*1024)
+#define SIZE_CLASS 16
+#define N 64
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t guids[N];
+    ocrMemoryStats_t before, created, holes;
+    void * ptr;
+    u64 i;
+
+    assert(ocrDbMemoryStats(&before, false) == 0);
+    assert(before.totalSize > 0);
+    assert(before.usedSize + before.freeSize == before.totalSize);
+    assert(before.largestFree <= before.freeSize);
+    assert(before.usedCount == 0);
+
+    for (i = 0; i < N; ++i) {
+        assert(ocrDbCreate(&guids[i], &ptr, SIZE, 0, NULL_GUID, NO_ALLOC) == 0);
+    }
+    assert(ocrDbMemoryStats(&created, true) == 0);
+    assert(created.errors == 0);
+    assert(created.usedSize + created.freeSize == created.totalSize);
+    assert(created.usedSize >= before.usedSize + N*SIZE);
+    assert(created.usedCount >= N);
+    assert(created.usedHistogram[SIZE_CLASS] >= N);
+
+    // The holes are between used chunks: they cannot merge
+    for (i = 0; i < N; i += 2) {
+        ocrDbDestroy(guids[i]);
+    }
+    assert(ocrDbMemoryStats(&holes, true) == 0);
+    assert(holes.errors == 0);
+    assert(holes.usedHistogram[SIZE_CLASS] + N/2 <= created.usedHistogram[SIZE_CLASS]);
+    assert(holes.freeHistogram[SIZE_CLASS] >= N/2);
+    assert(holes.freeCount >= created.freeCount + N/2 - 1);
+    assert(holes.freeSize >= created.freeSize + (N/2)*SIZE);
+    assert(holes.fragmentation > created.fragmentation);
+    assert(holes.fragmentation < 1000);
+
+    for (i = 1; i < N; i += 2) {
+        ocrDbDestroy(guids[i]);
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
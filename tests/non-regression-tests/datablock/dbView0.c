@@ -0,0 +1,90 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Fills a matrix through views of its tiles while the matrix itself
+ * is already destroyed and checks it through a view of the whole matrix
+ */
+
+#define N 64
+#define TILE 16
+#define TILES ((N/TILE)*(N/TILE))
+
+/* paramv: first row, first column - depv: tile */
+ocrGuid_t tileEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    char * tile = (char *) depv[0].ptr;
+    u64 i, j;
+    for (i = 0; i < TILE; ++i) {
+        u64 * row = (u64 *) (tile + i*N*sizeof(u64));
+        for (j = 0; j < TILE; ++j) {
+            row[j] = (paramv[0] + i)*N + paramv[1] + j;
+        }
+    }
+    ocrDbDestroy(depv[0].guid);
+    return NULL_GUID;
+}
+
+/* depv: whole matrix, tiles done */
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * matrix = (u64 *) depv[0].ptr;
+    u64 i;
+    for (i = 0; i < N*N; ++i) {
+        assert(matrix[i] == i);
+    }
+    // Last view of the matrix: frees it
+    ocrDbDestroy(depv[0].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t matrixGuid, allGuid, errorGuid;
+    u64 * matrix, * all;
+    void * error;
+    ocrDbCreate(&matrixGuid, (void **) &matrix, N*N*sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    assert(ocrDbCreateView(&allGuid, (void **) &all, matrixGuid, 0, N*N*sizeof(u64), 0) == 0);
+    assert(all == matrix);
+
+    assert(ocrDbCreateView(&errorGuid, &error, matrixGuid, 8, N*N*sizeof(u64), 0) == EINVAL);
+    assert(ocrDbCreateView2D(&errorGuid, &error, matrixGuid, 0, 16, 2, 8, 0) == EINVAL);
+    assert(ocrDbCreateView(&errorGuid, &error, NULL_GUID, 0, 8, 0) == EINVAL);
+
+    ocrGuid_t tileTemplate, checkTemplate, checkGuid, tileGuid;
+    ocrEdtTemplateCreate(&tileTemplate, tileEdt, 2, 1);
+    ocrEdtTemplateCreate(&checkTemplate, checkEdt, 0, 1 + TILES);
+    ocrGuid_t checkDepv[1 + TILES];
+    checkDepv[0] = allGuid;
+    ocrGuid_t tileViews[TILES];
+    u64 t;
+    for (t = 0; t < TILES; ++t) {
+        u64 position[2] = {(t/(N/TILE))*TILE, (t%(N/TILE))*TILE};
+        void * tile;
+        assert(ocrDbCreateView2D(&tileViews[t], &tile, matrixGuid,
+                                 (position[0]*N + position[1])*sizeof(u64), TILE*sizeof(u64),
+                                 TILE, N*sizeof(u64), 0) == 0);
+        assert(tile == (void *) (matrix + position[0]*N + position[1]));
+        ocrDbRelease(tileViews[t]);
+        ocrEdtCreate(&tileGuid, tileTemplate, EDT_PARAM_DEF, position, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, &checkDepv[1 + t]);
+        ocrAddDependence(tileViews[t], tileGuid, 0, DB_MODE_EW);
+    }
+
+    // The views keep the matrix alive but no new view can be created
+    ocrDbDestroy(matrixGuid);
+    assert(ocrDbCreateView(&errorGuid, &error, matrixGuid, 0, 8, 0) == EPERM);
+
+    ocrDbRelease(allGuid);
+    ocrEdtCreate(&checkGuid, checkTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, checkDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
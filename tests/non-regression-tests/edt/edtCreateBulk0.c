@@ -0,0 +1,69 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Create EDTs in bulk with strided parameters in a finish scope
+ */
+
+#define N 1000
+
+u32 hits[N];
+
+ocrGuid_t bulkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    assert(paramc == 3);
+    u64 i = paramv[0];
+    assert(i < N);
+    assert(paramv[1] == 7);
+    assert(paramv[2] == 100 + 2*i);
+    __sync_fetch_and_add(&hits[i], 1);
+    return NULL_GUID;
+}
+
+ocrGuid_t spawnEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t bulkTemplateGuid;
+    ocrEdtTemplateCreate(&bulkTemplateGuid, bulkEdt, 3, 0);
+    u64 params[3] = {0, 7, 100};
+    u64 strides[3] = {1, 0, 2};
+    ocrGuid_t guids[N];
+    assert(ocrEdtCreateBulk(guids, bulkTemplateGuid, N, EDT_PARAM_DEF, params, strides,
+                            EDT_PROP_NONE, NULL_GUID) == 0);
+    // Bulk EDTs cannot have dependences
+    ocrGuid_t depTemplateGuid;
+    ocrEdtTemplateCreate(&depTemplateGuid, bulkEdt, 3, 1);
+    assert(ocrEdtCreateBulk(NULL, depTemplateGuid, N, EDT_PARAM_DEF, params, strides,
+                            EDT_PROP_NONE, NULL_GUID) == EINVAL);
+    return NULL_GUID;
+}
+
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u32 i = 0;
+    for ( ; i < N; ++i) {
+        assert(hits[i] == 1);
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    // The finish EDT completes once all the bulk EDTs have run
+    ocrGuid_t spawnTemplateGuid, spawnEdtGuid, outputEventGuid;
+    ocrEdtTemplateCreate(&spawnTemplateGuid, spawnEdt, 0, 0);
+    ocrEdtCreate(&spawnEdtGuid, spawnTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_FINISH, NULL_GUID, &outputEventGuid);
+
+    ocrGuid_t checkTemplateGuid, checkEdtGuid;
+    ocrEdtTemplateCreate(&checkTemplateGuid, checkEdt, 0, 1);
+    ocrEdtCreate(&checkEdtGuid, checkTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &outputEventGuid,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
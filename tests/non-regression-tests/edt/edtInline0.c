@@ -0,0 +1,110 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: A finish EDT readies EDT_PROP_INLINE EDTs one at a time. The first
+ * 'inlinelimit' of them (32 in the default configurations) run inline,
+ * within the satisfy call, the others are pushed. Each of them spawns a
+ * normal EDT the finish scope must wait for, and their output events
+ * satisfy a collector EDT.
+ */
+
+#define N 40
+#define INLINE_LIMIT 32
+
+// Index (plus one) of the EDT the current worker is readying, if any
+static __thread u64 satisfying = 0;
+static volatile u64 inlined[N];
+static volatile u64 ran = 0;
+static volatile u64 spawned = 0;
+static volatile u64 collected = 0;
+
+ocrGuid_t spawnedEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u32 i;
+    for (i = 0; i < 100000; i++) {
+        __asm__ __volatile__("" ::: "memory");
+    }
+    __sync_fetch_and_add(&spawned, 1);
+    return NULL_GUID;
+}
+
+// paramv: index, spawned template - depv: trigger
+ocrGuid_t inlineEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 index = paramv[0];
+    // Another worker, or this one once the satisfy call
+    // returned, sees a different value
+    inlined[index] = (satisfying == index + 1);
+    __sync_fetch_and_add(&ran, 1);
+    ocrGuid_t spawnedGuid;
+    ocrEdtCreate(&spawnedGuid, (ocrGuid_t) paramv[1], EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
+
+// depv: output events of the inline EDTs
+ocrGuid_t collectorEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    assert(depc == N);
+    collected = 1;
+    return NULL_GUID;
+}
+
+ocrGuid_t finishEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t inlineTemplate, spawnedTemplate, collectorTemplate;
+    ocrEdtTemplateCreate(&inlineTemplate, inlineEdt, 2, 1);
+    ocrEdtTemplateCreate(&spawnedTemplate, spawnedEdt, 0, 0);
+    ocrEdtTemplateCreate(&collectorTemplate, collectorEdt, 0, N);
+    ocrGuid_t collectorGuid;
+    ocrEdtCreate(&collectorGuid, collectorTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+
+    ocrGuid_t triggers[N];
+    u64 i;
+    for (i = 0; i < N; i++) {
+        ocrGuid_t inlineGuid, outputGuid;
+        u64 nparamv[2] = {i, (u64) spawnedTemplate};
+        ocrEventCreate(&triggers[i], OCR_EVENT_ONCE_T, false);
+        ocrEdtCreate(&inlineGuid, inlineTemplate, EDT_PARAM_DEF, nparamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_INLINE, NULL_GUID, &outputGuid);
+        ocrAddDependence(triggers[i], inlineGuid, 0, DB_DEFAULT_MODE);
+        ocrAddDependence(outputGuid, collectorGuid, i, DB_DEFAULT_MODE);
+    }
+    for (i = 0; i < N; i++) {
+        satisfying = i + 1;
+        ocrEventSatisfy(triggers[i], NULL_GUID);
+        satisfying = 0;
+        // Past the limit, the EDTs go through the workpiles
+        assert(inlined[i] == (i < INLINE_LIMIT));
+    }
+    return NULL_GUID;
+}
+
+// depv: output event of the finish EDT
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    assert(ran == N);
+    assert(spawned == N);
+    assert(collected == 1);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t finishTemplate, doneTemplate;
+    ocrEdtTemplateCreate(&finishTemplate, finishEdt, 0, 0);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 1);
+    ocrGuid_t finishGuid, finishOutput, doneGuid;
+    ocrEdtCreate(&finishGuid, finishTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_FINISH, NULL_GUID, &finishOutput);
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &finishOutput,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
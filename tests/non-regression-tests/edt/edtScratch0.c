@@ -0,0 +1,94 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ocr.h"
+
+#ifdef OCR_LIBRARY_ITF
+#include "ocr-lib.h"
+#endif
+
+/**
+ * DESC: Allocates scratch memory past the first chunk of the arena and
+ * checks it is aligned and intact after other EDTs used scratch memory,
+ * while this EDT waits when the ocr-lib interface is available
+ */
+
+#define N 64
+#define SMALL 24
+#define COUNT 4096
+#define LARGE (1024*1024)
+
+static void check(u8 * buffer, u64 size, u8 value) {
+    u64 i;
+    for (i = 0; i < size; ++i) {
+        assert(buffer[i] == value);
+    }
+}
+
+/* paramv: id, latch */
+ocrGuid_t userEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 id = paramv[0];
+    u64 size = ((id % 4) == 0) ? LARGE : SMALL*(id + 1);
+    void * buffer;
+    assert(ocrScratchMalloc(size, &buffer) == 0);
+    assert(((u64) buffer & 15) == 0);
+    memset(buffer, (u8) id, size);
+    check((u8 *) buffer, size, (u8) id);
+    ocrEventSatisfySlot((ocrGuid_t) paramv[1], NULL_GUID, OCR_EVENT_LATCH_DECR_SLOT);
+    return NULL_GUID;
+}
+
+/* depv: latch, main done */
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    void * small[COUNT];
+    void * large;
+    u64 i;
+    for (i = 0; i < COUNT; ++i) {
+        assert(ocrScratchMalloc(SMALL, &small[i]) == 0);
+        assert(((u64) small[i] & 15) == 0);
+        memset(small[i], (u8) i, SMALL);
+    }
+    assert(ocrScratchMalloc(LARGE, &large) == 0);
+    memset(large, 0xAB, LARGE);
+
+    ocrGuid_t latchGuid, mainDoneGuid, doneTemplate, doneGuid, userTemplate, userGuid;
+    ocrEventCreate(&latchGuid, OCR_EVENT_LATCH_T, false);
+    ocrEventCreate(&mainDoneGuid, OCR_EVENT_ONCE_T, false);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 2);
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrAddDependence(latchGuid, doneGuid, 0, DB_MODE_RO);
+    ocrAddDependence(mainDoneGuid, doneGuid, 1, DB_MODE_RO);
+
+    ocrEdtTemplateCreate(&userTemplate, userEdt, 2, 0);
+    for (i = 0; i < N; ++i) {
+        ocrEventSatisfySlot(latchGuid, NULL_GUID, OCR_EVENT_LATCH_INCR_SLOT);
+        u64 userParamv[2] = {i, (u64) latchGuid};
+        ocrEdtCreate(&userGuid, userTemplate, EDT_PARAM_DEF, userParamv, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+    }
+#ifdef OCR_LIBRARY_ITF
+    // The EDTs running on this worker meanwhile allocate scratch memory too
+    ocrWait(latchGuid);
+#endif
+
+    for (i = 0; i < COUNT; ++i) {
+        check((u8 *) small[i], SMALL, (u8) i);
+    }
+    check((u8 *) large, LARGE, 0xAB);
+    ocrEventSatisfy(mainDoneGuid, NULL_GUID);
+    return NULL_GUID;
+}
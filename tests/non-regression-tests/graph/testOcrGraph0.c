@@ -0,0 +1,133 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Record a two-level reduction in a task graph, ending the recording
+ * too early once, and replay it with new parameters and data-blocks
+ */
+
+#define N 16
+#define ITERATIONS 6
+
+// paramv: factor, index - depv: data, result
+ocrGuid_t leafEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 factor = paramv[0];
+    u64 id = paramv[1];
+    u64 * data = (u64 *) depv[0].ptr;
+    u64 * result = (u64 *) depv[1].ptr;
+    result[id] = factor * data[id];
+    return NULL_GUID;
+}
+
+// paramv: factor - depv: result, N leaves, control event
+ocrGuid_t sumEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * result = (u64 *) depv[0].ptr;
+    assert(depc == N+2);
+    u64 sum = 0;
+    u32 i;
+    for(i = 0; i < N; i++) {
+        sum += result[i];
+    }
+    result[N] = sum;
+    return NULL_GUID;
+}
+
+// paramv: graph, template, iteration - depv: result, completion
+ocrGuid_t stepEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t graph = (ocrGuid_t) paramv[0];
+    ocrGuid_t stepTemplate = (ocrGuid_t) paramv[1];
+    u64 iteration = paramv[2];
+    ocrGuid_t * inputs = (ocrGuid_t *) &(paramv[3]);
+    u64 * result = (u64 *) depv[0].ptr;
+    if (iteration != 0) {
+        // Previous replay used factor 'iteration' on data[i] = i or 2*i
+        u64 expected = iteration * (N * (N-1) / 2) * (((iteration-1) % 2) + 1);
+        assert(result[N] == expected);
+    }
+    if (iteration == ITERATIONS) {
+        assert(ocrGraphDestroy(graph) == 0);
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    ocrGuid_t completion;
+    ocrEventCreate(&completion, OCR_EVENT_STICKY_T, false);
+    u64 nparamv[6] = {paramv[0], paramv[1], iteration+1, paramv[3], paramv[4], paramv[5]};
+    ocrGuid_t ndepv[2] = {depv[0].guid, completion};
+    ocrGuid_t stepGuid;
+    ocrEdtCreate(&stepGuid, stepTemplate, EDT_PARAM_DEF, nparamv, EDT_PARAM_DEF, ndepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    // Inputs are numbered in recording order: result first, then data.
+    // Alternate between the two data sets.
+    ocrGuid_t bindings[2] = {inputs[2], inputs[iteration % 2]};
+    u64 factor = iteration + 1;
+    assert(ocrGraphReplay(graph, 1, &factor, 2, bindings, completion) == 0);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t dataGuid[2];
+    u64 * data[2];
+    ocrDbCreate(&dataGuid[0], (void **) &data[0], sizeof(u64)*N, 0, NULL_GUID, NO_ALLOC);
+    ocrDbCreate(&dataGuid[1], (void **) &data[1], sizeof(u64)*N, 0, NULL_GUID, NO_ALLOC);
+    ocrGuid_t resultGuid;
+    u64 * result;
+    ocrDbCreate(&resultGuid, (void **) &result, sizeof(u64)*(N+1), 0, NULL_GUID, NO_ALLOC);
+    u32 i;
+    for(i = 0; i < N; i++) {
+        data[0][i] = i;
+        data[1][i] = 2*i;
+    }
+
+    ocrGuid_t leafTemplate, sumTemplate, stepTemplate;
+    ocrEdtTemplateCreate(&leafTemplate, leafEdt, 2, 2);
+    ocrEdtTemplateCreate(&sumTemplate, sumEdt, 1, N+2);
+    ocrEdtTemplateCreate(&stepTemplate, stepEdt, 6, 2);
+
+    // Record the graph: nothing runs until it is replayed
+    ocrGuid_t graph;
+    assert(ocrGraphBegin(&graph, 1) == 0);
+    ocrGuid_t sumGuid;
+    u64 sumParamv[1] = {0};
+    ocrEdtCreate(&sumGuid, sumTemplate, EDT_PARAM_DEF, sumParamv, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrAddDependence(resultGuid, sumGuid, 0, DB_MODE_ITW);
+    for(i = 0; i < N; i++) {
+        u64 leafParamv[2] = {0, i};
+        ocrGuid_t leafDepv[2] = {dataGuid[0], resultGuid};
+        ocrGuid_t leafGuid, leafDone;
+        ocrEdtCreate(&leafGuid, leafTemplate, EDT_PARAM_DEF, leafParamv, EDT_PARAM_DEF, leafDepv,
+                     EDT_PROP_NONE, NULL_GUID, &leafDone);
+        ocrAddDependence(leafDone, sumGuid, i+1, DB_MODE_RO);
+    }
+    // Event satisfied while recording: fired at each replay
+    ocrGuid_t control;
+    ocrEventCreate(&control, OCR_EVENT_STICKY_T, false);
+    // The control slot is not connected yet, recording goes on
+    assert(ocrGraphEnd(graph) != 0);
+    ocrAddDependence(control, sumGuid, N+1, DB_MODE_RO);
+    ocrEventSatisfy(control, NULL_GUID);
+    // Latch events cannot be recorded
+    ocrGuid_t latch;
+    assert(ocrEventCreate(&latch, OCR_EVENT_LATCH_T, false) != 0);
+    assert(ocrGraphEnd(graph) == 0);
+    // Not recording anymore
+    assert(ocrGraphEnd(graph) != 0);
+    assert(ocrAddDependence(NULL_GUID, control, 0, DB_MODE_RO) != 0);
+
+    u64 stepParamv[6] = {(u64) graph, (u64) stepTemplate, 0,
+                         (u64) dataGuid[0], (u64) dataGuid[1], (u64) resultGuid};
+    ocrGuid_t stepDepv[2] = {resultGuid, NULL_GUID};
+    ocrGuid_t stepGuid;
+    ocrEdtCreate(&stepGuid, stepTemplate, EDT_PARAM_DEF, stepParamv, EDT_PARAM_DEF, stepDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+// Only tested when ocr-lib interface is available
+#ifdef OCR_LIBRARY_ITF
+
+#include "ocr-lib.h"
+
+/**
+ * DESC: EDT recording a task graph waits on an event set by an EDT outside
+ * of the graph, then ends the recording, cannot wait on an event of the
+ * graph and replays the graph
+ */
+
+static volatile u64 runs = 0;
+
+// depv: data-block
+ocrGuid_t setterEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t readyGuid = (ocrGuid_t) paramv[0];
+    ocrEventSatisfy(readyGuid, depv[0].guid);
+    return NULL_GUID;
+}
+
+ocrGuid_t graphEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    __sync_fetch_and_add(&runs, 1);
+    return NULL_GUID;
+}
+
+// depv: replay completion
+ocrGuid_t doneEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    assert(runs == 1);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t dbGuid;
+    u64 * data;
+    ocrDbCreate(&dbGuid, (void **) &data, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    ocrGuid_t readyGuid;
+    ocrEventCreate(&readyGuid, OCR_EVENT_STICKY_T, true);
+    ocrGuid_t setterTemplate, graphTemplate, doneTemplate;
+    ocrEdtTemplateCreate(&setterTemplate, setterEdt, 1, 1);
+    ocrEdtTemplateCreate(&graphTemplate, graphEdt, 0, 0);
+    ocrEdtTemplateCreate(&doneTemplate, doneEdt, 0, 1);
+
+    ocrGuid_t setterGuid;
+    u64 setterParamv[1] = {(u64) readyGuid};
+    ocrEdtCreate(&setterGuid, setterTemplate, EDT_PARAM_DEF, setterParamv, EDT_PARAM_DEF, &dbGuid,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+
+    ocrGuid_t graph, graphEdtGuid;
+    assert(ocrGraphBegin(&graph, 0) == 0);
+    ocrEdtCreate(&graphEdtGuid, graphTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    ocrGuid_t graphEventGuid;
+    ocrEventCreate(&graphEventGuid, OCR_EVENT_STICKY_T, false);
+    // The EDT resuming this one must not be recorded in the graph
+    assert(ocrWait(readyGuid) == dbGuid);
+    assert(ocrGraphEnd(graph) == 0);
+    // Events of the graph cannot be waited on from outside of it
+    assert(ocrWait(graphEventGuid) == (ocrGuid_t) -1 /* ERROR_GUID */);
+    assert(runs == 0);
+
+    ocrGuid_t completion, doneGuid;
+    ocrEventCreate(&completion, OCR_EVENT_STICKY_T, false);
+    ocrEdtCreate(&doneGuid, doneTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &completion,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    assert(ocrGraphReplay(graph, 0, NULL, 0, NULL, completion) == 0);
+    return NULL_GUID;
+}
+
+#else
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Record EDTs that increment a counter in exclusive write mode and
+ * replay them while the counter is held by the EDT replaying the graph
+ */
+
+#define N 32
+#define ITERATIONS 4
+
+// depv: counter (RO), counter (EW)
+ocrGuid_t incrementEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    volatile u64 * counter = (volatile u64 *) depv[1].ptr;
+    assert(depv[0].ptr == depv[1].ptr);
+    // Increments are lost unless the EDTs run one at a time
+    u64 value = *counter;
+    u32 i;
+    for (i = 0; i < 10000; i++) {
+        *counter = value + i;
+    }
+    *counter = value + 1;
+    return NULL_GUID;
+}
+
+// paramv: graph, template, iteration - depv: counter, completion
+ocrGuid_t stepEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t graph = (ocrGuid_t) paramv[0];
+    ocrGuid_t stepTemplate = (ocrGuid_t) paramv[1];
+    u64 iteration = paramv[2];
+    u64 * counter = (u64 *) depv[0].ptr;
+    assert(*counter == N*iteration);
+    if (iteration == ITERATIONS) {
+        assert(ocrGraphDestroy(graph) == 0);
+        printf("Everything went OK\n");
+        ocrShutdown();
+        return NULL_GUID;
+    }
+    ocrGuid_t completion;
+    ocrEventCreate(&completion, OCR_EVENT_STICKY_T, false);
+    u64 nparamv[3] = {paramv[0], paramv[1], iteration+1};
+    ocrGuid_t ndepv[2] = {depv[0].guid, completion};
+    ocrGuid_t stepGuid;
+    ocrEdtCreate(&stepGuid, stepTemplate, EDT_PARAM_DEF, nparamv, EDT_PARAM_DEF, ndepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    // The graph's EDTs wait for this EDT to release the counter
+    assert(ocrGraphReplay(graph, 0, NULL, 0, NULL, completion) == 0);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t counterGuid;
+    u64 * counter;
+    ocrDbCreate(&counterGuid, (void **) &counter, sizeof(u64), 0, NULL_GUID, NO_ALLOC);
+    *counter = 0;
+    ocrDbRelease(counterGuid);
+
+    ocrGuid_t incrementTemplate, stepTemplate;
+    ocrEdtTemplateCreate(&incrementTemplate, incrementEdt, 0, 2);
+    ocrEdtTemplateCreate(&stepTemplate, stepEdt, 3, 2);
+
+    ocrGuid_t graph;
+    assert(ocrGraphBegin(&graph, 0) == 0);
+    u32 i;
+    for (i = 0; i < N; i++) {
+        ocrGuid_t incrementGuid;
+        ocrEdtCreate(&incrementGuid, incrementTemplate, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, NULL,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        ocrAddDependence(counterGuid, incrementGuid, 0, DB_MODE_RO);
+        ocrAddDependence(counterGuid, incrementGuid, 1, DB_MODE_EW);
+    }
+    assert(ocrGraphEnd(graph) == 0);
+
+    u64 stepParamv[3] = {(u64) graph, (u64) stepTemplate, 0};
+    ocrGuid_t stepDepv[2] = {counterGuid, NULL_GUID};
+    ocrGuid_t stepGuid;
+    ocrEdtCreate(&stepGuid, stepTemplate, EDT_PARAM_DEF, stepParamv, EDT_PARAM_DEF, stepDepv,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    return NULL_GUID;
+}
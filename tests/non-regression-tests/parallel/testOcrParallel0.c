@@ -0,0 +1,110 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "ocr.h"
+
+/**
+ * DESC: Parallel loop then a commutative and a non-commutative reduction
+ */
+
+#define N 100000
+
+u64 data[N];
+
+typedef struct {
+    u64 first;
+    u64 last;
+    u64 empty;
+    u64 ordered;
+} span_t;
+
+void initBody(u64 first, u64 last, void *arg) {
+    u64 * a = (u64 *) arg;
+    u64 i;
+    for (i = first; i < last; i++) {
+        a[i] = i;
+    }
+}
+
+void sumBody(u64 first, u64 last, void *arg, void *result) {
+    u64 * a = (u64 *) arg;
+    u64 i;
+    for (i = first; i < last; i++) {
+        *((u64 *) result) += a[i];
+    }
+}
+
+void sumCombine(void *left, const void *right, void *arg) {
+    *((u64 *) left) += *((const u64 *) right);
+}
+
+// Checks that ranges are reduced and combined in iteration order
+void spanBody(u64 first, u64 last, void *arg, void *result) {
+    span_t * span = (span_t *) result;
+    if (span->empty) {
+        span->first = first;
+        span->empty = 0;
+    } else if (span->last != first) {
+        span->ordered = 0;
+    }
+    span->last = last;
+}
+
+void spanCombine(void *left, const void *right, void *arg) {
+    span_t * l = (span_t *) left;
+    const span_t * r = (const span_t *) right;
+    if (r->empty) {
+        return;
+    }
+    if (l->empty) {
+        *l = *r;
+        return;
+    }
+    l->ordered = l->ordered && r->ordered && (l->last == r->first);
+    l->last = r->last;
+}
+
+ocrGuid_t checkEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 sum = *((u64 *) depv[0].ptr);
+    span_t * span = (span_t *) depv[1].ptr;
+    assert(sum == ((u64) N)*(N-1)/2);
+    assert(!span->empty && span->ordered && (span->first == 0) && (span->last == N));
+    ocrDbDestroy(depv[0].guid);
+    ocrDbDestroy(depv[1].guid);
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+ocrGuid_t reduceEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t events[2];
+    ocrEventCreate(&events[0], OCR_EVENT_ONCE_T, true);
+    ocrEventCreate(&events[1], OCR_EVENT_ONCE_T, true);
+    ocrGuid_t checkTemplateGuid, checkEdtGuid;
+    ocrEdtTemplateCreate(&checkTemplateGuid, checkEdt, 0, 2);
+    ocrEdtCreate(&checkEdtGuid, checkTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, events,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+
+    u64 zero = 0;
+    assert(ocrParallelReduce(0, N, 0, sumBody, sumCombine, &zero, sizeof(u64), data, events[0]) == 0);
+    span_t identity = {0, 0, 1, 1};
+    assert(ocrParallelReduce(0, N, 10, spanBody, spanCombine, &identity, sizeof(span_t), NULL, events[1]) == 0);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrGuid_t initDone;
+    ocrEventCreate(&initDone, OCR_EVENT_ONCE_T, false);
+    ocrGuid_t reduceTemplateGuid, reduceEdtGuid;
+    ocrEdtTemplateCreate(&reduceTemplateGuid, reduceEdt, 0, 1);
+    ocrEdtCreate(&reduceEdtGuid, reduceTemplateGuid, EDT_PARAM_DEF, NULL, EDT_PARAM_DEF, &initDone,
+                 EDT_PROP_NONE, NULL_GUID, NULL);
+    assert(ocrParallelFor(0, N, 0, initBody, data, initDone) == 0);
+    return NULL_GUID;
+}
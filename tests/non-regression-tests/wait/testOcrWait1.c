@@ -0,0 +1,72 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+// Only tested when ocr-lib interface is available
+#ifdef OCR_LIBRARY_ITF
+
+#include "ocr-lib.h"
+
+/**
+ * DESC: Chain of EDTs each waiting on the output event of the EDT it creates
+ */
+
+#define DEPTH 32
+
+ocrGuid_t waiterEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 depth = paramv[0];
+    u64 * array = (u64 *) depv[0].ptr;
+    if (depth < DEPTH) {
+        ocrGuid_t templateGuid;
+        ocrEdtTemplateCreate(&templateGuid, waiterEdt, 1 /*paramc*/, 1 /*depc*/);
+        u64 nparamv = depth+1;
+        ocrGuid_t edtGuid, outputEventGuid;
+        ocrEdtCreate(&edtGuid, templateGuid, EDT_PARAM_DEF, &nparamv, EDT_PARAM_DEF, &(depv[0].guid),
+                     EDT_PROP_NONE, NULL_GUID, &outputEventGuid);
+        ocrGuid_t returnGuid = ocrWait(outputEventGuid);
+        // The child returned the guid of the array once done
+        assert(returnGuid == depv[0].guid);
+        assert(array[depth+1] == depth+1);
+    }
+    array[depth] = depth;
+    return depv[0].guid;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * array;
+    ocrGuid_t dbGuid;
+    ocrDbCreate(&dbGuid, (void **) &array, sizeof(u64)*(DEPTH+1), 0, NULL_GUID, NO_ALLOC);
+
+    ocrGuid_t templateGuid;
+    ocrEdtTemplateCreate(&templateGuid, waiterEdt, 1 /*paramc*/, 1 /*depc*/);
+    u64 nparamv = 1;
+    ocrGuid_t edtGuid, outputEventGuid;
+    ocrEdtCreate(&edtGuid, templateGuid, EDT_PARAM_DEF, &nparamv, EDT_PARAM_DEF, &dbGuid,
+                 EDT_PROP_NONE, NULL_GUID, &outputEventGuid);
+    ocrWait(outputEventGuid);
+    u64 i = 1;
+    while (i <= DEPTH) {
+        assert(array[i] == i);
+        i++;
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#else
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#endif
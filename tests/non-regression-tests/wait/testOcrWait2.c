@@ -0,0 +1,69 @@
+/*
+ * This file is subject to the license agreement located in the file LICENSE
+ * and cannot be distributed without it. This notice cannot be
+ * removed or modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "ocr.h"
+
+// Only tested when ocr-lib interface is available
+#ifdef OCR_LIBRARY_ITF
+
+#include "ocr-lib.h"
+
+/**
+ * DESC: EDT waits on a latch-event decremented by the EDTs it spawns
+ */
+
+#define N 100
+
+ocrGuid_t updaterEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 id = paramv[0];
+    ocrGuid_t latchGuid = (ocrGuid_t) paramv[1];
+    u64 * array = (u64 *) depv[0].ptr;
+    array[id] = id;
+    ocrEventSatisfySlot(latchGuid, NULL_GUID, OCR_EVENT_LATCH_DECR_SLOT);
+    return NULL_GUID;
+}
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    u64 * array;
+    ocrGuid_t dbGuid;
+    ocrDbCreate(&dbGuid, (void **) &array, sizeof(u64)*N, 0, NULL_GUID, NO_ALLOC);
+
+    ocrGuid_t latchGuid;
+    ocrEventCreate(&latchGuid, OCR_EVENT_LATCH_T, false);
+    ocrGuid_t templateGuid;
+    ocrEdtTemplateCreate(&templateGuid, updaterEdt, 2 /*paramc*/, 1 /*depc*/);
+    u64 i = 0;
+    while (i < N) {
+        ocrEventSatisfySlot(latchGuid, NULL_GUID, OCR_EVENT_LATCH_INCR_SLOT);
+        u64 nparamv[2] = {i, (u64) latchGuid};
+        ocrGuid_t edtGuid;
+        ocrEdtCreate(&edtGuid, templateGuid, EDT_PARAM_DEF, nparamv, EDT_PARAM_DEF, &dbGuid,
+                     EDT_PROP_NONE, NULL_GUID, NULL);
+        i++;
+    }
+    ocrWait(latchGuid);
+    i = 0;
+    while (i < N) {
+        assert(array[i] == i);
+        i++;
+    }
+    printf("Everything went OK\n");
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#else
+
+ocrGuid_t mainEdt(u32 paramc, u64* paramv, u32 depc, ocrEdtDep_t depv[]) {
+    ocrShutdown();
+    return NULL_GUID;
+}
+
+#endif